@@ -16,6 +16,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include <glib.h>
 #include <inttypes.h>
 
@@ -50,6 +51,50 @@ struct clan_data * clan_by_name(char *arg);
 struct clan_data *clan_list;
 extern FILE *player_fl;
 
+// Clans by number
+static GHashTable *clan_map = NULL;
+
+// Changes to the clan tables not yet sent to the database.  Queries
+// are made in the order they were queued, so every write to the clan
+// tables must go through here.
+static GQueue *clan_sql_queue = NULL;
+
+static void
+queue_clan_sql(const char *str, ...)
+{
+    va_list args;
+
+    if (!clan_sql_queue)
+        clan_sql_queue = g_queue_new();
+
+    va_start(args, str);
+    g_queue_push_tail(clan_sql_queue, g_strdup_vprintf(str, args));
+    va_end(args);
+}
+
+/**
+ * flush_clan_sql:
+ *
+ * Sends the queued changes to the clan tables to the database in a
+ * single transaction.  Called every pulse, so commands changing clan
+ * membership don't wait on the database.
+ **/
+void
+flush_clan_sql(void)
+{
+    char *query;
+
+    if (!clan_sql_queue || g_queue_is_empty(clan_sql_queue))
+        return;
+
+    sql_exec("begin");
+    while ((query = g_queue_pop_head(clan_sql_queue))) {
+        sql_exec("%s", query);
+        g_free(query);
+    }
+    sql_exec("commit");
+}
+
 __attribute__ ((nonnull)) void
 remove_room_from_clan(struct room_list_elem *rm_list, struct clan_data *clan)
 {
@@ -58,23 +103,110 @@ remove_room_from_clan(struct room_list_elem *rm_list, struct clan_data *clan)
     free(rm_list);
 }
 
+// Puts the member into the member list before the members of the same
+// rank or lower, keeping the list in rank order
+__attribute__ ((nonnull)) static void
+link_clanmember(struct clan_data *clan, struct clanmember_data *member)
+{
+    struct clanmember_data **prev = &clan->member_list;
+
+    while (*prev && (*prev)->rank > member->rank)
+        prev = &(*prev)->next;
+    member->next = *prev;
+    *prev = member;
+}
+
 __attribute__ ((nonnull)) void
 remove_member_from_clan(/*@only@*/ struct clanmember_data *member, struct clan_data *clan)
 {
     struct clanmember_data *temp;
     REMOVE_FROM_LIST(member, clan->member_list, next);
+    g_hash_table_remove(clan->members, GINT_TO_POINTER(member->idnum));
+    clan->member_count--;
     free(member);
 }
 
-__attribute__ ((nonnull)) static int
-clan_member_count(struct clan_data *clan)
+/**
+ * add_clan_member:
+ * @clan the clan the player is joining
+ * @idnum the idnum of the player
+ * @rank the rank of the player in the clan
+ * @no_mail %true if the player doesn't receive clan mail
+ *
+ * Adds the player to the roster of the clan, without saving it.
+ *
+ * Returns: the new member
+ **/
+struct clanmember_data *
+add_clan_member(struct clan_data *clan, long idnum, int rank, bool no_mail)
 {
-    struct clanmember_data *member = NULL;
-    int result = 0;
+    struct clanmember_data *member;
+
+    CREATE(member, struct clanmember_data, 1);
+    member->idnum = idnum;
+    member->rank = rank;
+    member->no_mail = no_mail;
+    link_clanmember(clan, member);
+    g_hash_table_insert(clan->members, GINT_TO_POINTER(idnum), member);
+    clan->member_count++;
+
+    return member;
+}
 
-    for (member = clan->member_list; member; member = member->next)
-        result++;
-    return result;
+/**
+ * enroll_clan_member:
+ * @clan the clan the player is joining
+ * @idnum the idnum of the player
+ *
+ * Adds the player to the clan at the lowest rank.
+ *
+ * Returns: the new member
+ **/
+struct clanmember_data *
+enroll_clan_member(struct clan_data *clan, long idnum)
+{
+    queue_clan_sql("insert into clan_members (clan, player, rank, no_mail) values (%d, %ld, %d, 'f')",
+                   clan->number, idnum, 0);
+    return add_clan_member(clan, idnum, 0, false);
+}
+
+/**
+ * set_clanmember_rank:
+ * @clan the clan of the member
+ * @member the member to be promoted or demoted
+ * @rank the new rank of the member
+ *
+ * Changes the rank of the member, moving them to their place in the
+ * member list.
+ **/
+void
+set_clanmember_rank(struct clan_data *clan, struct clanmember_data *member,
+                    int rank)
+{
+    struct clanmember_data *temp;
+
+    REMOVE_FROM_LIST(member, clan->member_list, next);
+    member->rank = rank;
+    link_clanmember(clan, member);
+    queue_clan_sql("update clan_members set rank=%d where player=%ld",
+                   member->rank, member->idnum);
+}
+
+/**
+ * dismiss_clan_member:
+ * @clan the clan the player is leaving
+ * @idnum the idnum of the player
+ *
+ * Removes the player from the clan.
+ **/
+void
+dismiss_clan_member(struct clan_data *clan, long idnum)
+{
+    struct clanmember_data *member = real_clanmember(idnum, clan);
+
+    if (member)
+        remove_member_from_clan(member, clan);
+    queue_clan_sql("delete from clan_members where player=%ld", idnum);
 }
 
 __attribute__ ((nonnull)) static /*@observer@*/ const char *
@@ -133,7 +265,7 @@ char_can_enroll(struct creature *ch, struct creature *vict,
             "They are frozen right now.  Wait until a god has mercy.\r\n");
     else if (GET_LEVEL(vict) < LVL_CAN_CLAN && GET_REMORT_GEN(vict) == 0)
         send_to_char(ch, "Players must be level 10 before being inducted into the clan.\r\n");
-    else if (clan_member_count(clan) > MAX_CLAN_MEMBERS)
+    else if (clan->member_count > MAX_CLAN_MEMBERS)
         send_to_char(ch,
             "The max number of members has been reached for this clan.\r\n");
     else if (clan->owner == GET_IDNUM(ch))
@@ -221,7 +353,6 @@ ACMD(do_enroll)
 {
     struct creature *vict = NULL;
     struct clan_data *clan = real_clan(GET_CLAN(ch));
-    struct clanmember_data *member = NULL;
     char *msg, *member_str;
 
     member_str = tmp_getword(&argument);
@@ -258,21 +389,12 @@ ACMD(do_enroll)
         msg = tmp_strcat(msg, "\r\n", NULL);
         send_to_clan(msg, GET_CLAN(ch));
         GET_CLAN(vict) = clan->number;
-        CREATE(member, struct clanmember_data, 1);
-        member->idnum = GET_IDNUM(vict);
-        member->rank = 0;
-        member->next = clan->member_list;
-        clan->member_list = member;
-        sort_clanmembers(clan);
-        sql_exec
-            ("insert into clan_members (clan, player, rank, no_mail) values (%d, %ld, %d, 'f')",
-            clan->number, GET_IDNUM(vict), 0);
+        enroll_clan_member(clan, GET_IDNUM(vict));
     }
 }
 
 ACMD(do_join)
 {
-    struct clanmember_data *member = NULL;
     char *msg, *clan_str, *password;
     struct clan_data *clan;
 
@@ -317,7 +439,7 @@ ACMD(do_join)
             return;
         }
 
-        if (clan_member_count(clan) > MAX_CLAN_MEMBERS) {
+        if (clan->member_count > MAX_CLAN_MEMBERS) {
             send_to_char(ch, "The max number of members has been reached for this clan.\r\n");
             return;
         }
@@ -340,21 +462,13 @@ ACMD(do_join)
     send_to_clan(msg, clan->number);
 
     GET_CLAN(ch) = clan->number;
-    CREATE(member, struct clanmember_data, 1);
-    member->idnum = GET_IDNUM(ch);
-    member->rank = 0;
-    member->next = clan->member_list;
-    clan->member_list = member;
-    sort_clanmembers(clan);
-    sql_exec("insert into clan_members (clan, player, rank, no_mail) values (%d, %ld, %d, 'f')",
-             clan->number, GET_IDNUM(ch), 0);
+    enroll_clan_member(clan, GET_IDNUM(ch));
 }
 
 ACMD(do_dismiss)
 {
     struct creature *vict;
     struct clan_data *clan = real_clan(GET_CLAN(ch));
-    struct clanmember_data *member = NULL;
     bool in_file = false;
     long idnum = -1;
     char *arg, *msg;
@@ -403,11 +517,8 @@ ACMD(do_dismiss)
         mudlog(GET_INVIS_LVL(ch), NRM, true, "%s", msg);
         msg = tmp_strcat(msg, "\r\n", NULL);
         send_to_clan(msg, GET_CLAN(ch));
-        if ((member = real_clanmember(GET_IDNUM(vict), clan))) {
-            remove_member_from_clan(member, clan);
-        }
+        dismiss_clan_member(clan, GET_IDNUM(vict));
         REMOVE_BIT(PLR_FLAGS(vict), PLR_CLAN_LEADER);
-        sql_exec("delete from clan_members where player=%ld", GET_IDNUM(vict));
 
         crashsave(vict);
         send_to_char(ch, "Player dismissed.\r\n");
@@ -422,7 +533,6 @@ ACMD(do_resign)
 {
 
     struct clan_data *clan = real_clan(GET_CLAN(ch));
-    struct clanmember_data *member = NULL;
     char *msg;
 
     skip_spaces(&argument);
@@ -441,10 +551,7 @@ ACMD(do_resign)
         REMOVE_BIT(PLR_FLAGS(ch), PLR_CLAN_LEADER);
         if (clan->owner == GET_IDNUM(ch))
             clan->owner = 0;
-        if ((member = real_clanmember(GET_IDNUM(ch), clan))) {
-            remove_member_from_clan(member, clan);
-        }
-        sql_exec("delete from clan_members where player=%ld", GET_IDNUM(ch));
+        dismiss_clan_member(clan, GET_IDNUM(ch));
 
         send_to_char(ch, "You have resigned from clan %s.\r\n", clan->name);
         msg = tmp_sprintf("%s has resigned from clan %s.", GET_NAME(ch),
@@ -484,9 +591,7 @@ ACMD(do_promote)
             crashsave(vict);
         } else {
             // Normal rank promotion
-            vict_member->rank++;
-            sql_exec("update clan_members set rank=%d where player=%ld",
-                vict_member->rank, GET_IDNUM(vict));
+            set_clanmember_rank(clan, vict_member, vict_member->rank + 1);
             msg = tmp_sprintf("%s has promoted %s to clan rank %s (%d)",
                 GET_NAME(ch),
                 (ch == vict) ? "self" : GET_NAME(vict),
@@ -494,7 +599,6 @@ ACMD(do_promote)
             slog("%s", msg);
             msg = tmp_strcat(msg, "\r\n", NULL);
             send_to_clan(msg, clan->number);
-            sort_clanmembers(clan);
         }
     }
 }
@@ -523,16 +627,13 @@ ACMD(do_demote)
             send_to_char(ch,
                 "You are already at the bottom of the totem pole.\r\n");
         } else {
-            member1->rank--;
-            sql_exec("update clan_members set rank=%d where player=%ld",
-                member1->rank, GET_IDNUM(vict));
+            set_clanmember_rank(clan, member1, member1->rank - 1);
             msg = tmp_sprintf("%s has demoted self to clan rank %s (%d)",
                 GET_NAME(ch),
                 clan_rankname(clan, member1->rank), member1->rank);
             slog("%s", msg);
             msg = tmp_strcat(msg, "\r\n", NULL);
             send_to_clan(msg, clan->number);
-            sort_clanmembers(clan);
         }
     } else if (real_clan(GET_CLAN(vict)) != clan) {
         act("$N is not a member of your clan.", false, ch, NULL, vict, TO_CHAR);
@@ -553,16 +654,13 @@ ACMD(do_demote)
             member2->rank = 0;
         }
     } else {
-        member2->rank--;
-        sql_exec("update clan_members set rank=%d where player=%ld",
-            member2->rank, GET_IDNUM(vict));
+        set_clanmember_rank(clan, member2, member2->rank - 1);
         msg = tmp_sprintf("%s has demoted %s to clan rank %s (%d)",
             GET_NAME(ch),
             GET_NAME(vict), clan_rankname(clan, member2->rank), member2->rank);
         slog("%s", msg);
         msg = tmp_strcat(msg, "\r\n", NULL);
         send_to_clan(msg, clan->number);
-        sort_clanmembers(clan);
     }
 }
 
@@ -579,7 +677,7 @@ ACMD(do_clanmail)
         send_to_char(ch, "You are not properly installed in the clan.\r\n");
     else {
         member->no_mail = !member->no_mail;
-        sql_exec("update clan_members set no_mail='%c' where player=%ld",
+        queue_clan_sql("update clan_members set no_mail='%c' where player=%ld",
             (member->no_mail) ? 'T' : 'F', GET_IDNUM(ch));
         if (member->no_mail)
 
@@ -591,106 +689,188 @@ ACMD(do_clanmail)
     }
 }
 
+// Returns the creature shown in clan listings for the playing
+// descriptor
+static struct creature *
+clan_list_shown(struct creature *ch, struct descriptor_data *d)
+{
+    return ((d->original != NULL && GET_LEVEL(ch) > GET_LEVEL(d->original)) ?
+            d->original : d->creature);
+}
+
+// Returns the creature shown in clan listings for the descriptor, if
+// it's one ch can list
+static struct creature *
+clan_list_creature(struct creature *ch, struct descriptor_data *d,
+                   int min_lev)
+{
+    struct creature *i;
+
+    if (!IS_PLAYING(d))
+        return NULL;
+    i = clan_list_shown(ch, d);
+    if (i != NULL
+        && i->in_room != NULL
+        && GET_CLAN(i) == GET_CLAN(ch)
+        && can_see_creature(ch, i)
+        && GET_LEVEL(i) >= min_lev)
+        return i;
+    return NULL;
+}
+
+static void
+acc_print_online_clan_member(struct creature *ch, struct clan_data *clan,
+                             struct clanmember_data *member,
+                             struct descriptor_data *d, struct creature *i)
+{
+    const char *loc_desc, *name_col;
+    char *name;
+
+    name = tmp_strcat(GET_NAME(i), " ",
+        clan_rankname(clan, member->rank), " (online)", NULL);
+
+    if (!check_sight_room(ch, d->creature->in_room)) {
+        loc_desc = "You cannot tell...";
+    } else if (d->creature->in_room->zone != ch->in_room->zone) {
+        loc_desc = d->creature->in_room->zone->name;
+    } else {
+        loc_desc = d->creature->in_room->name;
+    }
+
+    if (GET_LEVEL(i) >= LVL_AMBASSADOR) {
+        name_col = CCGRN(ch, C_NRM);
+    } else if (PLR_FLAGGED(i, PLR_CLAN_LEADER)) {
+        name_col = CCCYN(ch, C_NRM);
+    } else {
+        name_col = "";
+    }
+
+    if (d->original)
+        acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s - %s%s%s %s(in %s)%s\r\n",
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                    GET_LEVEL(i),
+                    char_class_abbrevs[GET_CLASS(i)],
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                    name_col,
+                    name,
+                    (name_col[0] != '\0') ? CCNRM(ch, C_NRM):"",
+                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM),
+                    CCRED(ch, C_CMP), GET_NAME(d->creature), CCNRM(ch, C_CMP));
+    else if (GET_LEVEL(i) >= LVL_AMBASSADOR)
+        acc_sprintf("%s[%s%7s%s]%s %-40s%s - %s%s%s\r\n",
+                    CCYEL_BLD(ch, C_NRM),
+                    CCNRM_GRN(ch, C_SPR),
+                    BADGE(i),
+                    CCYEL_BLD(ch, C_NRM),
+                    CCNRM_GRN(ch, C_SPR), name, CCNRM(ch, C_SPR),
+                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM));
+    else
+        acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s - %s%s%s\r\n",
+                    CCGRN(ch, C_NRM),
+                    CCNRM(ch, C_NRM),
+                    GET_LEVEL(i),
+                    char_class_abbrevs[GET_CLASS(i)],
+                    CCGRN(ch, C_NRM),
+                    CCNRM(ch, C_NRM),
+                    name_col, name, (name_col[0] != '\0') ? CCNRM(ch, C_NRM):"",
+                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM));
+}
+
 static void
+acc_print_offline_clan_member(struct creature *ch, struct clan_data *clan,
+                              struct clanmember_data *member)
+{
+    struct creature *i;
+    char *name;
+
+    i = load_player_from_xml(member->idnum);
+    if (i != NULL) {
+        name = tmp_strcat(GET_NAME(i), " ",
+            clan_rankname(clan, member->rank), NULL);
+
+        if (GET_LEVEL(i) >= LVL_AMBASSADOR)
+            acc_sprintf("%s[%s%s%s]%s %-40s%s\r\n",
+                CCYEL_BLD(ch, C_NRM), CCNRM_GRN(ch, C_SPR),
+                level_abbrevs[GET_LEVEL(i) - LVL_AMBASSADOR],
+                CCYEL_BLD(ch, C_NRM), CCNRM_GRN(ch, C_SPR),
+                name, CCNRM(ch, C_SPR));
+        else
+            acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s\r\n",
+                        CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                        GET_LEVEL(i),
+                        char_class_abbrevs[GET_CLASS(i)],
+                        CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                        (PLR_FLAGGED(i, PLR_CLAN_LEADER) ? CCCYN(ch, C_NRM) : ""),
+                        name,
+                        CCNRM(ch, C_NRM));
+        free_creature(i);
+    }
+}
+
+/**
+ * acc_print_clan_members:
+ * @ch the character requesting the listing
+ * @clan the clan to be listed
+ * @complete %true to list members who aren't online
+ * @min_lev the lowest level of member to list
+ *
+ * Lists the members of the clan in rank order, finding the online
+ * members with a single pass over the descriptors.
+ **/
+void
 acc_print_clan_members(struct creature *ch, struct clan_data *clan,
     bool complete, int min_lev)
+{
+    GHashTable *online = g_hash_table_new(g_direct_hash, g_direct_equal);
+    struct clanmember_data *member = NULL;
+    struct descriptor_data *d;
+    struct creature *i;
+
+    for (d = descriptor_list; d != NULL; d = d->next) {
+        i = clan_list_creature(ch, d, min_lev);
+        if (i && !g_hash_table_lookup(online, GINT_TO_POINTER(GET_IDNUM(i))))
+            g_hash_table_insert(online, GINT_TO_POINTER(GET_IDNUM(i)), d);
+    }
+
+    for (member = clan->member_list; member; member = member->next) {
+        d = g_hash_table_lookup(online, GINT_TO_POINTER(member->idnum));
+        if (d)
+            acc_print_online_clan_member(ch, clan, member, d,
+                                         clan_list_creature(ch, d, min_lev));
+        else if (complete)
+            acc_print_offline_clan_member(ch, clan, member);
+    }
+    g_hash_table_destroy(online);
+}
+
+/**
+ * acc_print_clan_members_scan:
+ *
+ * Lists the members of the clan like acc_print_clan_members(), looking
+ * through every descriptor for each member.
+ **/
+void
+acc_print_clan_members_scan(struct creature *ch, struct clan_data *clan,
+    bool complete, int min_lev)
 {
     struct creature *i;
     struct clanmember_data *member = NULL;
     struct descriptor_data *d;
-    char *name;
 
     for (member = clan->member_list; member; member = member->next) {
         bool found = false;
         for (d = descriptor_list; d != NULL && !found; d = d->next) {
-            if (IS_PLAYING(d)) {
-                i = ((d->original != NULL && GET_LEVEL(ch) > GET_LEVEL(d->original)) ?
-                    d->original : d->creature);
-                if (i != NULL
-                    && i->in_room != NULL
-                    && GET_CLAN(i) == GET_CLAN(ch)
-                    && GET_IDNUM(i) == member->idnum
-                    && can_see_creature(ch, i)
-                    && GET_LEVEL(i) >= min_lev) {
-                    name = tmp_strcat(GET_NAME(i), " ",
-                        clan_rankname(clan, member->rank), " (online)", NULL);
-
-                    const char *loc_desc, *name_col;
-
-                    if (!check_sight_room(ch, d->creature->in_room)) {
-                        loc_desc = "You cannot tell...";
-                    } else if (d->creature->in_room->zone != ch->in_room->zone) {
-                        loc_desc = d->creature->in_room->zone->name;
-                    } else {
-                        loc_desc = d->creature->in_room->name;
-                    }
-
-                    if (GET_LEVEL(i) >= LVL_AMBASSADOR) {
-                        name_col = CCGRN(ch, C_NRM);
-                    } else if (PLR_FLAGGED(i, PLR_CLAN_LEADER)) {
-                        name_col = CCCYN(ch, C_NRM);
-                    } else {
-                        name_col = "";
-                    }
-
-                    if (d->original)
-                        acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s - %s%s%s %s(in %s)%s\r\n",
-                                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                                    GET_LEVEL(i),
-                                    char_class_abbrevs[GET_CLASS(i)],
-                                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                                    name_col,
-                                    name,
-                                    (name_col[0] != '\0') ? CCNRM(ch, C_NRM):"",
-                                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM),
-                                    CCRED(ch, C_CMP), GET_NAME(d->creature), CCNRM(ch, C_CMP));
-                    else if (GET_LEVEL(i) >= LVL_AMBASSADOR)
-                        acc_sprintf("%s[%s%7s%s]%s %-40s%s - %s%s%s\r\n",
-                                    CCYEL_BLD(ch, C_NRM),
-                                    CCNRM_GRN(ch, C_SPR),
-                                    BADGE(i),
-                                    CCYEL_BLD(ch, C_NRM),
-                                    CCNRM_GRN(ch, C_SPR), name, CCNRM(ch, C_SPR),
-                                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM));
-                    else
-                        acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s - %s%s%s\r\n",
-                                    CCGRN(ch, C_NRM),
-                                    CCNRM(ch, C_NRM),
-                                    GET_LEVEL(i),
-                                    char_class_abbrevs[GET_CLASS(i)],
-                                    CCGRN(ch, C_NRM),
-                                    CCNRM(ch, C_NRM),
-                                    name_col, name, (name_col[0] != '\0') ? CCNRM(ch, C_NRM):"",
-                                    CCCYN(ch, C_NRM), loc_desc, CCNRM(ch, C_NRM));
-
-                    found = true;
-                }
-            }
-        }
-        if (complete && !found) {
-            i = load_player_from_xml(member->idnum);
-            if (i != NULL) {
-                name = tmp_strcat(GET_NAME(i), " ",
-                    clan_rankname(clan, member->rank), NULL);
-
-                if (GET_LEVEL(i) >= LVL_AMBASSADOR)
-                    acc_sprintf("%s[%s%s%s]%s %-40s%s\r\n",
-                        CCYEL_BLD(ch, C_NRM), CCNRM_GRN(ch, C_SPR),
-                        level_abbrevs[GET_LEVEL(i) - LVL_AMBASSADOR],
-                        CCYEL_BLD(ch, C_NRM), CCNRM_GRN(ch, C_SPR),
-                        name, CCNRM(ch, C_SPR));
-                else
-                    acc_sprintf("%s[%s%2d %s%s]%s %s%-40s%s\r\n",
-                                CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                                GET_LEVEL(i),
-                                char_class_abbrevs[GET_CLASS(i)],
-                                CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                                (PLR_FLAGGED(i, PLR_CLAN_LEADER) ? CCCYN(ch, C_NRM) : ""),
-                                name,
-                                CCNRM(ch, C_NRM));
-                free_creature(i);
+            if (!IS_PLAYING(d))
+                continue;
+            i = clan_list_shown(ch, d);
+            if (i != NULL && GET_IDNUM(i) == member->idnum
+                && clan_list_creature(ch, d, min_lev)) {
+                acc_print_online_clan_member(ch, clan, member, d, i);
+                found = true;
             }
         }
+        if (complete && !found)
+            acc_print_offline_clan_member(ch, clan, member);
     }
 }
 
@@ -734,7 +914,6 @@ ACMD(do_cinfo)
 {
 
     struct clan_data *clan = real_clan(GET_CLAN(ch));
-    struct clanmember_data *member;
     struct room_list_elem *rm_list = NULL;
     bool found = false;
     int i;
@@ -745,14 +924,12 @@ ACMD(do_cinfo)
     }
 
     acc_string_clear();
-    for (i = 0, member = clan->member_list; member; member = member->next)
-        i++;
     acc_sprintf("Information on clan %s%s%s:\r\n\r\n"
                 "Clan badge: '%s%s%s', Clan headcount: %d, "
                 "Clan bank account: %'" PRId64 "\r\nClan ranks:\r\n",
                 CCCYN(ch, C_NRM), clan->name, CCNRM(ch, C_NRM),
                 CCCYN(ch, C_NRM), clan->badge, CCNRM(ch, C_NRM),
-                i, clan->bank_account);
+                clan->member_count, clan->bank_account);
     for (i = clan->top_rank; i >= 0; i--) {
         acc_sprintf(" (%2d)  %s%s%s\r\n", i, CCYEL(ch, C_NRM),
                     clan_rankname(clan, i), CCNRM(ch, C_NRM));
@@ -798,8 +975,8 @@ ACMD(do_clanpasswd)
 
     free(clan->password);
     clan->password = strdup(argument);
-    sql_exec("update clans set password='%s' where idnum=%d",
-             tmp_sqlescape(clan->password), clan->number);
+    queue_clan_sql("update clans set password='%s' where idnum=%d",
+                   tmp_sqlescape(clan->password), clan->number);
     slog("%s set clan %d password to '%s'.",
          GET_NAME(ch), clan->number, clan->password);
     send_to_char(ch, "Clan password set to '%s'.\r\n", argument);
@@ -808,16 +985,10 @@ ACMD(do_clanpasswd)
 struct clan_data *
 real_clan(int vnum)
 {
-    struct clan_data *clan = NULL;
-
-    if (!(vnum))
+    if (!(vnum) || !clan_map)
         return NULL;
 
-    for (clan = clan_list; clan; clan = clan->next)
-        if (clan->number == vnum)
-            return (clan);
-
-    return (NULL);
+    return g_hash_table_lookup(clan_map, GINT_TO_POINTER(vnum));
 }
 
 struct clan_data *
@@ -854,14 +1025,8 @@ clan_by_name(char *arg)
 struct clanmember_data *
 real_clanmember(long idnum, struct clan_data *clan)
 {
-
-    struct clanmember_data *member;
-    for (member = clan->member_list; member; member = member->next)
-        if (member->idnum == idnum)
-            return (member);
-
-    return (NULL);
-};
+    return g_hash_table_lookup(clan->members, GINT_TO_POINTER(idnum));
+}
 
 typedef struct cedit_command_data {
     const char *keyword;
@@ -1002,7 +1167,7 @@ ACMD(do_cedit)
                 free(clan->name);
             }
             clan->name = strdup(argument);
-            sql_exec("update clans set name='%s' where idnum=%d",
+            queue_clan_sql("update clans set name='%s' where idnum=%d",
                 clan->name, clan->number);
             slog("(cedit) %s set clan %d name to '%s'.", GET_NAME(ch),
                 clan->number, clan->name);
@@ -1019,7 +1184,7 @@ ACMD(do_cedit)
                 free(clan->badge);
             }
             clan->badge = strdup(argument);
-            sql_exec("update clans set badge='%s' where idnum=%d",
+            queue_clan_sql("update clans set badge='%s' where idnum=%d",
                 tmp_sqlescape(clan->badge), clan->number);
             slog("(cedit) %s set clan %d badge to '%s'.", GET_NAME(ch),
                 clan->number, clan->badge);
@@ -1036,8 +1201,8 @@ ACMD(do_cedit)
                 free(clan->password);
             }
             clan->password = strdup(argument);
-            sql_exec("update clans set password='%s' where idnum=%d",
-                     tmp_sqlescape(clan->password), clan->number);
+            queue_clan_sql("update clans set password='%s' where idnum=%d",
+                           tmp_sqlescape(clan->password), clan->number);
             slog("(cedit) %s set clan %d password to '%s'.", GET_NAME(ch),
                  clan->number, clan->password);
 
@@ -1074,10 +1239,10 @@ ACMD(do_cedit)
                 for (member = clan->member_list; member; member = member->next)
                     if (member->rank > clan->top_rank)
                         member->rank = clan->top_rank;
-                sql_exec
+                queue_clan_sql
                     ("update clan_members set rank=%d where clan=%d and rank > %d",
                     clan->top_rank, clan->number, clan->top_rank);
-                sql_exec("delete from clan_ranks where clan=%d and rank > %d",
+                queue_clan_sql("delete from clan_ranks where clan=%d and rank > %d",
                     clan->number, clan->top_rank);
 
                 slog("(cedit) %s set clan %d top to %d.", GET_NAME(ch),
@@ -1105,11 +1270,11 @@ ACMD(do_cedit)
             }
             if (clan->ranknames[i]) {
                 free(clan->ranknames[i]);
-                sql_exec
+                queue_clan_sql
                     ("update clan_ranks set title='%s' where clan=%d and rank=%d",
                     tmp_sqlescape(argument), clan->number, i);
             } else {
-                sql_exec
+                queue_clan_sql
                     ("insert into clan_ranks (clan, rank, title) values (%d, %d, '%s')",
                     clan->number, i, tmp_sqlescape(argument));
             }
@@ -1145,7 +1310,7 @@ ACMD(do_cedit)
             send_to_char(ch, "Clan bank account set from %" PRId64 " to %" PRId64 "\r\n",
                 clan->bank_account, money);
             clan->bank_account = money;
-            sql_exec("update clans set bank=%" PRId64 " where idnum=%d",
+            queue_clan_sql("update clans set bank=%" PRId64 " where idnum=%d",
                 money, clan->number);
 
             return;
@@ -1167,7 +1332,7 @@ ACMD(do_cedit)
             send_to_char(ch, "Clan owner set.\r\n");
             slog("(cedit) %s set clan %d owner to %s.", GET_NAME(ch),
                 clan->number, argument);
-            sql_exec("update clans set owner=%d where idnum=%d",
+            queue_clan_sql("update clans set owner=%d where idnum=%d",
                 i, clan->number);
             return;
         }
@@ -1200,18 +1365,17 @@ ACMD(do_cedit)
 
             j = atoi(arg1);
 
-            sql_exec("update clan_members set rank=%d where player=%d", j, i);
-            for (member = clan->member_list; member; member = member->next)
-                if (member->idnum == i) {
-                    member->rank = j;
-                    send_to_char(ch, "Member rank set.\r\n");
-                    slog("(cedit) %s set clan %d member %d rank to %d.",
-                        GET_NAME(ch), clan->number, i, member->rank);
-                    break;
-                }
-
-            if (!member)
+            member = real_clanmember(i, clan);
+            if (member) {
+                set_clanmember_rank(clan, member, j);
+                send_to_char(ch, "Member rank set.\r\n");
+                slog("(cedit) %s set clan %d member %d rank to %d.",
+                    GET_NAME(ch), clan->number, i, member->rank);
+            } else {
+                queue_clan_sql("update clan_members set rank=%d where player=%d",
+                               j, i);
                 send_to_char(ch, "Unable to find that member.\r\n");
+            }
             return;
 
         } else {
@@ -1270,7 +1434,7 @@ ACMD(do_cedit)
 
             slog("(cedit) %s added room %d to clan %d.", GET_NAME(ch),
                 room->number, clan->number);
-            sql_exec("insert into clan_rooms (clan, room) values (%d, %d)",
+            queue_clan_sql("insert into clan_rooms (clan, room) values (%d, %d)",
                 clan->number, room->number);
 
             return;
@@ -1287,27 +1451,17 @@ ACMD(do_cedit)
                 send_to_char(ch, "Real funny... reeeeeaaal funny.\r\n");
                 return;
             }
-            for (member = clan->member_list; member; member = member->next) {
-                if (member->idnum == i) {
-                    send_to_char(ch,
-                        "That player is already on the member list.\r\n");
-                    return;
-                }
+            if (real_clanmember(i, clan)) {
+                send_to_char(ch,
+                    "That player is already on the member list.\r\n");
+                return;
             }
-            CREATE(member, struct clanmember_data, 1);
-
-            member->idnum = i;
-            member->rank = 0;
-            member->next = clan->member_list;
-            clan->member_list = member;
+            member = enroll_clan_member(clan, i);
 
             send_to_char(ch, "Clan member added to list.\r\n");
 
             slog("(cedit) %s added member %ld to clan %d.",
                 GET_NAME(ch), member->idnum, clan->number);
-            sql_exec
-                ("insert into clan_members (clan, player, rank, no_mail) values (%d, %d, 0, 'f')",
-                clan->number, i);
 
             return;
         } else {
@@ -1354,7 +1508,7 @@ ACMD(do_cedit)
 
             slog("(cedit) %s removed room %d from clan %d.",
                 GET_NAME(ch), room->number, clan->number);
-            sql_exec("delete from clan_rooms where clan=%d and room=%d",
+            queue_clan_sql("delete from clan_rooms where clan=%d and room=%d",
                 clan->number, room->number);
 
             return;
@@ -1372,10 +1526,7 @@ ACMD(do_cedit)
                 send_to_char(ch, "Real funny... reeeeeaaal funny.\r\n");
                 return;
             }
-            for (member = clan->member_list; member; member = member->next)
-                if (member->idnum == i)
-                    break;
-
+            member = real_clanmember(i, clan);
             if (!member) {
                 send_to_char(ch,
                     "That player is not a part of this clan.\r\n");
@@ -1383,12 +1534,11 @@ ACMD(do_cedit)
             }
 
             remove_member_from_clan(member, clan);
-            free(member);
             send_to_char(ch, "Member removed from the sacred list.\r\n");
 
             slog("(cedit) %s removed member %d from clan %d.",
                 GET_NAME(ch), i, clan->number);
-            sql_exec("delete from clan_members where clan=%d and player=%d",
+            queue_clan_sql("delete from clan_members where clan=%d and player=%d",
                 clan->number, i);
 
             return;
@@ -1419,8 +1569,7 @@ ACMD(do_cedit)
 bool
 boot_clans(void)
 {
-    struct clan_data *clan, *tmp_clan;
-    struct clanmember_data *member;
+    struct clan_data *clan, *last_clan = NULL;
     struct room_list_elem *rm_list;
     struct room_data *room;
     PGresult *res;
@@ -1428,6 +1577,9 @@ boot_clans(void)
 
     slog("Reading clans");
 
+    if (!clan_map)
+        clan_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+
     res = sql_query("select idnum, name, badge, password, bank, owner from clans");
     count = PQntuples(res);
     if (count == 0) {
@@ -1445,18 +1597,20 @@ boot_clans(void)
         clan->bank_account = atoll(PQgetvalue(res, idx, 4));
         clan->owner = atoi(PQgetvalue(res, idx, 5));
         clan->member_list = NULL;
+        clan->members = g_hash_table_new(g_direct_hash, g_direct_equal);
         clan->room_list = NULL;
         clan->next = NULL;
 
-        if (!clan_list)
+        if (!last_clan)
+            for (last_clan = clan_list; last_clan && last_clan->next;
+                 last_clan = last_clan->next)
+                ;
+        if (!last_clan)
             clan_list = clan;
-        else {
-            for (tmp_clan = clan_list; tmp_clan; tmp_clan = tmp_clan->next)
-                if (!tmp_clan->next) {
-                    tmp_clan->next = clan;
-                    break;
-                }
-        }
+        else
+            last_clan->next = clan;
+        last_clan = clan;
+        g_hash_table_insert(clan_map, GINT_TO_POINTER(clan->number), clan);
     }
 
     // Add the ranks to the clan
@@ -1469,25 +1623,17 @@ boot_clans(void)
         clan->ranknames[num] = strdup(PQgetvalue(res, idx, 2));
     }
 
-    // Now add all the members to the clans
+    // Now add all the members to the clans.  Each member outranks the
+    // ones before, so goes to the front of the member list.
     res =
         sql_query
         ("select clan, player, rank, no_mail from clan_members order by rank");
     count = PQntuples(res);
     for (idx = 0; idx < count; idx++) {
-        CREATE(member, struct clanmember_data, 1);
-        member->idnum = atol(PQgetvalue(res, idx, 1));
-        member->rank = atol(PQgetvalue(res, idx, 2));
-        member->no_mail = (strcmp(PQgetvalue(res, idx, 3), "t") == 0);
-        member->next = NULL;
-
         clan = real_clan(atol(PQgetvalue(res, idx, 0)));
-        if (!clan->member_list)
-            clan->member_list = member;
-        else {
-            member->next = clan->member_list;
-            clan->member_list = member;
-        }
+        add_clan_member(clan, atol(PQgetvalue(res, idx, 1)),
+                        atol(PQgetvalue(res, idx, 2)),
+                        (strcmp(PQgetvalue(res, idx, 3), "t") == 0));
     }
 
     // Add rooms to the clans
@@ -1527,9 +1673,14 @@ create_clan(int vnum)
         newclan->ranknames[i] = NULL;
 
     newclan->member_list = NULL;
+    newclan->members = g_hash_table_new(g_direct_hash, g_direct_equal);
     newclan->room_list = NULL;
     newclan->next = NULL;
 
+    if (!clan_map)
+        clan_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(clan_map, GINT_TO_POINTER(vnum), newclan);
+
     if (!clan_list || newclan->number < clan_list->number) {
         newclan->next = clan_list;
         clan_list = newclan;
@@ -1543,7 +1694,7 @@ create_clan(int vnum)
             }
     }
 
-    sql_exec
+    queue_clan_sql
         ("insert into clans (idnum, name, badge, password, bank) values (%d, 'New', '(//NEW\\\\)', '', 0)",
         newclan->number);
     return (newclan);
@@ -1579,6 +1730,7 @@ delete_clan(struct clan_data *clan)
         if (!tmp_clan)
             return 1;
     }
+    g_hash_table_remove(clan_map, GINT_TO_POINTER(clan->number));
 
     free(clan->name);
     free(clan->badge);
@@ -1590,15 +1742,16 @@ delete_clan(struct clan_data *clan)
         clan->member_list = member->next;
         free(member);
     }
+    g_hash_table_destroy(clan->members);
 
     for (rm_list = clan->room_list; rm_list; rm_list = clan->room_list) {
         clan->room_list = rm_list->next;
         free(rm_list);
     }
-    sql_exec("delete from clan_rooms where clan=%d", clan->number);
-    sql_exec("delete from clan_members where clan=%d", clan->number);
-    sql_exec("delete from clan_ranks where clan=%d", clan->number);
-    sql_exec("delete from clans where idnum=%d", clan->number);
+    queue_clan_sql("delete from clan_rooms where clan=%d", clan->number);
+    queue_clan_sql("delete from clan_members where clan=%d", clan->number);
+    queue_clan_sql("delete from clan_ranks where clan=%d", clan->number);
+    queue_clan_sql("delete from clans where idnum=%d", clan->number);
 
     g_list_foreach(creatures, (GFunc)notify_clan_disbanding, clan);
 
@@ -1642,9 +1795,9 @@ do_show_clan(struct creature *ch, struct clan_data *clan)
         if (!num_rooms)
             acc_strcat("None.\r\n", NULL);
 
-        num_members = clan_member_count(clan);
+        num_members = clan->member_count;
         if (num_members) {
-            acc_sprintf("%d MEMBERS:\r\n", clan_member_count(clan));
+            acc_sprintf("%d MEMBERS:\r\n", num_members);
 
             for (member = clan->member_list; member; member = member->next) {
                 int acct_id = player_account_by_idnum(member->idnum);
@@ -1664,18 +1817,11 @@ do_show_clan(struct creature *ch, struct clan_data *clan)
     } else {
         acc_strcat("CLANS:\r\n", NULL);
         for (clan = clan_list; clan; clan = clan->next) {
-
-            member = clan->member_list;
-            num_members = 0;
-            while (member) {
-                num_members++;
-                member = member->next;
-            }
-
             acc_sprintf(" %3d - %s%20s%s  %s%20s%s  (%3d members)\r\n",
                 clan->number,
                 CCCYN(ch, C_NRM), clan->name, CCNRM(ch, C_NRM),
-                CCCYN(ch, C_NRM), clan->badge, CCNRM(ch, C_NRM), num_members);
+                CCCYN(ch, C_NRM), clan->badge, CCNRM(ch, C_NRM),
+                clan->member_count);
         }
     }
     page_string(ch->desc, acc_get_string());
@@ -1760,7 +1906,10 @@ clear_clan_owner(long idnum)
             clan->owner = 0;
 
     // Clear the owner of any clans this player might own on the db
-    sql_exec("update clans set owner=null where owner=%ld", idnum);
+    queue_clan_sql("update clans set owner=null where owner=%ld", idnum);
+
+    // The player is about to be deleted from the database
+    flush_clan_sql();
 }
 
 void
@@ -1768,13 +1917,12 @@ remove_char_clan(int clan_idnum, long ch_idnum)
 {
     // Remove character from clan
     struct clan_data *clan = real_clan(clan_idnum);
-    if (clan) {
-        struct clanmember_data *member, *temp;
+    struct clanmember_data *member;
 
-        member = real_clanmember(ch_idnum, clan);
-        if (member) {
-            REMOVE_FROM_LIST(member, clan->member_list, next);
-        }
-    }
-    sql_exec("delete from clan_members where player=%ld", ch_idnum);
+    if (clan && (member = real_clanmember(ch_idnum, clan)))
+        remove_member_from_clan(member, clan);
+    queue_clan_sql("delete from clan_members where player=%ld", ch_idnum);
+
+    // The player is about to be deleted from the database
+    flush_clan_sql();
 }
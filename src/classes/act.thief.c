@@ -293,6 +293,7 @@ ACMD(do_steal)
         GET_REMORT_GEN(ch) > GET_REMORT_GEN(vict) &&
         GET_INVIS_LVL(ch) > GET_LEVEL(vict)) {
         GET_INVIS_LVL(ch) = GET_LEVEL(vict);
+        invalidate_sight();
         send_to_char(ch, "You feel a bit more visible.\n");
     }
 
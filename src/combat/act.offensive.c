@@ -2845,6 +2845,7 @@ ACMD(do_ceasefire)
         act("$n stops attacking you.", false, ch, NULL, f, TO_VICT);
         g_list_free(ch->fighting);
         ch->fighting = NULL;
+        remove_combatant(ch);
         WAIT_STATE(ch, 2 RL_SEC);
     }
 }
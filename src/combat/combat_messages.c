@@ -106,6 +106,7 @@ appear(struct creature *ch, struct creature *vict)
         GET_REMORT_GEN(ch) > GET_REMORT_GEN(vict) &&
         GET_INVIS_LVL(ch) > GET_LEVEL(vict)) {
         GET_INVIS_LVL(ch) = GET_LEVEL(vict);
+        invalidate_sight();
         send_to_char(ch, "You feel a bit more visible.\n");
         found = true;
     }
@@ -3150,7 +3150,7 @@ perform_violence1(struct creature *ch, gpointer ignore __attribute__((unused)))
 void
 perform_violence(void)
 {
-    g_list_foreach(creatures, (GFunc) perform_violence1, NULL);
+    foreach_combatant((GFunc) perform_violence1, NULL);
 }
 
 
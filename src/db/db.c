@@ -21,10 +21,12 @@
 #define __db_c__
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <time.h>
 #include <glib.h>
 
 #include "interpreter.h"
@@ -65,6 +67,8 @@
 #include "voice.h"
 #include "olc.h"
 #include "strutil.h"
+#include "world_image.h"
+#include "memstat.h"
 
 #define ZONE_ERROR(message) \
 { zerrlog(state->zone, "%s (cmd %c, num %d)", message, zonecmd->command, zonecmd->line); state->last_cmd = 0; }
@@ -170,12 +174,46 @@ PGconn *sql_cxn = NULL;
 struct sql_query_data *sql_query_list = NULL;
 
 /* local functions */
-void setup_dir(FILE * fl, struct room_data *room, int dir);
+/*
+ * Records parsed from a single wld, mob, or obj file.  Parsing only
+ * fills in the staging structure, so that files may be parsed on
+ * worker threads; merge_boot_file() then adds the records to the
+ * world on the main thread.
+ */
+struct boot_file {
+    int mode;
+    char *path;
+    GList *records;             // staged rooms, mobs, or objs, in file order
+    GList *warnings;            // non-fatal messages, logged at merge
+    char *error;                // the error that stopped parsing, if any
+    char context[256];          // record being parsed, for error messages
+};
+
+// A parsed room and the zone whose room list it belongs on
+struct staged_room {
+    struct room_data *room;
+    struct zone_data *zone;
+};
+
+int boot_threads = 1;
+
+void setup_dir(FILE * fl, struct room_data *room, int dir,
+    struct boot_file *bf);
 void index_boot(int mode);
+void index_boot_parallel(void);
+void create_null_mob_shared(void);
+void create_null_obj_shared(void);
 void discrete_load(FILE * fl, int mode);
-void parse_room(FILE * fl, int vnum_nr);
-void parse_mobile(FILE * mob_f, int nr);
-char *parse_object(FILE * obj_f, int nr);
+void parse_boot_file(FILE * fl, struct boot_file *bf);
+void merge_boot_file(struct boot_file *bf);
+void parse_room(FILE * fl, int vnum_nr, struct boot_file *bf);
+void parse_mobile(FILE * mob_f, int nr, struct boot_file *bf);
+char *parse_object(FILE * obj_f, int nr, char *line, size_t line_size,
+    struct boot_file *bf);
+static char *fread_boot_string(FILE * fl, struct boot_file *bf);
+static bool report_boot_error(struct boot_file *bf);
+static int read_tilde_string(FILE * fl, char *str, size_t buf_size,
+    bool comments);
 void load_zones(FILE * fl, char *zonename);
 void assign_mobiles(void);
 void assign_objects(void);
@@ -294,6 +332,30 @@ ACMD(do_reboot)
         "%s has reloaded %s file", GET_NAME(ch), arg);
 }
 
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+static const char *boot_phase_name = NULL;
+static struct timespec boot_phase_start;
+
+/*
+ * Logs the time taken by the current boot phase, if any, and starts
+ * timing the named phase.  Pass NULL to end the last phase.
+ */
+static void
+boot_phase(const char *name)
+{
+    struct timespec now, elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (boot_phase_name) {
+        elapsed = timediff(&now, &boot_phase_start);
+        slog("Boot phase '%s' took %ld.%03lds.", boot_phase_name,
+            (long)elapsed.tv_sec, elapsed.tv_nsec / 1000000);
+    }
+    boot_phase_name = name;
+    boot_phase_start = now;
+}
+
 void
 boot_world(void)
 {
@@ -302,26 +364,60 @@ boot_world(void)
     obj_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
     creature_map = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-    slog("Loading zone table.");
-    index_boot(DB_BOOT_ZON);
+    if (use_world_image)
+        boot_phase("world image");
+    if (use_world_image && world_image_scan_sources()
+        && load_world_image()) {
+        slog("Loaded zones, rooms, mobs, and objs from world image.");
+        create_null_mob_shared();
+        create_null_obj_shared();
+
+        boot_phase("renumber rooms");
+        slog("Renumbering rooms.");
+        renum_world();
+
+        boot_phase("start rooms");
+        slog("Checking start rooms.");
+        check_start_rooms();
+    } else if (boot_threads > 1) {
+        boot_phase("zones");
+        slog("Loading zone table.");
+        index_boot(DB_BOOT_ZON);
+
+        // index_boot_parallel() times its own phases
+        boot_phase(NULL);
+        slog("Loading rooms, mobs, and objs with %d threads.", boot_threads);
+        index_boot_parallel();
+    } else {
+        boot_phase("zones");
+        slog("Loading zone table.");
+        index_boot(DB_BOOT_ZON);
 
-    slog("Loading rooms.");
-    index_boot(DB_BOOT_WLD);
+        boot_phase("rooms");
+        slog("Loading rooms.");
+        index_boot(DB_BOOT_WLD);
 
-    slog("Renumbering rooms.");
-    renum_world();
+        boot_phase("renumber rooms");
+        slog("Renumbering rooms.");
+        renum_world();
 
-    slog("Checking start rooms.");
-    check_start_rooms();
+        boot_phase("start rooms");
+        slog("Checking start rooms.");
+        check_start_rooms();
 
-    slog("Loading mobs and generating index.");
-    index_boot(DB_BOOT_MOB);
+        boot_phase("mobs");
+        slog("Loading mobs and generating index.");
+        index_boot(DB_BOOT_MOB);
 
-    slog("Loading objs and generating index.");
-    index_boot(DB_BOOT_OBJ);
+        boot_phase("objs");
+        slog("Loading objs and generating index.");
+        index_boot(DB_BOOT_OBJ);
+    }
 
+    boot_phase("renumber zones");
     slog("Renumbering zone table.");
     renum_zone_table();
+    boot_phase(NULL);
 
     /* for quad damage bamfing */
     if (!(default_quad_zone = real_zone(25)))
@@ -432,6 +528,11 @@ boot_db(void)
     slog("Compiling progs.");
     compile_all_progs();
 
+    if (use_world_image && !world_image_loaded) {
+        slog("Writing world image.");
+        save_world_image();
+    }
+
     slog("Reading banned site, invalid-name, and NASTY word lists.");
     load_banned();
     Read_Invalid_List();
@@ -455,9 +556,12 @@ boot_db(void)
 
     if (!no_initial_zreset) {
         for (zone = zone_table; zone; zone = zone->next) {
+            struct tmp_mark mark = tmp_mark();
+
             slog("Resetting %s (rms %d-%d).",
                 zone->name, zone->number * 100, zone->top);
             reset_zone(zone);
+            tmp_release(mark);
         }
     }
 
@@ -560,33 +664,62 @@ count_hash_records(FILE * fl)
 }
 
 void
-index_boot(int mode)
+create_null_mob_shared(void)
 {
-    const char *index_filename;
-    const char *index_path;
-    const char *prefix = NULL;
-    const char *file_path;
-    FILE *index, *db_file;
-    int rec_count = 0, index_count = 0, number = 9, i;
+    CREATE(null_mob_shared, struct mob_shared_data, 1);
+    null_mob_shared->vnum = -1;
+    null_mob_shared->number = 0;
+    null_mob_shared->func = NULL;
+    null_mob_shared->proto = NULL;
+    null_mob_shared->move_buf = NULL;
+}
+
+void
+create_null_obj_shared(void)
+{
+    CREATE(null_obj_shared, struct obj_shared_data, 1);
+    null_obj_shared->vnum = -1;
+    null_obj_shared->number = 0;
+    null_obj_shared->house_count = 0;
+    null_obj_shared->func = NULL;
+    null_obj_shared->proto = NULL;
+}
 
+static const char *
+boot_prefix(int mode)
+{
     switch (mode) {
     case DB_BOOT_WLD:
-        prefix = WLD_PREFIX;
-        break;
+        return WLD_PREFIX;
     case DB_BOOT_MOB:
-        prefix = NPC_PREFIX;
-        break;
+        return NPC_PREFIX;
     case DB_BOOT_OBJ:
-        prefix = OBJ_PREFIX;
-        break;
+        return OBJ_PREFIX;
     case DB_BOOT_ZON:
-        prefix = ZON_PREFIX;
-        break;
+        return ZON_PREFIX;
     default:
         errlog("Unknown subcommand to index_boot!");
         safe_exit(1);
-        break;
     }
+    return NULL;
+}
+
+/*
+ * Reads the index file for the given boot mode, verifying that each
+ * file it lists exists, and builds the matching wld, mob, or obj
+ * index.  Returns a list of the paths of the listed files, in index
+ * order, which must be freed by the caller.
+ */
+static GList *
+read_boot_index(int mode)
+{
+    const char *index_filename;
+    const char *index_path;
+    const char *prefix = boot_prefix(mode);
+    const char *file_path;
+    FILE *index, *db_file;
+    GList *paths = NULL;
+    int rec_count = 0, index_count = 0, number = 9, i;
 
     if (mini_mud)
         index_filename = MINDEX_FILE;
@@ -621,6 +754,7 @@ index_boot(int mode)
             rec_count += count_hash_records(db_file);
         index_count++;
         fclose(db_file);
+        paths = g_list_prepend(paths, g_strdup(file_path));
         if (fscanf(index, "%s\n", line) != 1) {
             errlog("Format error reading %s, line %d", index_path,
                 index_count + 1);
@@ -637,21 +771,11 @@ index_boot(int mode)
     case DB_BOOT_WLD:
         break;
     case DB_BOOT_MOB:
-        CREATE(null_mob_shared, struct mob_shared_data, 1);
-        null_mob_shared->vnum = -1;
-        null_mob_shared->number = 0;
-        null_mob_shared->func = NULL;
-        null_mob_shared->proto = NULL;
-        null_mob_shared->move_buf = NULL;
+        create_null_mob_shared();
         break;
 
     case DB_BOOT_OBJ:
-        CREATE(null_obj_shared, struct obj_shared_data, 1);
-        null_obj_shared->vnum = -1;
-        null_obj_shared->number = 0;
-        null_obj_shared->house_count = 0;
-        null_obj_shared->func = NULL;
-        null_obj_shared->proto = NULL;
+        create_null_obj_shared();
         break;
 
     case DB_BOOT_ZON:
@@ -697,14 +821,22 @@ index_boot(int mode)
             wld_index[index_count] = -1;
     }
 
-    rewind(index);
+    fclose(index);
+
+    return g_list_reverse(paths);
+}
+
+void
+index_boot(int mode)
+{
+    GList *paths, *it;
+    FILE *db_file;
+
+    paths = read_boot_index(mode);
+
+    for (it = paths; it; it = it->next) {
+        const char *file_path = it->data;
 
-    if (fscanf(index, "%s\n", line) != 1) {
-        errlog("Format error reading %s", index_path);
-        safe_exit(1);
-    }
-    while (*line != '$') {
-        file_path = tmp_sprintf("%s/%s", prefix, line);
         db_file = fopen(file_path, "r");
         if (!db_file) {
             perror(tmp_sprintf("Unable to open: %s", file_path));
@@ -721,18 +853,149 @@ index_boot(int mode)
             break;
         }
         fclose(db_file);
-        if (fscanf(index, "%s\n", line) != 1) {
-            errlog("Format error reading %s", index_path);
-            safe_exit(1);
-        }
     }
 
-    fclose(index);
+    g_list_free_full(paths, g_free);
+}
+
+/*
+ * Worker thread entry point for index_boot_parallel().  Nothing here
+ * may touch the tmpstr pool, the log, or any world structure other
+ * than the read-only zone table.
+ */
+static void
+parse_boot_file_worker(gpointer data, gpointer user_data __attribute__ ((unused)))
+{
+    struct boot_file *bf = data;
+    FILE *db_file;
+
+    db_file = fopen(bf->path, "r");
+    if (!db_file) {
+        fprintf(stderr, "Unable to open: %s\n", bf->path);
+        safe_exit(1);
+    }
+    parse_boot_file(db_file, bf);
+    fclose(db_file);
+}
+
+static GList *
+make_boot_files(GList *files, int mode)
+{
+    GList *paths, *it;
+
+    paths = read_boot_index(mode);
+    for (it = paths; it; it = it->next) {
+        struct boot_file *bf;
+
+        CREATE(bf, struct boot_file, 1);
+        bf->mode = mode;
+        bf->path = it->data;
+        files = g_list_prepend(files, bf);
+    }
+    // the paths are now owned by the boot files
+    g_list_free(paths);
+
+    return files;
+}
+
+static void
+merge_boot_files(GList *files, int mode)
+{
+    GList *it;
+
+    for (it = files; it; it = it->next) {
+        struct boot_file *bf = it->data;
+
+        if (bf->mode == mode)
+            merge_boot_file(bf);
+    }
+}
+
+/*
+ * Loads every wld, mob, and obj file, parsing the files on a pool of
+ * boot_threads worker threads.  The parsed records are merged into the
+ * world on the main thread in index order, so the result is the same
+ * as booting with index_boot().  The zone table must already be
+ * loaded.
+ */
+void
+index_boot_parallel(void)
+{
+    GThreadPool *pool;
+    GError *error = NULL;
+    GList *files = NULL, *it;
+    bool failed = false;
+
+    boot_phase("parse world files");
+    files = make_boot_files(files, DB_BOOT_WLD);
+    files = make_boot_files(files, DB_BOOT_MOB);
+    files = make_boot_files(files, DB_BOOT_OBJ);
+    files = g_list_reverse(files);
+
+    pool = g_thread_pool_new(parse_boot_file_worker, NULL, boot_threads,
+        true, &error);
+    if (!pool) {
+        errlog("Unable to create boot thread pool: %s", error->message);
+        safe_exit(1);
+    }
+    for (it = files; it; it = it->next)
+        g_thread_pool_push(pool, it->data, NULL);
+    // waits for all the files to be parsed
+    g_thread_pool_free(pool, false, true);
+
+    for (it = files; it; it = it->next)
+        if (report_boot_error(it->data))
+            failed = true;
+    if (failed)
+        safe_exit(1);
+
+    boot_phase("merge rooms");
+    merge_boot_files(files, DB_BOOT_WLD);
+
+    boot_phase("renumber rooms");
+    slog("Renumbering rooms.");
+    renum_world();
+
+    boot_phase("start rooms");
+    slog("Checking start rooms.");
+    check_start_rooms();
+
+    boot_phase("merge mobs");
+    merge_boot_files(files, DB_BOOT_MOB);
+
+    boot_phase("merge objs");
+    merge_boot_files(files, DB_BOOT_OBJ);
+
+    for (it = files; it; it = it->next) {
+        struct boot_file *bf = it->data;
+
+        g_free(bf->path);
+        free(bf);
+    }
+    g_list_free(files);
 }
 
 void
 discrete_load(FILE * fl, int mode)
 {
+    struct boot_file bf;
+
+    memset(&bf, 0, sizeof(bf));
+    bf.mode = mode;
+    parse_boot_file(fl, &bf);
+    if (report_boot_error(&bf))
+        safe_exit(1);
+    merge_boot_file(&bf);
+}
+
+/*
+ * Parses every record in a wld, mob, or obj file into bf->records.
+ * This is safe to call from a worker thread.
+ */
+void
+parse_boot_file(FILE * fl, struct boot_file *bf)
+{
+    int mode = bf->mode;
     int nr = -1, last = 0;
     char line[256];
 
@@ -750,7 +1013,7 @@ discrete_load(FILE * fl, int mode)
                 safe_exit(1);
             }
         if (*line == '$')
-            return;
+            break;
 
         if (*line == '#') {
             last = nr;
@@ -760,19 +1023,21 @@ discrete_load(FILE * fl, int mode)
                 safe_exit(1);
             }
             if (nr >= 99999)
-                return;
+                break;
             else
                 switch (mode) {
                 case DB_BOOT_WLD:
-                    parse_room(fl, nr);
+                    parse_room(fl, nr, bf);
                     break;
                 case DB_BOOT_MOB:
-                    parse_mobile(fl, nr);
+                    parse_mobile(fl, nr, bf);
                     break;
                 case DB_BOOT_OBJ:
-                    strcpy_s(line, sizeof(line), parse_object(fl, nr));
+                    parse_object(fl, nr, line, sizeof(line), bf);
                     break;
                 }
+            if (bf->error)
+                break;
         } else {
             fprintf(stderr, "Format error in %s file near %s #%d\n",
                 modes[mode], modes[mode], nr);
@@ -780,6 +1045,180 @@ discrete_load(FILE * fl, int mode)
             safe_exit(1);
         }
     }
+
+    bf->records = g_list_reverse(bf->records);
+    bf->warnings = g_list_reverse(bf->warnings);
+}
+
+static void
+merge_room(struct staged_room *staged)
+{
+    static int room_nr = 0;
+    struct room_data *room = staged->room, *tmp_room;
+    struct zone_data *zone = staged->zone;
+
+    free(staged);
+
+    top_of_world = room_nr++;
+
+    // Eliminate duplicates
+    if (real_room(room->number)) {
+        errlog("Duplicate room %d detected.  Ignoring second instance.",
+            room->number);
+        free_room(room);
+        return;
+    }
+
+    if (zone->world) {
+        for (tmp_room = zone->world; tmp_room; tmp_room = tmp_room->next)
+            if (!tmp_room->next) {
+                tmp_room->next = room;
+                break;
+            }
+    } else
+        zone->world = room;
+}
+
+/*
+ * Adds the records parsed from a file to the world, logging any
+ * warnings raised while parsing it.  Must be called on the main
+ * thread.
+ */
+void
+merge_boot_file(struct boot_file *bf)
+{
+    GList *it;
+
+    for (it = bf->warnings; it; it = it->next)
+        errlog("%s", (char *)it->data);
+    g_list_free_full(bf->warnings, g_free);
+    bf->warnings = NULL;
+
+    for (it = bf->records; it; it = it->next) {
+        switch (bf->mode) {
+        case DB_BOOT_WLD:
+            merge_room(it->data);
+            break;
+        case DB_BOOT_MOB: {
+            struct creature *mobile = it->data;
+            g_hash_table_insert(mob_prototypes,
+                GINT_TO_POINTER(GET_NPC_VNUM(mobile)), mobile);
+            break;
+        }
+        case DB_BOOT_OBJ: {
+            struct obj_data *obj = it->data;
+            g_hash_table_insert(obj_prototypes,
+                GINT_TO_POINTER(GET_OBJ_VNUM(obj)), obj);
+            break;
+        }
+        }
+    }
+    g_list_free(bf->records);
+    bf->records = NULL;
+
+    if (bf->mode == DB_BOOT_MOB)
+        invalidate_mobile_index();
+    else if (bf->mode == DB_BOOT_OBJ)
+        invalidate_object_index();
+}
+
+/*
+ * Queues a warning to be logged when the file is merged, since the
+ * log may not be written from a worker thread.
+ */
+static void
+boot_warning(struct boot_file *bf, const char *fmt, ...)
+{
+    va_list args;
+    char *msg;
+
+    va_start(args, fmt);
+    msg = g_strdup_vprintf(fmt, args);
+    va_end(args);
+
+    bf->warnings = g_list_prepend(bf->warnings, msg);
+}
+
+/*
+ * Records the error that stops a file being parsed.  Only the first
+ * error is kept; it is logged by report_boot_error() on the main
+ * thread.
+ */
+static void
+boot_error(struct boot_file *bf, const char *fmt, ...)
+{
+    va_list args;
+
+    if (bf->error)
+        return;
+
+    va_start(args, fmt);
+    bf->error = g_strdup_vprintf(fmt, args);
+    va_end(args);
+}
+
+/*
+ * Logs the error that stopped a file being parsed, if there was one.
+ * Returns true if there was.  Must be called on the main thread.
+ */
+static bool
+report_boot_error(struct boot_file *bf)
+{
+    if (!bf->error)
+        return false;
+
+    errlog("%s: %s", (bf->path) ? bf->path : "discrete load", bf->error);
+    g_free(bf->error);
+    bf->error = NULL;
+
+    return true;
+}
+
+/*
+ * Reads a '~'-terminated string for a record being parsed.  Unlike
+ * fread_string(), errors are recorded in bf rather than logged, so
+ * that this may be called from a worker thread.
+ */
+static char *
+fread_boot_string(FILE * fl, struct boot_file *bf)
+{
+    char str[MAX_STRING_LENGTH];
+    int result;
+
+    result = read_tilde_string(fl, str, sizeof(str), false);
+    if (result == 0) {
+        boot_error(bf, "format error at or near %s", bf->context);
+        return NULL;
+    }
+    if (result < 0)
+        boot_warning(bf, "string too big at or near %s", bf->context);
+
+    if (str[0] == '\0')
+        return NULL;
+
+    return strdup(str);
+}
+
+/*
+ * Returns true if the first word of str is an article.  Used instead
+ * of fname(), which returns a static buffer.
+ */
+static bool
+starts_with_article(const char *str)
+{
+    char word[8];
+    size_t len = 0;
+
+    while (isalnum(str[len]) && len < sizeof(word) - 1) {
+        word[len] = str[len];
+        len++;
+    }
+    if (isalnum(str[len]))
+        return false;
+    word[len] = '\0';
+
+    return (!strcasecmp(word, "a") || !strcasecmp(word, "an")
+        || !strcasecmp(word, "the"));
 }
 
 long
@@ -807,17 +1246,17 @@ asciiflag_conv(char *flag)
 
 /* load the rooms */
 void
-parse_room(FILE * fl, int vnum_nr)
+parse_room(FILE * fl, int vnum_nr, struct boot_file *bf)
 {
-    static int room_nr = 0;
     int t[10];
     char line[256], flags[128];
     struct extra_descr_data *new_descr = NULL, *t_exdesc = NULL;
     struct special_search_data *new_search = NULL, *t_srch = NULL;
     struct zone_data *zone = NULL;
-    struct room_data *room = NULL, *tmp_room = NULL;
+    struct room_data *room = NULL;
+    struct staged_room *staged = NULL;
 
-    snprintf(buf2, sizeof(buf2), "room #%d", vnum_nr);
+    snprintf(bf->context, sizeof(bf->context), "room #%d", vnum_nr);
 
     zone = zone_table;
 
@@ -831,8 +1270,8 @@ parse_room(FILE * fl, int vnum_nr)
     CREATE(room, struct room_data, 1);
     room->number = vnum_nr;
     room->zone = zone;
-    room->name = fread_string(fl, buf2);
-    room->description = fread_string(fl, buf2);
+    room->name = fread_boot_string(fl, bf);
+    room->description = fread_boot_string(fl, bf);
     room->sounds = NULL;
 
     if (!get_line(fl, line, sizeof(line))
@@ -852,27 +1291,27 @@ parse_room(FILE * fl, int vnum_nr)
         safe_exit(1);
     }
 
-    snprintf(buf, sizeof(buf), "Format error in room #%d (expecting D/E/S)", vnum_nr);
-
     while (true) {
         if (!get_line(fl, line, sizeof(line))) {
-            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, buf);
+            fprintf(stderr,
+                "%s:%d: Format error in room #%d (expecting D/E/S)\n",
+                __FILE__, __LINE__, vnum_nr);
             safe_exit(1);
         }
         switch (*line) {
         case 'R':
-            room->prog = fread_string(fl, buf2);
+            room->prog = fread_boot_string(fl, bf);
             break;
         case 'O':
             room->max_occupancy = atoi(line + 1);
             break;
         case 'D':
-            setup_dir(fl, room, atoi(line + 1));
+            setup_dir(fl, room, atoi(line + 1), bf);
             break;
         case 'E':
             CREATE(new_descr, struct extra_descr_data, 1);
-            new_descr->keyword = fread_string(fl, buf2);
-            new_descr->description = fread_string(fl, buf2);
+            new_descr->keyword = fread_boot_string(fl, bf);
+            new_descr->description = fread_boot_string(fl, bf);
 
             /* put the new exdesc at the end of the linked list, not head */
 
@@ -896,7 +1335,7 @@ parse_room(FILE * fl, int vnum_nr)
             }
             break;
         case 'L':
-            room->sounds = fread_string(fl, buf2);
+            room->sounds = fread_boot_string(fl, bf);
             break;
         case 'F':
             if (!get_line(fl, line, sizeof(line))
@@ -906,7 +1345,7 @@ parse_room(FILE * fl, int vnum_nr)
                 safe_exit(1);
             }
             if (FLOW_SPEED(room)) {
-                errlog("Multiple flow states assigned to room #%d.\n",
+                boot_warning(bf, "Multiple flow states assigned to room #%d.",
                     vnum_nr);
             }
             if (t[0] < 0 || t[0] >= NUM_DIRS) {
@@ -921,7 +1360,7 @@ parse_room(FILE * fl, int vnum_nr)
                 safe_exit(1);
             }
             if (t[2] < 0 || t[2] >= NUM_FLOW_TYPES) {
-                errlog("Illegal flow type in room #%d.", vnum_nr);
+                boot_warning(bf, "Illegal flow type in room #%d.", vnum_nr);
                 FLOW_TYPE(room) = F_TYPE_NONE;
             } else
                 FLOW_TYPE(room) = t[2];
@@ -930,11 +1369,11 @@ parse_room(FILE * fl, int vnum_nr)
             break;
         case 'Z':
             CREATE(new_search, struct special_search_data, 1);
-            new_search->command_keys = fread_string(fl, buf2);
-            new_search->keywords = fread_string(fl, buf2);
-            new_search->to_vict = fread_string(fl, buf2);
-            new_search->to_room = fread_string(fl, buf2);
-            new_search->to_remote = fread_string(fl, buf2);
+            new_search->command_keys = fread_boot_string(fl, bf);
+            new_search->keywords = fread_boot_string(fl, bf);
+            new_search->to_vict = fread_boot_string(fl, bf);
+            new_search->to_room = fread_boot_string(fl, bf);
+            new_search->to_remote = fread_boot_string(fl, bf);
 
             if (!get_line(fl, line, sizeof(line))) {
                 fprintf(stderr, "Search error in room #%d.", vnum_nr);
@@ -982,35 +1421,20 @@ parse_room(FILE * fl, int vnum_nr)
             break;
 
         case 'P':
-            room->func_param = fread_string(fl, buf2);
+            room->func_param = fread_boot_string(fl, bf);
             break;
         case 'S':              /* end of room */
-            top_of_world = room_nr++;
-
             room->next = NULL;
-
-            // Eliminate duplicates
-            if (real_room(vnum_nr)) {
-                errlog("Duplicate room %d detected.  Ignoring second instance.",
-                       vnum_nr);
-                free_room(room);
-                return;
-            }
-
-            if (zone->world) {
-                for (tmp_room = zone->world; tmp_room;
-                    tmp_room = tmp_room->next)
-                    if (!tmp_room->next) {
-                        tmp_room->next = room;
-                        break;
-                    }
-            } else
-                zone->world = room;
-
+            CREATE(staged, struct staged_room, 1);
+            staged->room = room;
+            staged->zone = zone;
+            bf->records = g_list_prepend(bf->records, staged);
             return;
             break;
         default:
-            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, buf);
+            fprintf(stderr,
+                "%s:%d: Format error in room #%d (expecting D/E/S)\n",
+                __FILE__, __LINE__, vnum_nr);
             safe_exit(1);
             break;
         }
@@ -1046,28 +1470,30 @@ calc_door_strength(struct room_data *room, int dir)
 
 /* read direction data */
 void
-setup_dir(FILE * fl, struct room_data *room, int dir)
+setup_dir(FILE * fl, struct room_data *room, int dir, struct boot_file *bf)
 {
     int t[5];
     char line[256], flags[128];
 
-    snprintf(buf2, sizeof(buf2), "room #%d, direction D%d", room->number, dir);
+    snprintf(bf->context, sizeof(bf->context), "room #%d, direction D%d",
+        room->number, dir);
 
     if (dir >= NUM_DIRS) {
-        errlog("Room direction > NUM_DIRS in room #%d", room->number);
+        fprintf(stderr, "Room direction > NUM_DIRS in room #%d\n",
+            room->number);
         safe_exit(1);
     }
 
     CREATE(room->dir_option[dir], struct room_direction_data, 1);
-    room->dir_option[dir]->general_description = fread_string(fl, buf2);
-    room->dir_option[dir]->keyword = fread_string(fl, buf2);
+    room->dir_option[dir]->general_description = fread_boot_string(fl, bf);
+    room->dir_option[dir]->keyword = fread_boot_string(fl, bf);
 
     if (!get_line(fl, line, sizeof(line))) {
-        fprintf(stderr, "Format error, %s\n", buf2);
+        fprintf(stderr, "Format error, %s\n", bf->context);
         safe_exit(1);
     }
     if (sscanf(line, " %s %d %d ", flags, t + 1, t + 2) != 3) {
-        fprintf(stderr, "Format error, %s\n", buf2);
+        fprintf(stderr, "Format error, %s\n", bf->context);
         safe_exit(1);
     }
 
@@ -1344,7 +1770,8 @@ renum_zone_table(void)
 
 void maybe_compile_prog(gpointer key __attribute__((unused)), struct creature *mob, gpointer ignore __attribute__((unused)))
 {
-    if (NPC_SHARED(mob)->prog)
+    // Progs loaded from the world image are already compiled
+    if (NPC_SHARED(mob)->prog && !NPC_SHARED(mob)->progobj)
         prog_compile(NULL, mob, PROG_TYPE_MOBILE);
 }
 
@@ -1356,7 +1783,7 @@ compile_all_progs(void)
     struct room_data *room;
     for (zone = zone_table; zone; zone = zone->next)
         for (room = zone->world; room; room = room->next)
-            if (room->prog)
+            if (room->prog && !room->progobj)
                 prog_compile(NULL, room, PROG_TYPE_ROOM);
 
     // Compile all mob progs
@@ -1784,7 +2211,8 @@ parse_espec(char *buf, struct creature *mobile, int nr)
 }
 
 void
-parse_enhanced_mob(FILE * mob_f, struct creature *mobile, int nr)
+parse_enhanced_mob(FILE * mob_f, struct creature *mobile, int nr,
+    struct boot_file *bf)
 {
     char line[256];
 
@@ -1792,11 +2220,11 @@ parse_enhanced_mob(FILE * mob_f, struct creature *mobile, int nr)
 
     while (get_line(mob_f, line, sizeof(line))) {
         if (!strcmp(line, "SpecParam:")) {  /* multi-line specparam */
-            NPC_SHARED(mobile)->func_param = fread_string(mob_f, buf2);
+            NPC_SHARED(mobile)->func_param = fread_boot_string(mob_f, bf);
         } else if (!strcmp(line, "LoadParam:")) {   /* multi-line load param */
-            NPC_SHARED(mobile)->load_param = fread_string(mob_f, buf2);
+            NPC_SHARED(mobile)->load_param = fread_boot_string(mob_f, bf);
         } else if (!strcmp(line, "Prog:")) {    /* multi-line prog */
-            NPC_SHARED(mobile)->prog = fread_string(mob_f, buf2);
+            NPC_SHARED(mobile)->prog = fread_boot_string(mob_f, bf);
         } else if (!strcmp(line, "E"))  /* end of the ehanced section */
             return;
         else if (*line == '#') {    /* we've hit the next mob, maybe? */
@@ -1811,7 +2239,7 @@ parse_enhanced_mob(FILE * mob_f, struct creature *mobile, int nr)
 }
 
 void
-parse_mobile(FILE * mob_f, int nr)
+parse_mobile(FILE * mob_f, int nr, struct boot_file *bf)
 {
     int j, t[10];
     char line[256], *tmpptr, letter;
@@ -1828,16 +2256,14 @@ parse_mobile(FILE * mob_f, int nr)
     mobile->mob_specials.shared->proto = mobile;
 
     mobile->player_specials = &dummy_mob;
-    snprintf(buf2, sizeof(buf2), "mob vnum %d", nr);
+    snprintf(bf->context, sizeof(bf->context), "mob vnum %d", nr);
 
     /***** String data *** */
-    mobile->player.name = fread_string(mob_f, buf2);
-    tmpptr = mobile->player.short_descr = fread_string(mob_f, buf2);
-    if (tmpptr && *tmpptr)
-        if (!strcasecmp(fname(tmpptr), "a") || !strcasecmp(fname(tmpptr), "an")
-            || !strcasecmp(fname(tmpptr), "the"))
-            *tmpptr = tolower(*tmpptr);
-    mobile->player.long_descr = fread_string(mob_f, buf2);
+    mobile->player.name = fread_boot_string(mob_f, bf);
+    tmpptr = mobile->player.short_descr = fread_boot_string(mob_f, bf);
+    if (tmpptr && *tmpptr && starts_with_article(tmpptr))
+        *tmpptr = tolower(*tmpptr);
+    mobile->player.long_descr = fread_boot_string(mob_f, bf);
     if (mobile->player.long_descr) {
         char *read_pt;
 
@@ -1847,7 +2273,7 @@ parse_mobile(FILE * mob_f, int nr)
         if ('\n' == read_pt[-1] && '\r' == read_pt[-2])
             read_pt[-2] = '\0';
     }
-    mobile->player.description = fread_string(mob_f, buf2);
+    mobile->player.description = fread_boot_string(mob_f, bf);
     mobile->player.title = NULL;
 
     /* *** Numeric data *** */
@@ -1867,7 +2293,7 @@ parse_mobile(FILE * mob_f, int nr)
         parse_simple_mob(mob_f, mobile, nr);
         break;
     case 'E':                  /* Circle3 Enhanced monsters */
-        parse_enhanced_mob(mob_f, mobile, nr);
+        parse_enhanced_mob(mob_f, mobile, nr, bf);
         break;
         /* add new mob types here.. */
     default:
@@ -1897,15 +2323,14 @@ parse_mobile(FILE * mob_f, int nr)
     mobile->desc = NULL;
     set_initial_tongue(mobile);
 
-    g_hash_table_insert(mob_prototypes,
-        GINT_TO_POINTER(GET_NPC_VNUM(mobile)), mobile);
+    bf->records = g_list_prepend(bf->records, mobile);
 }
 
 /* read all objects from obj file; generate index and prototypes */
 char *
-parse_object(FILE * obj_f, int nr)
+parse_object(FILE * obj_f, int nr, char *line, size_t line_size,
+    struct boot_file *bf)
 {
-    static char line[256];
     int retval;
     int t[10], j;
     char *tmpptr;
@@ -1926,26 +2351,25 @@ parse_object(FILE * obj_f, int nr)
     obj->in_room = NULL;
     obj->worn_on = -1;
 
-    snprintf(buf2, sizeof(buf2), "object #%d", nr);
+    snprintf(bf->context, sizeof(bf->context), "object #%d", nr);
 
     /* *** string data *** */
-    if ((obj->aliases = fread_string(obj_f, buf2)) == NULL) {
-        fprintf(stderr, "Null obj name or format error at or near %s\n", buf2);
-        safe_exit(1);
+    if ((obj->aliases = fread_boot_string(obj_f, bf)) == NULL) {
+        boot_error(bf, "null obj name or format error at or near %s",
+            bf->context);
+        return line;
     }
-    tmpptr = obj->name = fread_string(obj_f, buf2);
-    if (tmpptr && *tmpptr)
-        if (!strcasecmp(fname(tmpptr), "a") || !strcasecmp(fname(tmpptr), "an")
-            || !strcasecmp(fname(tmpptr), "the"))
-            *tmpptr = tolower(*tmpptr);
+    tmpptr = obj->name = fread_boot_string(obj_f, bf);
+    if (tmpptr && *tmpptr && starts_with_article(tmpptr))
+        *tmpptr = tolower(*tmpptr);
 
-    tmpptr = obj->line_desc = fread_string(obj_f, buf2);
+    tmpptr = obj->line_desc = fread_boot_string(obj_f, bf);
     if (tmpptr && *tmpptr)
         *tmpptr = toupper(*tmpptr);
-    obj->action_desc = fread_string(obj_f, buf2);
+    obj->action_desc = fread_boot_string(obj_f, bf);
 
     /* *** numeric data *** */
-    if (!get_line(obj_f, line, sizeof(line))) {
+    if (!get_line(obj_f, line, line_size)) {
         fprintf(stderr, "Unable to read first numeric line for object %d.\n",
             nr);
         safe_exit(1);
@@ -1969,15 +2393,15 @@ parse_object(FILE * obj_f, int nr)
     else {
         fprintf(stderr,
             "Format error in first numeric line (expecting 4 or 5 args, got %d), %s\n",
-            retval, buf2);
+            retval, bf->context);
         safe_exit(1);
     }
 
-    if (!get_line(obj_f, line, sizeof(line)) ||
+    if (!get_line(obj_f, line, line_size) ||
         (retval = sscanf(line, "%d %d %d %d", t, t + 1, t + 2, t + 3)) != 4) {
         fprintf(stderr,
             "Format error in second numeric line (expecting 4 args, got %d), %s\n",
-            retval, buf2);
+            retval, bf->context);
         safe_exit(1);
     }
     obj->obj_flags.value[0] = t[0];
@@ -1985,11 +2409,11 @@ parse_object(FILE * obj_f, int nr)
     obj->obj_flags.value[2] = t[2];
     obj->obj_flags.value[3] = t[3];
 
-    if (!get_line(obj_f, line, sizeof(line)) ||
+    if (!get_line(obj_f, line, line_size) ||
         (retval = sscanf(line, "%d %d %d", t, t + 1, t + 2)) != 3) {
         fprintf(stderr,
             "Format error in third numeric line (expecting 3 args, got %d), %s\n",
-            retval, buf2);
+            retval, bf->context);
         safe_exit(1);
     }
     obj->obj_flags.material = t[0];
@@ -1998,11 +2422,11 @@ parse_object(FILE * obj_f, int nr)
 
     t[3] = 0;
     float f;
-    if (!get_line(obj_f, line, sizeof(line)) ||
+    if (!get_line(obj_f, line, line_size) ||
         (retval = sscanf(line, "%f %d %d %d", &f, t + 1, t + 2, t + 3)) < 3) {
         fprintf(stderr,
             "Format error in fourth numeric line (expecting 3 or 4 args, got %d), %s\n",
-            retval, buf2);
+            retval, bf->context);
         safe_exit(1);
     }
     obj->obj_flags.weight = f;
@@ -2029,29 +2453,30 @@ parse_object(FILE * obj_f, int nr)
     obj->obj_flags.bitvector[1] = 0;
     obj->obj_flags.bitvector[2] = 0;
 
-    strcat_s(buf2, sizeof(buf2), ", after numeric constants (expecting E/A/#xxx)");
+    strcat_s(bf->context, sizeof(bf->context),
+        ", after numeric constants (expecting E/A/#xxx)");
     j = 0;
 
     while (true) {
-        if (!get_line(obj_f, line, sizeof(line))) {
-            fprintf(stderr, "Format error in %s\n", buf2);
+        if (!get_line(obj_f, line, line_size)) {
+            fprintf(stderr, "Format error in %s\n", bf->context);
             safe_exit(1);
         }
         switch (*line) {
         case 'E':
             CREATE(new_descr, struct extra_descr_data, 1);
-            new_descr->keyword = fread_string(obj_f, buf2);
-            new_descr->description = fread_string(obj_f, buf2);
+            new_descr->keyword = fread_boot_string(obj_f, bf);
+            new_descr->description = fread_boot_string(obj_f, bf);
             new_descr->next = obj->ex_description;
             obj->ex_description = new_descr;
             break;
         case 'A':
             if (j >= MAX_OBJ_AFFECT) {
                 fprintf(stderr, "Too many A fields (%d max), %s\n",
-                    MAX_OBJ_AFFECT, buf2);
+                    MAX_OBJ_AFFECT, bf->context);
                 safe_exit(1);
             }
-            get_line(obj_f, line, sizeof(line));
+            get_line(obj_f, line, line_size);
             sscanf(line, " %d %d ", t, t + 1);
             obj->affected[j].location = t[0];
             obj->affected[j].modifier = t[1];
@@ -2061,25 +2486,24 @@ parse_object(FILE * obj_f, int nr)
             sscanf(line + 1, " %ld ", &(obj->shared->owner_id));
             break;
         case 'V':
-            get_line(obj_f, line, sizeof(line));
+            get_line(obj_f, line, line_size);
             sscanf(line, " %d %s ", t, f1);
             if (t[0] < 1 || t[0] > 3)
                 break;
             obj->obj_flags.bitvector[t[0] - 1] = asciiflag_conv(f1);
             break;
         case 'P':
-            obj->shared->func_param = fread_string(obj_f, buf2);
+            obj->shared->func_param = fread_boot_string(obj_f, bf);
             break;
         case '$':
         case '#':
             obj->next = NULL;
             fix_object_weight(obj);
-            g_hash_table_insert(obj_prototypes,
-                GINT_TO_POINTER(GET_OBJ_VNUM(obj)), obj);
+            bf->records = g_list_prepend(bf->records, obj);
             return line;
             break;
         default:
-            fprintf(stderr, "Format error in %s\n", buf2);
+            fprintf(stderr, "Format error in %s\n", bf->context);
             safe_exit(1);
             break;
         }
@@ -2348,6 +2772,7 @@ read_mobile(int vnum)
 
     creatures = g_list_prepend(creatures, mob);
     g_hash_table_insert(creature_map, GINT_TO_POINTER(-NPC_IDNUM(mob)), mob);
+    prog_register_owner(mob, PROG_TYPE_MOBILE);
 
     return mob;
 }
@@ -2629,7 +3054,7 @@ read_object(int vnum)
         slog("Object (V) %d does not exist in database.", vnum);
         return NULL;
     }
-    CREATE(obj, struct obj_data, 1);
+    CREATE_KIND(obj, struct obj_data, 1, MEM_OBJECT);
     *obj = *tmp_obj;
     tmp_obj->shared->number++;
 
@@ -2649,6 +3074,7 @@ read_object(int vnum)
 
     obj->next = object_list;
     object_list = obj;
+    index_object(obj);
 
     if (IS_OBJ_STAT2(obj, ITEM2_UNAPPROVED))
         GET_OBJ_TIMER(obj) = 60;
@@ -3142,11 +3568,16 @@ reset_zone(struct zone_data *zone)
 ********************************************************************** */
 
 
-/* read and copy for a '~'-terminated string from a given file
-   copying it into str, returning 1 on success or 0 on failure  */
-bool
-pread_string(FILE * fl, char *str, size_t buf_size, bool comments, const char *error)
+/*
+ * Reads a '~'-terminated string from a file into str without logging.
+ * Returns 1 on success, 0 if the file ended first, or -1 if the string
+ * was too big for the buffer, in which case str is left empty.
+ */
+static int
+read_tilde_string(FILE * fl, char *str, size_t buf_size, bool comments)
 {
+    char *start = str;
+
     *str = '\0';
 
     while (fgets(str, buf_size, fl)) {
@@ -3165,21 +3596,33 @@ pread_string(FILE * fl, char *str, size_t buf_size, bool comments, const char *e
         char *point = strchr(str, '~');
         if (point) {
             *point = '\0';
-            return true;
+            return 1;
         }
 
         size_t line_size = strlen(str);
         buf_size -= line_size;
 
         if (buf_size <= 1) {
-            errlog("string too big (db.c, pread_string)");
-            *buf = '\0';
+            *start = '\0';
             return -1;
         }
         str += line_size;
     }
 
-    return false;
+    return 0;
+}
+
+/* read and copy for a '~'-terminated string from a given file
+   copying it into str, returning 1 on success or 0 on failure  */
+bool
+pread_string(FILE * fl, char *str, size_t buf_size, bool comments, const char *error)
+{
+    int result = read_tilde_string(fl, str, buf_size, comments);
+
+    if (result < 0)
+        errlog("string too big (db.c, pread_string) at or near %s", error);
+
+    return result != 0;
 }
 
 /**
@@ -3399,6 +3842,20 @@ get_corpse_file_path(long id)
     return tmp_sprintf("players/corpses/%0ld/%ld.dat", (id % 10), id);
 }
 
+// Roughly the number of bytes held by a query result
+static size_t
+sql_result_size(PGresult *res)
+{
+    int rows = PQntuples(res), fields = PQnfields(res);
+    size_t size = rows * fields * sizeof(char *);
+
+    for (int row = 0; row < rows; row++)
+        for (int field = 0; field < fields; field++)
+            size += PQgetlength(res, row, field) + 1;
+
+    return size;
+}
+
 void
 sql_exec(const char *str, ...)
 {
@@ -3425,6 +3882,8 @@ sql_exec(const char *str, ...)
         errlog("FROM SQL: %s", query);
         raise(SIGSEGV);
     }
+    memstat_alloc(MEM_SQL, res, sql_result_size(res));
+    memstat_free(MEM_SQL, res, sql_result_size(res));
     PQclear(res);
 }
 
@@ -3454,6 +3913,8 @@ sql_query(const char *str, ...)
         slog("FROM SQL: %s", query);
     }
 
+    memstat_alloc(MEM_SQL, res, sql_result_size(res));
+
     struct sql_query_data *rec;
     CREATE(rec, struct sql_query_data, 1);
     rec->next = sql_query_list;
@@ -3470,6 +3931,8 @@ sql_gc_queries(void)
 
     for (cur_query = sql_query_list; cur_query; cur_query = next_query) {
         next_query = cur_query->next;
+        memstat_free(MEM_SQL, cur_query->res,
+                     sql_result_size(cur_query->res));
         PQclear(cur_query->res);
         free(cur_query);
     }
@@ -92,8 +92,16 @@ struct mob_matcher {
     int64_t num;
     bool negated;
     enum operator op;
+    const char *index;          // name of the prototype index, if any
+    bool fixed;                 // live mobiles always agree with the prototype
 };
 
+// Inverted index of the mobile prototypes, mapping a matcher's index
+// key to a sorted GArray of the vnums it matches.  It's built by the
+// first query and dropped whenever OLC may have changed a prototype.
+static GHashTable *mob_proto_index = NULL;
+static GArray *mob_proto_index_all = NULL;
+
 int parse_char_class(char *arg);
 int parse_race(char *arg);
 
@@ -136,6 +144,8 @@ make_mobile_class_matcher(struct creature *ch,
     }
 
     matcher->pred = mobile_matches_class;
+    matcher->index = "class";
+    matcher->fixed = true;
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -165,6 +175,7 @@ make_mobile_race_matcher(struct creature *ch,
     }
 
     matcher->pred = mobile_matches_race;
+    matcher->index = "race";
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -202,6 +213,7 @@ make_mobile_flags_matcher(struct creature *ch,
     }
 
     matcher->pred = mobile_matches_flags;
+    matcher->index = "flags";
     index = 1;
     flag = search_block(expr, action_bits_desc,  0);
     if (flag < 0) {
@@ -248,6 +260,7 @@ make_mobile_affect_matcher(struct creature *ch,
     }
 
     matcher->pred = mobile_matches_affect;
+    matcher->index = "affect";
     index = 1;
     flag = search_block(expr, affected_bits_desc,  0);
     if (flag < 0) {
@@ -408,6 +421,180 @@ static struct {
     { NULL, NULL, MATCHER_STD }
 };
 
+static char *
+mob_index_key(struct mob_matcher *matcher)
+{
+    return tmp_sprintf("%s %d %" PRId64, matcher->index, matcher->idx,
+                       matcher->num);
+}
+
+static gint
+vnum_cmp(gconstpointer a, gconstpointer b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static void
+sort_index_entry(__attribute__ ((unused)) gpointer key,
+                 gpointer vnums,
+                 __attribute__ ((unused)) gpointer ignore)
+{
+    g_array_sort(vnums, vnum_cmp);
+}
+
+static void
+free_index_entry(gpointer vnums)
+{
+    g_array_free(vnums, true);
+}
+
+static void
+mob_index_add(struct creature *mob, struct mob_matcher *matcher)
+{
+    char *key;
+    GArray *vnums;
+
+    if (!matcher->pred(mob, matcher))
+        return;
+
+    key = mob_index_key(matcher);
+    vnums = g_hash_table_lookup(mob_proto_index, key);
+    if (!vnums) {
+        vnums = g_array_new(false, false, sizeof(int));
+        g_hash_table_insert(mob_proto_index, g_strdup(key), vnums);
+    }
+    g_array_append_val(vnums, mob->mob_specials.shared->vnum);
+}
+
+static void
+build_mobile_index(void)
+{
+    GHashTableIter iter;
+    struct creature *mob;
+    struct mob_matcher matcher;
+    int vnum, bit;
+
+    mob_proto_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                      g_free, free_index_entry);
+    mob_proto_index_all = g_array_new(false, false, sizeof(int));
+
+    g_hash_table_iter_init(&iter, mob_prototypes);
+    while (g_hash_table_iter_next(&iter, (gpointer)&vnum, (gpointer)&mob)) {
+        g_array_append_val(mob_proto_index_all, mob->mob_specials.shared->vnum);
+
+        // The index is filled by running the matchers themselves, so
+        // an index hit always agrees with the predicate.
+        memset(&matcher, 0, sizeof(matcher));
+        matcher.pred = mobile_matches_class;
+        matcher.index = "class";
+        for (matcher.num = 0; matcher.num < NUM_CLASSES; matcher.num++)
+            mob_index_add(mob, &matcher);
+
+        matcher.pred = mobile_matches_race;
+        matcher.index = "race";
+        for (matcher.num = 0; matcher.num <= NUM_RACES; matcher.num++)
+            mob_index_add(mob, &matcher);
+
+        matcher.pred = mobile_matches_flags;
+        matcher.index = "flags";
+        for (matcher.idx = 1; matcher.idx <= 2; matcher.idx++)
+            for (bit = 0; bit < 32; bit++) {
+                matcher.num = 1 << bit;
+                mob_index_add(mob, &matcher);
+            }
+
+        matcher.pred = mobile_matches_affect;
+        matcher.index = "affect";
+        for (matcher.idx = 1; matcher.idx <= 3; matcher.idx++)
+            for (bit = 0; bit < 32; bit++) {
+                matcher.num = 1 << bit;
+                mob_index_add(mob, &matcher);
+            }
+    }
+
+    g_array_sort(mob_proto_index_all, vnum_cmp);
+    g_hash_table_foreach(mob_proto_index, sort_index_entry, NULL);
+}
+
+void
+invalidate_mobile_index(void)
+{
+    if (!mob_proto_index)
+        return;
+    g_hash_table_destroy(mob_proto_index);
+    g_array_free(mob_proto_index_all, true);
+    mob_proto_index = NULL;
+    mob_proto_index_all = NULL;
+}
+
+static gint
+vnum_list_len_cmp(gconstpointer a, gconstpointer b)
+{
+    return (*(GArray * const *)a)->len - (*(GArray * const *)b)->len;
+}
+
+// Returns the sorted vnums of the prototypes matching every indexed,
+// non-negated matcher, intersecting the shortest lists first.  Indexed
+// matchers are marked so they aren't evaluated again.  For live
+// mobiles, only the matchers on fields which can't change in play are
+// used.
+static GArray *
+find_mobile_candidates(GList *matchers, bool live)
+{
+    GPtrArray *lists = g_ptr_array_new();
+    GArray *result;
+
+    if (!mob_proto_index)
+        build_mobile_index();
+
+    for (GList *cur = matchers;cur;cur = cur->next) {
+        struct mob_matcher *matcher = cur->data;
+        GArray *vnums;
+
+        if (!matcher->index || matcher->negated
+            || (live && !matcher->fixed))
+            continue;
+        vnums = g_hash_table_lookup(mob_proto_index, mob_index_key(matcher));
+        if (!vnums) {
+            g_ptr_array_free(lists, true);
+            return g_array_new(false, false, sizeof(int));
+        }
+        g_ptr_array_add(lists, vnums);
+        matcher->pred = NULL;
+    }
+
+    if (lists->len == 0)
+        g_ptr_array_add(lists, mob_proto_index_all);
+    g_ptr_array_sort(lists, vnum_list_len_cmp);
+
+    result = g_array_new(false, false, sizeof(int));
+    g_array_append_vals(result, ((GArray *)g_ptr_array_index(lists, 0))->data,
+                        ((GArray *)g_ptr_array_index(lists, 0))->len);
+    for (guint i = 1;i < lists->len && result->len;i++) {
+        GArray *other = g_ptr_array_index(lists, i);
+        guint read = 0, write = 0, pos = 0;
+
+        while (read < result->len && pos < other->len) {
+            int a = g_array_index(result, int, read);
+            int b = g_array_index(other, int, pos);
+
+            if (a < b) {
+                read++;
+            } else if (b < a) {
+                pos++;
+            } else {
+                g_array_index(result, int, write++) = a;
+                read++;
+                pos++;
+            }
+        }
+        g_array_set_size(result, write);
+    }
+    g_ptr_array_free(lists, true);
+
+    return result;
+}
+
 struct mob_matcher *
 make_mobile_matcher(struct creature *ch, char *expr)
 {
@@ -443,17 +630,113 @@ make_mobile_matcher(struct creature *ch, char *expr)
     return result;
 }
 
+static bool
+mobile_matches_all(struct creature *mob, GList *matchers)
+{
+    for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
+        struct mob_matcher *matcher = cur_matcher->data;
+        bool matches;
+
+        // Already satisfied by the index
+        if (!matcher->pred)
+            continue;
+        matches = matcher->pred(mob, matcher);
+        if (matcher->negated)
+            matches = !matches;
+        if (!matches)
+            return false;
+    }
+    return true;
+}
+
+static void
+show_mobile_match(struct creature *ch, struct creature *mob,
+                  GList *matchers, int found)
+{
+    acc_sprintf("%3d. %s[%s%5d%s]%s %-50s%s", found,
+                CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                mob->mob_specials.shared->vnum,
+                CCGRN(ch, C_NRM), CCYEL(ch, C_NRM),
+                GET_NAME(mob), CCNRM(ch, C_NRM));
+    if (mob->in_room)
+        acc_sprintf(" %s[%s%5d%s]%s",
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                    mob->in_room->number,
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM));
+    for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
+        struct mob_matcher *matcher = cur_matcher->data;
+        if (matcher->info)
+            acc_strcat(" ", matcher->info(ch, mob, matcher), NULL);
+    }
+    acc_strcat("\r\n", NULL);
+}
+
+// The state of a prototype listing being paged
+struct mobile_listing {
+    gchar **exprv;
+    GList *matchers;
+    GArray *candidates;
+    guint pos;
+    int found;
+};
+
+static void
+free_mobile_listing(void *data)
+{
+    struct mobile_listing *listing = data;
+
+    g_strfreev(listing->exprv);
+    g_list_foreach(listing->matchers, (GFunc)free, NULL);
+    g_list_free(listing->matchers);
+    g_array_free(listing->candidates, true);
+    free(listing);
+}
+
+// Lists the next few matching prototypes.  Prototypes are looked up
+// again by vnum, since they may have been deleted between pages.
+static bool
+next_mobile_matches(struct descriptor_data *d, void *data)
+{
+    struct mobile_listing *listing = data;
+    int shown = 0;
+
+    if (!d->creature)
+        return false;
+
+    while (listing->pos < listing->candidates->len && shown < 20) {
+        int vnum = g_array_index(listing->candidates, int, listing->pos++);
+        struct creature *mob = real_mobile_proto(vnum);
+        struct tmp_mark mark = tmp_mark();
+
+        if (mob && mobile_matches_all(mob, listing->matchers)) {
+            show_mobile_match(d->creature, mob, listing->matchers,
+                              ++listing->found);
+            shown++;
+        }
+        tmp_release(mark);
+    }
+
+    return listing->pos < listing->candidates->len;
+}
+
 void
 do_show_mobiles(struct creature *ch, char *value, char *argument)
 {
     gchar **exprv;
     GList *matchers = NULL;
+    bool live = false;
+
+    if (!strcasecmp(value, "live")) {
+        live = true;
+        value = tmp_getword(&argument);
+    }
 
     if (!*value) {
         send_to_char(ch,
-                     "Usage: show mobile [!] <term>[, [!]<term> ...]\r\n"
+                     "Usage: show mobile [live] [!] <term>[, [!]<term> ...]\r\n"
                      "Precede the term with an exclamation point (!) to select\r\n"
-                     "mobiles that don't match.\r\n"
+                     "mobiles that don't match.  Use 'live' to search the mobiles\r\n"
+                     "in the world instead of the prototypes.\r\n"
                      "Valid terms can be:\r\n");
         for (int i = 0;match_table[i].matcher;i++) {
             send_to_char(ch, "%s\r\n", match_table[i].matcher);
@@ -485,38 +768,51 @@ do_show_mobiles(struct creature *ch, char *value, char *argument)
         }
     }
 
-    GHashTableIter iter;
-    struct creature *mob;
-    int vnum, found;
+    if (!live) {
+        struct mobile_listing *listing;
+
+        // Prototypes are only matched as the listing is paged through
+        CREATE(listing, struct mobile_listing, 1);
+        listing->exprv = exprv;
+        listing->matchers = matchers;
+        listing->candidates = find_mobile_candidates(matchers, false);
+        if (!page_generator(ch->desc, next_mobile_matches, listing,
+                            free_mobile_listing))
+            send_to_char(ch, "No matching mobiles found.\r\n");
+        return;
+    }
+
+    GArray *candidates = find_mobile_candidates(matchers, live);
+    guint kept = 0;
+    int found = 0;
+
+    // Only prototypes with mobiles in the world are worth looking for
+    for (guint i = 0;i < candidates->len;i++) {
+        int vnum = g_array_index(candidates, int, i);
+        struct creature *proto = real_mobile_proto(vnum);
+
+        if (proto && proto->mob_specials.shared->number > 0)
+            g_array_index(candidates, int, kept++) = vnum;
+    }
+    g_array_set_size(candidates, kept);
 
     acc_string_clear();
-    found = 0;
 
-    g_hash_table_iter_init(&iter, mob_prototypes);
-    while (g_hash_table_iter_next(&iter, (gpointer)&vnum, (gpointer)&mob)) {
-        bool matches = false;
-        for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
-            struct mob_matcher *matcher = cur_matcher->data;
-            matches = matcher->pred(mob, matcher);
-            if (matcher->negated)
-                matches = !matches;
-            if (!matches)
-                break;
-        }
-        if (matches) {
-            acc_sprintf("%3d. %s[%s%5d%s]%s %-50s%s", ++found,
-                        CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                        mob->mob_specials.shared->vnum,
-                        CCGRN(ch, C_NRM), CCYEL(ch, C_NRM),
-                        GET_NAME(mob), CCNRM(ch, C_NRM));
-            for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
-                struct mob_matcher *matcher = cur_matcher->data;
-                if (matcher->info)
-                    acc_strcat(" ", matcher->info(ch, mob, matcher), NULL);
-            }
-            acc_strcat("\r\n", NULL);
-        }
+    // Live mobiles can differ from their prototypes in everything but
+    // the fixed fields, so the other matchers are checked against each
+    // one.
+    for (GList *it = first_living(creatures);it && candidates->len;it = next_living(it)) {
+        struct creature *mob = it->data;
+        struct tmp_mark mark = tmp_mark();
+
+        if (IS_NPC(mob)
+            && bsearch(&mob->mob_specials.shared->vnum, candidates->data,
+                       candidates->len, sizeof(int), vnum_cmp)
+            && mobile_matches_all(mob, matchers))
+            show_mobile_match(ch, mob, matchers, ++found);
+        tmp_release(mark);
     }
+    g_array_free(candidates, true);
 
     if (found)
         page_string(ch->desc, acc_get_string());
@@ -79,8 +79,15 @@ struct obj_matcher {
     int num;
     bool negated;
     enum operator op;
+    const char *index;          // name of the prototype index, if any
 };
 
+// Inverted index of the object prototypes, mapping a matcher's index
+// key to a sorted GArray of the vnums it matches.  It's built by the
+// first query and dropped whenever OLC may have changed a prototype.
+static GHashTable *obj_proto_index = NULL;
+static GArray *obj_proto_index_all = NULL;
+
 bool
 object_matches_name(struct obj_data *obj, struct obj_matcher *matcher)
 {
@@ -118,6 +125,7 @@ make_object_type_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_type;
+    matcher->index = "type";
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -146,6 +154,7 @@ make_object_material_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_material;
+    matcher->index = "material";
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -191,6 +200,7 @@ make_object_apply_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_apply;
+    matcher->index = "apply";
     matcher->info = object_apply_info;
 
     if (is_number(expr))
@@ -247,6 +257,7 @@ make_object_affect_matcher(struct creature *ch,
 
     int index, affect;
     matcher->pred = object_matches_affect;
+    matcher->index = "affect";
 
     index = 1;
     affect = search_block(expr, affected_bits_desc,  0);
@@ -363,6 +374,7 @@ make_object_spell_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_spell;
+    matcher->index = "spell";
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -391,6 +403,7 @@ make_object_worn_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_worn;
+    matcher->index = "worn";
     if (is_number(expr))
         matcher->num = atoi(expr);
     else
@@ -431,6 +444,7 @@ make_object_extra_matcher(struct creature *ch,
     }
 
     matcher->pred = object_matches_extra;
+    matcher->index = "extra";
     index = 1;
     flag = search_block(expr, extra_names,  0);
     if (flag < 0) {
@@ -468,6 +482,203 @@ static struct {
     { NULL, NULL }
 };
 
+static char *
+obj_index_key(struct obj_matcher *matcher)
+{
+    return tmp_sprintf("%s %d %d", matcher->index, matcher->idx,
+                       matcher->num);
+}
+
+static gint
+vnum_cmp(gconstpointer a, gconstpointer b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static void
+sort_index_entry(__attribute__ ((unused)) gpointer key,
+                 gpointer vnums,
+                 __attribute__ ((unused)) gpointer ignore)
+{
+    g_array_sort(vnums, vnum_cmp);
+}
+
+static void
+free_index_entry(gpointer vnums)
+{
+    g_array_free(vnums, true);
+}
+
+static void
+obj_index_add(struct obj_data *obj, struct obj_matcher *matcher)
+{
+    char *key;
+    GArray *vnums;
+
+    if (!matcher->pred(obj, matcher))
+        return;
+
+    key = obj_index_key(matcher);
+    vnums = g_hash_table_lookup(obj_proto_index, key);
+    if (!vnums) {
+        vnums = g_array_new(false, false, sizeof(int));
+        g_hash_table_insert(obj_proto_index, g_strdup(key), vnums);
+    }
+    // Several candidate values may produce the same key
+    if (vnums->len
+        && g_array_index(vnums, int, vnums->len - 1) == obj->shared->vnum)
+        return;
+    g_array_append_val(vnums, obj->shared->vnum);
+}
+
+static void
+build_object_index(void)
+{
+    GHashTableIter iter;
+    struct obj_data *obj;
+    struct obj_matcher matcher;
+    int vnum, bit;
+
+    obj_proto_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                      g_free, free_index_entry);
+    obj_proto_index_all = g_array_new(false, false, sizeof(int));
+
+    g_hash_table_iter_init(&iter, obj_prototypes);
+    while (g_hash_table_iter_next(&iter, (gpointer)&vnum, (gpointer)&obj)) {
+        g_array_append_val(obj_proto_index_all, obj->shared->vnum);
+
+        // The index is filled by running the matchers themselves, so
+        // an index hit always agrees with the predicate.
+        memset(&matcher, 0, sizeof(matcher));
+        matcher.pred = object_matches_type;
+        matcher.index = "type";
+        matcher.num = GET_OBJ_TYPE(obj);
+        obj_index_add(obj, &matcher);
+
+        matcher.pred = object_matches_material;
+        matcher.index = "material";
+        matcher.num = GET_OBJ_MATERIAL(obj);
+        obj_index_add(obj, &matcher);
+
+        matcher.pred = object_matches_apply;
+        matcher.index = "apply";
+        for (int i = 0; i < MAX_OBJ_AFFECT; i++) {
+            matcher.num = obj->affected[i].location;
+            obj_index_add(obj, &matcher);
+        }
+
+        matcher.pred = object_matches_spell;
+        matcher.index = "spell";
+        for (int i = 0; i < 4; i++) {
+            matcher.num = GET_OBJ_VAL(obj, i);
+            obj_index_add(obj, &matcher);
+        }
+
+        matcher.pred = object_matches_worn;
+        matcher.index = "worn";
+        for (bit = 0; bit <= NUM_WEAR_FLAGS; bit++) {
+            matcher.num = 1 << bit;
+            obj_index_add(obj, &matcher);
+        }
+
+        matcher.pred = object_matches_extra;
+        matcher.index = "extra";
+        for (matcher.idx = 1; matcher.idx <= 3; matcher.idx++)
+            for (bit = 0; bit < 32; bit++) {
+                matcher.num = 1 << bit;
+                obj_index_add(obj, &matcher);
+            }
+
+        matcher.pred = object_matches_affect;
+        matcher.index = "affect";
+        for (matcher.idx = 1; matcher.idx <= 3; matcher.idx++)
+            for (bit = 0; bit < 32; bit++) {
+                matcher.num = 1 << bit;
+                obj_index_add(obj, &matcher);
+            }
+        matcher.idx = 0;
+    }
+
+    g_array_sort(obj_proto_index_all, vnum_cmp);
+    g_hash_table_foreach(obj_proto_index, sort_index_entry, NULL);
+}
+
+void
+invalidate_object_index(void)
+{
+    if (!obj_proto_index)
+        return;
+    g_hash_table_destroy(obj_proto_index);
+    g_array_free(obj_proto_index_all, true);
+    obj_proto_index = NULL;
+    obj_proto_index_all = NULL;
+}
+
+static gint
+vnum_list_len_cmp(gconstpointer a, gconstpointer b)
+{
+    return (*(GArray * const *)a)->len - (*(GArray * const *)b)->len;
+}
+
+// Returns the sorted vnums of the prototypes matching every indexed,
+// non-negated matcher, intersecting the shortest lists first.  Indexed
+// matchers are marked so they aren't evaluated again.
+static GArray *
+find_object_candidates(GList *matchers)
+{
+    GPtrArray *lists = g_ptr_array_new();
+    GArray *result;
+
+    if (!obj_proto_index)
+        build_object_index();
+
+    for (GList *cur = matchers;cur;cur = cur->next) {
+        struct obj_matcher *matcher = cur->data;
+        GArray *vnums;
+
+        if (!matcher->index || matcher->negated)
+            continue;
+        vnums = g_hash_table_lookup(obj_proto_index, obj_index_key(matcher));
+        if (!vnums) {
+            g_ptr_array_free(lists, true);
+            return g_array_new(false, false, sizeof(int));
+        }
+        g_ptr_array_add(lists, vnums);
+        matcher->pred = NULL;
+    }
+
+    if (lists->len == 0)
+        g_ptr_array_add(lists, obj_proto_index_all);
+    g_ptr_array_sort(lists, vnum_list_len_cmp);
+
+    result = g_array_new(false, false, sizeof(int));
+    g_array_append_vals(result, ((GArray *)g_ptr_array_index(lists, 0))->data,
+                        ((GArray *)g_ptr_array_index(lists, 0))->len);
+    for (guint i = 1;i < lists->len && result->len;i++) {
+        GArray *other = g_ptr_array_index(lists, i);
+        guint read = 0, write = 0, pos = 0;
+
+        while (read < result->len && pos < other->len) {
+            int a = g_array_index(result, int, read);
+            int b = g_array_index(other, int, pos);
+
+            if (a < b) {
+                read++;
+            } else if (b < a) {
+                pos++;
+            } else {
+                g_array_index(result, int, write++) = a;
+                read++;
+                pos++;
+            }
+        }
+        g_array_set_size(result, write);
+    }
+    g_ptr_array_free(lists, true);
+
+    return result;
+}
+
 struct obj_matcher *
 make_object_matcher(struct creature *ch, char *expr)
 {
@@ -503,17 +714,113 @@ make_object_matcher(struct creature *ch, char *expr)
     return result;
 }
 
+static bool
+object_matches_all(struct obj_data *obj, GList *matchers)
+{
+    for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
+        struct obj_matcher *matcher = cur_matcher->data;
+        bool matches;
+
+        // Already satisfied by the index
+        if (!matcher->pred)
+            continue;
+        matches = matcher->pred(obj, matcher);
+        if (matcher->negated)
+            matches = !matches;
+        if (!matches)
+            return false;
+    }
+    return true;
+}
+
+static void
+show_object_match(struct creature *ch, struct obj_data *obj,
+                  GList *matchers, int found, struct room_data *room)
+{
+    acc_sprintf("%3d. %s[%s%5d%s]%s %-50s%s", found,
+                CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                obj->shared->vnum,
+                CCGRN(ch, C_NRM), CCYEL(ch, C_NRM),
+                obj->name, CCNRM(ch, C_NRM));
+    if (room)
+        acc_sprintf(" %s[%s%5d%s]%s",
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
+                    room->number,
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM));
+    for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
+        struct obj_matcher *matcher = cur_matcher->data;
+        if (matcher->info)
+            acc_strcat(" ", matcher->info(ch, obj, matcher), NULL);
+    }
+    acc_strcat("\r\n", NULL);
+}
+
+// The state of a prototype listing being paged
+struct object_listing {
+    gchar **exprv;
+    GList *matchers;
+    GArray *candidates;
+    guint pos;
+    int found;
+};
+
+static void
+free_object_listing(void *data)
+{
+    struct object_listing *listing = data;
+
+    g_strfreev(listing->exprv);
+    g_list_foreach(listing->matchers, (GFunc)free, NULL);
+    g_list_free(listing->matchers);
+    g_array_free(listing->candidates, true);
+    free(listing);
+}
+
+// Lists the next few matching prototypes.  Prototypes are looked up
+// again by vnum, since they may have been deleted between pages.
+static bool
+next_object_matches(struct descriptor_data *d, void *data)
+{
+    struct object_listing *listing = data;
+    int shown = 0;
+
+    if (!d->creature)
+        return false;
+
+    while (listing->pos < listing->candidates->len && shown < 20) {
+        int vnum = g_array_index(listing->candidates, int, listing->pos++);
+        struct obj_data *obj = real_object_proto(vnum);
+        struct tmp_mark mark = tmp_mark();
+
+        if (obj && object_matches_all(obj, listing->matchers)) {
+            show_object_match(d->creature, obj, listing->matchers,
+                              ++listing->found, NULL);
+            shown++;
+        }
+        tmp_release(mark);
+    }
+
+    return listing->pos < listing->candidates->len;
+}
+
 void
 do_show_objects(struct creature *ch, char *value, char *argument)
 {
     gchar **exprv;
     GList *matchers = NULL;
+    bool live = false;
+
+    if (!strcasecmp(value, "live")) {
+        live = true;
+        value = tmp_getword(&argument);
+    }
 
     if (!*value) {
         send_to_char(ch,
-                     "Usage: show object [!] <term>[, [!]<term> ...]\r\n"
+                     "Usage: show object [live] [!] <term>[, [!]<term> ...]\r\n"
                      "Precede the term with an exclamation point (!) to select\r\n"
-                     "objects that don't match.\r\n"
+                     "objects that don't match.  Use 'live' to search the objects\r\n"
+                     "in the world instead of the prototypes.\r\n"
                      "Valid terms can be:\r\n");
         for (int i = 0;match_table[i].matcher;i++) {
             send_to_char(ch, "%s\r\n", match_table[i].matcher);
@@ -533,37 +840,32 @@ do_show_objects(struct creature *ch, char *value, char *argument)
             goto cleanup;
     }
 
-    GHashTableIter iter;
-    struct obj_data *obj;
-    int vnum, found;
+    if (!live) {
+        struct object_listing *listing;
+
+        // Prototypes are only matched as the listing is paged through
+        CREATE(listing, struct object_listing, 1);
+        listing->exprv = exprv;
+        listing->matchers = matchers;
+        listing->candidates = find_object_candidates(matchers);
+        if (!page_generator(ch->desc, next_object_matches, listing,
+                            free_object_listing))
+            send_to_char(ch, "No matching objects found.\r\n");
+        return;
+    }
+
+    int found = 0;
 
     acc_string_clear();
-    found = 0;
 
-    g_hash_table_iter_init(&iter, obj_prototypes);
-    while (g_hash_table_iter_next(&iter, (gpointer)&vnum, (gpointer)&obj)) {
-        bool matches = false;
-        for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
-            struct obj_matcher *matcher = cur_matcher->data;
-            matches = matcher->pred(obj, matcher);
-            if (matcher->negated)
-                matches = !matches;
-            if (!matches)
-                break;
-        }
-        if (matches) {
-            acc_sprintf("%3d. %s[%s%5d%s]%s %-50s%s", ++found,
-                        CCGRN(ch, C_NRM), CCNRM(ch, C_NRM),
-                        obj->shared->vnum,
-                        CCGRN(ch, C_NRM), CCYEL(ch, C_NRM),
-                        obj->name, CCNRM(ch, C_NRM));
-            for (GList *cur_matcher = matchers;cur_matcher;cur_matcher = cur_matcher->next) {
-                struct obj_matcher *matcher = cur_matcher->data;
-                if (matcher->info)
-                    acc_strcat(" ", matcher->info(ch, obj, matcher), NULL);
-            }
-            acc_strcat("\r\n", NULL);
-        }
+    // Live objects can differ from their prototypes, so every
+    // matcher is checked against each one.
+    for (struct obj_data *obj = object_list;obj;obj = obj->next) {
+        struct tmp_mark mark = tmp_mark();
+
+        if (object_matches_all(obj, matchers))
+            show_object_match(ch, obj, matchers, ++found, where_obj(obj));
+        tmp_release(mark);
     }
 
     if (found)
@@ -0,0 +1,962 @@
+//
+// File: world_image.c                      -- Part of TempusMUD
+//
+// Compiled binary snapshot of the world files.
+//
+// The image consists of a fixed header followed by a payload.  The
+// header identifies the format version, the sizes of every structure
+// stored in the image, and an FNV-1a checksum of the payload.  The
+// payload starts with a manifest of every world source file (path,
+// mtime, size, and content hash) and is followed by the zones, rooms,
+// mobile prototypes, and object prototypes, in that order.  Structures
+// are stored as their raw in-memory representation followed by the
+// strings they own, so the image is only valid for the binary that
+// wrote it; the structure sizes and WORLD_IMAGE_VERSION catch most
+// layout changes, and the version must be bumped whenever a parser or
+// the prog object code format changes.
+//
+// The image is read through mmap() and every string is copied out, so
+// the resulting world is indistinguishable from one booted from the
+// text files.
+//
+
+#ifdef HAS_CONFIG_H
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+
+#include "interpreter.h"
+#include "structs.h"
+#include "utils.h"
+#include "constants.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "search.h"
+#include "prog.h"
+#include "weather.h"
+#include "world_image.h"
+
+#define WORLD_IMAGE_MAGIC "TMPSWRLD"
+#define WORLD_IMAGE_VERSION 2
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+enum {
+    IMG_SIZE_ROOM,
+    IMG_SIZE_DIR,
+    IMG_SIZE_EXDESC,
+    IMG_SIZE_SEARCH,
+    IMG_SIZE_ZONE,
+    IMG_SIZE_RESET,
+    IMG_SIZE_WEATHER,
+    IMG_SIZE_CREATURE,
+    IMG_SIZE_MOB_SHARED,
+    IMG_SIZE_OBJ,
+    IMG_SIZE_OBJ_SHARED,
+    IMG_SIZE_POINTER,
+    IMG_SIZE_COUNT
+};
+
+struct world_image_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t mini_mud;
+    uint32_t struct_sizes[IMG_SIZE_COUNT];
+    uint64_t payload_len;
+    uint64_t checksum;
+};
+
+struct world_source {
+    char *path;
+    int64_t mtime;
+    int64_t size;
+    uint64_t hash;
+};
+
+struct image_writer {
+    FILE *fl;
+    uint64_t checksum;
+    uint64_t len;
+};
+
+struct image_reader {
+    const unsigned char *pos;
+    const unsigned char *end;
+    bool error;
+};
+
+extern int mini_mud;
+extern int top_of_world;
+extern int top_of_zone_table;
+extern int *obj_index;
+extern int *mob_index;
+extern int *wld_index;
+extern struct zone_data *zone_table;
+extern struct player_special_data dummy_mob;
+
+bool use_world_image = false;
+bool world_image_loaded = false;
+
+static GList *world_sources = NULL;
+
+static uint64_t
+fnv_hash(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while (len--) {
+        hash ^= *p++;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static void
+image_struct_sizes(uint32_t *sizes)
+{
+    sizes[IMG_SIZE_ROOM] = sizeof(struct room_data);
+    sizes[IMG_SIZE_DIR] = sizeof(struct room_direction_data);
+    sizes[IMG_SIZE_EXDESC] = sizeof(struct extra_descr_data);
+    sizes[IMG_SIZE_SEARCH] = sizeof(struct special_search_data);
+    sizes[IMG_SIZE_ZONE] = sizeof(struct zone_data);
+    sizes[IMG_SIZE_RESET] = sizeof(struct reset_com);
+    sizes[IMG_SIZE_WEATHER] = sizeof(struct weather_data);
+    sizes[IMG_SIZE_CREATURE] = sizeof(struct creature);
+    sizes[IMG_SIZE_MOB_SHARED] = sizeof(struct mob_shared_data);
+    sizes[IMG_SIZE_OBJ] = sizeof(struct obj_data);
+    sizes[IMG_SIZE_OBJ_SHARED] = sizeof(struct obj_shared_data);
+    sizes[IMG_SIZE_POINTER] = sizeof(void *);
+}
+
+/*************************************************************************
+ * source manifest                                                       *
+ *************************************************************************/
+
+static void
+free_world_sources(void)
+{
+    for (GList *it = world_sources; it; it = it->next) {
+        struct world_source *src = it->data;
+        free(src->path);
+        free(src);
+    }
+    g_list_free(world_sources);
+    world_sources = NULL;
+}
+
+static bool
+scan_source_file(const char *path)
+{
+    static unsigned char chunk[65536];
+    struct world_source *src;
+    struct stat st;
+    uint64_t hash = FNV_OFFSET_BASIS;
+    size_t len;
+    FILE *fl;
+
+    fl = fopen(path, "r");
+    if (!fl)
+        return false;
+    if (fstat(fileno(fl), &st) < 0) {
+        fclose(fl);
+        return false;
+    }
+    while ((len = fread(chunk, 1, sizeof(chunk), fl)) > 0)
+        hash = fnv_hash(hash, chunk, len);
+    fclose(fl);
+
+    CREATE(src, struct world_source, 1);
+    src->path = strdup(path);
+    src->mtime = st.st_mtime;
+    src->size = st.st_size;
+    src->hash = hash;
+    world_sources = g_list_prepend(world_sources, src);
+
+    return true;
+}
+
+bool
+world_image_scan_sources(void)
+{
+    const char *prefixes[] = { ZON_PREFIX, WLD_PREFIX, NPC_PREFIX,
+                               OBJ_PREFIX, NULL };
+    const char *index_path;
+    char line[1024];
+    FILE *index;
+
+    free_world_sources();
+
+    for (int i = 0; prefixes[i]; i++) {
+        index_path = tmp_sprintf("%s/%s", prefixes[i],
+                                 (mini_mud) ? MINDEX_FILE : INDEX_FILE);
+        if (!scan_source_file(index_path))
+            goto failed;
+
+        index = fopen(index_path, "r");
+        if (!index)
+            goto failed;
+        while (fscanf(index, "%1023s", line) == 1 && *line != '$') {
+            if (!scan_source_file(tmp_sprintf("%s/%s", prefixes[i], line))) {
+                fclose(index);
+                goto failed;
+            }
+        }
+        fclose(index);
+    }
+
+    world_sources = g_list_reverse(world_sources);
+    return true;
+
+  failed:
+    errlog("Unable to scan world source files; world image disabled");
+    free_world_sources();
+    return false;
+}
+
+/*************************************************************************
+ * writing                                                               *
+ *************************************************************************/
+
+static void
+img_write(struct image_writer *w, const void *data, size_t len)
+{
+    if (len == 0)
+        return;
+    fwrite(data, 1, len, w->fl);
+    w->checksum = fnv_hash(w->checksum, data, len);
+    w->len += len;
+}
+
+static void
+img_write_int(struct image_writer *w, int32_t val)
+{
+    img_write(w, &val, sizeof(val));
+}
+
+static void
+img_write_blob(struct image_writer *w, const void *data, size_t len)
+{
+    img_write_int(w, (data) ? (int32_t)len : -1);
+    if (data)
+        img_write(w, data, len);
+}
+
+static void
+img_write_str(struct image_writer *w, const char *str)
+{
+    img_write_blob(w, str, (str) ? strlen(str) : 0);
+}
+
+static void
+img_write_exdescs(struct image_writer *w, struct extra_descr_data *exd_list)
+{
+    int count = 0;
+
+    for (struct extra_descr_data *exd = exd_list; exd; exd = exd->next)
+        count++;
+    img_write_int(w, count);
+    for (struct extra_descr_data *exd = exd_list; exd; exd = exd->next) {
+        img_write_str(w, exd->keyword);
+        img_write_str(w, exd->description);
+    }
+}
+
+static void
+img_write_room(struct image_writer *w, struct room_data *room)
+{
+    struct special_search_data *srch;
+    int dir_mask = 0, count = 0;
+
+    img_write(w, room, sizeof(*room));
+    img_write_str(w, room->name);
+    img_write_str(w, room->description);
+    img_write_str(w, room->sounds);
+    img_write_str(w, room->prog);
+    img_write_str(w, room->func_param);
+    img_write_blob(w, room->progobj, room->progobj_len);
+
+    for (int dir = 0; dir < NUM_OF_DIRS; dir++)
+        if (room->dir_option[dir])
+            dir_mask |= (1 << dir);
+    img_write_int(w, dir_mask);
+    for (int dir = 0; dir < NUM_OF_DIRS; dir++) {
+        struct room_direction_data *exit = room->dir_option[dir];
+
+        if (!exit)
+            continue;
+        img_write(w, exit, sizeof(*exit));
+        img_write_str(w, exit->general_description);
+        img_write_str(w, exit->keyword);
+        img_write_int(w, (exit->to_room) ? exit->to_room->number : NOWHERE);
+    }
+
+    img_write_exdescs(w, room->ex_description);
+
+    for (srch = room->search; srch; srch = srch->next)
+        count++;
+    img_write_int(w, count);
+    for (srch = room->search; srch; srch = srch->next) {
+        img_write(w, srch, sizeof(*srch));
+        img_write_str(w, srch->command_keys);
+        img_write_str(w, srch->keywords);
+        img_write_str(w, srch->to_vict);
+        img_write_str(w, srch->to_room);
+        img_write_str(w, srch->to_remote);
+    }
+}
+
+static void
+img_write_zone(struct image_writer *w, struct zone_data *zone)
+{
+    struct reset_com *cmd;
+    struct room_data *room;
+    int count = 0;
+
+    img_write(w, zone, sizeof(*zone));
+    img_write_str(w, zone->name);
+    img_write_str(w, zone->public_desc);
+    img_write_str(w, zone->private_desc);
+    img_write_str(w, zone->author);
+    img_write_int(w, zone->weather != NULL);
+    if (zone->weather)
+        img_write(w, zone->weather, sizeof(*zone->weather));
+
+    for (cmd = zone->cmd; cmd; cmd = cmd->next)
+        count++;
+    img_write_int(w, count);
+    for (cmd = zone->cmd; cmd; cmd = cmd->next)
+        img_write(w, cmd, sizeof(*cmd));
+
+    count = 0;
+    for (room = zone->world; room; room = room->next)
+        count++;
+    img_write_int(w, count);
+    for (room = zone->world; room; room = room->next)
+        img_write_room(w, room);
+}
+
+static void
+img_write_mobile(struct image_writer *w, struct creature *mob)
+{
+    struct mob_shared_data *shared = mob->mob_specials.shared;
+
+    img_write(w, mob, sizeof(*mob));
+    img_write(w, shared, sizeof(*shared));
+    img_write_str(w, mob->player.name);
+    img_write_str(w, mob->player.short_descr);
+    img_write_str(w, mob->player.long_descr);
+    img_write_str(w, mob->player.description);
+    img_write_str(w, mob->player.title);
+    img_write_str(w, shared->move_buf);
+    img_write_str(w, shared->func_param);
+    img_write_str(w, shared->load_param);
+    img_write_str(w, shared->prog);
+    img_write_blob(w, shared->progobj, shared->progobj_len);
+}
+
+static void
+img_write_object(struct image_writer *w, struct obj_data *obj)
+{
+    img_write(w, obj, sizeof(*obj));
+    img_write(w, obj->shared, sizeof(*obj->shared));
+    img_write_str(w, obj->name);
+    img_write_str(w, obj->aliases);
+    img_write_str(w, obj->line_desc);
+    img_write_str(w, obj->action_desc);
+    img_write_str(w, obj->engraving);
+    img_write_str(w, obj->shared->func_param);
+    img_write_exdescs(w, obj->ex_description);
+}
+
+static void
+img_write_index(struct image_writer *w, int *index)
+{
+    int count = 0;
+
+    while (index && index[count] != -1)
+        count++;
+    img_write_int(w, count);
+    img_write(w, index, count * sizeof(int));
+}
+
+void
+save_world_image(void)
+{
+    struct world_image_header hdr;
+    struct image_writer w;
+    struct zone_data *zone;
+    GHashTableIter iter;
+    gpointer key, val;
+    const char *tmp_path;
+    int count;
+
+    if (!world_sources) {
+        errlog("World sources were not scanned; not writing world image");
+        return;
+    }
+
+    tmp_path = tmp_sprintf("%s.new", WORLD_IMAGE_FILE);
+    w.fl = fopen(tmp_path, "w");
+    if (!w.fl) {
+        errlog("Unable to open %s for writing: %s", tmp_path,
+               strerror(errno));
+        return;
+    }
+    w.checksum = FNV_OFFSET_BASIS;
+    w.len = 0;
+
+    // The header is rewritten once the payload checksum is known
+    memset(&hdr, 0, sizeof(hdr));
+    fwrite(&hdr, sizeof(hdr), 1, w.fl);
+
+    img_write_int(&w, g_list_length(world_sources));
+    for (GList *it = world_sources; it; it = it->next) {
+        struct world_source *src = it->data;
+        img_write_str(&w, src->path);
+        img_write(&w, &src->mtime, sizeof(src->mtime));
+        img_write(&w, &src->size, sizeof(src->size));
+        img_write(&w, &src->hash, sizeof(src->hash));
+    }
+
+    img_write_int(&w, top_of_world);
+    img_write_int(&w, top_of_zone_table);
+    img_write_index(&w, wld_index);
+    img_write_index(&w, mob_index);
+    img_write_index(&w, obj_index);
+
+    count = 0;
+    for (zone = zone_table; zone; zone = zone->next)
+        count++;
+    img_write_int(&w, count);
+    for (zone = zone_table; zone; zone = zone->next)
+        img_write_zone(&w, zone);
+
+    img_write_int(&w, g_hash_table_size(mob_prototypes));
+    g_hash_table_iter_init(&iter, mob_prototypes);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        img_write_mobile(&w, val);
+
+    img_write_int(&w, g_hash_table_size(obj_prototypes));
+    g_hash_table_iter_init(&iter, obj_prototypes);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        img_write_object(&w, val);
+
+    memcpy(hdr.magic, WORLD_IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = WORLD_IMAGE_VERSION;
+    hdr.mini_mud = mini_mud;
+    image_struct_sizes(hdr.struct_sizes);
+    hdr.payload_len = w.len;
+    hdr.checksum = w.checksum;
+
+    rewind(w.fl);
+    fwrite(&hdr, sizeof(hdr), 1, w.fl);
+
+    if (ferror(w.fl) | fclose(w.fl)) {
+        errlog("Error writing world image: %s", strerror(errno));
+        unlink(tmp_path);
+        return;
+    }
+    if (rename(tmp_path, WORLD_IMAGE_FILE) < 0) {
+        errlog("Unable to rename %s to %s: %s", tmp_path, WORLD_IMAGE_FILE,
+               strerror(errno));
+        unlink(tmp_path);
+        return;
+    }
+
+    slog("Wrote world image (%" PRIu64 " bytes, %u source files).",
+         (uint64_t)(sizeof(hdr) + w.len), g_list_length(world_sources));
+}
+
+/*************************************************************************
+ * reading                                                               *
+ *************************************************************************/
+
+static void
+img_read(struct image_reader *r, void *data, size_t len)
+{
+    if (r->error || (size_t)(r->end - r->pos) < len) {
+        r->error = true;
+        memset(data, 0, len);
+        return;
+    }
+    memcpy(data, r->pos, len);
+    r->pos += len;
+}
+
+static int32_t
+img_read_int(struct image_reader *r)
+{
+    int32_t val;
+
+    img_read(r, &val, sizeof(val));
+    return val;
+}
+
+static void *
+img_read_blob(struct image_reader *r, size_t *len_out)
+{
+    int32_t len = img_read_int(r);
+    unsigned char *result;
+
+    if (len_out)
+        *len_out = 0;
+    if (r->error || len < 0)
+        return NULL;
+    if ((size_t)(r->end - r->pos) < (size_t)len) {
+        r->error = true;
+        return NULL;
+    }
+    // Allocate an extra byte so that strings are always terminated
+    CREATE(result, unsigned char, len + 1);
+    memcpy(result, r->pos, len);
+    r->pos += len;
+    if (len_out)
+        *len_out = len;
+
+    return result;
+}
+
+static char *
+img_read_str(struct image_reader *r)
+{
+    return img_read_blob(r, NULL);
+}
+
+static struct extra_descr_data *
+img_read_exdescs(struct image_reader *r)
+{
+    struct extra_descr_data *head = NULL, *tail = NULL, *exd;
+    int count = img_read_int(r);
+
+    for (int i = 0; i < count && !r->error; i++) {
+        CREATE(exd, struct extra_descr_data, 1);
+        exd->keyword = img_read_str(r);
+        exd->description = img_read_str(r);
+        if (tail)
+            tail->next = exd;
+        else
+            head = exd;
+        tail = exd;
+    }
+
+    return head;
+}
+
+static struct room_data *
+img_read_room(struct image_reader *r, struct zone_data *zone)
+{
+    struct room_data *room;
+    struct special_search_data *srch, *srch_tail = NULL;
+    int dir_mask, count;
+
+    CREATE(room, struct room_data, 1);
+    img_read(r, room, sizeof(*room));
+    room->name = img_read_str(r);
+    room->description = img_read_str(r);
+    room->sounds = img_read_str(r);
+    room->prog = img_read_str(r);
+    room->func_param = img_read_str(r);
+    room->progobj = img_read_blob(r, &room->progobj_len);
+    prog_link(room->progobj);
+    prog_register_owner(room, PROG_TYPE_ROOM);
+    room->prog_marker = 0;
+    room->prog_state = NULL;
+    room->affects = NULL;
+    room->trail = NULL;
+    room->func = NULL;
+    room->zone = zone;
+    room->next = NULL;
+    room->contents = NULL;
+    room->contents_serial = 0;
+    room->house_rent = 0;
+    room->house_objects = 0;
+    room->people = NULL;
+    room->light = 0;
+
+    dir_mask = img_read_int(r);
+    for (int dir = 0; dir < NUM_OF_DIRS; dir++) {
+        struct room_direction_data *exit;
+
+        room->dir_option[dir] = NULL;
+        if (r->error || !(dir_mask & (1 << dir)))
+            continue;
+        CREATE(exit, struct room_direction_data, 1);
+        img_read(r, exit, sizeof(*exit));
+        exit->general_description = img_read_str(r);
+        exit->keyword = img_read_str(r);
+        // renum_world() expects the destination vnum in the pointer
+        exit->to_room = GINT_TO_POINTER(img_read_int(r));
+        room->dir_option[dir] = exit;
+    }
+
+    room->ex_description = img_read_exdescs(r);
+
+    room->search = NULL;
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++) {
+        CREATE(srch, struct special_search_data, 1);
+        img_read(r, srch, sizeof(*srch));
+        srch->command_keys = img_read_str(r);
+        srch->keywords = img_read_str(r);
+        srch->to_vict = img_read_str(r);
+        srch->to_room = img_read_str(r);
+        srch->to_remote = img_read_str(r);
+        srch->next = NULL;
+        if (srch_tail)
+            srch_tail->next = srch;
+        else
+            room->search = srch;
+        srch_tail = srch;
+    }
+
+    return room;
+}
+
+static struct zone_data *
+img_read_zone(struct image_reader *r)
+{
+    struct zone_data *zone;
+    struct reset_com *cmd, *cmd_tail = NULL;
+    struct room_data *room, *room_tail = NULL;
+    int count;
+
+    CREATE(zone, struct zone_data, 1);
+    img_read(r, zone, sizeof(*zone));
+    zone->name = img_read_str(r);
+    zone->public_desc = img_read_str(r);
+    zone->private_desc = img_read_str(r);
+    zone->author = img_read_str(r);
+    zone->world = NULL;
+    zone->cmd = NULL;
+    zone->weather = NULL;
+    zone->next = NULL;
+    zone->num_players = 0;
+    zone->idle_time = 0;
+
+    if (img_read_int(r)) {
+        CREATE(zone->weather, struct weather_data, 1);
+        img_read(r, zone->weather, sizeof(*zone->weather));
+    }
+
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++) {
+        CREATE(cmd, struct reset_com, 1);
+        img_read(r, cmd, sizeof(*cmd));
+        cmd->next = NULL;
+        if (cmd_tail)
+            cmd_tail->next = cmd;
+        else
+            zone->cmd = cmd;
+        cmd_tail = cmd;
+    }
+
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++) {
+        room = img_read_room(r, zone);
+        if (room_tail)
+            room_tail->next = room;
+        else
+            zone->world = room;
+        room_tail = room;
+    }
+
+    return zone;
+}
+
+static struct creature *
+img_read_mobile(struct image_reader *r)
+{
+    struct creature *mob;
+    struct mob_shared_data *shared;
+
+    CREATE(mob, struct creature, 1);
+    CREATE(shared, struct mob_shared_data, 1);
+    img_read(r, mob, sizeof(*mob));
+    img_read(r, shared, sizeof(*shared));
+
+    // Nothing but the strings and the shared data survive from the
+    // image; a prototype is never in the game, so everything else is
+    // cleared.
+    mob->in_room = NULL;
+    mob->fighting = NULL;
+    mob->player_specials = &dummy_mob;
+    mob->mob_specials.memory = NULL;
+    mob->mob_specials.func_data = NULL;
+    mob->mob_specials.shared = shared;
+    mob->language_data.languages_heard = NULL;
+    mob->char_specials.defending = NULL;
+    mob->char_specials.hunting = NULL;
+    mob->char_specials.mounted = NULL;
+    mob->char_specials.mood_str = NULL;
+    mob->affected = NULL;
+    for (int pos = 0; pos < NUM_WEARS; pos++) {
+        mob->equipment[pos] = NULL;
+        mob->implants[pos] = NULL;
+        mob->tattoos[pos] = NULL;
+    }
+    mob->prog_state = NULL;
+    mob->carrying = NULL;
+    mob->desc = NULL;
+    mob->account = NULL;
+    mob->followers = NULL;
+    mob->master = NULL;
+    mob->prog_marker = 0;
+
+    mob->player.name = img_read_str(r);
+    mob->player.short_descr = img_read_str(r);
+    mob->player.long_descr = img_read_str(r);
+    mob->player.description = img_read_str(r);
+    mob->player.title = img_read_str(r);
+
+    shared->number = 0;
+    shared->kills = 0;
+    shared->loaded = 0;
+    shared->proto = mob;
+    shared->func = NULL;
+    shared->move_buf = img_read_str(r);
+    shared->func_param = img_read_str(r);
+    shared->load_param = img_read_str(r);
+    shared->prog = img_read_str(r);
+    shared->progobj = img_read_blob(r, &shared->progobj_len);
+    prog_link(shared->progobj);
+
+    return mob;
+}
+
+static struct obj_data *
+img_read_object(struct image_reader *r)
+{
+    struct obj_data *obj;
+    struct obj_shared_data *shared;
+
+    CREATE(obj, struct obj_data, 1);
+    CREATE(shared, struct obj_shared_data, 1);
+    img_read(r, obj, sizeof(*obj));
+    img_read(r, shared, sizeof(*shared));
+
+    obj->in_room = NULL;
+    obj->carried_by = NULL;
+    obj->worn_by = NULL;
+    obj->shared = shared;
+    obj->func_data = NULL;
+    obj->tmp_affects = NULL;
+    obj->in_obj = NULL;
+    obj->contains = NULL;
+    obj->aux_obj = NULL;
+    obj->next_content = NULL;
+    obj->next = NULL;
+
+    obj->name = img_read_str(r);
+    obj->aliases = img_read_str(r);
+    obj->line_desc = img_read_str(r);
+    obj->action_desc = img_read_str(r);
+    obj->engraving = img_read_str(r);
+
+    shared->number = 0;
+    shared->house_count = 0;
+    shared->proto = obj;
+    shared->func = NULL;
+    shared->func_param = img_read_str(r);
+
+    obj->ex_description = img_read_exdescs(r);
+
+    return obj;
+}
+
+static int *
+img_read_index(struct image_reader *r)
+{
+    int count = img_read_int(r);
+    int *index;
+
+    if (r->error || count < 0)
+        return NULL;
+    CREATE(index, int, count + 1);
+    img_read(r, index, count * sizeof(int));
+    index[count] = -1;
+
+    return index;
+}
+
+static bool
+img_sources_match(struct image_reader *r)
+{
+    int count = img_read_int(r);
+    bool match = (count == (int)g_list_length(world_sources));
+    GList *it = world_sources;
+
+    for (int i = 0; i < count && !r->error; i++) {
+        struct world_source src;
+        char *path = img_read_str(r);
+
+        img_read(r, &src.mtime, sizeof(src.mtime));
+        img_read(r, &src.size, sizeof(src.size));
+        img_read(r, &src.hash, sizeof(src.hash));
+
+        if (match) {
+            struct world_source *cur = it->data;
+
+            if (!path || strcmp(path, cur->path)
+                || src.mtime != cur->mtime
+                || src.size != cur->size || src.hash != cur->hash) {
+                slog("World image is stale: %s has changed.", cur->path);
+                match = false;
+            }
+            it = it->next;
+        }
+        free(path);
+    }
+
+    return match && !r->error;
+}
+
+static bool
+img_read_world(struct image_reader *r)
+{
+    struct zone_data *zones = NULL, *zone_tail = NULL, *zone;
+    GList *mobs = NULL, *objs = NULL;
+    int world_top, zone_top, count;
+    int *wld_idx, *mob_idx, *obj_idx;
+
+    world_top = img_read_int(r);
+    zone_top = img_read_int(r);
+    wld_idx = img_read_index(r);
+    mob_idx = img_read_index(r);
+    obj_idx = img_read_index(r);
+
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++) {
+        zone = img_read_zone(r);
+        if (zone_tail)
+            zone_tail->next = zone;
+        else
+            zones = zone;
+        zone_tail = zone;
+    }
+
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++)
+        mobs = g_list_prepend(mobs, img_read_mobile(r));
+
+    count = img_read_int(r);
+    for (int i = 0; i < count && !r->error; i++)
+        objs = g_list_prepend(objs, img_read_object(r));
+
+    if (r->error || r->pos != r->end) {
+        // The checksum matched, so this is a bug in the image code.
+        // The partially read world is leaked; we are about to parse
+        // the text files anyway.
+        errlog("World image is malformed; booting from text files.");
+        g_list_free(mobs);
+        g_list_free(objs);
+        return false;
+    }
+
+    zone_table = zones;
+    top_of_world = world_top;
+    top_of_zone_table = zone_top;
+    wld_index = wld_idx;
+    mob_index = mob_idx;
+    obj_index = obj_idx;
+
+    for (GList *it = mobs; it; it = it->next)
+        g_hash_table_insert(mob_prototypes,
+            GINT_TO_POINTER(GET_NPC_VNUM((struct creature *)it->data)),
+            it->data);
+    for (GList *it = objs; it; it = it->next)
+        g_hash_table_insert(obj_prototypes,
+            GINT_TO_POINTER(GET_OBJ_VNUM((struct obj_data *)it->data)),
+            it->data);
+    g_list_free(mobs);
+    g_list_free(objs);
+    invalidate_mobile_index();
+    invalidate_object_index();
+
+    return true;
+}
+
+bool
+load_world_image(void)
+{
+    struct world_image_header hdr;
+    struct image_reader reader;
+    uint32_t sizes[IMG_SIZE_COUNT];
+    const unsigned char *base;
+    void *map;
+    struct stat st;
+    bool result = false;
+    int fd;
+
+    world_image_loaded = false;
+    if (!world_sources)
+        return false;
+
+    fd = open(WORLD_IMAGE_FILE, O_RDONLY);
+    if (fd < 0) {
+        slog("No world image found; booting from text files.");
+        return false;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(hdr)) {
+        close(fd);
+        slog("World image is truncated; booting from text files.");
+        return false;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        errlog("Unable to map world image: %s", strerror(errno));
+        return false;
+    }
+
+    base = map;
+    memcpy(&hdr, base, sizeof(hdr));
+    image_struct_sizes(sizes);
+
+    if (memcmp(hdr.magic, WORLD_IMAGE_MAGIC, sizeof(hdr.magic))
+        || hdr.version != WORLD_IMAGE_VERSION
+        || memcmp(hdr.struct_sizes, sizes, sizeof(sizes))) {
+        slog("World image is from an incompatible version; booting from text files.");
+    } else if (hdr.mini_mud != (uint32_t)mini_mud) {
+        slog("World image was built for a different index; booting from text files.");
+    } else if (hdr.payload_len != st.st_size - sizeof(hdr)
+               || hdr.checksum != fnv_hash(FNV_OFFSET_BASIS,
+                                           base + sizeof(hdr),
+                                           hdr.payload_len)) {
+        errlog("World image checksum failed; booting from text files.");
+    } else {
+        reader.pos = base + sizeof(hdr);
+        reader.end = reader.pos + hdr.payload_len;
+        reader.error = false;
+
+        if (img_sources_match(&reader))
+            result = img_read_world(&reader);
+    }
+
+    munmap(map, st.st_size);
+
+    world_image_loaded = result;
+    return result;
+}
@@ -756,9 +756,8 @@ editor_help(struct editor *editor, char *line)
         help_item = help_collection_find_items(help,
             tmp_sprintf("tedii-%c", *command), false, 0, false);
         if (help_item) {
-            help_item_load_text(help_item);
             d_printf(editor->desc, "&cTEDII Command '%c'&n\r\n", *command);
-            d_printf(editor->desc, "%s", help_item->text);
+            d_printf(editor->desc, "%s", help_item_text(help_item));
         } else {
             d_printf(editor->desc,
                 "Sorry.  There is no help on that.\r\n");
@@ -30,6 +30,7 @@
 
 struct texteditor_data {
     char **target;
+    bool *mark;                 // set when the text is saved, if not NULL
 };
 
 void
@@ -61,6 +62,8 @@ texteditor_finalize(struct editor *editor, const char *text)
     }
 
     *text_data->target = strdup(text);
+    if (text_data->mark)
+        *text_data->mark = true;
 
     // If editing their description.
     if (STATE(editor->desc) == CXN_EDIT_DESC) {
@@ -83,8 +86,26 @@ texteditor_finalize(struct editor *editor, const char *text)
     free_texteditor(editor);
 }
 
+bool
+texteditor_is_editing(struct editor *editor, char *buffer)
+{
+    struct texteditor_data *text_data =
+        (struct texteditor_data *)editor->mode_data;
+
+    return buffer && *text_data->target == buffer;
+}
+
 void
 start_editing_text(struct descriptor_data *d, char **dest, int max)
+{
+    start_editing_marked_text(d, dest, max, NULL);
+}
+
+// Edits the text like start_editing_text(), setting *mark when the
+// text is saved, so that its owner knows to save it again
+void
+start_editing_marked_text(struct descriptor_data *d, char **dest, int max,
+                          bool *mark)
 {
     struct texteditor_data *text_data;
     // There MUST be a destination!
@@ -115,9 +136,11 @@ start_editing_text(struct descriptor_data *d, char **dest, int max)
     CREATE(text_data, struct texteditor_data, 1);
     d->text_editor->finalize = texteditor_finalize;
     d->text_editor->cancel = texteditor_cancel;
+    d->text_editor->is_editing = texteditor_is_editing;
     d->text_editor->mode_data = text_data;
 
     text_data->target = dest;
+    text_data->mark = mark;
     if (*dest)
         editor_import(d->text_editor, *dest);
 
@@ -553,6 +553,7 @@ affect_to_room(struct room_data *room, struct room_affect_data *aff)
             SET_BIT(room->room_flags, aff->flags);
         else
             return;
+        invalidate_sight();
     } else if (aff->spell_type) {
     } else if (!(aff->type == -1) && aff->spell_type) {
         errlog("Invalid aff->type passed to affect_to_room.");
@@ -595,9 +596,10 @@ affect_from_room(struct room_data *room, struct room_affect_data *aff)
     if (!tmp_aff)
         errlog("affect_from_room(): aff not found in room->affects");
 
-    if (aff->type == RM_AFF_FLAGS)
+    if (aff->type == RM_AFF_FLAGS) {
         REMOVE_BIT(room->room_flags, aff->flags);
-    else if (aff->type < NUM_DIRS && room->dir_option[(int)aff->type])
+        invalidate_sight();
+    } else if (aff->type < NUM_DIRS && room->dir_option[(int)aff->type])
         REMOVE_BIT(room->dir_option[(int)aff->type]->exit_info, aff->flags);
     else if (aff->type != RM_AFF_OTHER)
         errlog("affect_from_room(): Invalid aff->type %d", aff->type);
@@ -8,6 +8,10 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <glib.h>
 
 #include "interpreter.h"
@@ -26,6 +30,7 @@
 #include "account.h"
 #include "help.h"
 #include "strutil.h"
+#include "accstr.h"
 
 // The global HelpCollection object.
 // Allocated in comm.cc
@@ -145,21 +150,67 @@ const char *help_bits[] = {
     "\n"
 };
 
+// One keyword of a help topic, as split up by one_word()
+struct help_key {
+    char *word;
+    int order;
+};
+
 struct help_collection *
 make_help_collection(void)
 {
     struct help_collection *col;
 
     CREATE(col, struct help_collection, 1);
+    col->ordered = g_ptr_array_new();
+    col->unindexed = g_ptr_array_new();
+    col->keys_stale = true;
 
     return col;
 }
 
+static void
+free_help_keys(struct help_collection *col)
+{
+    GArray *all = col->keys[HGROUP_MAX];
+
+    if (all)
+        for (guint i = 0; i < all->len; i++)
+            free(g_array_index(all, struct help_key, i).word);
+    for (int g = 0; g <= HGROUP_MAX; g++) {
+        if (col->keys[g])
+            g_array_free(col->keys[g], true);
+        col->keys[g] = NULL;
+    }
+}
+
+static void
+free_help_store(struct help_collection *col)
+{
+    for (guint i = 0; i < col->ordered->len; i++) {
+        struct help_item *item = g_ptr_array_index(col->ordered, i);
+
+        item->stored_text = NULL;
+    }
+    if (col->store)
+        munmap(col->store, col->store_size);
+    col->store = NULL;
+    col->store_size = 0;
+    if (col->words)
+        g_hash_table_destroy(col->words);
+    col->words = NULL;
+}
+
 void
 free_help_collection(struct help_collection *col)
 {
+    free_help_keys(col);
+    free_help_store(col);
+    g_ptr_array_free(col->ordered, true);
+    g_ptr_array_free(col->unindexed, true);
     g_list_foreach(col->items, (GFunc) free_help_item, NULL);
     g_list_free(col->items);
+    free(col);
 
     slog("Help system ended.");
 }
@@ -168,6 +219,375 @@ void
 help_collection_push(struct help_collection *col, struct help_item *n)
 {
     col->items = g_list_append(col->items, n);
+    n->order = col->ordered->len;
+    g_ptr_array_add(col->ordered, n);
+    if (!n->text_indexed)
+        g_ptr_array_add(col->unindexed, n);
+    col->keys_stale = true;
+}
+
+static int
+help_key_cmp(const void *a, const void *b)
+{
+    const struct help_key *key_a = a, *key_b = b;
+    int result = strcmp(key_a->word, key_b->word);
+
+    if (result)
+        return result;
+    return key_a->order - key_b->order;
+}
+
+// Splits the keywords of every topic into one sorted array, so that all
+// the keywords starting with a prefix are next to each other, and copies
+// it into a smaller array for each group.
+void
+help_collection_index_keys(struct help_collection *col)
+{
+    char bit[MAX_HELP_NAME_LENGTH * 2];
+    GArray *all;
+
+    free_help_keys(col);
+    all = g_array_new(false, false, sizeof(struct help_key));
+    for (guint i = 0; i < col->ordered->len; i++) {
+        struct help_item *item = g_ptr_array_index(col->ordered, i);
+        char *keys = tmp_strdup(item->keys ? item->keys : "");
+        char *b = keys;
+
+        if (strlen(keys) >= sizeof(bit))
+            keys[sizeof(bit) - 1] = '\0';
+        while (*b) {
+            b = one_word(b, bit);
+            if (*bit) {
+                struct help_key key = { strdup(bit), item->order };
+                g_array_append_val(all, key);
+            }
+        }
+    }
+    qsort(all->data, all->len, sizeof(struct help_key), help_key_cmp);
+
+    for (int g = 0; g < HGROUP_MAX; g++) {
+        col->keys[g] = g_array_new(false, false, sizeof(struct help_key));
+        for (guint i = 0; i < all->len; i++) {
+            struct help_key *key = &g_array_index(all, struct help_key, i);
+            struct help_item *item = g_ptr_array_index(col->ordered, key->order);
+
+            if (help_item_in_group(item, 1 << g))
+                g_array_append_val(col->keys[g], *key);
+        }
+    }
+    col->keys[HGROUP_MAX] = all;
+    col->keys_stale = false;
+}
+
+// Splits text into lowercase words, skipping color codes.  Returns false
+// when there are no more words.
+static bool
+next_help_word(const char **text, char *word)
+{
+    const char *c = *text;
+    int len = 0;
+
+    while (*c && !isalnum(*c)) {
+        if (*c == '&' && isalpha(c[1]))
+            c++;
+        c++;
+    }
+    if (!*c)
+        return false;
+    while (isalnum(*c)) {
+        if (len < MAX_HELP_WORD_LENGTH - 1)
+            word[len++] = tolower(*c);
+        c++;
+    }
+    word[len] = '\0';
+    *text = c;
+
+    return true;
+}
+
+static void
+index_help_words(GHashTable *words, const char *text, int order)
+{
+    char word[MAX_HELP_WORD_LENGTH];
+
+    while (next_help_word(&text, word)) {
+        GArray *orders = g_hash_table_lookup(words, word);
+
+        if (!orders) {
+            orders = g_array_new(false, false, sizeof(int));
+            g_hash_table_insert(words, strdup(word), orders);
+        }
+        // Topics are indexed in order, so a repeat is always the last one
+        if (orders->len && g_array_index(orders, int, orders->len - 1) == order)
+            continue;
+        g_array_append_val(orders, order);
+    }
+}
+
+static void
+free_help_orders(gpointer orders)
+{
+    g_array_free(orders, true);
+}
+
+// The text store starts with this line and the number of topics, then
+// a line for each topic with its idnum and the offset of its text, or
+// -1 if it had none, each field ten characters wide.  The texts follow
+// end to end.
+#define HELP_STORE_MAGIC "HSTORE 1"
+
+// Maps the text store at path, pointing each topic at its text and
+// indexing the words of them all.  If current is set, the store is
+// only used if it holds every topic and is newer than the index and
+// each topic's file.
+static bool
+help_collection_map_store(struct help_collection *col, const char *path,
+                          bool current)
+{
+    struct stat stat_buf, src_buf;
+    long *offsets = NULL;
+    long header_len, size;
+    char *store = NULL;
+    guint count;
+    FILE *inf;
+    bool ok = false;
+
+    inf = fopen(path, "r");
+    if (!inf)
+        return false;
+    if (fstat(fileno(inf), &stat_buf) < 0
+        || fscanf(inf, HELP_STORE_MAGIC " %u\n", &count) != 1
+        || count != col->ordered->len)
+        goto done;
+    if (current
+        && (stat(tmp_sprintf("%s/index", HELP_DIRECTORY), &src_buf) < 0
+            || src_buf.st_mtime >= stat_buf.st_mtime))
+        goto done;
+
+    CREATE(offsets, long, count + 1);
+    for (guint i = 0; i < count; i++) {
+        struct help_item *item = g_ptr_array_index(col->ordered, i);
+        int idnum;
+
+        if (fscanf(inf, "%d %ld\n", &idnum, &offsets[i]) != 2
+            || idnum != item->idnum)
+            goto done;
+        if (!current)
+            continue;
+        // Topics being changed, or changed since, need a new store
+        if (item->text)
+            goto done;
+        if (stat(tmp_sprintf("%s/%04d.topic", HELP_DIRECTORY, item->idnum),
+                 &src_buf) < 0) {
+            if (offsets[i] >= 0)
+                goto done;
+        } else if (offsets[i] < 0 || src_buf.st_mtime >= stat_buf.st_mtime) {
+            goto done;
+        }
+    }
+    // Reading the last line may have skipped space the text began with
+    header_len = strlen(HELP_STORE_MAGIC) + 12 + count * 22;
+    size = stat_buf.st_size - header_len;
+    if (size < 0)
+        goto done;
+
+    if (size > 0) {
+        store = mmap(NULL, stat_buf.st_size, PROT_READ, MAP_SHARED,
+                     fileno(inf), 0);
+        if (store == MAP_FAILED) {
+            errlog("Unable to map help text store (%s): %s", path,
+                   strerror(errno));
+            store = NULL;
+            goto done;
+        }
+        if (store[stat_buf.st_size - 1] != '\0') {
+            munmap(store, stat_buf.st_size);
+            store = NULL;
+            goto done;
+        }
+    }
+    for (guint i = 0; i < count; i++)
+        if (offsets[i] >= size) {
+            if (store)
+                munmap(store, stat_buf.st_size);
+            store = NULL;
+            goto done;
+        }
+
+    free_help_store(col);
+    col->store = store;
+    col->store_size = (store) ? stat_buf.st_size : 0;
+    col->words = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+                                       free_help_orders);
+    for (guint i = 0; i < count; i++) {
+        struct help_item *item = g_ptr_array_index(col->ordered, i);
+
+        if (offsets[i] >= 0)
+            item->stored_text = store + header_len + offsets[i];
+        index_help_words(col->words, item->name ? item->name : "", item->order);
+        if (item->stored_text)
+            index_help_words(col->words, item->stored_text, item->order);
+        item->text_indexed = true;
+    }
+    g_ptr_array_set_size(col->unindexed, 0);
+
+    slog("Help: %ld bytes of text stored, %u words indexed", size,
+         g_hash_table_size(col->words));
+    ok = true;
+
+done:
+    free(offsets);
+    fclose(inf);
+    return ok;
+}
+
+// Reads the text of every topic once, writing them end to end into one
+// file which is mapped into memory.  Topics are then served from the map
+// without opening their files, and since the map is backed by the file,
+// the kernel can drop pages of it nobody has been reading.  The words of
+// every stored topic are indexed while the text is at hand.  The store
+// is written beside the old one and renamed over it, so that a store
+// still mapped is never changed.
+bool
+help_collection_build_store(struct help_collection *col, const char *path)
+{
+    char *new_path = tmp_strcat(path, ".new", NULL);
+    long *offsets;
+    long size = 0;
+    FILE *ouf;
+
+    ouf = fopen(new_path, "w");
+    if (!ouf) {
+        errlog("Unable to write help text store (%s): %s", new_path,
+               strerror(errno));
+        return false;
+    }
+
+    // The header is written again once the offsets are known, so its
+    // fields are of fixed width
+    CREATE(offsets, long, col->ordered->len + 1);
+    for (int pass = 0; pass < 2; pass++) {
+        fprintf(ouf, HELP_STORE_MAGIC " %10u\n", col->ordered->len);
+        for (guint i = 0; i < col->ordered->len; i++)
+            fprintf(ouf, "%10d %10ld\n",
+                    ((struct help_item *)g_ptr_array_index(col->ordered, i))->idnum,
+                    offsets[i]);
+        if (pass)
+            break;
+
+        for (guint i = 0; i < col->ordered->len; i++) {
+            struct help_item *item = g_ptr_array_index(col->ordered, i);
+            bool loaded = (item->text || item->stored_text);
+
+            offsets[i] = -1;
+            if (!loaded && !help_item_load_text(item))
+                continue;
+            const char *text = help_item_text(item);
+            offsets[i] = size;
+            size += strlen(text) + 1;
+            fwrite(text, 1, strlen(text) + 1, ouf);
+            // Topics not loaded were only read to be stored
+            if (!loaded) {
+                free(item->text);
+                item->text = NULL;
+            }
+        }
+        rewind(ouf);
+    }
+    free(offsets);
+
+    if (fclose(ouf) || rename(new_path, path) < 0) {
+        errlog("Unable to write help text store (%s): %s", path,
+               strerror(errno));
+        unlink(new_path);
+        return false;
+    }
+
+    if (!help_collection_map_store(col, path, false)) {
+        errlog("Unable to open help text store (%s)", path);
+        return false;
+    }
+    return true;
+}
+
+// Maps the text store at path if the help topics haven't changed since
+// it was written, or builds it again if they have
+bool
+help_collection_open_store(struct help_collection *col, const char *path)
+{
+    if (help_collection_map_store(col, path, true))
+        return true;
+    return help_collection_build_store(col, path);
+}
+
+// Called when the name or text of a topic changes, so that searches
+// check the topic itself until the store is built again.
+void
+help_collection_text_changed(struct help_collection *col,
+                             struct help_item *item)
+{
+    if (!item->text_indexed)
+        return;
+    item->text_indexed = false;
+    g_ptr_array_add(col->unindexed, item);
+}
+
+// The state of a list of help items being paged
+struct help_listing {
+    char *title;
+    GPtrArray *items;
+    guint pos;
+    int mode;
+};
+
+static void
+free_help_listing(void *data)
+{
+    struct help_listing *listing = data;
+
+    free(listing->title);
+    g_ptr_array_free(listing->items, true);
+    free(listing);
+}
+
+// Lists the next few help items.  Items are only freed with the
+// collection, so they are kept between pages.
+static bool
+next_help_entries(struct descriptor_data *d, void *data)
+{
+    struct help_listing *listing = data;
+    int shown = 0;
+
+    if (!d->creature)
+        return false;
+
+    if (listing->title) {
+        acc_strcat(listing->title, NULL);
+        free(listing->title);
+        listing->title = NULL;
+    }
+    while (listing->pos < listing->items->len && shown < 20) {
+        help_item_show(g_ptr_array_index(listing->items, listing->pos++),
+                       d->creature, linebuf, sizeof(linebuf), listing->mode);
+        acc_strcat(linebuf, NULL);
+        shown++;
+    }
+
+    return listing->pos < listing->items->len;
+}
+
+// Pages a list of help items, each shown in the given mode
+static void
+help_collection_page_items(struct creature *ch, char *title,
+                           GPtrArray *items, int mode)
+{
+    struct help_listing *listing;
+
+    CREATE(listing, struct help_listing, 1);
+    listing->title = title;
+    listing->items = items;
+    listing->mode = mode;
+    page_generator(ch->desc, next_help_entries, listing, free_help_listing);
 }
 
 // Show all the items
@@ -175,9 +595,8 @@ void
 help_collection_list(struct help_collection *col,
     struct creature *ch, char *args)
 {
-    struct help_item *cur;
+    GPtrArray *items = g_ptr_array_new();
     int start = 0, end = col->top_id;
-    int space_left = sizeof(gHelpbuf) - 480;
 
     skip_spaces(&args);
     args = one_argument(args, linebuf);
@@ -189,26 +608,18 @@ help_collection_list(struct help_collection *col,
         if (isdigit(linebuf[0]))
             end = atoi(linebuf);
     }
-    snprintf(gHelpbuf, sizeof(gHelpbuf), "Help Topics (%d,%d):\r\n", start, end);
-    space_left -= strlen(gHelpbuf);
     for (GList * hit = col->items; hit; hit = hit->next) {
-        cur = hit->data;
+        struct help_item *cur = hit->data;
+
         if (cur->idnum > end)
             break;
-        if (cur->idnum < start)
-            continue;
-        help_item_show(cur, ch, linebuf, sizeof(linebuf), 1);
-        strcat_s(gHelpbuf, sizeof(gHelpbuf), linebuf);
-        space_left -= strlen(linebuf);
-        if (space_left <= 0) {
-            snprintf(linebuf, sizeof(linebuf),
-                "Maximum buffer size reached at item # %d. \r\nUse \"range\" param for higher numbered items.\r\n",
-                cur->idnum);
-            strcat_s(gHelpbuf, sizeof(gHelpbuf), linebuf);
-            break;
-        }
+        if (cur->idnum >= start)
+            g_ptr_array_add(items, cur);
     }
-    page_string(ch->desc, gHelpbuf);
+    help_collection_page_items(ch,
+                               strdup(tmp_sprintf("Help Topics (%d,%d):\r\n",
+                                                  start, end)),
+                               items, 1);
 }
 
 // Save the index
@@ -289,13 +700,15 @@ help_collection_edit_item(struct help_collection * col, struct creature * ch,
 
 // Clear an item
 bool
-help_collection_clear_item(struct help_collection *col __attribute__((unused)), struct creature * ch)
+help_collection_clear_item(struct help_collection *col, struct creature * ch)
 {
     if (!GET_OLC_HELP(ch)) {
         send_to_char(ch, "You must be editing an item to clear it.\r\n");
         return false;
     }
     help_item_clear(GET_OLC_HELP(ch));
+    help_collection_text_changed(col, GET_OLC_HELP(ch));
+    col->keys_stale = true;
     return true;
 }
 
@@ -311,12 +724,119 @@ help_collection_save_item(struct help_collection *col __attribute__((unused)), s
     return true;
 }
 
+static bool
+help_item_findable(struct help_item *item, bool find_no_approve, int thegroup)
+{
+    if (IS_SET(item->flags, HFLAG_UNAPPROVED) && !find_no_approve)
+        return false;
+    if (thegroup && !help_item_in_group(item, thegroup))
+        return false;
+    return true;
+}
+
+static int
+order_cmp(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// Links the topics with the given orders into a show list, in the
+// order of the item list when ascending is set, or in reverse.
+static struct help_item *
+help_collection_show_list(struct help_collection *col, GArray *orders,
+                          bool ascending)
+{
+    struct help_item *list = NULL;
+    int last = -1;
+
+    qsort(orders->data, orders->len, sizeof(int), order_cmp);
+    for (guint i = 0; i < orders->len; i++) {
+        int order = g_array_index(orders, int,
+                                  ascending ? orders->len - i - 1 : i);
+        struct help_item *cur;
+
+        if (order == last)
+            continue;
+        cur = g_ptr_array_index(col->ordered, order);
+        cur->next_show = list;
+        list = cur;
+        last = order;
+    }
+    return list;
+}
+
 // Find an Item in the index
 // This should take an optional "mode" argument to specify groups the
 //  returned topic can be part of. e.g. (FindItems(argument,FIND_MODE_OLC))
+//
+// The keywords starting with args are found by binary search in the
+// index of the group, so the first match in the item list is the one
+// with the lowest order.
 struct help_item *
 help_collection_find_items(struct help_collection *col,
     char *args, bool find_no_approve, int thegroup, bool searchmode)
+{
+    struct help_item *list = NULL;
+    GArray *keys, *found;
+    char *b;
+    size_t length;
+    int lo, hi, best = -1;
+
+    for (b = args; *b; b++)
+        *b = tolower(*b);
+    length = strlen(args);
+
+    if (col->keys_stale)
+        help_collection_index_keys(col);
+    // A single group has its own index
+    keys = col->keys[HGROUP_MAX];
+    for (int g = 0; g < HGROUP_MAX; g++)
+        if (thegroup == (1 << g))
+            keys = col->keys[g];
+
+    lo = 0;
+    hi = keys->len;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (strcmp(g_array_index(keys, struct help_key, mid).word, args) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    found = g_array_new(false, false, sizeof(int));
+    for (guint i = lo; i < keys->len; i++) {
+        struct help_key *key = &g_array_index(keys, struct help_key, i);
+        struct help_item *cur;
+
+        if (strncmp(key->word, args, length))
+            break;
+        if (!searchmode && best >= 0 && key->order > best)
+            continue;
+        cur = g_ptr_array_index(col->ordered, key->order);
+        if (!help_item_findable(cur, find_no_approve, thegroup))
+            continue;
+        if (searchmode)
+            g_array_append_val(found, key->order);
+        else
+            best = key->order;
+    }
+
+    if (searchmode)
+        list = help_collection_show_list(col, found, false);
+    else if (best >= 0)
+        list = g_ptr_array_index(col->ordered, best);
+    g_array_free(found, true);
+
+    return list;
+}
+
+// Finds items by checking the keywords of every topic in turn.  Returns
+// the same items as help_collection_find_items().
+struct help_item *
+help_collection_find_items_scan(struct help_collection *col,
+    char *args, bool find_no_approve, int thegroup, bool searchmode)
 {
     struct help_item *cur = NULL;
     struct help_item *list = NULL;
@@ -352,6 +872,173 @@ help_collection_find_items(struct help_collection *col,
     return list;
 }
 
+// Returns true if every one of the words is in the name or text of the
+// topic.
+static bool
+help_item_mentions(struct help_item *item, char **words, int count)
+{
+    char word[MAX_HELP_WORD_LENGTH];
+    bool seen[count];
+    int left = count;
+
+    memset(seen, 0, sizeof(seen));
+    for (int pass = 0; pass < 2 && left; pass++) {
+        const char *text = (pass == 0) ? item->name : help_item_text(item);
+
+        if (!text)
+            continue;
+        while (left && next_help_word(&text, word)) {
+            for (int i = 0; i < count; i++) {
+                if (!seen[i] && !strcmp(word, words[i])) {
+                    seen[i] = true;
+                    left--;
+                }
+            }
+        }
+    }
+    return left == 0;
+}
+
+static int
+split_help_words(const char *args, char ***words)
+{
+    char word[MAX_HELP_WORD_LENGTH];
+    int count = 0;
+
+    *words = NULL;
+    while (next_help_word(&args, word)) {
+        *words = realloc(*words, sizeof(char *) * (count + 1));
+        (*words)[count++] = tmp_strdup(word);
+    }
+    return count;
+}
+
+static bool
+orders_contain(GArray *orders, int order)
+{
+    int lo = 0, hi = orders->len;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int val = g_array_index(orders, int, mid);
+
+        if (val == order)
+            return true;
+        if (val < order)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return false;
+}
+
+// Finds the topics mentioning every word of args in their names or
+// texts.  Returns them as a show list in the order of the item list.
+//
+// The stored topics are found by intersecting the orders of each word
+// in the word index, starting from the rarest word.  Topics changed
+// since then are checked one by one.
+struct help_item *
+help_collection_search_text(struct help_collection *col, const char *args,
+                            bool find_no_approve, int thegroup)
+{
+    struct help_item *list = NULL;
+    GArray **postings, *rarest = NULL, *found;
+    char **words;
+    int count;
+
+    if (!col->words)
+        return help_collection_search_text_scan(col, args, find_no_approve,
+                                                thegroup);
+
+    count = split_help_words(args, &words);
+    if (!count)
+        return NULL;
+
+    found = g_array_new(false, false, sizeof(int));
+    CREATE(postings, GArray *, count);
+    for (int i = 0; i < count; i++) {
+        postings[i] = g_hash_table_lookup(col->words, words[i]);
+        if (!postings[i]) {
+            rarest = NULL;
+            break;
+        }
+        if (!rarest || postings[i]->len < rarest->len)
+            rarest = postings[i];
+    }
+
+    for (guint i = 0; rarest && i < rarest->len; i++) {
+        int order = g_array_index(rarest, int, i);
+        struct help_item *cur = g_ptr_array_index(col->ordered, order);
+        int w;
+
+        if (!cur->text_indexed
+            || !help_item_findable(cur, find_no_approve, thegroup))
+            continue;
+        for (w = 0; w < count; w++)
+            if (postings[w] != rarest && !orders_contain(postings[w], order))
+                break;
+        if (w == count)
+            g_array_append_val(found, order);
+    }
+
+    for (guint i = 0; i < col->unindexed->len; i++) {
+        struct help_item *cur = g_ptr_array_index(col->unindexed, i);
+
+        if (help_item_findable(cur, find_no_approve, thegroup)
+            && help_item_mentions(cur, words, count))
+            g_array_append_val(found, cur->order);
+    }
+
+    list = help_collection_show_list(col, found, true);
+    g_array_free(found, true);
+    free(postings);
+    free(words);
+
+    return list;
+}
+
+// Finds the same topics as help_collection_search_text() by reading
+// every topic.
+struct help_item *
+help_collection_search_text_scan(struct help_collection *col,
+                                 const char *args, bool find_no_approve,
+                                 int thegroup)
+{
+    struct help_item *list = NULL;
+    char **words;
+    int count;
+
+    count = split_help_words(args, &words);
+    if (!count)
+        return NULL;
+
+    for (GList *hit = g_list_last(col->items); hit; hit = hit->prev) {
+        struct help_item *cur = hit->data;
+
+        if (help_item_findable(cur, find_no_approve, thegroup)
+            && help_item_mentions(cur, words, count)) {
+            cur->next_show = list;
+            list = cur;
+        }
+    }
+    free(words);
+
+    return list;
+}
+
+// Pages a show list of items, each shown in the given mode
+static void
+help_collection_page_list(struct creature *ch, struct help_item *cur,
+    int mode)
+{
+    GPtrArray *items = g_ptr_array_new();
+
+    for (; cur; cur = cur->next_show)
+        g_ptr_array_add(items, cur);
+    help_collection_page_items(ch, NULL, items, mode);
+}
+
 // Calls FindItems
 // Mode is how to show the item.
 // Type: 0==normal help, 1==immhelp, 2==olchelp
@@ -365,7 +1052,6 @@ help_collection_get_topic(struct help_collection *col,
 
     gHelpbuf[0] = '\0';
     linebuf[0] = '\0';
-    int space_left = sizeof(gHelpbuf) - 480;
     if (!args || !*args) {
         send_to_char(ch, "You must enter search criteria.\r\n");
         return;
@@ -390,24 +1076,28 @@ help_collection_get_topic(struct help_collection *col,
     // Normal plain old help. One item at a time.
     if (searchmode == false) {
         help_item_show(cur, ch, gHelpbuf, sizeof(gHelpbuf), mode);
+        page_string(ch->desc, gHelpbuf);
     } else {                    // Searching for multiple items.
-        space_left -= strlen(gHelpbuf);
-        for (; cur; cur = cur->next_show) {
-            help_item_show(cur, ch, linebuf, sizeof(linebuf), 1);
-            strcat_s(gHelpbuf, sizeof(gHelpbuf), linebuf);
-            space_left -= strlen(linebuf);
-            if (space_left <= 0) {
-                snprintf(linebuf, sizeof(linebuf), "Maximum buffer size reached at item # %d.",
-                    cur->idnum);
-                strcat_s(gHelpbuf, sizeof(gHelpbuf), linebuf);
-                break;
-            }
-        }
+        help_collection_page_list(ch, cur, 1);
     }
-    page_string(ch->desc, gHelpbuf);
     return;
 }
 
+// 'help search': lists the topics mentioning all the given words
+void
+help_collection_search_topics(struct help_collection *col,
+    struct creature *ch, char *args, bool show_no_app, int thegroup)
+{
+    struct help_item *cur;
+
+    cur = help_collection_search_text(col, args, show_no_app, thegroup);
+    if (!cur) {
+        send_to_char(ch, "No help topics mention '%s'.\r\n", args);
+        return;
+    }
+    help_collection_page_list(ch, cur, 0);
+}
+
 // Save everything.
 bool
 help_collection_save_all(struct help_collection * col, struct creature * ch)
@@ -492,6 +1182,9 @@ help_collection_load_index(struct help_collection * col)
     }
 
     slog("%d items read from help file index", num_items);
+    help_collection_open_store(col, tmp_sprintf("%s/%s", HELP_DIRECTORY,
+                                                HELP_STORE_FILE));
+    help_collection_index_keys(col);
     return true;
 
 error:
@@ -505,7 +1198,7 @@ error:
 // Funnels outside commands into struct help_item functions
 // (that should be protected or something... shrug.)
 bool
-help_collection_set(struct help_collection *col __attribute__((unused)), struct creature * ch,
+help_collection_set(struct help_collection *col, struct creature * ch,
     char *argument)
 {
     char *arg1;
@@ -522,6 +1215,7 @@ help_collection_set(struct help_collection *col __attribute__((unused)), struct
     arg1 = tmp_getword(&argument);
     if (!strncmp(arg1, "groups", strlen(arg1))) {
         help_item_setgroups(GET_OLC_HELP(ch), argument);
+        col->keys_stale = true;
         return true;
     } else if (!strncmp(arg1, "flags", strlen(arg1))) {
         help_item_setflags(GET_OLC_HELP(ch), argument);
@@ -529,20 +1223,24 @@ help_collection_set(struct help_collection *col __attribute__((unused)), struct
     } else if (!strncmp(arg1, "name", strlen(arg1))) {
         free(GET_OLC_HELP(ch)->name);
         GET_OLC_HELP(ch)->name = strdup(argument);
+        help_collection_text_changed(col, GET_OLC_HELP(ch));
         return true;
     } else if (!strncmp(arg1, "keywords", strlen(arg1))) {
         free(GET_OLC_HELP(ch)->keys);
         GET_OLC_HELP(ch)->keys = strdup(argument);
+        col->keys_stale = true;
         return true;
     } else if (!strncmp(arg1, "description", strlen(arg1))) {
         help_item_edittext(GET_OLC_HELP(ch));
+        help_collection_text_changed(col, GET_OLC_HELP(ch));
         return true;
     }
     return false;
 }
 
-// Trims off the text of all the help items that people have looked at.
-// (each text is approx 65k. We only want the ones in ram that we need.)
+// Trims off the text of all the help items that people have edited or
+// looked at without a text store.  (each text is approx 65k. We only
+// want the ones in ram that we need.)
 void
 help_collection_sync(struct help_collection *col)
 {
@@ -726,6 +1424,11 @@ ACMD(do_hcollect_help)
     if (cur) {
         help_item_show(cur, ch, gHelpbuf, sizeof(gHelpbuf), 2);
         page_string(ch->desc, gHelpbuf);
+    } else if (!strncasecmp(argument, "search ", 7)
+               && *(argument + 7 + strspn(argument + 7, " "))) {
+        // 'help search' alone is still the topic on searching
+        help_collection_search_topics(help, ch, argument + 7, false,
+            HGROUP_PLAYER);
     } else {
         help_collection_get_topic(help, ch, argument, 2, false, HGROUP_PLAYER, false);
     }
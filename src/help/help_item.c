@@ -102,6 +102,10 @@ help_item_load_text(struct help_item *item)
 
     if (item->text)
         return true;
+    if (item->stored_text) {
+        item->text = strdup(item->stored_text);
+        return true;
+    }
 
     fname = tmp_sprintf("%s/%04d.topic", HELP_DIRECTORY, item->idnum);
 
@@ -141,12 +145,27 @@ error:
     return false;
 }
 
+// Returns the text of the help entry, preferring the copy being edited
+// to the one in the text store.
+const char *
+help_item_text(struct help_item *item)
+{
+    if (item->text)
+        return item->text;
+    if (item->stored_text)
+        return item->stored_text;
+    help_item_load_text(item);
+    return item->text;
+}
+
 // Crank up the text item->editor and lets hit it.
 void
 help_item_edittext(struct help_item *item)
 {
 
     help_item_load_text(item);
+    // The stored text is out of date once the editor is done with it
+    item->stored_text = NULL;
     SET_BIT(item->flags, HFLAG_MODIFIED);
     start_editing_text(item->editor->desc, &item->text, MAX_HELP_TEXT_LENGTH);
     SET_BIT(PLR_FLAGS(item->editor), PLR_OLC);
@@ -254,6 +273,7 @@ help_item_clear(struct help_item *item)
     item->name = strdup("A New Help Entry");
     item->keys = strdup("new help entry");
     item->text = NULL;
+    item->stored_text = NULL;
 }
 
 struct help_item *
@@ -273,6 +293,7 @@ free_help_item(struct help_item *item)
     free(item->name);
     free(item->keys);
     free(item->text);
+    free(item);
 }
 
 // Begin editing an item much like olc oedit.
@@ -353,15 +374,12 @@ help_item_show(struct help_item *item, struct creature *ch, char *buffer,
             groupbuf, CCCYN(ch, C_NRM), CCNRM(ch, C_NRM), bitbuf);
         break;
     case 2:                    // 2 == Entire Entry
-        if (!item->text)
-            help_item_load_text(item);
         snprintf(buffer, buf_size, "\r\n%s%s%s\r\n%s\r\n",
-            CCCYN(ch, C_NRM), item->name, CCNRM(ch, C_NRM), item->text);
+            CCCYN(ch, C_NRM), item->name, CCNRM(ch, C_NRM),
+            help_item_text(item));
         item->counter++;
         break;
     case 3:                    // 3 == Entire Entry Stat
-        if (!item->text)
-            help_item_load_text(item);
         sprintbit(item->flags, help_bit_descs, bitbuf, sizeof(bitbuf));
         sprintbit(item->groups, help_group_bits, groupbuf, sizeof(groupbuf));
         snprintf(buffer, buf_size,
@@ -372,7 +390,7 @@ help_item_show(struct help_item *item, struct creature *ch, char *buffer,
             groupbuf, CCCYN(ch, C_NRM),
             CCNRM(ch, C_NRM), bitbuf, CCCYN(ch, C_NRM),
             CCNRM(ch, C_NRM), item->keys, CCCYN(ch, C_NRM), CCNRM(ch, C_NRM),
-            item->text);
+            help_item_text(item));
         break;
     default:
         break;
@@ -61,7 +61,7 @@
   HCONTROL_DELETE_FORMAT \
   HCONTROL_SET_FORMAT \
   HCONTROL_SHOW_FORMAT \
-  "Usage: hcontrol save/recount\r\n" \
+  "Usage: hcontrol save/audit\r\n" \
   "Usage: hcontrol where\r\n" \
   "Usage: hcontrol reload [house#] (Use with caution!)\r\n")
 
@@ -73,6 +73,9 @@ void extract_norents(struct obj_data *obj);
 time_t last_house_collection;
 GList *houses;
 
+// Room vnum -> the house it belongs to
+static GHashTable *house_rooms = NULL;
+
 static char*
 get_house_file_path( int id )
 {
@@ -221,6 +224,52 @@ house_has_room(struct house * house, room_num room)
     return g_list_find(house->rooms, GINT_TO_POINTER(room));
 }
 
+static void adjust_housed_contents(struct obj_data *list, int delta,
+                                   int *rent, int *count);
+
+// Adjusts the housed count of obj and its contents, adding their rent
+// and number to the given totals.
+static void
+adjust_housed_object(struct obj_data *obj, int delta, int *rent, int *count)
+{
+    // don't count NORENT items as being in house
+    if (!IS_OBJ_STAT(obj, ITEM_NORENT)) {
+        if (obj->shared->proto)
+            obj->shared->house_count += delta;
+        *rent += GET_OBJ_RENT(obj);
+    }
+    (*count)++;
+    adjust_housed_contents(obj->contains, delta, rent, count);
+}
+
+static void
+adjust_housed_contents(struct obj_data *list, int delta, int *rent,
+                       int *count)
+{
+    for (struct obj_data *obj = list; obj; obj = obj->next_content)
+        adjust_housed_object(obj, delta, rent, count);
+}
+
+/* Counts obj and its contents as entering (delta 1) or leaving (delta
+ * -1) the given room, if the room belongs to a house. */
+void
+house_object_moved(struct obj_data *obj, struct room_data *room, int delta)
+{
+    struct house *house;
+    int rent = 0, count = 0;
+
+    if (!house_rooms)
+        return;
+    house = g_hash_table_lookup(house_rooms, GINT_TO_POINTER(room->number));
+    if (!house)
+        return;
+
+    adjust_housed_object(obj, delta, &rent, &count);
+    room->house_rent += delta * rent;
+    room->house_objects += delta * count;
+    house->dirty = true;
+}
+
 bool
 add_house_room(struct house * house, room_num room)
 {
@@ -228,6 +277,19 @@ add_house_room(struct house * house, room_num room)
         return false;
     } else {
         house->rooms = g_list_prepend(house->rooms, GINT_TO_POINTER(room));
+        if (!house_rooms)
+            house_rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
+        // A room claimed by two houses stays with the first
+        if (!g_hash_table_lookup(house_rooms, GINT_TO_POINTER(room))) {
+            struct room_data *real = real_room(room);
+
+            g_hash_table_insert(house_rooms, GINT_TO_POINTER(room), house);
+            if (real) {
+                real->house_rent = real->house_objects = 0;
+                adjust_housed_contents(real->contents, 1, &real->house_rent,
+                                       &real->house_objects);
+            }
+        }
         return true;
     }
 }
@@ -236,6 +298,17 @@ bool
 remove_house_room(struct house * house, room_num room)
 {
     house->rooms = g_list_remove_all(house->rooms, GINT_TO_POINTER(room));
+    if (house_rooms
+        && g_hash_table_lookup(house_rooms, GINT_TO_POINTER(room)) == house) {
+        struct room_data *real = real_room(room);
+
+        if (real) {
+            adjust_housed_contents(real->contents, -1, &real->house_rent,
+                                   &real->house_objects);
+            real->house_rent = real->house_objects = 0;
+        }
+        g_hash_table_remove(house_rooms, GINT_TO_POINTER(room));
+    }
     return true;
 }
 
@@ -263,6 +336,8 @@ free_house(struct house *house)
         if (room)
             REMOVE_BIT(ROOM_FLAGS(room), ROOM_HOUSE | ROOM_HOUSE_CRASH);
     }
+    while (house->rooms)
+        remove_house_room(house, GPOINTER_TO_INT(house->rooms->data));
 
     g_list_free(house->rooms);
     g_list_free(house->guests);
@@ -304,25 +379,12 @@ get_house_by_index(int index)
     return g_list_nth_data(houses, index);
 }
 
-gint
-this_house_has_room(struct house *house, gpointer user_data)
-{
-    room_num room_idnum = GPOINTER_TO_INT(user_data);
-
-    return (house_has_room(house, room_idnum)) ? 0 : -1;
-}
-
 struct house *
 find_house_by_room(room_num room_idnum)
 {
-    struct room_data *room = real_room(room_idnum);
-    if (!room)
+    if (!house_rooms)
         return NULL;
-
-    GList *it = g_list_find_custom(houses,
-                                   GINT_TO_POINTER(room_idnum),
-                                   (GCompareFunc) this_house_has_room);
-    return (it) ? it->data : NULL;
+    return g_hash_table_lookup(house_rooms, GINT_TO_POINTER(room_idnum));
 }
 
 gint
@@ -498,6 +560,47 @@ update_objects_housed_count(void)
     g_list_foreach(houses, (GFunc) update_objects_in_house, NULL);
 }
 
+static void
+save_housed_count(gpointer vnum, struct obj_data *obj, GHashTable *counts)
+{
+    g_hash_table_insert(counts, vnum,
+                        GINT_TO_POINTER(obj->shared->house_count));
+}
+
+/* Recounts the housed objects from scratch, and reports any prototype
+ * whose kept count was wrong.  Returns the number of wrong counts. */
+int
+audit_objects_housed_count(struct creature *ch)
+{
+    GHashTable *counts = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GHashTableIter iter;
+    gpointer key, val;
+    int wrong = 0;
+
+    g_hash_table_foreach(obj_prototypes, (GHFunc) save_housed_count, counts);
+    update_objects_housed_count();
+
+    g_hash_table_iter_init(&iter, obj_prototypes);
+    while (g_hash_table_iter_next(&iter, &key, &val)) {
+        struct obj_data *obj = val;
+        int kept = GPOINTER_TO_INT(g_hash_table_lookup(counts, key));
+
+        if (kept == obj->shared->house_count)
+            continue;
+        wrong++;
+        if (ch)
+            send_to_char(ch, "[%5d] %-40s kept %d, counted %d\r\n",
+                         GPOINTER_TO_INT(key), obj->name, kept,
+                         obj->shared->house_count);
+        else
+            errlog("Housed count of object %d was %d, counted %d",
+                   GPOINTER_TO_INT(key), kept, obj->shared->house_count);
+    }
+    g_hash_table_destroy(counts);
+
+    return wrong;
+}
+
 int
 count_objects_in_room(struct room_data *room)
 {
@@ -553,6 +656,7 @@ save_house(struct house * house)
         fprintf(ouf, "    </room>\n");
         REMOVE_BIT(ROOM_FLAGS(room), ROOM_HOUSE_CRASH);
     }
+    house->dirty = false;
     for (GList * i = house->guests; i; i = i->next) {
         fprintf(ouf, "    <guest id=\"%d\"></guest>\n",
             GPOINTER_TO_INT(i->data));
@@ -667,6 +771,8 @@ load_house(const char *filename)
     }
 
     xmlFreeDoc(doc);
+    // Loading the contents doesn't change the house
+    house->dirty = false;
     return house;
 }
 
@@ -751,6 +857,41 @@ save_houses(void)
     }
 }
 
+bool
+house_needs_save(struct house *house)
+{
+    if (house->dirty)
+        return true;
+    for (GList *i = house->rooms; i; i = i->next) {
+        struct room_data *room = real_room(GPOINTER_TO_INT(i->data));
+
+        if (room && ROOM_FLAGGED(room, ROOM_HOUSE_CRASH))
+            return true;
+    }
+    return false;
+}
+
+/* Saves only the houses which have changed since they were last
+ * saved.  Returns the number of houses saved. */
+int
+save_changed_houses(void)
+{
+    int count = 0;
+
+    for (GList * i = houses; i; i = i->next) {
+        struct house *house = (struct house *)i->data;
+
+        if (!house_needs_save(house))
+            continue;
+        if (!save_house(house))
+            errlog("Failed to save house %d.", house->id);
+        else
+            count++;
+    }
+
+    return count;
+}
+
 void
 load_houses(void)
 {
@@ -815,21 +956,37 @@ load_houses(void)
     }
 }
 
-int
-room_rent_cost(struct house *house __attribute__((unused)), struct room_data *room)
+static int
+room_rent_total(int room_sum, int room_count)
+{
+    if (room_count > MAX_HOUSE_ITEMS) {
+        room_sum *= (room_count / MAX_HOUSE_ITEMS) + 1;
+    }
+    return room_sum;
+}
+
+// Totals the rent of a room by walking everything in it
+static int
+room_rent_cost_scan(struct room_data *room)
 {
-    if (room == NULL)
-        return 0;
     int room_count = count_objects_in_room(room);
     int room_sum = 0;
 
     for (struct obj_data * obj = room->contents; obj; obj = obj->next_content) {
         room_sum += recurs_obj_cost(obj, false, NULL);
     }
-    if (room_count > MAX_HOUSE_ITEMS) {
-        room_sum *= (room_count / MAX_HOUSE_ITEMS) + 1;
-    }
-    return room_sum;
+    return room_rent_total(room_sum, room_count);
+}
+
+int
+room_rent_cost(struct house *house __attribute__((unused)), struct room_data *room)
+{
+    if (room == NULL)
+        return 0;
+    // House rooms keep their totals as objects come and go
+    if (find_house_by_room(room->number))
+        return room_rent_total(room->house_rent, room->house_objects);
+    return room_rent_cost_scan(room);
 }
 
 gint
@@ -838,8 +995,9 @@ creature_is_pc(struct creature *ch, gpointer ignore __attribute__((unused)))
     return (IS_PC(ch)) ? 0 : -1;
 }
 
-int
-house_rent_cost(struct house *house)
+static int
+house_rent_cost_by(struct house *house,
+                   int (*room_cost)(struct house *, struct room_data *))
 {
     int room_count = 0;
     int sum = 0;
@@ -847,7 +1005,7 @@ house_rent_cost(struct house *house)
         struct room_data *room = real_room(GPOINTER_TO_INT(i->data));
 
         if (!g_list_find_custom(room->people, NULL, (GCompareFunc) creature_is_pc))
-            sum += room_rent_cost(house, room);
+            sum += room_cost(house, room);
 
         room_count++;
     }
@@ -858,6 +1016,88 @@ house_rent_cost(struct house *house)
     return sum;
 }
 
+int
+house_rent_cost(struct house *house)
+{
+    return house_rent_cost_by(house, room_rent_cost);
+}
+
+static int
+room_rent_cost_uncached(struct house *house __attribute__((unused)),
+                        struct room_data *room)
+{
+    return (room) ? room_rent_cost_scan(room) : 0;
+}
+
+int
+house_rent_cost_scan(struct house *house)
+{
+    return house_rent_cost_by(house, room_rent_cost_uncached);
+}
+
+/* Recounts the rent totals kept for each house room, for when the rent
+ * of a prototype has changed under the objects housed there. */
+void
+house_rent_changed(void)
+{
+    for (GList *it = houses; it; it = it->next) {
+        struct house *house = it->data;
+
+        for (GList *r = house->rooms; r; r = r->next) {
+            struct room_data *room = real_room(GPOINTER_TO_INT(r->data));
+
+            if (!room || find_house_by_room(room->number) != house)
+                continue;
+            room->house_rent = room->house_objects = 0;
+            adjust_housed_contents(room->contents, 0, &room->house_rent,
+                                   &room->house_objects);
+        }
+    }
+}
+
+/* Checks the rent totals kept for each house room against a full
+ * walk of its contents, correcting any that are wrong.  Returns the
+ * number of rooms which were wrong. */
+int
+audit_house_rent(struct creature *ch)
+{
+    int wrong = 0;
+
+    for (GList *it = houses; it; it = it->next) {
+        struct house *house = it->data;
+
+        for (GList *r = house->rooms; r; r = r->next) {
+            struct room_data *room = real_room(GPOINTER_TO_INT(r->data));
+            int rent = 0, count = 0;
+
+            if (!room || find_house_by_room(room->number) != house)
+                continue;
+            for (struct obj_data *obj = room->contents; obj;
+                 obj = obj->next_content) {
+                rent += recurs_obj_cost(obj, false, NULL);
+                count += recurs_obj_contents(obj, NULL);
+            }
+            if (rent == room->house_rent && count == room->house_objects)
+                continue;
+
+            wrong++;
+            if (ch)
+                send_to_char(ch, "Room %d of house %d kept %d rent for %d "
+                             "objects, counted %d for %d\r\n",
+                             room->number, house->id, room->house_rent,
+                             room->house_objects, rent, count);
+            else
+                errlog("Room %d of house %d kept %d rent for %d objects, "
+                       "counted %d for %d", room->number, house->id,
+                       room->house_rent, room->house_objects, rent, count);
+            room->house_rent = rent;
+            room->house_objects = count;
+        }
+    }
+
+    return wrong;
+}
+
 int
 reconcile_clan_collection(struct house *house, int cost)
 {
@@ -954,6 +1194,8 @@ collect_house_rent(struct house *house, int cost)
         slog("HOUSE: [%d] Previous repossessions covering %d rent.", house->id,
             cost);
         house->rent_overflow -= cost;
+        if (cost)
+            house->dirty = true;
         return false;
     }
 
@@ -983,8 +1225,8 @@ collect_housing_rent(void)
             // Cost per minute
             int cost = (int)((house_rent_cost(house) / 24.0) / 60);
 
+            // The house is saved with the others if anything changed
             collect_house_rent(house, cost);
-            save_house(house);
         }
     }
 }
@@ -1013,9 +1255,12 @@ list_house_rooms(struct house *house, struct creature *ch, bool show_contents)
     for (GList * i = house->rooms; i; i = i->next) {
         struct room_data *room = real_room(GPOINTER_TO_INT(i->data));
 
-        if (room)
+        if (room) {
+            struct tmp_mark mark = tmp_mark();
+
             acc_strcat(print_room_contents(ch, room, show_contents), NULL);
-        else
+            tmp_release(mark);
+        } else
             errlog("Room [%5d] of House [%5d] does not exist.",
                 GPOINTER_TO_INT(i->data), house->id);
     }
@@ -1257,6 +1502,7 @@ set_house_clan_owner(struct creature *ch, struct house *house, char *arg)
     }
 
     house->owner_id = clanID;
+    house->dirty = true;
     send_to_char(ch, "Owner set to clan %d.\r\n", house->owner_id);
     slog("HOUSE: Owner of house %d set to clan %d by %s.",
         house->id, house->owner_id, GET_NAME(ch));
@@ -1291,6 +1537,7 @@ set_house_account_owner(struct creature *ch, struct house *house, char *arg)
     }
 
     house->owner_id = accountID;
+    house->dirty = true;
     send_to_char(ch, "Owner set to account %d.\r\n", house->owner_id);
     slog("HOUSE: Owner of house %d set to account %d by %s.",
         house->id, house->owner_id, GET_NAME(ch));
@@ -1381,6 +1628,7 @@ hcontrol_set_house(struct creature *ch, char *arg)
         }
 
         house->landlord = player_idnum_by_name(landlord);
+        house->dirty = true;
 
         send_to_char(ch, "Landlord of house %d set to %s.\r\n",
             house->id, player_name_by_idnum(house->landlord));
@@ -1663,6 +1911,7 @@ display_houses(GList * houses, struct creature *ch)
 
     for (GList * cur = houses; cur; cur = cur->next) {
         struct house *house = (struct house *)cur->data;
+        struct tmp_mark mark = tmp_mark();
         const char *landlord = "none";
         if (player_idnum_exists(house->landlord))
             landlord = player_name_by_idnum(house->landlord);
@@ -1677,6 +1926,7 @@ display_houses(GList * houses, struct creature *ch)
             }
         }
         acc_strcat("\r\n", NULL);
+        tmp_release(mark);
     }
     page_string(ch->desc, acc_get_string());
 }
@@ -1749,6 +1999,23 @@ ACMD(do_hcontrol)
         hcontrol_find_houses(ch, argument);
     } else if (is_abbrev(action_str, "where")) {
         hcontrol_where_house(ch);
+    } else if (is_abbrev(action_str, "audit")) {
+        int wrong = audit_objects_housed_count(ch);
+
+        if (wrong)
+            send_to_char(ch, "%d housed object count%s corrected.\r\n",
+                         wrong, (wrong == 1) ? "" : "s");
+        else
+            send_to_char(ch, "All housed object counts are correct.\r\n");
+        int wrong_rent = audit_house_rent(ch);
+
+        if (wrong_rent)
+            send_to_char(ch, "%d house room rent total%s corrected.\r\n",
+                         wrong_rent, (wrong_rent == 1) ? "" : "s");
+        else
+            send_to_char(ch, "All house room rent totals are correct.\r\n");
+        slog("HOUSE: Housed counts audited by %s, %d counts and %d rooms wrong.",
+             GET_NAME(ch), wrong, wrong_rent);
     } else if (is_abbrev(action_str, "show")) {
         if (!*argument) {
             display_houses(houses, ch);
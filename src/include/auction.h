@@ -0,0 +1,95 @@
+#ifndef _AUCTION_H_
+#define _AUCTION_H_
+
+struct _GPQueue;
+
+extern const char *AUC_FILE_PATH;
+extern const char *AUC_DIR_PATH;
+extern GList *auctions;
+
+extern int GOING_ONCE;
+extern int GOING_TWICE;
+extern int SOLD_TIME;
+extern int NO_BID_THRESH;
+extern int AUCTION_THRESH;
+extern float BID_INCREMENT;
+
+enum auction_state {
+    AUCTION_STARTED = 0, /* initial state: auction needs to be announced */
+    AUCTION_ANNOUNCED, /* auction has been announced and is waiting for bids */
+    AUCTION_NO_BIDS, /* it's been announced that no bids have been made */
+    AUCTION_NEW_BID,   /* a bid has just been made */
+    AUCTION_BID_ANNOUNCED,   /* the new bid has been announced */
+    AUCTION_GOING_ONCE,      /* the bid has gone once */
+    AUCTION_GOING_TWICE,     /* the bid has gone twice */
+};
+
+/**
+ * bid_data:
+ * @bidder_id: The idnum of the bidder
+ * @past_amount: The amount of gold used in the bid
+ * @future_amount: The amount of cash used in the bid
+ * @heap_index: The position of the bid in its auction's heap of bids
+ **/
+struct bid_data {
+    long bidder_id;
+    money_t past_amount;
+    money_t future_amount;
+    guint heap_index;
+};
+
+/**
+ * auction_data:
+ * @idnum: a unique id number for the auction
+ * @room_id: The room of the auctioneer holding this auction
+ * @owner_id: The player ID of the owner of the item
+ * @item: The object being auctioned
+ * @start_bid: The minimum bid of the auction
+ * @start_time: The time the auction started
+ * @last_bid_time: The last time the bid was made
+ * @state: The state of the auction
+ * @bids: A #GPtrArray of bids, kept as a heap with the greatest bid first
+ * @bidders: A #GHashTable of the bids by bidder idnum
+ * @deadline: The entry of the auction in its room's queue of deadlines
+ * @dirty: Whether the auction has changed since it was last saved
+ *
+ **/
+struct auction_data {
+    uint32_t idnum;
+    long room_id;
+    long owner_id;
+    struct obj_data *item;
+    money_t start_bid;
+    time_t start_time;
+    time_t last_bid_time;
+    enum auction_state state;
+    GPtrArray *bids;
+    GHashTable *bidders;
+    struct _GPQueue *deadline;
+    bool dirty;
+};
+
+money_t bid_total(struct bid_data *bid);
+struct auction_data *auction_data_from_idnum(int idnum);
+struct auction_data *auction_data_from_idnum_scan(int idnum);
+uint32_t unused_auction_idnum(void);
+struct auction_data *new_auction(void);
+struct auction_data *add_new_auction(long room_id, long seller_id,
+                                     money_t start_bid, struct obj_data *obj);
+void add_auction(struct auction_data *auc);
+void remove_auction(struct auction_data *auc);
+void free_auction(struct auction_data *auc);
+struct bid_data *add_auction_bid(struct auction_data *auc, long bidder_id,
+                                 money_t past_amount, money_t future_amount);
+struct bid_data *auction_winning_bid(struct auction_data *auc);
+struct bid_data *bid_by_bidder_idnum(struct auction_data *auc, long idnum);
+money_t auction_minimum_bid(struct auction_data *auc);
+time_t auction_deadline(struct auction_data *auc);
+bool auction_is_due(struct auction_data *auc, time_t now);
+void schedule_auction(struct auction_data *auc);
+GList *due_auctions(long room_id, time_t now);
+GList *due_auctions_scan(long room_id, time_t now);
+bool load_auctions(void);
+int save_auctions(void);
+
+#endif
@@ -41,6 +41,18 @@ int delete_clan(/*@only@*/ struct clan_data *clan)
     __attribute__ ((nonnull));
 void sort_clanmembers(struct clan_data *clan)
     __attribute__ ((nonnull));
+/*@dependent@*/ struct clanmember_data *add_clan_member(struct clan_data *clan,
+                                                       long idnum, int rank,
+                                                       bool no_mail)
+    __attribute__ ((nonnull));
+/*@dependent@*/ struct clanmember_data *enroll_clan_member(struct clan_data *clan,
+                                                          long idnum)
+    __attribute__ ((nonnull));
+void set_clanmember_rank(struct clan_data *clan,
+                         struct clanmember_data *member, int rank)
+    __attribute__ ((nonnull));
+void dismiss_clan_member(struct clan_data *clan, long idnum)
+    __attribute__ ((nonnull));
 void remove_member_from_clan(/*@only@*/ struct clanmember_data *member,
                              struct clan_data *clan)
     __attribute__ ((nonnull));
@@ -53,6 +65,13 @@ void clear_clan_owner(long idnum);
 void remove_char_clan(int clan_idnum, long ch_idnum);
 int clan_id(struct clan_data *clan)
     __attribute__ ((nonnull));
+void flush_clan_sql(void);
+void acc_print_clan_members(struct creature *ch, struct clan_data *clan,
+                            bool complete, int min_lev)
+    __attribute__ ((nonnull));
+void acc_print_clan_members_scan(struct creature *ch, struct clan_data *clan,
+                                 bool complete, int min_lev)
+    __attribute__ ((nonnull));
 
 struct clanmember_data {
 	long idnum;
@@ -75,7 +94,9 @@ struct clan_data {
 	char *badge;				/* title of clan for who list, etc. */
 	char *password;				/* password of clan */
 	/*@owned@*/ char *ranknames[NUM_CLAN_RANKS];
-	/*@owned@*/ struct clanmember_data *member_list;	/* list of idnums */
+	/*@owned@*/ struct clanmember_data *member_list;	/* highest rank first */
+	GHashTable *members;		/* members by idnum */
+	int member_count;
 	/*@owned@*/ struct room_list_elem *room_list;	/* list of clan house rooms */
 	/*@owned@*/ struct clan_data *next;
 };
@@ -110,6 +110,20 @@ void write_to_q(char *txt, struct txt_q *queue, int aliased)
 void write_to_output(const char *txt, struct descriptor_data *d)
     __attribute__ ((nonnull));
 void page_string(struct descriptor_data *d, const char *str);
+
+// A pager generator appends the next part of a listing to the string
+// accumulator, returning false once there is nothing more to add.
+typedef bool (*pager_func)(struct descriptor_data *d, void *data);
+
+// Pages the output of a generator, which is only asked for as much text
+// as the reader has paged through.  The pager owns data, and frees it
+// with free_data when finished.  Returns false, having freed data, if
+// the generator produced nothing at all.
+bool page_generator(struct descriptor_data *d, pager_func gen, void *data,
+                    void (*free_data)(void *data));
+
+// Discards any text being paged to the descriptor
+void pager_stop(struct descriptor_data *d);
 void show_file(struct creature *ch, const char *fname, int lines)
     __attribute__ ((nonnull));
 void show_account_chars(struct descriptor_data *d, struct account *acct, bool immort, bool brief)
@@ -799,6 +799,9 @@ struct player_special_data {
 	enum cxn_state desc_mode;
 	int rent_currency;
     GHashTable *tags;           /* unordered set of strings mapped to 0x1 */
+    unsigned long privs_generation; /* role_generation when compiled */
+    uint32_t *role_bits;        /* bit per role slot the player is in */
+    uint32_t *cmd_bits;         /* bit per cmd_info entry roles allow */
 };
 
 struct mob_shared_data {
@@ -832,6 +835,7 @@ struct mob_special_data {
 	int wait_state;				/* Wait state for bashed mobs           */
 	int8_t last_direction;		/* The last direction the monster went     */
 	long mob_idnum;		/* mobile's unique idnum */
+	unsigned int ai_pulse;		/* Mobile AI pulse the mob last ran on      */
 };
 
 /* An affect structure */
@@ -880,6 +884,7 @@ struct creature {
     struct prog_state_data *prog_state;
 
 	struct obj_data *carrying;	/* Head of list                  */
+	unsigned long carrying_serial;	/* Changed when carrying is      */
 	struct descriptor_data *desc;	/* NULL for mobiles              */
 	struct account *account;
 
@@ -936,6 +941,9 @@ void add_combat(struct creature *ch, struct creature *target, bool initiated);
 struct creature *random_opponent(struct creature *ch);
 void remove_combat(struct creature *ch, struct creature *vict);
 void remove_all_combat(struct creature *ch);
+void remove_combatant(struct creature *ch);
+void foreach_combatant(GFunc func, gpointer data);
+guint combatant_count(void);
 void remove_combat(struct creature *ch, struct creature *target);
 
 #define NPC_HUNTING(ch) ((ch)->char_specials.hunting)
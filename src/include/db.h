@@ -93,6 +93,9 @@ void clear_object(struct obj_data *obj);
 void free_obj(struct obj_data *obj);
 int real_object(int vnum);
 struct obj_data *real_object_proto(int vnum);
+/* Forget the prototype indexes after prototypes are added, removed, or changed */
+void invalidate_mobile_index(void);
+void invalidate_object_index(void);
 struct obj_data *read_object(int vnum);
 int zone_number(int nr);
 struct room_data *where_obj(struct obj_data *obj);
@@ -81,6 +81,9 @@ struct descriptor_data {
 	time_t login_time;			/* when the person connected        */
 	char *showstr_head;			/* for paging through texts     */
 	char *showstr_point;		/*      -           */
+	bool (*pager_gen)(struct descriptor_data *d, void *data);	/* makes more paged text */
+	void *pager_data;			/*      -           */
+	void (*pager_free)(void *data);	/*      -           */
 	int8_t bad_pws;				/* number of bad pw attempts this login  */
 	bool need_prompt;			/* control of prompt-printing       */
 	int max_str;				/*      -           */
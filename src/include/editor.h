@@ -51,6 +51,11 @@ void start_editing_text(struct descriptor_data *d,
                         char **target,
                         int max)
     __attribute__ ((nonnull (1)));
+void start_editing_marked_text(struct descriptor_data *d,
+                               char **target,
+                               int max,
+                               bool *mark)
+    __attribute__ ((nonnull (1)));
 
 void start_editing_mail(struct descriptor_data *d,
                         GList *recipients)
@@ -35,6 +35,8 @@
 #define HELP_DIRECTORY "text/help_data/"
 #define MAX_HELP_NAME_LENGTH 128
 #define MAX_HELP_TEXT_LENGTH 16384
+#define HELP_STORE_FILE "topics.store"
+#define MAX_HELP_WORD_LENGTH 32
 
 struct creature;
 
@@ -47,7 +49,10 @@ struct help_item {
 	long owner;					// Last person to edit the topic
 	char *keys;					// Key Words
 	char *name;					// The listed name of the help topic
-	char *text;					// The body of the help topic
+	char *text;					// The body of the help topic, while loaded
+	const char *stored_text;	// The body of the topic in the text store
+	int order;					// Position in the collection's item list
+	bool text_indexed;			// Name and text are in the word index
 	struct creature *editor;
 	struct help_item *next;
 	struct help_item *next_show;
@@ -56,6 +61,18 @@ struct help_item {
 struct help_collection {
 	// Data
 	GList *items;			// The top of the list of help topics
+	GPtrArray *ordered;			// The same topics, indexed by order
+
+	// Sorted keywords of every topic, then of the topics in each group
+	GArray *keys[HGROUP_MAX + 1];
+	bool keys_stale;			// Keywords must be indexed again
+
+	// Every topic text, mapped from HELP_STORE_FILE
+	char *store;
+	size_t store_size;
+	// Words of the stored names and texts, each to an array of orders
+	GHashTable *words;
+	GPtrArray *unindexed;		// Topics changed since the words were indexed
 
 	// Returns a show list of items it found
 	int top_id;					// The highest id in use..
@@ -78,7 +95,14 @@ void help_item_edittext(struct help_item *item);
 
 extern struct help_collection *help;
 struct help_collection *make_help_collection(void);
+void free_help_collection(struct help_collection *col);
+void help_collection_push(struct help_collection *col, struct help_item *n);
 bool help_collection_load_index(struct help_collection *col);
+bool help_collection_build_store(struct help_collection *col, const char *path);
+bool help_collection_open_store(struct help_collection *col, const char *path);
+void help_collection_index_keys(struct help_collection *col);
+void help_collection_text_changed(struct help_collection *col,
+                                  struct help_item *item);
 void help_collection_sync(struct help_collection *col);
 
 struct help_item *help_collection_find_item_by_id(struct help_collection *col, int id);
@@ -87,7 +111,21 @@ struct help_item *help_collection_find_items(struct help_collection *col,
                                              bool find_no_approve,
                                              int thegroup,
                                              bool searchmode);
+struct help_item *help_collection_find_items_scan(struct help_collection *col,
+                                                  char *args,
+                                                  bool find_no_approve,
+                                                  int thegroup,
+                                                  bool searchmode);
+struct help_item *help_collection_search_text(struct help_collection *col,
+                                              const char *args,
+                                              bool find_no_approve,
+                                              int thegroup);
+struct help_item *help_collection_search_text_scan(struct help_collection *col,
+                                                   const char *args,
+                                                   bool find_no_approve,
+                                                   int thegroup);
 bool help_item_load_text(struct help_item *item);
+const char *help_item_text(struct help_item *item);
 bool help_item_in_group(struct help_item *item, int thegroup);
 
 void do_qcontrol_help( struct creature *ch, char *argument );
@@ -41,6 +41,8 @@ struct house
     // to cover rent cost.
     struct txt_block *repo_notes;
 
+    // true if the house has changed since it was last saved
+    bool dirty;
 };
 
 extern time_t last_house_collection;
@@ -49,22 +51,36 @@ extern GList *houses;
 
 #define TOROOM(room, dir) (world[room].dir_option[dir] ? \
 			    world[room].dir_option[dir]->to_room : NOWHERE)
+struct house *make_house(int idnum, int owner);
+void free_house(struct house *house);
+bool add_house_room(struct house *house, room_num room);
+bool remove_house_room(struct house *house, room_num room);
 char* print_room_contents(struct creature *ch, struct room_data *real_house_room, bool showContents);
 int recurs_obj_cost(struct obj_data *obj, bool mode, struct obj_data *top_o);
 int recurs_obj_contents(struct obj_data *obj, struct obj_data *top_o);
 bool can_enter_house(struct creature *ch, room_num room_idnum);
 void load_houses(void);
 void update_objects_housed_count(void);
+int audit_objects_housed_count(struct creature *ch);
+void house_object_moved(struct obj_data *obj, struct room_data *room,
+                        int delta);
 struct house *find_house_by_idnum(int idnum);
 struct house *find_house_by_owner(int idnum);
 struct house *find_house_by_clan(int idnum);
 struct house *find_house_by_room(room_num room_idnum);
+bool collect_house_rent(struct house *house, int cost);
 void collect_housing_rent(void);
 bool save_house(struct house *house);
 void save_houses(void);
+bool house_needs_save(struct house *house);
+int save_changed_houses(void);
 int repo_note_count(struct house *house);
 void house_notify_repossession(struct house *house, struct creature *ch);
 int room_rent_cost(struct house *house, struct room_data *room);
+int house_rent_cost(struct house *house);
+int house_rent_cost_scan(struct house *house);
+void house_rent_changed(void);
+int audit_house_rent(struct creature *ch);
 int count_objects_in_room(struct room_data *room);
 void list_house_rooms(struct house *house, struct creature *ch, bool show_contents);
 
@@ -53,6 +53,9 @@ struct command_info {
 	int subcmd;
 	int role_count;
 	unsigned long usage;
+	unsigned long timed;        // Times the handler was run
+	unsigned long total_usec;   // Microseconds spent in the handler
+	unsigned long max_usec;     // Longest single run of the handler
 };
 
 struct sort_struct {
@@ -68,6 +71,9 @@ extern int num_of_cmds;
 /* necessary for CMD_IS macro */
 extern struct command_info cmd_info[];
 
+// Commands running longer than this are logged, unless it is zero
+extern unsigned long cmd_slow_usec;
+
 #define CMD_NAME (cmd_info[cmd].command)
 #define CMD_IS(cmd_name) (!strcmp(cmd_name, cmd_info[cmd].command))
 #define IS_MOVE(cmdnum) (cmdnum >= 1 && cmdnum <= 6)
@@ -64,6 +64,20 @@ bool send_mail(struct creature *ch,
 GList *receive_mail(struct creature * ch, int *num_mails);
 bool purge_mail(long idnum);
 
+// The mail waiting in a player's mail file
+struct mailbox {
+	int letters;
+	int packages;
+	long size;					// Bytes in the mail file
+};
+
+typedef void (*mail_reader)(struct obj_data *obj, void *data);
+
+bool mail_file_scan(const char *path, struct mailbox *box);
+long mail_file_append(const char *path, struct obj_data *letter,
+	struct obj_data *obj_list);
+int mail_file_read(const char *path, mail_reader func, void *data);
+
 // The actual mail file entry struct.
 struct mail_data {
 	long to;
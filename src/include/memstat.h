@@ -0,0 +1,87 @@
+#ifndef _MEMSTAT_H_
+#define _MEMSTAT_H_
+
+//
+// File: memstat.h                      -- Part of TempusMUD
+//
+// Counts the memory held by each subsystem, so leaks and bloat can be
+// found in a running game.  Only per-kind counters are kept unless
+// block tracking is turned on, which records every block by address
+// so the live blocks can be dumped.  A block must be passed to
+// memstat_free() with the kind and size it was counted with before it
+// is freed or reallocated.
+//
+
+#define MEMSTAT_FILE "log/memusage"
+
+enum mem_kind {
+    MEM_CREATURE = 0,
+    MEM_OBJECT,
+    MEM_PROG,
+    MEM_TMPSTR,
+    MEM_ACCSTR,
+    MEM_GLIST,
+    MEM_SQL,
+    NUM_MEM_KINDS
+};
+
+extern const char *mem_kind_names[];
+
+struct mem_counts {
+    size_t allocs;              // Allocations made
+    size_t frees;               // Allocations freed
+    size_t blocks;              // Blocks still held
+    size_t bytes;               // Bytes still held
+};
+
+struct mem_pulse {
+    size_t allocs;              // Allocations made during the pulse
+    size_t frees;               // Allocations freed during the pulse
+    long bytes;                 // Change in bytes held over the pulse
+    long most_growth;           // Largest growth seen in a single pulse
+};
+
+// Like CREATE, but counts the allocation against the given kind
+#define CREATE_KIND(result, type, number, kind)  do {\
+        CREATE(result, type, number);                               \
+        memstat_alloc((kind), (result), sizeof(type) * (number));   \
+    } while (0)
+
+// Frees a single block that was counted with CREATE_KIND()
+#define FREE_KIND(ptr, kind)  do {\
+        memstat_free((kind), (ptr), sizeof(*(ptr)));    \
+        free(ptr);                                      \
+    } while (0)
+
+void memstat_alloc(enum mem_kind kind, void *ptr, size_t size);
+void memstat_free(enum mem_kind kind, void *ptr, size_t size);
+
+// Turns the recording of each block by address on or off.  Tracking
+// costs an allocation and a hash insert per block, so it is off unless
+// a leak is being hunted.
+void memstat_set_tracking(bool on);
+bool memstat_tracking(void);
+
+// Sets the usage of a kind which can't be tracked block by block
+void memstat_sample(enum mem_kind kind, size_t blocks, size_t bytes);
+
+// Samples the number of GList nodes held by the largest lists
+void memstat_sample_glists(void);
+
+// Called once per main loop pulse to record the change in usage
+void memstat_pulse(void);
+
+void memstat_counts(enum mem_kind kind, struct mem_counts *counts,
+                    struct mem_pulse *pulse);
+
+// Writes every tracked block to the given file, in the format read by
+// tools/analyze_memusage.rb.  Returns the number of blocks written, or
+// -1 if the file couldn't be opened.  Nothing is written while block
+// tracking is off.
+int memstat_dump(const char *path);
+
+// Logs the usage of each kind, and dumps the blocks to MEMSTAT_FILE
+// if they are being tracked
+void memstat_log(void);
+
+#endif
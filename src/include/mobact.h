@@ -32,4 +32,6 @@ bool psionic_mob_fight(struct creature *ch, struct creature *precious_vict);
 void mage_best_attack(struct creature *ch, struct creature *vict);
 void mage_activity(struct creature *ch);
 bool mage_mob_fight(struct creature *ch, struct creature *precious_vict);
+
+void show_mob_ai(struct creature *ch);
 #endif
@@ -385,6 +385,8 @@ struct obj_data {
 
 	struct obj_data *next_content;	/* For 'contains' lists             */
 	struct obj_data *next;		/* For the object list              */
+	GList *vnum_link;	/* This object's link in the vnum index */
+	GList *id_link;		/* This object's link in the unique id index */
 };
 /* ======================================================================= */
 
@@ -393,6 +395,13 @@ static inline /*@dependent@*/ struct room_direction_data *OEXIT( struct obj_data
 }
 struct obj_data *make_object(void);
 void free_object(struct obj_data *obj);
+void index_object(struct obj_data *obj);
+void unindex_object(struct obj_data *obj);
+void set_object_unique_id(struct obj_data *obj, long unique_id);
+GList *object_instances(int vnum);
+struct obj_data *object_by_unique_id(long unique_id);
+void foreach_object_instance(int vnum, GFunc func, gpointer data);
+GList *duplicate_objects(void);
 void save_object_to_xml(struct obj_data *obj, FILE *outf);
 struct obj_data *load_object_from_xml(struct obj_data *container, struct creature *victim, struct room_data* room, xmlNodePtr node);
 int count_contained_objs(struct obj_data *obj);
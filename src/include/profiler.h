@@ -0,0 +1,51 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+//
+// File: profiler.h                      -- Part of TempusMUD
+//
+// Timing histograms for the main loop callbacks.  Histograms keep
+// PROF_HIST_SUB_BITS bits of precision at every magnitude, so any
+// recorded value is within about 6% of the value reported for it.
+//
+
+#define PROF_HIST_SUB_BITS 5
+#define PROF_HIST_SUB_COUNT (1 << PROF_HIST_SUB_BITS)
+#define PROF_HIST_HALF_COUNT (PROF_HIST_SUB_COUNT / 2)
+#define PROF_HIST_MAX_BITS 32   // Values are capped at about 71 minutes
+#define PROF_HIST_BUCKETS \
+    (PROF_HIST_SUB_COUNT + \
+     (PROF_HIST_MAX_BITS - PROF_HIST_SUB_BITS) * PROF_HIST_HALF_COUNT)
+
+// Unless given its own budget, any callback taking longer than a pulse
+// is logged as slow
+#define PULSE_BUDGET_USEC 100000
+
+struct prof_hist {
+    unsigned long count;
+    unsigned long total;
+    unsigned long max;
+    unsigned int buckets[PROF_HIST_BUCKETS];
+};
+
+void prof_hist_record(struct prof_hist *hist, unsigned long value);
+
+// Returns the value at the given percentile, from 0 to 100
+unsigned long prof_hist_percentile(struct prof_hist *hist, double pct);
+
+void prof_hist_clear(struct prof_hist *hist);
+
+// Registers a repeating main loop callback, like g_timeout_add(), but
+// records its wall time, CPU time, and how late it fired.
+guint pulse_timeout_add(const char *name, guint interval,
+                        GSourceFunc func, gpointer data);
+
+// Like pulse_timeout_add(), for callbacks which are expected to run
+// longer than PULSE_BUDGET_USEC before they are logged as slow.
+guint pulse_timeout_add_budget(const char *name, guint interval,
+                               unsigned long budget_usec,
+                               GSourceFunc func, gpointer data);
+
+void show_pulse_stats(struct creature *ch, char *arg);
+
+#endif
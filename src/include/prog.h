@@ -49,6 +49,33 @@ enum prog_cmd_kind {
     PROG_CMD_CONDNEXTHANDLER,
 };
 
+// Set on an instruction whose argument is a compiled template rather
+// than a plain string.  Only arguments containing a $ are compiled to
+// templates, so all other arguments are passed to the handler as-is.
+#define PROG_CMD_TEMPLATE   0x4000
+#define PROG_CMD_MASK       0x3fff
+
+// Segments of a compiled argument template.  A template is the
+// original argument text and its terminating NUL, followed by a series
+// of segments terminated by PROG_SEG_END.  Segments refer to the text
+// by its offset from the start of the template instead of copying it.
+//   PROG_SEG_TEXT:   uint16 offset, uint16 length of literal text
+//   PROG_SEG_VAR:    int32 symbol, uint16 offset, uint8 length of the
+//                    name of a ${var} reference
+//   PROG_SEG_PREFIX: uint16 offset and uint8 length n of the characters
+//                    following a bare $, then n int32 symbols.  Symbol
+//                    i is the name formed by the first i + 1
+//                    characters; the longest one set as a variable is
+//                    substituted.
+//   PROG_SEG_TYPO:   an invalid variable reference
+enum prog_seg_kind {
+    PROG_SEG_END,
+    PROG_SEG_TEXT,
+    PROG_SEG_VAR,
+    PROG_SEG_PREFIX,
+    PROG_SEG_TYPO,
+};
+
 struct prog_evt {
 	enum prog_evt_phase phase;
 	enum prog_evt_kind kind;
@@ -62,12 +89,14 @@ struct prog_evt {
 
 struct prog_var {
 	struct prog_var *next;
+	int sym;					// interned symbol of key
 	char key[255];
 	char value[255];
 };
 
 struct prog_state_data {
 	struct prog_var *var_list;
+	GHashTable *vars;			// symbol -> struct prog_var
 };
 
 struct prog_env {
@@ -82,6 +111,8 @@ struct prog_env {
 	struct prog_evt evt;				// copy of event that caused prog to trigger
     bool tracing;               // prog is being traced
 	struct prog_state_data *state; // thread-local state
+	struct _GPQueue *wakeup;	// entry in the wakeup queue, while sleeping
+	GList *link;				// entry in active_progs
 };
 
 struct prog_command {
@@ -110,8 +141,17 @@ void prog_update(void);
 void prog_update_pending(void);
 size_t prog_count(bool total);
 size_t free_prog_count(void);
+void prog_sched_counts(size_t *active, size_t *sleeping, size_t *due);
+void prog_terminate(struct prog_env *env);
+void prog_register_owner(void *owner, enum prog_evt_type owner_type);
+void prog_unregister_owner(void *owner, enum prog_evt_type owner_type);
+void prog_owner_counts(size_t *mobs, size_t *rooms);
 void prog_state_free(struct prog_state_data *state);
 void prog_compile(struct creature *ch, void *owner, enum prog_evt_type owner_type);
+void prog_link(unsigned char *obj);
+const char *prog_template_text(const unsigned char *tmpl);
+int prog_intern_symbol(const char *name);
+int prog_find_symbol(const char *name);
 char *prog_get_text(void *owner, enum prog_evt_type owner_type);
 void prog_unreference_object(struct obj_data *obj);
 
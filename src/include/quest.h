@@ -74,6 +74,8 @@ struct quest {
 		int maxgen;
         int loadroom;
 		uint8_t type;
+		bool dirty; // changed since it was last saved
+		bool archived; // ended, and saved in the quest archive
 };
 
 // utility functions
@@ -88,6 +90,8 @@ struct creature *check_char_vis(struct creature *ch, char *name);
 void list_quest_players(struct creature *ch, struct quest *quest, char *outbuf, size_t size);
 int boot_quests(void);
 void save_quests();
+void load_quest_files(const char *path, const char *archive_path);
+void save_quest_files(const char *path, const char *archive_path);
 
 // quest subfunctions and utils
 void do_quest_list(struct creature *ch);
@@ -227,7 +227,10 @@ struct room_data {
 	struct zone_data *zone;		// zone the room is in
 	struct room_data *next;
 	struct obj_data *contents;	// List of items in room
+	unsigned long contents_serial;	// Changed when contents is
 	GList *people;		// List of NPC / PC in room
+    int house_rent;             // Rent of the contents, if a house room
+    int house_objects;          // Number of objects, if a house room
 };
 
 static inline int
@@ -45,10 +45,16 @@ struct role {
     GList *commands;
     // player ids, sorted
     GList *members;
+    // bit held by this role in players' compiled role bitmaps
+    int slot;
 };
 
 extern GList *roles;
 
+// Changed whenever roles, their commands, or their members change, so
+// that players' compiled privileges are rebuilt before being used.
+extern unsigned long role_generation;
+
 enum privilege {
     CREATE_ROLE,
     DESTROY_ROLE,
@@ -125,5 +131,14 @@ void send_role_member_list(struct role *role,
 bool is_tester(struct creature *ch);
 bool send_available_commands(struct creature *ch, long id);
 bool is_named_role_member(struct creature *ch, const char *role_name);
+bool role_command_allowed(struct creature *ch,
+                          const struct command_info *command);
+void roles_changed(void);
+void compile_role_privileges(struct creature *ch);
+
+// Answer the same questions by searching the role lists directly
+bool is_named_role_member_scan(struct creature *ch, const char *role_name);
+bool role_command_allowed_scan(struct creature *ch,
+                               const struct command_info *command);
 
 #endif
@@ -958,6 +958,8 @@ ASPELL(song_hymn_of_peace);
 /* basic magic calling functions */
 
 int find_skill_num(char *name);
+int find_skill_num_scan(char *name);
+void index_skill_names(void);
 
 bool can_cast_spell(struct creature *ch, int spellnum);
 
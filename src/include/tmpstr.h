@@ -95,4 +95,36 @@ void tmp_gc_strings(void);
 
 extern size_t tmp_max_used;
 
+// A checkpoint in the temp str pool.  Releasing it frees every temp
+// str allocated after it was made, so long loops can reclaim their
+// temporaries without waiting for tmp_gc_strings().  Marks must be
+// released in the reverse order they were made.
+struct tmp_str_pool;
+struct tmp_mark {
+    struct tmp_str_pool *pool;
+    size_t used;
+    unsigned int gc_count;
+    const char *site;
+};
+
+#ifdef DEBUG_TMPSTR
+#define TMP_MARK_LINE(line) #line
+#define TMP_MARK_SITE(line) __FILE__ ":" TMP_MARK_LINE(line)
+#define tmp_mark() tmp_mark_site(TMP_MARK_SITE(__LINE__))
+#else
+#define tmp_mark() tmp_mark_site(NULL)
+#endif
+
+struct tmp_mark tmp_mark_site(const char *site);
+
+// Frees all temp strs allocated since the mark was made.  Does
+// nothing if the strings were already freed.
+void tmp_release(struct tmp_mark mark);
+
+// Calls func with each mark site and the most space released there.
+// Sites are only tracked when built with DEBUG_TMPSTR.
+void tmp_foreach_mark_site(void (*func)(const char *site, size_t released,
+                                        void *data),
+                           void *data);
+
 #endif
@@ -503,6 +503,8 @@ bool check_sight_object(struct creature *self, struct obj_data *obj);
 bool check_sight_vict(struct creature *self, struct creature *vict);
 
 bool can_see_creature(struct creature *self, struct creature *vict);
+bool can_see_creature_uncached(struct creature *self, struct creature *vict);
+void invalidate_sight(void);
 bool can_see_object(struct creature *self, struct obj_data *obj);
 bool can_see_room(struct creature *self, struct room_data *room);
 
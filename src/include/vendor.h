@@ -20,6 +20,25 @@ struct shop_time {
 	int start, end;
 };
 
+// A run of identical objects in a shop's stock, listed as one item
+struct vendor_stock_group {
+	struct obj_data *obj;		// First object of the run
+	struct obj_data *last;		// Last object, which the listing shows
+	int count;
+	bool same_aliases;			// All of the run has obj's aliases
+};
+
+// The shop's stock grouped the way it is listed.  The vendor's own
+// trades update their groups in place, and it is regrouped whenever
+// anything else moves an object into or out of the stock.
+struct vendor_stock {
+	struct obj_data *contents;	// Head of the list when grouped
+	unsigned long serial;		// Serial of the list when grouped
+	GPtrArray *groups;			// Groups in the order they're listed
+	GHashTable *first_of_vnum;	// vnum -> first group of that vnum
+	GHashTable *group_of;		// first object -> its group
+};
+
 struct shop_data {
 	long room;				// Room of self
 	GList *item_list;	// list of produced items
@@ -46,11 +65,19 @@ struct shop_data {
 	bool call_for_help;
 	SPECIAL((*func));
 	struct reaction *reaction;
+	struct vendor_stock stock;
 };
 
 SPECIAL(vendor);
 const char *vendor_parse_param(char *param, struct shop_data *shop, int *err_line);
 struct obj_data *vendor_resolve_hash(struct shop_data *shop, struct creature *self, char *obj_str);
 struct obj_data *vendor_resolve_name(struct shop_data *shop, struct creature *self, char *obj_str);
+struct vendor_stock *vendor_stock(struct shop_data *shop, struct creature *self);
+int vendor_stock_count(struct shop_data *shop, struct creature *self, struct obj_data *obj);
+void vendor_stock_add(struct shop_data *shop, struct creature *self, struct room_data *room, struct obj_data *obj);
+void vendor_stock_remove(struct shop_data *shop, struct creature *self, struct room_data *room, struct obj_data *obj);
+void vendor_free_stock(struct shop_data *shop);
+char *vendor_list_str(struct creature *ch, char *arg, struct creature *self, struct shop_data *shop);
+char *vendor_list_str_scan(struct creature *ch, char *arg, struct creature *self, struct shop_data *shop);
 
 #endif
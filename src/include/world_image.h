@@ -0,0 +1,29 @@
+#ifndef _WORLD_IMAGE_H_
+#define _WORLD_IMAGE_H_
+
+//
+// File: world_image.h                      -- Part of TempusMUD
+//
+// The world image is a compiled binary snapshot of the zon, wld, mob,
+// and obj files, including compiled prog object code.  It is written
+// after a successful text boot and reused on subsequent boots as long
+// as every source file it was built from is unchanged.
+//
+
+#define WORLD_IMAGE_FILE "world/world.img"
+
+extern bool use_world_image;
+extern bool world_image_loaded;
+
+// Records the mtime, size, and hash of every world source file.  Must
+// be called before the world files are parsed.
+bool world_image_scan_sources(void);
+
+// Boots the world from the image, if it matches the scanned sources.
+// Returns true if the world was loaded.
+bool load_world_image(void);
+
+// Writes an image of the loaded world and its compiled progs
+void save_world_image(void);
+
+#endif
@@ -53,6 +53,7 @@
 extern int log_cmds;
 struct sort_struct *cmd_sort_info = NULL;
 int num_of_cmds = 0;
+unsigned long cmd_slow_usec = 0;   // Commands slower than this are logged
 
 int general_search(struct creature *ch, struct special_search_data *srch,
     int mode);
@@ -109,6 +110,9 @@ ACMD(do_arm);
 ACMD(do_aset);
 ACMD(do_access);
 ACMD(do_coderutil);
+ACMD(do_memory);
+ACMD(do_pulse);
+ACMD(do_cmdstat);
 ACMD(do_unapprove);
 ACMD(do_assist);
 ACMD(do_assimilate);
@@ -1516,6 +1520,9 @@ struct command_info cmd_info[] = {
     {"hcollection", POS_DEAD, do_help_collection_command, 1, 0, 0, 0},
     {"access", POS_DEAD, do_access, LVL_IMMORT, 0, 0, 0},
     {"coderutil", POS_DEAD, do_coderutil, LVL_DEMI, 0, 0, 0},
+    {"memory", POS_DEAD, do_memory, LVL_DEMI, 0, 0, 0},
+    {"pulse", POS_DEAD, do_pulse, LVL_DEMI, 0, 0, 0},
+    {"cmdstat", POS_DEAD, do_cmdstat, LVL_DEMI, 0, 0, 0},
     // Moods!
     {"accusingly", POS_DEAD, do_mood, 0, 0, 0, 0},
     {"angelically", POS_DEAD, do_mood, 0, 0, 0, 0},
@@ -1820,9 +1827,32 @@ command_interpreter(struct creature *ch, const char *argument)
         case POS_FIGHTING:
             send_to_char(ch, "No way!  You're fighting for your life!\r\n");
             break;
-    } else if (no_specials ||
-        !special(ch, cmd, cmd_info[cmd].subcmd, cmdargs, SPECIAL_CMD)) {
-        cmd_info[cmd].command_pointer(ch, cmdargs, cmd, cmd_info[cmd].subcmd);
+    } else {
+        gint64 start = g_get_monotonic_time();
+        unsigned long elapsed;
+
+        // The actor may not survive the command, so only its numbers
+        // are kept.  The arguments are never logged, since they may
+        // hold passwords.
+        bool npc = IS_NPC(ch);
+        long idnum = npc ? GET_NPC_VNUM(ch) : GET_IDNUM(ch);
+        room_num room = (ch->in_room) ? ch->in_room->number : -1;
+
+        // Specials include any progs triggered by the command
+        if (no_specials ||
+            !special(ch, cmd, cmd_info[cmd].subcmd, cmdargs, SPECIAL_CMD))
+            cmd_info[cmd].command_pointer(ch, cmdargs, cmd,
+                                          cmd_info[cmd].subcmd);
+
+        elapsed = g_get_monotonic_time() - start;
+        cmd_info[cmd].timed++;
+        cmd_info[cmd].total_usec += elapsed;
+        if (elapsed > cmd_info[cmd].max_usec)
+            cmd_info[cmd].max_usec = elapsed;
+        if (cmd_slow_usec && elapsed > cmd_slow_usec)
+            slog("SLOW CMD: [%d] %s %ld :: %s took %lu.%03lums",
+                 room, npc ? "mob" : "player", idnum, cmd_info[cmd].command,
+                 elapsed / 1000, elapsed % 1000);
     }
 }
 
@@ -22,6 +22,7 @@
 #include "creature.h"
 #include "screen.h"
 #include "players.h"
+#include "tmpstr.h"
 #include "accstr.h"
 #include "account.h"
 
@@ -31,6 +32,55 @@
 /** The global container of Role objects. **/
 GList *roles;
 
+// Starts above zero so that new players are always compiled
+unsigned long role_generation = 1;
+
+// Lower-cased role names -> roles, rebuilt when role_generation changes
+static GHashTable *role_index = NULL;
+static unsigned long role_index_generation = 0;
+static int role_slots = 0;
+static int command_slots = 0;
+
+void
+roles_changed(void)
+{
+    role_generation++;
+}
+
+static void
+index_roles(void)
+{
+    int slot = 0;
+
+    if (role_index && role_index_generation == role_generation)
+        return;
+
+    if (!role_index)
+        role_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                           g_free, NULL);
+    else
+        g_hash_table_remove_all(role_index);
+
+    for (GList *it = roles; it; it = it->next) {
+        struct role *role = it->data;
+        char *key = g_ascii_strdown(role->name, -1);
+
+        role->slot = slot++;
+        // The first role of a name is the one found by name
+        if (g_hash_table_lookup(role_index, key))
+            g_free(key);
+        else
+            g_hash_table_insert(role_index, key, role);
+    }
+    role_slots = slot;
+
+    if (!command_slots)
+        while (*cmd_info[command_slots].command != '\n')
+            command_slots++;
+
+    role_index_generation = role_generation;
+}
+
 void
 security_log(const char *msg, const char *name)
 {
@@ -45,6 +95,15 @@ role_matches(struct role *role, const char *name)
 
 struct role *
 role_by_name(const char *name)
+{
+    if (!name)
+        return NULL;
+    index_roles();
+    return g_hash_table_lookup(role_index, tmp_tolower(name));
+}
+
+static struct role *
+role_by_name_scan(const char *name)
 {
     GList *it = g_list_find_custom(roles,
         (gconstpointer) name,
@@ -52,6 +111,105 @@ role_by_name(const char *name)
     return (it) ? it->data : NULL;
 }
 
+#define PRIV_BIT_SET(bits, idx) ((bits)[(idx) / 32] |= (1U << ((idx) % 32)))
+#define PRIV_BIT_TEST(bits, idx) ((bits)[(idx) / 32] & (1U << ((idx) % 32)))
+
+/* Builds the bitmaps of the roles a player holds and the commands
+ * those roles give them. */
+void
+compile_role_privileges(struct creature *ch)
+{
+    struct player_special_data *specials = ch->player_specials;
+
+    index_roles();
+
+    free(specials->role_bits);
+    free(specials->cmd_bits);
+    CREATE(specials->role_bits, uint32_t, role_slots / 32 + 1);
+    CREATE(specials->cmd_bits, uint32_t, command_slots / 32 + 1);
+
+    for (GList *it = roles; it; it = it->next) {
+        struct role *role = it->data;
+
+        if (!is_role_member(role, GET_IDNUM(ch)))
+            continue;
+        PRIV_BIT_SET(specials->role_bits, role->slot);
+        for (GList *cmd_it = role->commands; cmd_it; cmd_it = cmd_it->next) {
+            struct command_info *command = cmd_it->data;
+
+            PRIV_BIT_SET(specials->cmd_bits, command - cmd_info);
+        }
+    }
+
+    specials->privs_generation = role_generation;
+}
+
+static void
+check_role_privileges(struct creature *ch)
+{
+    if (ch->player_specials->privs_generation != role_generation
+        || !ch->player_specials->role_bits)
+        compile_role_privileges(ch);
+}
+
+bool
+is_named_role_member(struct creature *ch, const char *role_name)
+{
+    struct role *role;
+
+    if (IS_NPC(ch))
+        return false;
+    if (AFF_FLAGGED(ch, AFF_CHARM))
+        return false;
+
+    role = role_by_name(role_name);
+    if (!role)
+        return false;
+    check_role_privileges(ch);
+    return PRIV_BIT_TEST(ch->player_specials->role_bits, role->slot);
+}
+
+bool
+is_named_role_member_scan(struct creature *ch, const char *role_name)
+{
+    struct role *role;
+
+    if (IS_NPC(ch))
+        return false;
+    if (AFF_FLAGGED(ch, AFF_CHARM))
+        return false;
+
+    role = role_by_name_scan(role_name);
+    if (!role)
+        return false;
+    return is_role_member(role, GET_IDNUM(ch));
+}
+
+/* True if one of the player's roles gives them the command. */
+bool
+role_command_allowed(struct creature *ch, const struct command_info *command)
+{
+    if (!IS_PC(ch))
+        return false;
+    check_role_privileges(ch);
+    return PRIV_BIT_TEST(ch->player_specials->cmd_bits, command - cmd_info);
+}
+
+bool
+role_command_allowed_scan(struct creature *ch,
+                          const struct command_info *command)
+{
+    if (!IS_PC(ch))
+        return false;
+    for (GList * it = roles; it; it = it->next) {
+        struct role *role = (struct role *)it->data;
+        if (is_role_command(role, command)
+            && is_role_member(role, GET_IDNUM(ch)))
+            return true;
+    }
+    return false;
+}
+
 /* sets this role's description */
 void
 set_role_description(struct role *role, const char *desc)
@@ -189,6 +347,7 @@ add_role_command(struct role *role, struct command_info *command)
         return false;
     command->role_count += 1;
     role->commands = g_list_prepend(role->commands, command);
+    roles_changed();
     return true;
 }
 
@@ -201,6 +360,7 @@ remove_role_command(struct role * role, struct command_info * command)
 
     role->commands = g_list_remove(role->commands, command);
     command->role_count -= 1;
+    roles_changed();
     return true;
 }
 
@@ -212,6 +372,7 @@ remove_role_member(struct role * role, long player)
         return false;
 
     role->members = g_list_remove(role->members, GINT_TO_POINTER(player));
+    roles_changed();
 
     return true;
 }
@@ -224,6 +385,7 @@ add_role_member(struct role * role, long player)
         return false;
 
     role->members = g_list_prepend(role->members, GINT_TO_POINTER(player));
+    roles_changed();
 
     return true;
 }
@@ -280,6 +442,7 @@ make_role(const char *name, const char *description, const char *admin_role)
         role->description = strdup(description);
     if (admin_role)
         role->admin_role = strdup(admin_role);
+    roles_changed();
 
     return role;
 }
@@ -293,4 +456,5 @@ free_role(struct role *role)
     g_list_free(role->commands);
     g_list_free(role->members);
     free(role);
+    roles_changed();
 }
@@ -137,22 +137,6 @@ find_access_command(char *command)
 struct role *role_by_name(const char *name);
 bool authorized_to_edit_role(struct creature *ch, struct role *role);
 
-bool
-is_named_role_member(struct creature *ch, const char *role_name)
-{
-    struct role *role;
-
-    if (IS_NPC(ch))
-        return false;
-    if (AFF_FLAGGED(ch, AFF_CHARM))
-        return false;
-
-    role = role_by_name(role_name);
-    if (!role)
-        return false;
-    return is_role_member(role, GET_IDNUM(ch));
-}
-
 bool
 is_authorized(struct creature * ch, enum privilege priv, void *target)
 {
@@ -283,15 +267,7 @@ is_authorized(struct creature * ch, enum privilege priv, void *target)
         if (!command->role_count)
             return true;
 
-        if (IS_PC(ch)) {
-            for (GList * it = roles; it; it = it->next) {
-                struct role *role = (struct role *)it->data;
-                if (is_role_command(role, command)
-                    && is_role_member(role, GET_IDNUM(ch)))
-                    return true;
-            }
-        }
-        return false;
+        return role_command_allowed(ch, command);
 
     case SET:
         if (IS_NPC(ch))
@@ -389,6 +365,7 @@ destroy_role(struct role *role)
 
     roles = g_list_remove(roles, role);
     free_role(role);
+    roles_changed();
     return true;
 }
 
@@ -442,6 +419,7 @@ free_roles(void)
     g_list_foreach(roles, (GFunc) free_role, NULL);
     g_list_free(roles);
     roles = NULL;
+    roles_changed();
 }
 
 bool
@@ -464,6 +442,7 @@ load_roles_from_db(void)
         roles = g_list_prepend(roles, role);
     }
     roles = g_list_reverse(roles);
+    roles_changed();
 
     res =
         sql_query
@@ -637,6 +616,7 @@ ACMD(do_access)
                 "values (%d, '%s', 'No description.')", role_id, token);
 
             roles = g_list_prepend(roles, role);
+            roles_changed();
 
             send_to_char(ch, "Role created.\r\n");
             slog("Security:  Role '%s' created by %s.", token, GET_NAME(ch));
@@ -743,11 +723,11 @@ ACMD(do_access)
             int command_idx;
             command_idx = find_command(token);
             if (command_idx != -1) {
-                add_role_command(role, &cmd_info[command_idx]);
+                remove_role_command(role, &cmd_info[command_idx]);
                 send_to_char(ch, "Command removed : %s\r\n",
                     cmd_info[command_idx].command);
                 sql_exec("delete from sgroup_commands "
-                    "where sgroup = %d and command='%s') ",
+                    "where sgroup = %d and command='%s'",
                     role->id, cmd_info[command_idx].command);
 
                 slog("Security:  command %s removed from role '%s' by %s.",
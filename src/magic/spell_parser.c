@@ -202,34 +202,141 @@ say_spell(struct creature *ch,
             ch, tobj, tch, TO_NOTVICT);
 }
 
-int
-find_skill_num(char *name)
+// Spell name lookup tables, rebuilt by index_skill_names().
+// skill_abbrevs maps every lowercased prefix of every spell name to the
+// lowest spell number with that prefix.  skill_first_words maps every
+// prefix of the first word of a spell name to a GArray of the spell
+// numbers starting with that word, in ascending order.
+static GHashTable *skill_abbrevs = NULL;
+static GHashTable *skill_first_words = NULL;
+
+// Returns true if every word of name is an abbreviation of the
+// corresponding word of the spell name, such as "c l" for "cure light"
+static bool
+skill_words_match(const char *spell, char *name)
 {
-    int index = 0, ok;
     char *temp, *temp2;
     char spellname[256];
     char first[256], first2[256];
+    bool ok = true;
+
+    strncpy(spellname, spell, 255);
+    spellname[255] = '\0';
+    temp = any_one_arg(spellname, first);
+    temp2 = any_one_arg(name, first2);
+    while (*first && *first2 && ok) {
+        if (!is_abbrev(first2, first))
+            ok = false;
+        temp = any_one_arg(temp, first);
+        temp2 = any_one_arg(temp2, first2);
+    }
+
+    return ok && !*first2;
+}
+
+// The original linear search, used until the spells are indexed
+int
+find_skill_num_scan(char *name)
+{
+    int index = 0;
 
     while (*spell_to_str(++index) != '\n') {
         if (is_abbrev(name, spell_to_str(index)))
             return index;
+        if (skill_words_match(spell_to_str(index), name))
+            return index;
+    }
+
+    return -1;
+}
+
+static void
+free_skill_index_array(gpointer array)
+{
+    g_array_free(array, true);
+}
+
+void
+index_skill_names(void)
+{
+    char first[256];
+    int index;
+
+    if (skill_abbrevs) {
+        g_hash_table_destroy(skill_abbrevs);
+        g_hash_table_destroy(skill_first_words);
+    }
+    skill_abbrevs = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, NULL);
+    skill_first_words = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, free_skill_index_array);
 
-        ok = 1;
-        strncpy(spellname, spell_to_str(index), 255);
-        temp = any_one_arg(spellname, first);
-        temp2 = any_one_arg(name, first2);
-        while (*first && *first2 && ok) {
-            if (!is_abbrev(first2, first))
-                ok = 0;
-            temp = any_one_arg(temp, first);
-            temp2 = any_one_arg(temp2, first2);
+    for (index = 1; *spells[index] != '\n'; index++) {
+        char *name = tmp_tolower(spells[index]);
+        size_t len = strlen(name);
+
+        for (size_t i = 1; i <= len; i++) {
+            char *key = g_strndup(name, i);
+
+            if (g_hash_table_lookup(skill_abbrevs, key))
+                g_free(key);
+            else
+                g_hash_table_insert(skill_abbrevs, key,
+                    GINT_TO_POINTER(index));
         }
 
-        if (ok && !*first2)
+        any_one_arg(name, first);
+        len = strlen(first);
+        for (size_t i = 1; i <= len; i++) {
+            char *key = g_strndup(first, i);
+            GArray *matches = g_hash_table_lookup(skill_first_words, key);
+
+            if (matches) {
+                g_free(key);
+            } else {
+                matches = g_array_new(false, false, sizeof(int));
+                g_hash_table_insert(skill_first_words, key, matches);
+            }
+            g_array_append_val(matches, index);
+        }
+    }
+}
+
+int
+find_skill_num(char *name)
+{
+    char first[256];
+    GArray *matches;
+    int result = -1;
+
+    if (!skill_abbrevs)
+        return find_skill_num_scan(name);
+
+    // A whole-name abbreviation wins over any higher-numbered spell
+    if (*name)
+        result = GPOINTER_TO_INT(g_hash_table_lookup(skill_abbrevs,
+                tmp_tolower(name)));
+    if (!result)
+        result = -1;
+
+    any_one_arg(name, first);
+    if (!*first)
+        return (*spells[1] != '\n') ? 1 : -1;
+
+    matches = g_hash_table_lookup(skill_first_words, first);
+    if (!matches)
+        return result;
+
+    for (guint i = 0; i < matches->len; i++) {
+        int index = g_array_index(matches, int, i);
+
+        if (result != -1 && index >= result)
+            break;
+        if (skill_words_match(spells[index], name))
             return index;
     }
 
-    return -1;
+    return result;
 }
 
 /*
@@ -2462,6 +2569,8 @@ boot_spells(const char *path)
     }
 
     xmlFreeDoc(doc);
+
+    index_skill_names();
 }
 
 #undef __spell_parser_c__
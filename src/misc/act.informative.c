@@ -1829,11 +1829,17 @@ look_at_target(struct creature *ch, char *arg, int cmd)
                         TO_CHAR);
             } else if (IS_V_WINDOW(found_obj)) {
 
-                for (car = object_list; car; car = car->next)
-                    if (GET_OBJ_VNUM(car) == V_CAR_VNUM(found_obj) &&
-                        ROOM_NUMBER(car) == ROOM_NUMBER(found_obj) &&
-                        car->in_room)
+                car = NULL;
+                for (GList *it = object_instances(V_CAR_VNUM(found_obj));
+                     it; it = it->next) {
+                    struct obj_data *obj = it->data;
+
+                    if (ROOM_NUMBER(obj) == ROOM_NUMBER(found_obj)
+                        && obj->in_room) {
+                        car = obj;
                         break;
+                    }
+                }
 
                 if (car) {
                     act("You look through $p.", false, ch, found_obj, NULL,
@@ -3525,6 +3531,75 @@ who_list_compare(struct creature *a, struct creature *b)
     return cmp(time_b, time_a);
 }
 
+// The state of a who list being paged
+struct who_listing {
+    char *header;
+    GArray *idnums;
+    guint pos;
+    bool flags;
+    bool kills;
+    char *footer;
+};
+
+static void
+free_who_listing(void *data)
+{
+    struct who_listing *listing = data;
+
+    free(listing->header);
+    g_array_free(listing->idnums, true);
+    free(listing->footer);
+    free(listing);
+}
+
+static void
+who_listing_add(struct who_listing *listing, GList *list)
+{
+    for (GList *cit = first_living(list); cit; cit = next_living(cit)) {
+        long idnum = GET_IDNUM((struct creature *)cit->data);
+
+        g_array_append_val(listing->idnums, idnum);
+    }
+}
+
+// Lists the next few players.  Players are looked up again by idnum,
+// since they may have left the game between pages.
+static bool
+next_who_entries(struct descriptor_data *d, void *data)
+{
+    struct who_listing *listing = data;
+    struct creature *ch = d->creature;
+    int shown = 0;
+
+    if (!ch)
+        return false;
+
+    if (listing->header) {
+        acc_strcat(listing->header, NULL);
+        free(listing->header);
+        listing->header = NULL;
+    }
+    while (listing->pos < listing->idnums->len && shown < 20) {
+        struct creature *curr = get_char_in_world_by_idnum(
+            g_array_index(listing->idnums, long, listing->pos++));
+
+        if (!curr)
+            continue;
+        who_string(ch, curr);
+        if (listing->flags)
+            who_flags(ch, curr);
+        if (listing->kills)
+            who_kills(ch, curr);
+        acc_strcat("\r\n", NULL);
+        shown++;
+    }
+    if (listing->pos < listing->idnums->len)
+        return true;
+
+    acc_strcat(listing->footer, NULL);
+    return false;
+}
+
 ACMD(do_who)
 {
 
@@ -3541,6 +3616,7 @@ ACMD(do_who)
     struct clan_data *real_clan = NULL;
     char *arg;
     GList *immortals = NULL, *testers = NULL, *players = NULL;
+    struct who_listing *listing;
 
     for (arg = tmp_getword(&argument); *arg; arg = tmp_getword(&argument)) {
         if (!strcmp(arg, "zone")) {
@@ -3699,47 +3775,22 @@ ACMD(do_who)
     testers = g_list_sort(testers, (GCompareFunc) who_list_compare);
     players = g_list_sort(players, (GCompareFunc) who_list_compare);
 
-    acc_strcat(CCNRM(ch, C_SPR), CCBLD(ch, C_CMP), "**************      ",
+    CREATE(listing, struct who_listing, 1);
+    listing->idnums = g_array_new(false, false, sizeof(long));
+    listing->flags = !noflags;
+    listing->kills = kills;
+    listing->header = strdup(tmp_strcat(CCNRM(ch, C_SPR), CCBLD(ch, C_CMP),
+        "**************      ",
         CCGRN(ch, C_NRM), "Visible Players of TEMPUS",
         CCNRM(ch, C_NRM), CCBLD(ch, C_CMP), "      **************",
         CCNRM(ch, C_SPR), "\r\n",
-        (IS_NPC(ch) || ch->account->compact_level > 1) ? "" : "\r\n", NULL);
-    for (GList *cit = first_living(immortals); cit; cit = next_living(cit)) {
-        curr = (struct creature *)cit->data;
-        who_string(ch, curr);
-        if (!noflags) {
-            who_flags(ch, curr);
-        }
-        if (kills) {
-            who_kills(ch, curr);
-        }
-        acc_strcat("\r\n", NULL);
-    }
-    if (IS_IMMORT(ch) || is_tester(ch)) {
-        for (GList * cit = first_living(testers); cit; cit = next_living(cit)) {
-            curr = (struct creature *)cit->data;
-            who_string(ch, curr);
-            if (!noflags) {
-                who_flags(ch, curr);
-            }
-            if (kills) {
-                who_kills(ch, curr);
-            }
-            acc_strcat("\r\n", NULL);
-        }
-    }
-    for (GList * cit = first_living(players); cit; cit = next_living(cit)) {
-        curr = (struct creature *)cit->data;
-        who_string(ch, curr);
-        if (!noflags) {
-            who_flags(ch, curr);
-        }
-        if (kills) {
-            who_kills(ch, curr);
-        }
-        acc_strcat("\r\n", NULL);
-    }
+        (IS_NPC(ch) || ch->account->compact_level > 1) ? "" : "\r\n", NULL));
+    who_listing_add(listing, immortals);
+    if (IS_IMMORT(ch) || is_tester(ch))
+        who_listing_add(listing, testers);
+    who_listing_add(listing, players);
 
+    acc_string_clear();
     if (IS_PC(ch) && ch->account->compact_level <= 1)
         acc_strcat("\r\n", NULL);
     acc_sprintf("%s%d of %d immortal%s, ",
@@ -3752,10 +3803,13 @@ ACMD(do_who)
     }
     acc_sprintf("and %d of %d player%s displayed.\r\n", g_list_length(players),
         playerTotal, (playerTotal == 1) ? "" : "s");
-    page_string(ch->desc, acc_get_string());
+    listing->footer = strdup(acc_get_string());
+
     g_list_free(immortals);
     g_list_free(testers);
     g_list_free(players);
+
+    page_generator(ch->desc, next_who_entries, listing, free_who_listing);
 }
 
 /* Generic page_string function for displaying text */
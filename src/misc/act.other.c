@@ -1210,6 +1210,7 @@ ACMD(do_gen_tog)
         break;
     case SCMD_HOLYLIGHT:
         result = PRF_TOG_CHK(ch, PRF_HOLYLIGHT);
+        invalidate_sight();
         break;
     case SCMD_SLOWNS:
         result = (nameserver_is_slow = !nameserver_is_slow);
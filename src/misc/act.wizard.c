@@ -70,11 +70,14 @@
 #include "quest.h"
 #include "paths.h"
 #include "voice.h"
+#include "mobact.h"
 #include "olc.h"
 #include "editor.h"
 #include "boards.h"
 #include "smokes.h"
 #include "ban.h"
+#include "memstat.h"
+#include "profiler.h"
 
 /*   external vars  */
 extern struct obj_data *object_list;
@@ -3175,6 +3178,7 @@ perform_vis(struct creature *ch)
     }
 
     GET_INVIS_LVL(ch) = 0;
+    invalidate_sight();
     for (GList * it = first_living(ch->in_room->people); it; it = next_living(it)) {
         struct creature *tch = it->data;
         if (tch == ch || !can_see_creature(tch, ch))
@@ -3202,6 +3206,7 @@ perform_invis(struct creature *ch, int level)
     // that we can still take invisibility/transparency into account.
     old_level = GET_INVIS_LVL(ch);
     GET_INVIS_LVL(ch) = 0;
+    invalidate_sight();
 
     for (GList * it = first_living(ch->in_room->people); it; it = next_living(it)) {
         struct creature *tch = it->data;
@@ -3228,6 +3233,7 @@ perform_invis(struct creature *ch, int level)
     }
 
     GET_INVIS_LVL(ch) = level;
+    invalidate_sight();
     send_to_char(ch, "Your invisibility level is %d.\r\n", level);
 }
 
@@ -3970,11 +3976,20 @@ list_skills_to_char(struct creature *ch, struct creature *vict)
     page_string(ch->desc, buf2);
 }
 
+static void
+show_tmp_mark_site(const char *site, size_t released, void *data)
+{
+    send_to_char((struct creature *)data,
+                 "  %5zu tmpstr released at %s\r\n", released, site);
+}
+
 void
 do_show_stats(struct creature *ch)
 {
     int i = 0, j = 0, k = 0, con = 0, tr_count = 0, srch_count = 0;
     short int num_active_zones = 0;
+    size_t progs_active, progs_sleeping, progs_due;
+    size_t prog_mobs, prog_rooms;
     struct obj_data *obj;
     struct room_data *room;
     struct room_trail_data *trail;
@@ -4019,6 +4034,7 @@ do_show_stats(struct creature *ch)
         account_cache_size(), player_count());
     send_to_char(ch, "  %5d mobiles          %5d prototypes (%d id'd)\r\n",
         j, g_hash_table_size(mob_prototypes), current_mob_idnum);
+    send_to_char(ch, "  %5u in combat\r\n", combatant_count());
     send_to_char(ch, "  %5d objects          %5d prototypes\r\n",
         k, g_hash_table_size(obj_prototypes));
     send_to_char(ch, "  %5d rooms            %5d zones (%d active)\r\n",
@@ -4029,6 +4045,7 @@ do_show_stats(struct creature *ch)
         buf_switches, buf_overflows);
     send_to_char(ch, "  %5zd tmpstr space     %5zu accstr space\r\n",
         tmp_max_used, acc_str_space);
+    tmp_foreach_mark_site(show_tmp_mark_site, ch);
 #ifdef MEMTRACK
     send_to_char(ch, "  %5ld trail count      %ldMB total memory\r\n",
         tr_count, dbg_memory_used() / (1024 * 1024));
@@ -4037,6 +4054,12 @@ do_show_stats(struct creature *ch)
 #endif
     send_to_char(ch, "  %5zu running progs (%zu total, %zu free)\r\n",
         prog_count(false), prog_count(true), free_prog_count());
+    prog_sched_counts(&progs_active, &progs_sleeping, &progs_due);
+    send_to_char(ch, "  %5zu active progs (%zu sleeping, %zu due)\r\n",
+        progs_active, progs_sleeping, progs_due);
+    prog_owner_counts(&prog_mobs, &prog_rooms);
+    send_to_char(ch, "  %5zu mobiles and %zu rooms with progs\r\n",
+        prog_mobs, prog_rooms);
     //send_to_char(ch, "  %5zu fighting creatures\r\n",
     // combatList.size());
     send_to_char(ch, "  Lunar day: %2d, phase: %s (%d)\r\n",
@@ -4382,6 +4405,49 @@ show_mobkills(struct creature *ch, char *value, char *arg
     page_string(ch->desc, acc_get_string());
 }
 
+static void
+show_dupes(struct creature *ch)
+{
+    GList *dupes = duplicate_objects();
+    int i = 0;
+
+    if (!dupes) {
+        send_to_char(ch, "No duplicated objects are loaded.\r\n");
+        return;
+    }
+
+    acc_string_clear();
+    acc_strcat("Objects sharing a unique id:\r\n", NULL);
+    acc_strcat
+        (" ---- -Id------- -Vnum-- -Name------------------------- -Location-\r\n",
+        NULL);
+    for (GList *it = dupes; it; it = it->next) {
+        for (GList *oi = it->data; oi; oi = oi->next) {
+            struct obj_data *obj = oi->data;
+            struct obj_data *top = obj;
+            struct room_data *room = where_obj(obj);
+            const char *holder = "";
+
+            while (top->in_obj)
+                top = top->in_obj;
+            if (top->carried_by)
+                holder = tmp_sprintf(" (carried by %s)",
+                                     GET_NAME(top->carried_by));
+            else if (top->worn_by)
+                holder = tmp_sprintf(" (worn by %s)",
+                                     GET_NAME(top->worn_by));
+
+            acc_sprintf(" %3d. %9ld [%5d]  %-29s [%5d]%s\r\n",
+                        ++i, obj->unique_id, GET_OBJ_VNUM(obj),
+                        obj->name,
+                        (room) ? room->number : -1, holder);
+        }
+    }
+    g_list_free(dupes);
+
+    page_string(ch->desc, acc_get_string());
+}
+
 const char *show_room_flags[] = {
     "rflags",
     "searches",
@@ -4972,16 +5038,55 @@ acc_print_zone(struct creature *ch, struct zone_data *zone)
         CCNRM(ch, C_NRM));
 }
 
+// The state of a zone listing being paged
+struct zone_listing {
+    GArray *zones;
+    guint pos;
+};
+
+static void
+free_zone_listing(void *data)
+{
+    struct zone_listing *listing = data;
+
+    g_array_free(listing->zones, true);
+    free(listing);
+}
+
+// Lists the next few matching zones.  Zones are looked up again by
+// number, since they may have been deleted between pages.
+static bool
+next_zone_entries(struct descriptor_data *d, void *data)
+{
+    struct zone_listing *listing = data;
+    int shown = 0;
+
+    if (!d->creature)
+        return false;
+
+    while (listing->pos < listing->zones->len && shown < 20) {
+        struct zone_data *zone =
+            real_zone(g_array_index(listing->zones, int, listing->pos++));
+
+        if (zone) {
+            acc_print_zone(d->creature, zone);
+            shown++;
+        }
+    }
+
+    return listing->pos < listing->zones->len;
+}
+
 void
 show_zones(struct creature *ch, char *arg, char *value)
 {
     struct zone_data *zone;
-
-    acc_string_clear();
+    struct zone_listing *listing;
+    GArray *zones = g_array_new(false, false, sizeof(int));
 
     skip_spaces(&arg);
     if (!*value) {
-        acc_print_zone(ch, ch->in_room->zone);
+        g_array_append_val(zones, ch->in_room->zone->number);
     } else if (is_number(value)) {  // show a range ( from a to b )
         int a = atoi(value);
         int b = a;
@@ -4992,10 +5097,11 @@ show_zones(struct creature *ch, char *arg, char *value)
 
         for (zone = zone_table; zone; zone = zone->next)
             if (zone->number >= a && zone->number <= b)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
 
-        if (acc_get_string()[0] == '\0') {
+        if (zones->len == 0) {
             send_to_char(ch, "That is not a valid zone.\r\n");
+            g_array_free(zones, true);
             return;
         }
     } else if (strcasecmp("owner", value) == 0 && *arg) {
@@ -5008,6 +5114,7 @@ show_zones(struct creature *ch, char *arg, char *value)
             owner_id = player_idnum_by_name(value);
             if (!owner_id) {
                 send_to_char(ch, "That player does not exist.\r\n");
+                g_array_free(zones, true);
                 return;
             }
         }
@@ -5015,7 +5122,7 @@ show_zones(struct creature *ch, char *arg, char *value)
         for (zone = zone_table; zone; zone = zone->next)
             if (owner_id == zone->owner_idnum
                 || owner_id == zone->co_owner_idnum)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp("co-owner", value) == 0 && *arg) {    // Show by name
         int owner_id;
 
@@ -5026,64 +5133,64 @@ show_zones(struct creature *ch, char *arg, char *value)
             owner_id = player_idnum_by_name(value);
             if (!owner_id) {
                 send_to_char(ch, "That player does not exist.\r\n");
+                g_array_free(zones, true);
                 return;
             }
         }
 
         for (zone = zone_table; zone; zone = zone->next)
             if (owner_id == zone->co_owner_idnum)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "all") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
-            acc_print_zone(ch, zone);
+            g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "fullcontrol") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (ZONE_FLAGGED(zone, ZONE_FULLCONTROL))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "lawless") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (ZONE_FLAGGED(zone, ZONE_NOLAW))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "past") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (zone->time_frame == TIME_PAST)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "future") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (zone->time_frame == TIME_FUTURE)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "timeless") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (zone->time_frame == TIME_TIMELESS)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "norecalc") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (ZONE_FLAGGED(zone, ZONE_NORECALC))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "noauthor") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (!zone->author || !*zone->author)
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "inplay") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (ZONE_FLAGGED(zone, ZONE_INPLAY))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else if (strcasecmp(value, "!inplay") == 0) {
         for (zone = zone_table; zone; zone = zone->next)
             if (!ZONE_FLAGGED(zone, ZONE_INPLAY))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     } else {                    // Show by name
         for (zone = zone_table; zone; zone = zone->next)
             if (strcasestr(zone->name, value))
-                acc_print_zone(ch, zone);
+                g_array_append_val(zones, zone->number);
     }
 
-    if (acc_get_string()[0] == '\0') {
+    CREATE(listing, struct zone_listing, 1);
+    listing->zones = zones;
+    if (!page_generator(ch->desc, next_zone_entries, listing,
+                        free_zone_listing))
         send_to_char(ch, "No zones match that criteria.\r\n");
-        return;
-    }
-
-    page_string(ch->desc, acc_get_string());
 }
 
 #define SFC_OBJ 1
@@ -5136,6 +5243,8 @@ struct show_struct fields[] = {
     {"wizcommands", LVL_IMMORT, ""},
     {"timewarps", LVL_IMMORT, ""},  // 43
     {"voices", LVL_IMMORT, ""},
+    {"mobai", LVL_IMMORT, "Coder"}, // 45
+    {"dupes", LVL_IMMORT, "WizardBasic"},
     {"\n", 0, ""}
 };
 
@@ -5833,6 +5942,12 @@ ACMD(do_show)
     case 44:                   // voices
         show_voices(ch);
         break;
+    case 45:                   // mobai
+        show_mob_ai(ch);
+        break;
+    case 46:                   // dupes
+        show_dupes(ch);
+        break;
     default:
         send_to_char(ch, "Sorry, I don't understand that.\r\n");
         break;
@@ -6198,6 +6313,7 @@ ACMD(do_set)
         GET_INVIS_LVL(vict) = RANGE(0, GET_LEVEL(vict));
         if (GET_INVIS_LVL(vict) > LVL_LUCIFER)
             GET_INVIS_LVL(vict) = LVL_LUCIFER;
+        invalidate_sight();
         break;
     case 24:
         if (GET_LEVEL(ch) < GET_LEVEL(vict)) {
@@ -6429,6 +6545,7 @@ ACMD(do_set)
         break;
     case 56:
         GET_INVIS_LVL(vict) = RANGE(0, GET_LEVEL(vict));
+        invalidate_sight();
         break;
     case 57:
         SET_OR_REMOVE(PLR_FLAGS(vict), PLR_HALT);
@@ -6964,61 +7081,83 @@ ACMD(do_xlist)
     page_string(ch->desc, acc_get_string());
 }
 
-ACMD(do_mlist)
+// The state of a vnum range listing being paged
+struct vnum_listing {
+    int vnum;
+    int last;
+    int found;
+};
+
+// Lists the next few mobile prototypes in the range
+static bool
+next_mlist_entries(struct descriptor_data *d, void *data)
 {
-    int first, last, found = 0;
-    two_arguments(argument, buf, buf2);
+    struct vnum_listing *listing = data;
+    struct creature *ch = d->creature;
+    int shown = 0;
 
-    if (!*buf) {
-        first = ch->in_room->zone->number * 100;
-        last = ch->in_room->zone->top;
-    } else if (!*buf2) {
-        send_to_char(ch, "Usage: mlist <begining number> <ending number>\r\n");
-        return;
-    } else {
-        first = atoi(buf);
-        last = atoi(buf2);
-    }
+    if (!ch)
+        return false;
 
-    if ((first < 0) || (first > 99999) || (last < 0) || (last > 99999)) {
-        send_to_char(ch, "Values must be between 0 and 99999.\r\n");
-        return;
+    while (listing->vnum <= listing->last && shown < 20) {
+        struct creature *mob = g_hash_table_lookup(mob_prototypes,
+                                                   GINT_TO_POINTER(listing->vnum++));
+        if (!mob)
+            continue;
+        acc_sprintf("%5d. %s[%s%5d%s]%s %-40s%s  [%2d] <%3d> %s%s\r\n",
+                    ++listing->found,
+                    CCGRN(ch, C_NRM),
+                    CCNRM(ch, C_NRM),
+                    mob->mob_specials.shared->vnum,
+                    CCGRN(ch, C_NRM),
+                    CCYEL(ch, C_NRM),
+                    mob->player.short_descr,
+                    CCNRM(ch, C_NRM),
+                    mob->player.level,
+                    NPC_SHARED(mob)->number,
+                    NPC2_FLAGGED((mob), NPC2_UNAPPROVED) ? "(!ap)" : "",
+                    GET_NPC_PROG(mob) ? "(prog)" : "");
+        shown++;
     }
 
-    if (first >= last) {
-        send_to_char(ch, "Second value must be greater than first.\r\n");
-        return;
-    }
+    return listing->vnum <= listing->last;
+}
 
-    acc_string_clear();
+// Lists the next few object prototypes in the range
+static bool
+next_olist_entries(struct descriptor_data *d, void *data)
+{
+    struct vnum_listing *listing = data;
+    struct creature *ch = d->creature;
+    int shown = 0;
 
-    for (int vnum = first;vnum <= last;vnum++) {
-        struct creature *mob = g_hash_table_lookup(mob_prototypes, GINT_TO_POINTER(vnum));
-        if (mob)
-            acc_sprintf("%5d. %s[%s%5d%s]%s %-40s%s  [%2d] <%3d> %s%s\r\n",
-                        ++found,
-                        CCGRN(ch, C_NRM),
-                        CCNRM(ch, C_NRM),
-                        mob->mob_specials.shared->vnum,
-                        CCGRN(ch, C_NRM),
-                        CCYEL(ch, C_NRM),
-                        mob->player.short_descr,
-                        CCNRM(ch, C_NRM),
-                        mob->player.level,
-                        NPC_SHARED(mob)->number,
-                        NPC2_FLAGGED((mob), NPC2_UNAPPROVED) ? "(!ap)" : "",
-                        GET_NPC_PROG(mob) ? "(prog)" : "");
+    if (!ch)
+        return false;
+
+    while (listing->vnum <= listing->last && shown < 20) {
+        struct obj_data *obj = g_hash_table_lookup(obj_prototypes,
+                                                   GINT_TO_POINTER(listing->vnum++));
+        if (!obj)
+            continue;
+        acc_sprintf("%5d. %s[%s%5d%s]%s %-36s%s %s %s\r\n", ++listing->found,
+                    CCGRN(ch, C_NRM), CCNRM(ch, C_NRM), obj->shared->vnum,
+                    CCGRN(ch, C_NRM), CCGRN(ch, C_NRM),
+                    obj->name, CCNRM(ch, C_NRM),
+                    !P_OBJ_APPROVED(obj) ? "(!aprvd)" : "",
+                    (!(obj->line_desc) || !(*(obj->line_desc))) ? "(nodesc)" : "");
+        shown++;
     }
 
-    if (!found)
-        send_to_char(ch, "No mobiles were found in those parameters.\r\n");
-    else
-        page_string(ch->desc, acc_get_string());
+    return listing->vnum <= listing->last;
 }
 
-ACMD(do_olist)
+// Parses the vnum range given to mlist or olist, returning NULL if
+// it isn't valid
+static struct vnum_listing *
+make_vnum_listing(struct creature *ch, char *argument, const char *cmd)
 {
-    int first, last, found = 0;
+    struct vnum_listing *listing;
+    int first, last;
 
     two_arguments(argument, buf, buf2);
 
@@ -7026,8 +7165,9 @@ ACMD(do_olist)
         first = ch->in_room->zone->number * 100;
         last = ch->in_room->zone->top;
     } else if (!*buf2) {
-        send_to_char(ch, "Usage: olist <begining number> <ending number>\r\n");
-        return;
+        send_to_char(ch, "Usage: %s <begining number> <ending number>\r\n",
+                     cmd);
+        return NULL;
     } else {
         first = atoi(buf);
         last = atoi(buf2);
@@ -7035,32 +7175,36 @@ ACMD(do_olist)
 
     if ((first < 0) || (first > 99999) || (last < 0) || (last > 99999)) {
         send_to_char(ch, "Values must be between 0 and 99999.\r\n");
-        return;
+        return NULL;
     }
 
     if (first >= last) {
         send_to_char(ch, "Second value must be greater than first.\r\n");
-        return;
+        return NULL;
     }
 
-    acc_string_clear();
+    CREATE(listing, struct vnum_listing, 1);
+    listing->vnum = first;
+    listing->last = last;
+    return listing;
+}
 
+ACMD(do_mlist)
+{
+    struct vnum_listing *listing = make_vnum_listing(ch, argument, "mlist");
 
-    for (int vnum = first;vnum <= last;vnum++) {
-        struct obj_data *obj = g_hash_table_lookup(obj_prototypes, GINT_TO_POINTER(vnum));
-        if (obj)
-            acc_sprintf("%5d. %s[%s%5d%s]%s %-36s%s %s %s\r\n", ++found,
-                        CCGRN(ch, C_NRM), CCNRM(ch, C_NRM), obj->shared->vnum,
-                        CCGRN(ch, C_NRM), CCGRN(ch, C_NRM),
-                        obj->name, CCNRM(ch, C_NRM),
-                        !P_OBJ_APPROVED(obj) ? "(!aprvd)" : "",
-                        (!(obj->line_desc) || !(*(obj->line_desc))) ? "(nodesc)" : "");
-    }
+    if (listing
+        && !page_generator(ch->desc, next_mlist_entries, listing, free))
+        send_to_char(ch, "No mobiles were found in those parameters.\r\n");
+}
 
-    if (!found)
+ACMD(do_olist)
+{
+    struct vnum_listing *listing = make_vnum_listing(ch, argument, "olist");
+
+    if (listing
+        && !page_generator(ch->desc, next_olist_entries, listing, free))
         send_to_char(ch, "No objects were found in those parameters.\r\n");
-    else
-        page_string(ch->desc, acc_get_string());
 }
 
 ACMD(do_rename)
@@ -7664,6 +7808,135 @@ load_single_zone(int zone_num)
     }
 }
 
+ACMD(do_memory)
+{
+    struct mem_counts counts;
+    struct mem_pulse pulse;
+    char *arg = tmp_getword(&argument);
+
+    if (!strcmp(arg, "track")) {
+        arg = tmp_getword(&argument);
+        if (!strcmp(arg, "on"))
+            memstat_set_tracking(true);
+        else if (!strcmp(arg, "off"))
+            memstat_set_tracking(false);
+        else if (*arg) {
+            send_to_char(ch, "Usage: memory track [on|off]\r\n");
+            return;
+        }
+        send_to_char(ch, "Block tracking is %s.\r\n",
+                     memstat_tracking() ? "on" : "off");
+        return;
+    } else if (!strcmp(arg, "dump")) {
+        int blocks;
+
+        if (!memstat_tracking()) {
+            send_to_char(ch, "Block tracking is off.  "
+                         "Use 'memory track on' first.\r\n");
+            return;
+        }
+        blocks = memstat_dump(MEMSTAT_FILE);
+        if (blocks < 0)
+            send_to_char(ch, "Couldn't write %s.\r\n", MEMSTAT_FILE);
+        else
+            send_to_char(ch, "%d blocks written to %s.\r\n", blocks,
+                         MEMSTAT_FILE);
+        return;
+    } else if (*arg) {
+        send_to_char(ch, "Usage: memory [dump|track [on|off]]\r\n");
+        return;
+    }
+
+    memstat_sample_glists();
+    acc_string_clear();
+    acc_strcat("Kind       Blocks      Bytes  Allocs  Frees  Growth  Most growth\r\n"
+               "--------- ------- ---------- ------- ------ ------- ------------\r\n",
+               NULL);
+    for (int kind = 0; kind < NUM_MEM_KINDS; kind++) {
+        memstat_counts(kind, &counts, &pulse);
+        acc_sprintf("%-9s %7zu %10zu %7zu %6zu %+7ld %+12ld\r\n",
+                    mem_kind_names[kind], counts.blocks, counts.bytes,
+                    pulse.allocs, pulse.frees, pulse.bytes,
+                    pulse.most_growth);
+    }
+    acc_strcat("Allocs, frees, and growth are for the last pulse.\r\n", NULL);
+    page_string(ch->desc, acc_get_string());
+}
+
+ACMD(do_pulse)
+{
+    show_pulse_stats(ch, argument);
+}
+
+static int
+cmdstat_compare(const void *a, const void *b)
+{
+    const struct command_info *ca = &cmd_info[*(const int *)a];
+    const struct command_info *cb = &cmd_info[*(const int *)b];
+
+    if (ca->total_usec != cb->total_usec)
+        return (ca->total_usec < cb->total_usec) ? 1 : -1;
+    return strcmp(ca->command, cb->command);
+}
+
+ACMD(do_cmdstat)
+{
+    char *arg = tmp_getword(&argument);
+    int *order, count = 0;
+
+    if (!strcmp(arg, "reset")) {
+        for (int cmd_num = 0; cmd_num < num_of_cmds; cmd_num++) {
+            cmd_info[cmd_num].timed = 0;
+            cmd_info[cmd_num].total_usec = 0;
+            cmd_info[cmd_num].max_usec = 0;
+        }
+        send_to_char(ch, "Command timings cleared.\r\n");
+        return;
+    } else if (!strcmp(arg, "slow")) {
+        arg = tmp_getword(&argument);
+        if (!strcmp(arg, "off")) {
+            cmd_slow_usec = 0;
+            send_to_char(ch, "Slow commands will no longer be logged.\r\n");
+        } else if (is_number(arg) && atoi(arg) > 0) {
+            cmd_slow_usec = atoi(arg) * 1000UL;
+            send_to_char(ch, "Commands taking over %sms will be logged.\r\n",
+                         arg);
+        } else {
+            send_to_char(ch, "Usage: cmdstat slow <milliseconds>|off\r\n");
+        }
+        return;
+    } else if (*arg) {
+        send_to_char(ch, "Usage: cmdstat [reset|slow <milliseconds>|off]\r\n");
+        return;
+    }
+
+    CREATE(order, int, num_of_cmds);
+    for (int cmd_num = 0; cmd_num < num_of_cmds; cmd_num++)
+        if (cmd_info[cmd_num].timed)
+            order[count++] = cmd_num;
+    qsort(order, count, sizeof(int), cmdstat_compare);
+
+    acc_string_clear();
+    if (cmd_slow_usec)
+        acc_sprintf("Commands over %lums are logged.\r\n",
+                    cmd_slow_usec / 1000);
+    else
+        acc_strcat("Slow commands are not logged.\r\n", NULL);
+    acc_strcat("Command            Count   Total ms   Avg ms   Max ms\r\n"
+               "--------------- -------- ---------- -------- --------\r\n",
+               NULL);
+    for (int idx = 0; idx < count; idx++) {
+        struct command_info *info = &cmd_info[order[idx]];
+
+        acc_sprintf("%-15s %8lu %10.1f %8.2f %8.1f\r\n",
+                    info->command, info->timed, info->total_usec / 1000.0,
+                    info->total_usec / 1000.0 / info->timed,
+                    info->max_usec / 1000.0);
+    }
+    free(order);
+    page_string(ch->desc, acc_get_string());
+}
+
 ACMD(do_coderutil)
 {
     int idx, cmd_num;
@@ -7788,11 +8061,15 @@ ACMD(do_coderutil)
                 int cmd = *((short *)(exec + prog->exec_pt));
                 int arg_addr =
                     *((short *)(exec + prog->exec_pt + sizeof(short)));
+                const char *arg = (cmd & PROG_CMD_TEMPLATE) ?
+                    prog_template_text(exec + arg_addr) :
+                    (char *)exec + arg_addr;
+                cmd &= PROG_CMD_MASK;
                 acc_sprintf("0x%lx %-8s  %-15s %4d %s %s\r\n",
                     (unsigned long)prog,
                     prog_event_kind_desc[(int)prog->evt.kind],
                     (prog->target) ? GET_NAME(prog->target) : "<none>",
-                    prog->next_tick - prog_tick, prog_cmds[cmd].str, (char *)exec + arg_addr);
+                    prog->next_tick - prog_tick, prog_cmds[cmd].str, arg);
             }
         }
 
@@ -7823,12 +8100,16 @@ ACMD(do_coderutil)
             int cmd = *((short *)(exec + prog->exec_pt));
             int arg_addr =
                 *((short *)(exec + prog->exec_pt + sizeof(short)));
+            const char *arg = (cmd & PROG_CMD_TEMPLATE) ?
+                prog_template_text(exec + arg_addr) :
+                (char *)exec + arg_addr;
+            cmd &= PROG_CMD_MASK;
             fprintf(ouf, "%12s 0x%lx %-8s  %-15s %4d %s %s\r\n",
                     prog_get_desc(prog),
                     (unsigned long)prog,
                     prog_event_kind_desc[(int)prog->evt.kind],
                     (prog->target) ? GET_NAME(prog->target) : "<none>",
-                    prog->next_tick - prog_tick, prog_cmds[cmd].str, (char *)exec + arg_addr);
+                    prog->next_tick - prog_tick, prog_cmds[cmd].str, arg);
         }
         fclose(ouf);
         send_to_char(ch, "Dumped.\r\n");
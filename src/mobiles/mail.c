@@ -25,6 +25,7 @@ Rewritten by John Rothe (forget@tempusmud.com)
 #include <stdbool.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <libpq-fe.h>
@@ -64,31 +65,312 @@ void call_for_help(struct creature *ch, struct creature *attacker);
 // The vnum of the "letter" object
 const int MAIL_OBJ_VNUM = 1204;
 
-GList *load_mail(char *path);
+// Mail files start with this line, followed by one record for each
+// letter or package.  A record is a line holding its kind, L for a
+// letter or P for a package, and its length, followed by that many
+// bytes of object XML.  Older mail files held a single XML document
+// of objects, and are converted when they are first read.
+#define MAIL_FILE_MAGIC "TMAIL 1\n"
 
+static GHashTable *mailboxes = NULL;    // idnum -> struct mailbox
+
+static bool load_mail_xml(const char *path, GList **objs);
+
+// Appends obj to the mail file being built in ouf
+static void
+write_mail_record(FILE *ouf, char kind, struct obj_data *obj)
+{
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *rec = open_memstream(&buf, &len);
+
+    save_object_to_xml(obj, rec);
+    fclose(rec);
+    fprintf(ouf, "%c %zu\n", kind, len);
+    fwrite(buf, 1, len, ouf);
+    free(buf);
+}
+
+static bool
+read_mail_record_header(FILE *inf, char *kind, size_t *len)
+{
+    char line[64];
+
+    if (!fgets(line, sizeof(line), inf))
+        return false;
+    return sscanf(line, "%c %zu", kind, len) == 2
+        && (*kind == 'L' || *kind == 'P');
+}
+
+// Rewrites a mail file in the old format as mail file records.  A file
+// that can't be read is left as it is.
+static bool
+migrate_mail_file(const char *path)
+{
+    GList *objs = NULL;
+    char *new_path = tmp_strcat(path, ".new", NULL);
+    FILE *ouf;
+
+    if (!load_mail_xml(path, &objs)) {
+        errlog("Unable to convert mail file '%s'", path);
+        return false;
+    }
+
+    ouf = fopen(new_path, "w");
+    if (!ouf) {
+        errlog("Unable to open mail file '%s': %s", new_path,
+               strerror(errno));
+        g_list_foreach(objs, (GFunc) extract_obj, NULL);
+        g_list_free(objs);
+        return false;
+    }
+
+    fputs(MAIL_FILE_MAGIC, ouf);
+    for (GList *oi = objs; oi; oi = oi->next) {
+        struct obj_data *obj = oi->data;
+
+        write_mail_record(ouf, (GET_OBJ_VNUM(obj) == MAIL_OBJ_VNUM) ? 'L' : 'P',
+                          obj);
+        extract_obj(obj);
+    }
+    g_list_free(objs);
+
+    if (fclose(ouf) != 0 || rename(new_path, path) < 0) {
+        errlog("Unable to convert mail file '%s': %s", path, strerror(errno));
+        unlink(new_path);
+        return false;
+    }
+
+    return true;
+}
+
+// Opens a mail file for reading, converting it from the old format if
+// needed.  The file is left positioned at the first record.
+static FILE *
+open_mail_file(const char *path)
+{
+    char magic[sizeof(MAIL_FILE_MAGIC)];
+    FILE *inf = fopen(path, "r");
+
+    if (!inf)
+        return NULL;
+    if (fgets(magic, sizeof(magic), inf) && !strcmp(magic, MAIL_FILE_MAGIC))
+        return inf;
+
+    fclose(inf);
+    if (!migrate_mail_file(path))
+        return NULL;
+    inf = fopen(path, "r");
+    if (inf && !fgets(magic, sizeof(magic), inf)) {
+        fclose(inf);
+        return NULL;
+    }
+    return inf;
+}
+
+/* Counts the letters and packages in a mail file without loading
+ * them.  A record left incomplete by a crash is cut off the end of
+ * the file.  Returns false if the file couldn't be read. */
 bool
-has_mail(long id)
+mail_file_scan(const char *path, struct mailbox *box)
+{
+    struct stat stat_buf;
+    FILE *inf;
+    char kind;
+    size_t len;
+    long good;
+
+    memset(box, 0, sizeof(*box));
+
+    // An empty file is given its first line by the next letter
+    if (stat(path, &stat_buf) < 0)
+        return errno == ENOENT;
+    if (stat_buf.st_size == 0)
+        return true;
+
+    inf = open_mail_file(path);
+    if (!inf) {
+        errlog("Unable to open mail file '%s': %s", path, strerror(errno));
+        return false;
+    }
+    if (fstat(fileno(inf), &stat_buf) < 0) {
+        fclose(inf);
+        return false;
+    }
+
+    good = ftell(inf);
+    while (read_mail_record_header(inf, &kind, &len)) {
+        if (ftell(inf) + (off_t)len > stat_buf.st_size
+            || fseek(inf, len, SEEK_CUR) < 0)
+            break;
+        if (kind == 'L')
+            box->letters++;
+        else
+            box->packages++;
+        good = ftell(inf);
+    }
+    fclose(inf);
+
+    if (good != stat_buf.st_size) {
+        errlog("Cutting %ld damaged bytes from the end of mail file '%s'",
+               (long)stat_buf.st_size - good, path);
+        if (truncate(path, good) < 0)
+            errlog("Unable to truncate mail file '%s': %s", path,
+                   strerror(errno));
+    }
+    box->size = good;
+
+    return true;
+}
+
+/* Appends a letter and any packages sent with it to a mail file,
+ * syncing it to disk.  Returns the number of bytes written, or -1 on
+ * failure. */
+long
+mail_file_append(const char *path, struct obj_data *letter,
+                 struct obj_data *obj_list)
+{
+    struct stat stat_buf;
+    char *buf = NULL;
+    size_t len = 0, written = 0;
+    FILE *ouf;
+    int fd;
+
+    fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &stat_buf) < 0) {
+        errlog("Unable to open mail file '%s': %s", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    // The whole letter goes out in a single write
+    ouf = open_memstream(&buf, &len);
+    if (stat_buf.st_size == 0)
+        fputs(MAIL_FILE_MAGIC, ouf);
+    if (letter)
+        write_mail_record(ouf, 'L', letter);
+    for (struct obj_data *obj = obj_list; obj; obj = obj->next_content)
+        write_mail_record(ouf, 'P', obj);
+    fclose(ouf);
+
+    while (written < len) {
+        ssize_t result = write(fd, buf + written, len - written);
+
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        written += result;
+    }
+    if (written < len || fsync(fd) < 0) {
+        errlog("Unable to write mail file '%s': %s", path, strerror(errno));
+        written = 0;
+    }
+    close(fd);
+    free(buf);
+
+    return (written) ? (long)written : -1;
+}
+
+/* Loads the objects in a mail file one at a time, passing each to
+ * func.  Returns the number of objects read. */
+int
+mail_file_read(const char *path, mail_reader func, void *data)
 {
-    if (!player_idnum_exists(id))
+    FILE *inf = open_mail_file(path);
+    char kind;
+    size_t len;
+    int count = 0;
+
+    if (!inf) {
+        if (errno != ENOENT)
+            errlog("Unable to open mail file '%s': %s", path,
+                   strerror(errno));
         return 0;
-    return access(get_mail_file_path(id), F_OK) == 0;
+    }
+
+    while (read_mail_record_header(inf, &kind, &len)) {
+        char *buf = malloc(len);
+        struct obj_data *obj = NULL;
+        xmlDocPtr doc;
+
+        if (!buf || fread(buf, 1, len, inf) != len) {
+            errlog("Mail file '%s' ends in the middle of a record", path);
+            free(buf);
+            break;
+        }
+        doc = xmlReadMemory(buf, len, path, NULL, 0);
+        free(buf);
+        if (!doc) {
+            errlog("XML parse error while loading %s", path);
+            continue;
+        }
+        if (xmlDocGetRootElement(doc))
+            obj = load_object_from_xml(NULL, NULL, NULL,
+                                       xmlDocGetRootElement(doc));
+        xmlFreeDoc(doc);
+        if (obj) {
+            func(obj, data);
+            count++;
+        }
+    }
+    fclose(inf);
+
+    return count;
+}
+
+// Returns the mailbox of the player, counting their mail file the
+// first time it is needed.
+static struct mailbox *
+find_mailbox(long id)
+{
+    struct mailbox *box;
+
+    if (!mailboxes)
+        mailboxes = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                          NULL, free);
+
+    box = g_hash_table_lookup(mailboxes, GINT_TO_POINTER(id));
+    if (box)
+        return box;
+
+    CREATE(box, struct mailbox, 1);
+    if (!mail_file_scan(get_mail_file_path(id), box)) {
+        free(box);
+        return NULL;
+    }
+    g_hash_table_insert(mailboxes, GINT_TO_POINTER(id), box);
+
+    return box;
+}
+
+static void
+forget_mailbox(long id)
+{
+    if (mailboxes)
+        g_hash_table_remove(mailboxes, GINT_TO_POINTER(id));
+}
+
+bool
+has_mail(long id)
+{
+    struct mailbox *box = find_mailbox(id);
+
+    return box && (box->letters || box->packages);
 }
 
 bool
 can_receive_mail(long id)
 {
-    struct stat stat_buf;
+    struct mailbox *box = find_mailbox(id);
 
-    // Return false if player doesn't exist
-    if (!player_idnum_exists(id))
+    if (!box)
         return false;
 
-    // Return true if file not found, false on any other error
-    if (stat(get_mail_file_path(id), &stat_buf) < 0)
-        return errno == ENOENT;
-
     // Purge mail if file size has gotten too large
-    if (stat_buf.st_size > MAX_MAILFILE_SIZE)
+    if (box->size > MAX_MAILFILE_SIZE)
         purge_mail(id);
 
     return true;
@@ -126,12 +408,11 @@ static bool
 store_mail(const char *from_name, long to_id, const char *txt, GList *cc_list,
            struct obj_data *obj_list, char **error)
 {
-    char *mail_file_path;
-    FILE *ofile;
+    struct mailbox *box;
     char *time_str, *obj_string = NULL;
-    struct obj_data *obj, *temp_o;
+    struct obj_data *obj, *temp_o, *next_o;
     time_t now = time(NULL);
-    GList *mailBag = NULL;
+    long written;
 
     // NO zero length mail!
     // This should never happen.
@@ -140,24 +421,17 @@ store_mail(const char *from_name, long to_id, const char *txt, GList *cc_list,
         return false;
     }
     // Recipient is frozen, buried, or deleted
-    if (!can_receive_mail(to_id)) {
+    if (!player_idnum_exists(to_id) || !can_receive_mail(to_id)) {
         *error = tmp_sprintf("%s doesn't seem to be able to receive mail.",
                              player_name_by_idnum(to_id));
         return false;
     }
-
-    if (!player_idnum_exists(to_id)) {
+    box = find_mailbox(to_id);
+    if (!box) {
         *error = "Sorry, you hit a bug in the mailing system.";
-        errlog("Toss_Mail Error, recipient idnum %ld invalid.", to_id);
         return false;
     }
 
-    mail_file_path = get_mail_file_path(to_id);
-
-    // If we already have a mail file then we have to read in the mail and write it all back out.
-    if (access(mail_file_path, F_OK) == 0)
-        mailBag = load_mail(mail_file_path);
-
     obj = read_object(MAIL_OBJ_VNUM);
     time_str = asctime(localtime(&now));
     time_str[strlen(time_str) - 1] = '\0';
@@ -188,31 +462,20 @@ store_mail(const char *from_name, long to_id, const char *txt, GList *cc_list,
     obj->action_desc = strdup(acc_get_string());
 
     obj->plrtext_len = strlen(obj->action_desc) + 1;
-    mailBag = g_list_append(mailBag, obj);
 
-    if ((ofile = fopen(mail_file_path, "w")) == NULL) {
-        errlog("Unable to open xml mail file '%s': %s",
-            mail_file_path, strerror(errno));
+    written = mail_file_append(get_mail_file_path(to_id), obj, obj_list);
+    extract_obj(obj);
+    if (written < 0) {
+        *error = "Sorry, you hit a bug in the mailing system.";
         return false;
-    } else {
-        GList *oi;
+    }
 
-        fprintf(ofile, "<objects>");
-        for (oi = mailBag; oi; oi = oi->next) {
-            obj = (struct obj_data *)oi->data;
-            save_object_to_xml(obj, ofile);
-            extract_obj(obj);
-        }
-        if (obj_list) {
-            temp_o = obj_list;
-            while (temp_o) {
-                save_object_to_xml(temp_o, ofile);
-                extract_obj(temp_o);
-                temp_o = temp_o->next_content;
-            }
-        }
-        fprintf(ofile, "</objects>");
-        fclose(ofile);
+    box->letters++;
+    box->size += written;
+    for (temp_o = obj_list; temp_o; temp_o = next_o) {
+        next_o = temp_o->next_content;
+        box->packages++;
+        extract_obj(temp_o);
     }
 
     return true;
@@ -260,83 +523,99 @@ send_mail(struct creature *from,
 bool
 purge_mail(long idnum)
 {
+    forget_mailbox(idnum);
     return unlink(get_mail_file_path(idnum)) == 0;
 }
 
+struct mail_delivery {
+    struct creature *ch;
+    struct obj_data *bag;       // Bag being filled, if the mail is bagged
+    int bagged;                 // Objects in the bag being filled
+    int letters;
+    GList *packages;
+};
+
+static void
+deliver_mail(struct obj_data *obj, void *data)
+{
+    struct mail_delivery *delivery = data;
+
+    if (GET_OBJ_VNUM(obj) == MAIL_OBJ_VNUM)
+        delivery->letters++;
+    else
+        delivery->packages = g_list_prepend(delivery->packages, obj);
+
+    if (delivery->bag && delivery->bagged >= MAIL_BAG_OBJ_CONTAINS) {
+        obj_to_char(delivery->bag, delivery->ch);
+        delivery->bag = read_object(MAIL_BAG_OBJ_VNUM);
+        delivery->bagged = 0;
+    }
+    if (delivery->bag) {
+        obj_to_obj(obj, delivery->bag);
+        delivery->bagged++;
+    } else {
+        obj_to_char(obj, delivery->ch);
+    }
+}
+
 // Pull the mail out of the players mail file if he has one.
 // Create the "letters" from the file, and plant them on him without
 //     telling him.  We'll let the spec say what it wants.
-// Returns the number of mails received.
+// Returns the packages received, and sets the number of letters.
 GList *
 receive_mail(struct creature *ch, int *num_letters)
 {
-    int counter = 0;
     char *path = get_mail_file_path(GET_IDNUM(ch));
-    struct obj_data *container = NULL;
-    GList *olist = NULL;
-
-
-    GList *mailBag = load_mail(path);
-
-    if (g_list_length(mailBag) > MAIL_BAG_THRESH)
-        container = read_object(MAIL_BAG_OBJ_VNUM);
+    struct mailbox *box = find_mailbox(GET_IDNUM(ch));
+    struct mail_delivery delivery = { ch, NULL, 0, 0, NULL };
 
     *num_letters = 0;
-    for (GList *oi = mailBag; oi; oi = oi->next) {
-        struct obj_data *obj = oi->data;
-        counter++;
+    if (!box)
+        return NULL;
 
-        if (GET_OBJ_VNUM(obj) == MAIL_OBJ_VNUM)
-            (*num_letters)++;
-        else
-            olist = g_list_append(olist, obj);
+    if (box->letters + box->packages > MAIL_BAG_THRESH)
+        delivery.bag = read_object(MAIL_BAG_OBJ_VNUM);
 
-        if ((counter > MAIL_BAG_OBJ_CONTAINS) && container) {
-            obj_to_char(obj, ch);
-            obj = read_object(MAIL_BAG_OBJ_VNUM);
-            counter = 0;
-        }
-        if (container) {
-            obj_to_obj(obj, container);
-        } else {
-            obj_to_char(obj, ch);
-        }
-    }
+    mail_file_read(path, deliver_mail, &delivery);
 
-    if (container)
-        obj_to_char(container, ch);
+    if (delivery.bag)
+        obj_to_char(delivery.bag, ch);
 
     unlink(path);
+    forget_mailbox(GET_IDNUM(ch));
 
-    return olist;
+    *num_letters = delivery.letters;
+    return g_list_reverse(delivery.packages);
 }
 
-GList *
-load_mail(char *path)
+// Loads a mail file in the old format, a single XML document, into
+// objs.  Returns false if the file couldn't be read.
+static bool
+load_mail_xml(const char *path, GList **objs)
 {
     int axs = access(path, W_OK | R_OK);
-    GList *mailBag = NULL;
 
+    *objs = NULL;
     if (axs != 0) {
         if (errno != ENOENT) {
             errlog("Unable to open xml mail file '%s': %s",
                 path, strerror(errno));
-            return mailBag;
+            return false;
         } else {
-            return mailBag;     // normal no eq file
+            return true;        // normal no eq file
         }
     }
     xmlDocPtr doc = xmlParseFile(path);
     if (!doc) {
         errlog("XML parse error while loading %s", path);
-        return mailBag;
+        return false;
     }
 
     xmlNodePtr root = xmlDocGetRootElement(doc);
     if (!root) {
         xmlFreeDoc(doc);
         errlog("XML file %s is empty", path);
-        return mailBag;
+        return false;
     }
 
     for (xmlNodePtr node = root->xmlChildrenNode; node; node = node->next) {
@@ -344,14 +623,14 @@ load_mail(char *path)
             struct obj_data *obj =
                 load_object_from_xml(NULL, NULL, NULL, node);
             if (obj) {
-                mailBag = g_list_append(mailBag, obj);
+                *objs = g_list_append(*objs, obj);
             }
         }
     }
 
     xmlFreeDoc(doc);
 
-    return mailBag;
+    return true;
 }
 
 /*****************************************************************
@@ -567,6 +846,7 @@ postmaster_receive_mail(struct creature *ch, struct creature *mailman)
 
     act(to_char, false, mailman, NULL, ch, TO_VICT);
     act(to_room, false, mailman, NULL, ch, TO_NOTVICT);
+    g_list_free(olist);
 
     crashsave(ch);
 }
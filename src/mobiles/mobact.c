@@ -24,6 +24,7 @@
 #include <stdbool.h>
 #include <ctype.h>
 #include <math.h>
+#include <time.h>
 #include <libpq-fe.h>
 #include <libxml/parser.h>
 #include <glib.h>
@@ -2583,10 +2584,151 @@ single_mobile_activity(struct creature *ch)
     /* end for() */
 }
 
+// Mobile AI gets this many microseconds of each PULSE_MOBILE.  Mobs
+// with players in the room, fighting mobs, and players themselves always
+// run.  Mobs in idle zones are parked.  The rest run round-robin, those
+// that have waited longest first, until the budget is spent.
+#define MOB_AI_BUDGET 50000
+
+struct mob_ai_waiter {
+    long idnum;
+    unsigned int ai_pulse;
+};
+
+struct mob_ai_stats {
+    unsigned long pulses;
+    long usec;
+    long max_usec;
+    int forced;
+    int processed;
+    int deferred;
+    int parked;
+    unsigned int oldest_wait;
+    unsigned long total_processed;
+    unsigned long total_deferred;
+};
+
+static unsigned int mob_ai_pulse = 0;
+static struct mob_ai_stats mob_ai_stats;
+
+static gint
+mob_ai_waiter_cmp(gconstpointer a, gconstpointer b)
+{
+    const struct mob_ai_waiter *wa = a;
+    const struct mob_ai_waiter *wb = b;
+
+    if (wa->ai_pulse != wb->ai_pulse)
+        return (wa->ai_pulse < wb->ai_pulse) ? -1 : 1;
+    return 0;
+}
+
+static long
+mob_ai_usec_since(struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000L
+        + (now.tv_nsec - start->tv_nsec) / 1000L;
+}
+
+static void
+run_mobile_ai(struct creature *ch)
+{
+    if (IS_NPC(ch))
+        ch->mob_specials.ai_pulse = mob_ai_pulse;
+    single_mobile_activity(ch);
+}
+
 void
 mobile_activity(void)
 {
-    g_list_foreach(creatures, (GFunc) single_mobile_activity, NULL);
+    struct timespec start;
+    GHashTable *player_rooms;
+    GArray *waiting;
+    GList *next;
+    guint idx;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    mob_ai_pulse++;
+    mob_ai_stats.forced = mob_ai_stats.processed = 0;
+    mob_ai_stats.deferred = mob_ai_stats.parked = 0;
+    mob_ai_stats.oldest_wait = 0;
+
+    player_rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (struct descriptor_data *d = descriptor_list;d;d = d->next)
+        if (d->creature && d->creature->in_room)
+            g_hash_table_add(player_rooms, d->creature->in_room);
+
+    waiting = g_array_new(false, false, sizeof(struct mob_ai_waiter));
+    for (GList *it = creatures;it;it = next) {
+        struct creature *ch = it->data;
+
+        next = it->next;
+        if (is_dead(ch))
+            continue;
+        if (!IS_NPC(ch) || ch->desc || !ch->in_room || is_fighting(ch)
+            || g_hash_table_contains(player_rooms, ch->in_room)) {
+            mob_ai_stats.forced++;
+            run_mobile_ai(ch);
+        } else if (ch->in_room->zone->idle_time >= ZONE_IDLE_TIME) {
+            mob_ai_stats.parked++;
+        } else {
+            struct mob_ai_waiter waiter = {
+                NPC_IDNUM(ch), ch->mob_specials.ai_pulse
+            };
+            g_array_append_val(waiting, waiter);
+        }
+    }
+    g_hash_table_destroy(player_rooms);
+
+    // Mobs are looked up again by idnum, since running the ones before
+    // them may have extracted them.
+    g_array_sort(waiting, mob_ai_waiter_cmp);
+    for (idx = 0;idx < waiting->len;idx++) {
+        struct mob_ai_waiter *waiter =
+            &g_array_index(waiting, struct mob_ai_waiter, idx);
+        struct creature *ch;
+
+        if (mob_ai_usec_since(&start) >= MOB_AI_BUDGET)
+            break;
+        ch = g_hash_table_lookup(creature_map,
+            GINT_TO_POINTER(-waiter->idnum));
+        if (!ch || is_dead(ch))
+            continue;
+        mob_ai_stats.processed++;
+        run_mobile_ai(ch);
+    }
+    mob_ai_stats.deferred = waiting->len - idx;
+    if (idx < waiting->len)
+        mob_ai_stats.oldest_wait = mob_ai_pulse
+            - g_array_index(waiting, struct mob_ai_waiter, idx).ai_pulse;
+    g_array_free(waiting, true);
+
+    mob_ai_stats.usec = mob_ai_usec_since(&start);
+    mob_ai_stats.max_usec = MAX(mob_ai_stats.max_usec, mob_ai_stats.usec);
+    mob_ai_stats.pulses++;
+    mob_ai_stats.total_processed += mob_ai_stats.forced
+        + mob_ai_stats.processed;
+    mob_ai_stats.total_deferred += mob_ai_stats.deferred;
+}
+
+void
+show_mob_ai(struct creature *ch)
+{
+    send_to_char(ch, "Mobile AI scheduler (%d usec budget per pulse):\r\n",
+        MOB_AI_BUDGET);
+    send_to_char(ch, "  %8lu pulses run\r\n", mob_ai_stats.pulses);
+    send_to_char(ch, "  %8ld usec last pulse  %8ld usec max\r\n",
+        mob_ai_stats.usec, mob_ai_stats.max_usec);
+    send_to_char(ch, "  %8d always run       %8d run in turn\r\n",
+        mob_ai_stats.forced, mob_ai_stats.processed);
+    send_to_char(ch, "  %8d deferred         %8d parked in idle zones\r\n",
+        mob_ai_stats.deferred, mob_ai_stats.parked);
+    send_to_char(ch, "  %8u pulses waited by the oldest deferred mob\r\n",
+        mob_ai_stats.oldest_wait);
+    send_to_char(ch, "  %8lu processed total  %8lu deferred total\r\n",
+        mob_ai_stats.total_processed, mob_ai_stats.total_deferred);
 }
 
 bool
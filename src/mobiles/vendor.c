@@ -114,6 +114,234 @@ vendor_items_forsale(struct shop_data *shop, struct creature *self)
     return self->carrying;
 }
 
+static bool
+vendor_same_aliases(struct obj_data *obj1, struct obj_data *obj2)
+{
+    return obj1->aliases == obj2->aliases
+        || (obj1->aliases && obj2->aliases
+            && !strcmp(obj1->aliases, obj2->aliases));
+}
+
+// Returns the serial of the list the shop's stock is kept in
+static unsigned long
+vendor_stock_serial(struct shop_data *shop, struct creature *self)
+{
+    if (shop->storeroom > 0) {
+        struct room_data *room = real_room(shop->storeroom);
+
+        return (room) ? room->contents_serial : 0;
+    }
+    return self->carrying_serial;
+}
+
+static struct vendor_stock_group *
+make_vendor_stock_group(struct obj_data *obj)
+{
+    struct vendor_stock_group *group;
+
+    CREATE(group, struct vendor_stock_group, 1);
+    group->obj = obj;
+    group->last = obj;
+    group->count = 1;
+    group->same_aliases = true;
+
+    return group;
+}
+
+struct vendor_stock *
+vendor_stock(struct shop_data *shop, struct creature *self)
+{
+    struct vendor_stock *stock = &shop->stock;
+    struct obj_data *contents = vendor_items_forsale(shop, self);
+    struct obj_data *last_obj = NULL;
+    struct vendor_stock_group *group = NULL;
+    unsigned long serial = vendor_stock_serial(shop, self);
+
+    if (stock->groups && stock->contents == contents && stock->serial == serial)
+        return stock;
+
+    if (!stock->groups) {
+        stock->groups = g_ptr_array_new_with_free_func(free);
+        stock->first_of_vnum = g_hash_table_new(g_direct_hash, g_direct_equal);
+        stock->group_of = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    g_ptr_array_set_size(stock->groups, 0);
+    g_hash_table_remove_all(stock->first_of_vnum);
+    g_hash_table_remove_all(stock->group_of);
+
+    for (struct obj_data *obj = contents; obj; obj = obj->next_content) {
+        if (group && same_obj(last_obj, obj)) {
+            group->last = obj;
+            group->count++;
+            if (!vendor_same_aliases(group->obj, obj))
+                group->same_aliases = false;
+        } else {
+            group = make_vendor_stock_group(obj);
+            g_ptr_array_add(stock->groups, group);
+            g_hash_table_insert(stock->group_of, obj, group);
+            if (!g_hash_table_lookup(stock->first_of_vnum,
+                                     GINT_TO_POINTER(GET_OBJ_VNUM(obj))))
+                g_hash_table_insert(stock->first_of_vnum,
+                                    GINT_TO_POINTER(GET_OBJ_VNUM(obj)), group);
+        }
+        last_obj = obj;
+    }
+    stock->contents = contents;
+    stock->serial = serial;
+
+    return stock;
+}
+
+// Marks the stock as matching the list again, after the vendor has
+// changed its groups to match a move of its own
+static void
+vendor_stock_synced(struct shop_data *shop, struct creature *self)
+{
+    shop->stock.contents = vendor_items_forsale(shop, self);
+    shop->stock.serial = vendor_stock_serial(shop, self);
+}
+
+// Puts obj into the shop's stock, in room if the shop has a
+// storeroom, adding it to its group in place.  Anything unexpected
+// leaves the stock to be regrouped.
+void
+vendor_stock_add(struct shop_data *shop, struct creature *self,
+                 struct room_data *room, struct obj_data *obj)
+{
+    struct vendor_stock *stock = vendor_stock(shop, self);
+    struct vendor_stock_group *group = NULL;
+    struct obj_data *next;
+
+    if (room)
+        obj_to_room(obj, room);
+    else
+        obj_to_char(obj, self);
+    if ((room != NULL) != (shop->storeroom > 0))
+        return;
+
+    // Objects go in front of the first one like them, or at the head
+    next = obj->next_content;
+    if (next && same_obj(next, obj))
+        group = g_hash_table_lookup(stock->group_of, next);
+    if (group) {
+        g_hash_table_remove(stock->group_of, next);
+        if (!vendor_same_aliases(obj, next))
+            group->same_aliases = false;
+        group->obj = obj;
+        group->count++;
+    } else if (next == stock->contents) {
+        GPtrArray *groups = stock->groups;
+
+        group = make_vendor_stock_group(obj);
+        g_ptr_array_add(groups, NULL);
+        memmove(groups->pdata + 1, groups->pdata,
+                (groups->len - 1) * sizeof(gpointer));
+        groups->pdata[0] = group;
+        g_hash_table_insert(stock->first_of_vnum,
+                            GINT_TO_POINTER(GET_OBJ_VNUM(obj)), group);
+    } else {
+        return;
+    }
+    g_hash_table_insert(stock->group_of, obj, group);
+    vendor_stock_synced(shop, self);
+}
+
+// Takes obj out of the shop's stock, from room if the shop has a
+// storeroom, removing it from its group in place.  Anything
+// unexpected leaves the stock to be regrouped.
+void
+vendor_stock_remove(struct shop_data *shop, struct creature *self,
+                    struct room_data *room, struct obj_data *obj)
+{
+    struct vendor_stock *stock = vendor_stock(shop, self);
+    struct vendor_stock_group *group = g_hash_table_lookup(stock->group_of, obj);
+    struct obj_data *next = obj->next_content;
+    GPtrArray *groups = stock->groups;
+    guint idx;
+
+    if (room)
+        obj_from_room(obj);
+    else
+        obj_from_char(obj);
+    if ((room != NULL) != (shop->storeroom > 0) || !group)
+        return;
+
+    g_hash_table_remove(stock->group_of, obj);
+    if (--group->count > 0) {
+        group->obj = next;
+        g_hash_table_insert(stock->group_of, next, group);
+        if (!group->same_aliases) {
+            struct obj_data *cur = next->next_content;
+
+            group->same_aliases = true;
+            for (int i = 1; i < group->count; i++, cur = cur->next_content)
+                if (!vendor_same_aliases(next, cur))
+                    group->same_aliases = false;
+        }
+        vendor_stock_synced(shop, self);
+        return;
+    }
+
+    for (idx = 0; idx < groups->len; idx++)
+        if (g_ptr_array_index(groups, idx) == group)
+            break;
+    if (idx == groups->len)
+        return;
+    // The groups on either side would have to be joined
+    if (idx > 0 && idx + 1 < groups->len
+        && same_obj(((struct vendor_stock_group *)
+                     g_ptr_array_index(groups, idx - 1))->obj,
+                    ((struct vendor_stock_group *)
+                     g_ptr_array_index(groups, idx + 1))->obj))
+        return;
+
+    if (g_hash_table_lookup(stock->first_of_vnum,
+                            GINT_TO_POINTER(GET_OBJ_VNUM(obj))) == group) {
+        g_hash_table_remove(stock->first_of_vnum,
+                            GINT_TO_POINTER(GET_OBJ_VNUM(obj)));
+        for (guint i = idx + 1; i < groups->len; i++) {
+            struct vendor_stock_group *later = g_ptr_array_index(groups, i);
+
+            if (GET_OBJ_VNUM(later->obj) == GET_OBJ_VNUM(obj)) {
+                g_hash_table_insert(stock->first_of_vnum,
+                                    GINT_TO_POINTER(GET_OBJ_VNUM(obj)), later);
+                break;
+            }
+        }
+    }
+    g_ptr_array_remove_index(groups, idx);
+    vendor_stock_synced(shop, self);
+}
+
+void
+vendor_free_stock(struct shop_data *shop)
+{
+    struct vendor_stock *stock = &shop->stock;
+
+    if (!stock->groups)
+        return;
+    g_ptr_array_free(stock->groups, true);
+    g_hash_table_destroy(stock->first_of_vnum);
+    g_hash_table_destroy(stock->group_of);
+    memset(stock, 0, sizeof(*stock));
+}
+
+// Returns the number of objects like obj the shop has for sale, as
+// vendor_inventory() would find in the whole stock
+int
+vendor_stock_count(struct shop_data *shop, struct creature *self,
+                   struct obj_data *obj)
+{
+    struct vendor_stock *stock = vendor_stock(shop, self);
+    struct vendor_stock_group *group;
+
+    group = g_hash_table_lookup(stock->first_of_vnum,
+                                GINT_TO_POINTER(GET_OBJ_VNUM(obj)));
+    if (!group || !same_obj(group->obj, obj))
+        return 0;
+    return group->count;
+}
+
 static bool
 vendor_invalid_buy(struct creature *self, struct creature *ch,
     struct shop_data *shop, struct obj_data *obj)
@@ -165,7 +393,7 @@ vendor_invalid_buy(struct creature *self, struct creature *ch,
         return true;
     }
 
-    if (vendor_inventory(obj, vendor_items_forsale(shop, self)) >= MAX_ITEMS) {
+    if (vendor_stock_count(shop, self, obj) >= MAX_ITEMS) {
         perform_say_to(self, ch,
             "No thanks.  I've got too many of those in stock already.");
         return true;
@@ -223,7 +451,7 @@ vendor_invalid_consignment(struct creature *self, struct creature *ch,
         return true;
     }
 
-    if (vendor_inventory(obj, vendor_items_forsale(shop, self)) >= MAX_ITEMS) {
+    if (vendor_stock_count(shop, self, obj) >= MAX_ITEMS) {
         perform_say_to(self, ch,
             "No thanks.  I've got too many of those in stock already.");
         return true;
@@ -280,7 +508,7 @@ vendor_get_value(struct creature *buyer, struct creature *seller, struct obj_dat
 struct obj_data *
 vendor_resolve_hash(struct shop_data *shop, struct creature *self, char *obj_str)
 {
-    struct obj_data *last_obj = NULL, *cur_obj;
+    struct vendor_stock *stock;
     int num;
 
     if (*obj_str != '#') {
@@ -292,24 +520,32 @@ vendor_resolve_hash(struct shop_data *shop, struct creature *self, char *obj_str
     if (num <= 0)
         return NULL;
 
-    for (cur_obj = vendor_items_forsale(shop, self); cur_obj; cur_obj = cur_obj->next_content) {
-        if (!last_obj || !same_obj(last_obj, cur_obj))
-            if (--num == 0)
-                return cur_obj;
-        last_obj = cur_obj;
-    }
+    stock = vendor_stock(shop, self);
+    if ((guint)num > stock->groups->len)
+        return NULL;
 
-    return cur_obj;
+    return ((struct vendor_stock_group *)
+            g_ptr_array_index(stock->groups, num - 1))->obj;
 }
 
 struct obj_data *
 vendor_resolve_name(struct shop_data *shop, struct creature *self, char *obj_str)
 {
-    struct obj_data *cur_obj;
+    struct vendor_stock *stock = vendor_stock(shop, self);
 
-    for (cur_obj = vendor_items_forsale(shop, self); cur_obj; cur_obj = cur_obj->next_content)
-        if (namelist_match(obj_str, cur_obj->aliases))
-            return cur_obj;
+    for (guint i = 0; i < stock->groups->len; i++) {
+        struct vendor_stock_group *group = g_ptr_array_index(stock->groups, i);
+        struct obj_data *obj = group->obj;
+
+        if (group->same_aliases) {
+            if (namelist_match(obj_str, obj->aliases))
+                return obj;
+            continue;
+        }
+        for (int j = 0; j < group->count; j++, obj = obj->next_content)
+            if (namelist_match(obj_str, obj->aliases))
+                return obj;
+    }
 
     return NULL;
 }
@@ -446,7 +682,7 @@ vendor_sell(struct creature *ch, char *arg, struct creature *self,
     }
 
     if (num > 1) {
-        int obj_cnt = vendor_inventory(obj, vendor_items_forsale(shop, self));
+        int obj_cnt = vendor_stock_count(shop, self, obj);
         if (!vendor_is_produced(obj, shop) && num > obj_cnt) {
             perform_say_to(self, ch,
                 tmp_sprintf("I only have %d to sell to you.", obj_cnt));
@@ -627,12 +863,7 @@ vendor_sell(struct creature *ch, char *arg, struct creature *self,
             obj->consignor = 0;
             obj->consign_price = 0;
 
-            if (room) {
-                obj_from_room(obj);
-            } else {
-                obj_from_char(obj);
-            }
-
+            vendor_stock_remove(shop, self, room, obj);
             obj_to_char(obj, ch);
             obj = next_obj;
             num--;
@@ -730,8 +961,8 @@ vendor_buy(struct creature *ch, char *arg, struct creature *self,
             tmp_sprintf("I can only afford to buy %d.", num));
     }
 
-    if (vendor_inventory(obj, self->carrying) + num > MAX_ITEMS) {
-        num = MAX_ITEMS - vendor_inventory(obj, vendor_items_forsale(shop, self));
+    if (vendor_stock_count(shop, self, obj) + num > MAX_ITEMS) {
+        num = MAX_ITEMS - vendor_stock_count(shop, self, obj);
         perform_say_to(self, ch, tmp_sprintf("I only want to buy %d.", num));
     }
 
@@ -755,11 +986,7 @@ vendor_buy(struct creature *ch, char *arg, struct creature *self,
         // transfer object
         next_obj = obj->next_content;
         obj_from_char(obj);
-        if (room) {
-            obj_to_room(obj, room);
-        } else {
-            obj_to_char(obj, self);
-        }
+        vendor_stock_add(shop, self, room, obj);
 
         // repair object
         if (GET_OBJ_DAM(obj) != -1 && GET_OBJ_MAX_DAM(obj) != -1)
@@ -828,19 +1055,10 @@ vendor_list_obj(struct creature *ch, struct obj_data *obj, int cnt, int idx,
         obj_desc, cost);
 }
 
-static void
-vendor_list(struct creature *ch, char *arg, struct creature *self,
-    struct shop_data *shop)
+static const char *
+vendor_list_header(struct creature *ch, struct shop_data *shop)
 {
-    struct obj_data *cur_obj, *last_obj;
-    int idx, cnt;
     const char *msg;
-    unsigned long cost;
-
-    if (!vendor_items_forsale(shop, self)) {
-        perform_say_to(self, ch, "I'm out of stock at the moment.");
-        return;
-    }
 
     switch (shop->currency) {
     case 0:
@@ -857,11 +1075,49 @@ vendor_list(struct creature *ch, char *arg, struct creature *self,
         msg = "PleaseReport";
     }
 
-    msg = tmp_strcat(CCCYN(ch, C_NRM),
+    return tmp_strcat(CCCYN(ch, C_NRM),
         " ##   Available   Item                                       ", msg,
         "\r\n",
         "-------------------------------------------------------------------------\r\n",
         CCNRM(ch, C_NRM), NULL);
+}
+
+// Returns the shop's listing, matching the objects against arg if
+// it is given
+char *
+vendor_list_str(struct creature *ch, char *arg, struct creature *self,
+    struct shop_data *shop)
+{
+    struct vendor_stock *stock = vendor_stock(shop, self);
+    char *msg = tmp_strdup(vendor_list_header(ch, shop));
+    unsigned long cost;
+
+    for (guint i = 0; i < stock->groups->len; i++) {
+        struct vendor_stock_group *group = g_ptr_array_index(stock->groups, i);
+        int cnt = group->count;
+
+        if (*arg && !namelist_match(arg, group->last->aliases))
+            continue;
+        if (vendor_is_produced(group->last, shop))
+            cnt = -1;
+        cost = vendor_get_value(ch, self, group->last, shop->markup, shop->currency);
+        msg = tmp_strcat(msg,
+            vendor_list_obj(ch, group->last, cnt, i + 1, cost), NULL);
+    }
+
+    return msg;
+}
+
+// Builds the listing by walking the whole stock, as it was before the
+// stock was indexed.  Kept to check the index against.
+char *
+vendor_list_str_scan(struct creature *ch, char *arg, struct creature *self,
+    struct shop_data *shop)
+{
+    struct obj_data *cur_obj, *last_obj;
+    int idx, cnt;
+    char *msg = tmp_strdup(vendor_list_header(ch, shop));
+    unsigned long cost;
 
     last_obj = NULL;
     cnt = idx = 1;
@@ -892,8 +1148,20 @@ vendor_list(struct creature *ch, char *arg, struct creature *self,
         }
     }
 
+    return msg;
+}
+
+static void
+vendor_list(struct creature *ch, char *arg, struct creature *self,
+    struct shop_data *shop)
+{
+    if (!vendor_items_forsale(shop, self)) {
+        perform_say_to(self, ch, "I'm out of stock at the moment.");
+        return;
+    }
+
     act("$n peruses the shop's wares.", false, ch, NULL, NULL, TO_ROOM);
-    page_string(ch->desc, msg);
+    page_string(ch->desc, vendor_list_str(ch, arg, self, shop));
 }
 
 static void
@@ -63,6 +63,9 @@
 #include "editor.h"
 #include "ban.h"
 #include "paths.h"
+#include "world_image.h"
+#include "memstat.h"
+#include "profiler.h"
 
 /* externs */
 extern struct help_collection *Help;
@@ -150,6 +153,7 @@ void mem_cleanup(void);
 void retire_trails(void);
 void set_desc_state(int state, struct descriptor_data *d);
 void save_quests();             // quests.cc - saves quest data
+void flush_clan_sql(void);
 void save_all_players();
 void random_mob_activity(void);
 gboolean update_room_affects(gpointer ignore);
@@ -168,6 +172,10 @@ init_game(void)
 
     extern PGconn *sql_cxn;
 
+    struct timespec boot_start, boot_done, boot_len;
+
+    clock_gettime(CLOCK_MONOTONIC, &boot_start);
+
     my_srand(time(NULL));
     boot_db();
 
@@ -178,6 +186,12 @@ init_game(void)
     GIOChannel *main_io = init_socket(main_port);
     GIOChannel *reader_io = init_socket(reader_port);
 
+    clock_gettime(CLOCK_MONOTONIC, &boot_done);
+    boot_len = timediff(&boot_done, &boot_start);
+    slog("Boot to listen took %ld.%03lds (world %s).",
+        (long)boot_len.tv_sec, boot_len.tv_nsec / 1000000,
+        (world_image_loaded) ? "image" : "text files");
+
     avail_descs = get_avail_descs();
 
     slog("Signal trapping.");
@@ -197,6 +211,7 @@ init_game(void)
     save_all_players();
     save_houses();
     save_quests();
+    flush_clan_sql();
     xmlCleanupParser();
     PQfinish(sql_cxn);
 
@@ -340,8 +355,7 @@ autosave(__attribute__ ((unused)) gpointer ignore)
 {
     save_all_players();
     collect_housing_rent();
-    save_houses();
-    update_objects_housed_count();
+    save_changed_houses();
     return true;
 }
 
@@ -488,32 +502,62 @@ game_loop(GIOChannel *main_listener, GIOChannel *reader_listener)
                    GINT_TO_POINTER(reader_port));
 
     /* Set up repeating events */
-    g_timeout_add(100, repeating_func_wrapper, prog_update_pending);
-    g_timeout_add(100, repeating_func_wrapper, update_unique_id);
-    g_timeout_add(100, repeating_func_wrapper, update_ticks);
-    g_timeout_add(100, repeating_func_wrapper, sql_gc_queries);
-    g_timeout_add(100, repeating_func_wrapper, tmp_gc_strings);
-    g_timeout_add(100, update_suppress_output, NULL);
-    g_timeout_add(1000, reap_dead_creatures, NULL);
-    g_timeout_add(100 * PULSE_MOBILE, repeating_func_wrapper, mobile_activity);
-    g_timeout_add(100 * PULSE_MOBILE_SPEC, repeating_func_wrapper, mobile_spec);
-    g_timeout_add(100 * SEG_VIOLENCE, repeating_func_wrapper, perform_violence);
-    g_timeout_add(100 * FIRE_TICK, repeating_func_wrapper, burn_update);
-    g_timeout_add(100 * PULSE_FLOWS, repeating_func_wrapper, flow_room);
-    g_timeout_add(5000, update_room_affects, NULL);
-    g_timeout_add(4000, update_alignment_ambience, NULL);
-    g_timeout_add(100 * PULSE_FLOWS, repeating_func_wrapper, dynamic_object_pulse);
-    g_timeout_add(100 * PULSE_FLOWS, repeating_func_wrapper, path_activity);
-    g_timeout_add(100 * PULSE_FLOWS, repeating_func_wrapper, prog_update);
-    g_timeout_add(100 * 130 * PASSES_PER_SEC, repeating_func_wrapper, retire_trails);
-    g_timeout_add(100 * SECS_PER_MUD_HOUR * PASSES_PER_SEC, mud_wide_tick, NULL);
-    g_timeout_add(100 * 300 * PASSES_PER_SEC, repeating_func_wrapper, record_usage);
-    g_timeout_add(100 * 900 * PASSES_PER_SEC, temp_autosave_zones, NULL);
-    g_timeout_add(100 * 666 * PASSES_PER_SEC, repeating_func_wrapper, bamf_quad_damage);
+    pulse_timeout_add("prog_update_pending", 100,
+                      repeating_func_wrapper, prog_update_pending);
+    pulse_timeout_add("update_unique_id", 100,
+                      repeating_func_wrapper, update_unique_id);
+    pulse_timeout_add("update_ticks", 100,
+                      repeating_func_wrapper, update_ticks);
+    pulse_timeout_add("sql_gc_queries", 100,
+                      repeating_func_wrapper, sql_gc_queries);
+    pulse_timeout_add("flush_clan_sql", 100,
+                      repeating_func_wrapper, flush_clan_sql);
+    pulse_timeout_add("tmp_gc_strings", 100,
+                      repeating_func_wrapper, tmp_gc_strings);
+    pulse_timeout_add("invalidate_sight", 100,
+                      repeating_func_wrapper, invalidate_sight);
+    pulse_timeout_add("memstat_pulse", 100,
+                      repeating_func_wrapper, memstat_pulse);
+    pulse_timeout_add("update_suppress_output", 100,
+                      update_suppress_output, NULL);
+    pulse_timeout_add("reap_dead_creatures", 1000, reap_dead_creatures, NULL);
+    pulse_timeout_add("mobile_activity", 100 * PULSE_MOBILE,
+                      repeating_func_wrapper, mobile_activity);
+    pulse_timeout_add("mobile_spec", 100 * PULSE_MOBILE_SPEC,
+                      repeating_func_wrapper, mobile_spec);
+    pulse_timeout_add("perform_violence", 100 * SEG_VIOLENCE,
+                      repeating_func_wrapper, perform_violence);
+    pulse_timeout_add("burn_update", 100 * FIRE_TICK,
+                      repeating_func_wrapper, burn_update);
+    pulse_timeout_add("flow_room", 100 * PULSE_FLOWS,
+                      repeating_func_wrapper, flow_room);
+    pulse_timeout_add("update_room_affects", 5000, update_room_affects, NULL);
+    pulse_timeout_add("update_alignment_ambience", 4000,
+                      update_alignment_ambience, NULL);
+    pulse_timeout_add("dynamic_object_pulse", 100 * PULSE_FLOWS,
+                      repeating_func_wrapper, dynamic_object_pulse);
+    pulse_timeout_add("path_activity", 100 * PULSE_FLOWS,
+                      repeating_func_wrapper, path_activity);
+    pulse_timeout_add("prog_update", 100 * PULSE_FLOWS,
+                      repeating_func_wrapper, prog_update);
+    pulse_timeout_add("retire_trails", 100 * 130 * PASSES_PER_SEC,
+                      repeating_func_wrapper, retire_trails);
+    pulse_timeout_add_budget("mud_wide_tick",
+                             100 * SECS_PER_MUD_HOUR * PASSES_PER_SEC,
+                             1000000, mud_wide_tick, NULL);
+    pulse_timeout_add("record_usage", 100 * 300 * PASSES_PER_SEC,
+                      repeating_func_wrapper, record_usage);
+    pulse_timeout_add_budget("temp_autosave_zones",
+                             100 * 900 * PASSES_PER_SEC,
+                             1000000, temp_autosave_zones, NULL);
+    pulse_timeout_add("bamf_quad_damage", 100 * 666 * PASSES_PER_SEC,
+                      repeating_func_wrapper, bamf_quad_damage);
     if (auto_save)
-        g_timeout_add(100 * 60 * PASSES_PER_SEC, autosave, NULL);
+        pulse_timeout_add_budget("autosave", 100 * 60 * PASSES_PER_SEC,
+                                 1000000, autosave, NULL);
     if (stress_test) {
-        g_timeout_add(100, repeating_func_wrapper, random_mob_activity);
+        pulse_timeout_add("random_mob_activity", 100,
+                          repeating_func_wrapper, random_mob_activity);
     }
 
     /* Start the game */
@@ -584,6 +628,8 @@ record_usage(void)
     }
 #endif
 
+    memstat_log();
+
 }
 
 void
@@ -1038,8 +1084,7 @@ destroy_socket(struct descriptor_data *d)
 
     REMOVE_FROM_LIST(d, descriptor_list, next);
 
-    if (d->showstr_head)
-        free(d->showstr_head);
+    pager_stop(d);
 
     g_source_remove(d->in_watcher);
     g_source_remove(d->err_watcher);
@@ -1986,9 +2031,14 @@ bamf_quad_damage(void)
     struct zone_data *zone = NULL;
     struct room_data *room = NULL, *orig_room = NULL;
 
-    for (quad = object_list; quad; quad = quad->next)
-        if (quad->in_room && (GET_OBJ_VNUM(quad) == QUAD_VNUM))
+    for (GList *it = object_instances(QUAD_VNUM); it; it = it->next) {
+        struct obj_data *obj = it->data;
+
+        if (obj->in_room) {
+            quad = obj;
             break;
+        }
+    }
 
     if (quad) {
         if (quad->in_room->people)
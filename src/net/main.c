@@ -28,6 +28,7 @@
 #include "tmpstr.h"
 #include "accstr.h"
 #include "strutil.h"
+#include "world_image.h"
 
 extern int DFLT_PORT;
 extern char *DFLT_DIR;
@@ -43,6 +44,7 @@ extern bool stress_test;
 extern bool production_mode;
 extern int main_port;
 extern int reader_port;
+extern int boot_threads;
 
 void ensure_environment(void);
 void init_game(void);
@@ -77,12 +79,14 @@ main(int argc, char **argv)
         {"user", required_argument, NULL, 'u'},
         {"group", required_argument, NULL, 'g'},
         {"port", required_argument, NULL, 'p'},
+        {"worldimage", no_argument, NULL, 'w'},
+        {"boot-threads", required_argument, NULL, 't'},
         {NULL, 0, NULL, 0}
     };
 
     char c;
     opterr = 1;
-    while ((c = getopt_long(argc, argv, "bmcqrsoznlPp:u:g:",
+    while ((c = getopt_long(argc, argv, "bmcqrsoznlPwp:u:g:t:",
                 long_options, &option_idx)) != -1) {
         switch (c) {
         case 'b':
@@ -126,6 +130,19 @@ main(int argc, char **argv)
             production_mode = true;
             slog("Running in production mode");
             break;
+        case 'w':
+            use_world_image = true;
+            slog("Using compiled world image when up to date.");
+            break;
+        case 't':
+            if (!is_number(optarg) || atoi(optarg) < 1) {
+                fprintf(stderr, "%s: boot threads must be a positive number\n",
+                    argv[0]);
+                safe_exit(EXIT_FAILURE);
+            }
+            boot_threads = atoi(optarg);
+            slog("Parsing world files with %d boot threads.", boot_threads);
+            break;
         case 'u':
             user = optarg;
             break;
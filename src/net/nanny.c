@@ -1753,6 +1753,7 @@ char_to_game(struct descriptor_data *d)
         d_send(d, "\e[H\e[J");
 
     reset_char(d->creature);
+    compile_role_privileges(d->creature);
 
     // Report and go back to menu if buried
     if (PLR2_FLAGGED(d->creature, PLR2_BURIED)) {
@@ -602,9 +602,11 @@ SPECIAL(vehicle_console)
         !CMD_IS("exits") && !CMD_IS("rev") && !CMD_IS("spinout"))
         return 0;
 
-    for (vehicle = object_list; vehicle; vehicle = vehicle->next) {
-        if (GET_OBJ_VNUM(vehicle) == V_CAR_VNUM(console) && vehicle->in_room)
+    for (GList *it = object_instances(V_CAR_VNUM(console)); it; it = it->next) {
+        if (((struct obj_data *)it->data)->in_room) {
+            vehicle = it->data;
             break;
+        }
     }
 
     if (!vehicle)
@@ -872,9 +874,9 @@ find_vehicle(struct obj_data *v_door)
 {
     struct obj_data *vehicle = NULL;
 
-    for (vehicle = object_list; vehicle; vehicle = vehicle->next) {
-        if (ROOM_NUMBER(vehicle) == ROOM_NUMBER(v_door) &&
-            GET_OBJ_VNUM(vehicle) == V_CAR_VNUM(v_door) && vehicle->in_room)
+    for (GList *it = object_instances(V_CAR_VNUM(v_door)); it; it = it->next) {
+        vehicle = it->data;
+        if (ROOM_NUMBER(vehicle) == ROOM_NUMBER(v_door) && vehicle->in_room)
             return vehicle;
     }
     return NULL;
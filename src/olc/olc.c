@@ -61,6 +61,7 @@
 #include "editor.h"
 #include "smokes.h"
 #include "strutil.h"
+#include "house.h"
 
 extern const char *language_names[];
 extern const char *race_language[][2];
@@ -360,6 +361,10 @@ ACMD(do_olc)
         return;
     }
 
+    // Any olc command may change a prototype
+    invalidate_mobile_index();
+    invalidate_object_index();
+
     if (olc_command != 8 && olc_command != 10) {    /* help? */
         if (!is_authorized(ch, EDIT_ZONE, ch->in_room->zone)) {
             if (is_authorized(ch, WORLDWRITE, NULL)
@@ -968,7 +973,10 @@ ACMD(do_olc)
         obj_p->obj_flags.damage = tmp_obj->obj_flags.damage;
         obj_p->obj_flags.weight = tmp_obj->obj_flags.weight;
         obj_p->shared->cost = tmp_obj->shared->cost;
-        obj_p->shared->cost_per_day = tmp_obj->shared->cost_per_day;
+        if (obj_p->shared->cost_per_day != tmp_obj->shared->cost_per_day) {
+            obj_p->shared->cost_per_day = tmp_obj->shared->cost_per_day;
+            house_rent_changed();
+        }
         obj_p->shared->func = NULL;
         obj_p->shared->func_param = NULL;
 
@@ -2305,6 +2313,9 @@ ACMD(do_unapprove)
     struct zone_data *zone = NULL;
     struct creature *mob = NULL;
 
+    invalidate_mobile_index();
+    invalidate_object_index();
+
     arg1 = tmp_getword(&argument);
     arg2 = tmp_getword(&argument);
     arg3 = tmp_getword(&argument);
@@ -2476,6 +2487,9 @@ ACMD(do_approve)
     struct zone_data *zone = NULL;
     struct creature *mob = NULL;
 
+    invalidate_mobile_index();
+    invalidate_object_index();
+
     arg1 = tmp_getword(&argument);
     arg2 = tmp_getword(&argument);
     arg3 = tmp_getword(&argument);
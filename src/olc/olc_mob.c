@@ -264,6 +264,7 @@ do_create_mob(struct creature *ch, int vnum)
     new_mob->in_room = NULL;
 
     g_hash_table_insert(mob_prototypes, GINT_TO_POINTER(vnum), new_mob);
+    invalidate_mobile_index();
 
     return (new_mob);
 }
@@ -369,6 +370,9 @@ do_mob_mset(struct creature *ch, char *argument)
         return;
     }
 
+    // Any mset may change what the prototype matches
+    invalidate_mobile_index();
+
     if (!*argument) {
         strcpy_s(buf, sizeof(buf), "Valid mset commands:\r\n");
         strcat_s(buf, sizeof(buf), CCYEL(ch, C_NRM));
@@ -1587,6 +1591,7 @@ do_destroy_mobile(struct creature *ch, int vnum)
     }
 
     g_hash_table_remove(mob_prototypes, GINT_TO_POINTER(GET_NPC_VNUM(mob)));
+    invalidate_mobile_index();
     for (d = descriptor_list; d; d = d->next) {
         if (d->creature && GET_OLC_MOB(d->creature) == mob) {
             GET_OLC_MOB(d->creature) = NULL;
@@ -43,6 +43,7 @@
 #include "olc.h"
 #include "editor.h"
 #include "strutil.h"
+#include "house.h"
 
 extern struct room_data *world;
 extern struct obj_data *object_list;
@@ -413,6 +414,7 @@ do_create_obj(struct creature *ch, int vnum)
     new_obj->in_room = NULL;
 
     g_hash_table_insert(obj_prototypes, GINT_TO_POINTER(vnum), new_obj);
+    invalidate_object_index();
 
     return (new_obj);
 }
@@ -456,6 +458,7 @@ do_destroy_object(struct creature *ch, int vnum)
     }
 
     g_hash_table_remove(obj_prototypes, GINT_TO_POINTER(GET_OBJ_VNUM(obj)));
+    invalidate_object_index();
 
     for (d = descriptor_list; d; d = d->next)
         if (d->creature && GET_OLC_OBJ(d->creature) == obj) {
@@ -504,6 +507,10 @@ perform_oset(struct creature *ch, struct obj_data *obj_p,
     char arg1[MAX_INPUT_LENGTH], arg2[MAX_INPUT_LENGTH];
     struct extra_descr_data *desc = NULL, *ndesc = NULL;
     bool metric = USE_METRIC(ch);
+    int old_rent = obj_p->shared->cost_per_day;
+
+    // Any oset may change what the prototype matches
+    invalidate_object_index();
 
     if (!*argument) {
         strcpy_s(buf, sizeof(buf), "Valid oset commands:\r\n");
@@ -1185,6 +1192,10 @@ perform_oset(struct creature *ch, struct obj_data *obj_p,
             && !is_authorized(ch, WORLDWRITE, NULL))
             SET_BIT(obj_p->obj_flags.extra2_flags, ITEM2_UNAPPROVED);
     }
+
+    // Houses keep the rent of the objects in them
+    if (obj_p->shared->cost_per_day != old_rent)
+        house_rent_changed();
 }
 
 /** olc only! */
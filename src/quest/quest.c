@@ -18,6 +18,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
 #include <libpq-fe.h>
 #include <libxml/parser.h>
 #include <glib.h>
@@ -160,9 +162,12 @@ const char *qp_bits[] = {
 };
 
 #define QUEST_PATH "etc/quest.xml"
+#define QUEST_ARCHIVE_PATH "etc/quest_archive.xml"
 #define PLURAL(num) (num == 1 ? "" : "s")
 
 GList *quests = NULL;
+// Set when the quest file holds quests which are no longer active
+static bool quest_file_stale = false;
 
 /**
  * next_quest_vnum
@@ -227,6 +232,7 @@ make_quest(long owner_id, int owner_level, int type, const char *name)
     quest->mingen = 0;
     quest->maxgen = 10;
     quest->loadroom = -1;
+    quest->dirty = true;
 
     return quest;
 }
@@ -421,6 +427,7 @@ add_quest_player(struct quest *quest, int id)
     CREATE(player, struct qplayer_data, 1);
     player->idnum = id;
     quest->players = g_list_prepend(quest->players, player);
+    quest->dirty = true;
 }
 
 /**
@@ -445,6 +452,7 @@ remove_quest_player(struct quest * quest, int id)
         return false;
 
     quest->players = g_list_remove(quest->players, player);
+    quest->dirty = true;
 
     vict = get_char_in_world_by_idnum(player->idnum);
 
@@ -523,62 +531,291 @@ can_join_quest(struct quest * quest, struct creature * ch)
 }
 
 /**
- * load_quests:
+ * load_quest_archive:
+ * @path the path of the quest archive
+ * @damaged set to %true if the end of the archive was cut off
+ *
+ * Parses the quest archive.  Quests are appended to the archive as
+ * they are saved, so it has no root element; its contents are parsed
+ * as the children of one.  A quest left incomplete by a crash is
+ * cut off.
+ *
+ * Returns: the parsed document, or %NULL if there is no archive
+ **/
+static xmlDocPtr
+load_quest_archive(const char *path, bool *damaged)
+{
+    static const char *head = "<Quests>", *tail = "</Quests>";
+    xmlDocPtr doc;
+    char *buf, *end, *next;
+    long len;
+    FILE *inf;
+
+    inf = fopen(path, "r");
+    if (!inf)
+        return NULL;
+    fseek(inf, 0, SEEK_END);
+    len = ftell(inf);
+    rewind(inf);
+
+    CREATE(buf, char, strlen(head) + len + strlen(tail) + 1);
+    strcpy(buf, head);
+    if (fread(buf + strlen(head), 1, len, inf) != (size_t)len) {
+        errlog("Unable to read quest archive %s: %s", path, strerror(errno));
+        fclose(inf);
+        free(buf);
+        return NULL;
+    }
+    fclose(inf);
+
+    // Only whole quests are read
+    end = buf + strlen(head);
+    while ((next = strstr(end, "</Quest>")))
+        end = next + strlen("</Quest>");
+    for (next = end; *next; next++)
+        if (!isspace(*next))
+            *damaged = true;
+    strcpy(end, tail);
+
+    doc = xmlReadMemory(buf, strlen(buf), path, NULL,
+                        XML_PARSE_RECOVER | XML_PARSE_NOERROR
+                        | XML_PARSE_NOWARNING);
+    free(buf);
+    if (!doc)
+        errlog("Unable to parse quest archive %s", path);
+    return doc;
+}
+
+/**
+ * write_quest_file:
+ * @path the path of the file to be written
+ * @archive %true to write the archived quests, %false to write the
+ * others, which are the active quests and any ended quests not yet
+ * archived
+ *
+ * Replaces the file with one holding the chosen quests.  The file is
+ * written under another name and renamed, so a crash leaves the old
+ * one in place.
+ *
+ * Returns: %true if the file was written
+ **/
+static bool
+write_quest_file(const char *path, bool archive)
+{
+    char *new_path = tmp_sprintf("%s.new", path);
+    FILE *out;
+
+    out = fopen(new_path, "w");
+    if (!out) {
+        errlog("Cannot open quest file: %s", new_path);
+        return false;
+    }
+    if (!archive)
+        fputs("<Quests>", out);
+    for (GList * qit = quests; qit; qit = qit->next) {
+        struct quest *quest = qit->data;
+
+        if (quest->archived == archive)
+            save_quest(quest, out);
+    }
+    if (!archive)
+        fputs("</Quests>", out);
+    if (fclose(out) || rename(new_path, path) < 0) {
+        errlog("Cannot write quest file %s: %s", path, strerror(errno));
+        unlink(new_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * load_quest_files:
+ * @path the path of the active quest file
+ * @archive_path the path of the quest archive
  *
- * Loads all quest information from the saved quest file.
+ * Loads all quests from the active quest file and the archive of
+ * ended quests.  A quest may be in the archive more than once, when it
+ * was changed after ending, so the last copy of it is loaded and the
+ * archive is compacted.  Ended quests still in the active file, as all
+ * quests were before the archive, are moved to the archive at the next
+ * save.
  **/
 void
-load_quests(void)
+load_quest_files(const char *path, const char *archive_path)
 {
+    GHashTable *archived = g_hash_table_new(g_direct_hash, g_direct_equal);
+    bool damaged = false;
+    int records = 0;
+    xmlDocPtr doc;
+    xmlNodePtr cur;
+
     g_list_foreach(quests, (GFunc) free_quest, NULL);
     g_list_free(quests);
     quests = NULL;
+    quest_file_stale = false;
+
+    doc = load_quest_archive(archive_path, &damaged);
+    cur = (doc) ? xmlDocGetRootElement(doc) : NULL;
+    for (cur = (cur) ? cur->xmlChildrenNode : NULL; cur; cur = cur->next) {
+        if (!xmlMatches(cur->name, "Quest"))
+            continue;
+
+        struct quest *quest = load_quest(cur, doc);
+        struct quest *old = g_hash_table_lookup(archived,
+                                                GINT_TO_POINTER(quest->vnum));
+
+        if (old) {
+            quests = g_list_remove(quests, old);
+            free_quest(old);
+        }
+        quest->archived = true;
+        g_hash_table_insert(archived, GINT_TO_POINTER(quest->vnum), quest);
+        quests = g_list_prepend(quests, quest);
+        records++;
+    }
+    if (doc)
+        xmlFreeDoc(doc);
 
-    xmlDocPtr doc = xmlParseFile(QUEST_PATH);
+    doc = xmlParseFile(path);
     if (doc == NULL) {
         errlog("Quesst load FAILED.");
-        return;
-    }
-    // discard root node
-    xmlNodePtr cur = xmlDocGetRootElement(doc);
-    if (cur == NULL) {
+    } else {
+        // discard root node
+        cur = xmlDocGetRootElement(doc);
+        // Load all the nodes in the file
+        for (cur = (cur) ? cur->xmlChildrenNode : NULL; cur; cur = cur->next) {
+            // But only question nodes
+            if (!xmlMatches(cur->name, "Quest"))
+                continue;
+
+            struct quest *quest = load_quest(cur, doc);
+
+            // The quest ended and was archived, but the quest file
+            // wasn't written again
+            if (g_hash_table_lookup(archived, GINT_TO_POINTER(quest->vnum))) {
+                free_quest(quest);
+                quest_file_stale = true;
+                continue;
+            }
+            if (quest->ended)
+                quest->dirty = true;
+            quests = g_list_prepend(quests, quest);
+        }
         xmlFreeDoc(doc);
-        return;
     }
 
-    cur = cur->xmlChildrenNode;
-    // Load all the nodes in the file
-    while (cur != NULL) {
-        // But only question nodes
-        if ((xmlMatches(cur->name, "Quest")))
-            quests = g_list_prepend(quests, load_quest(cur, doc));
-        cur = cur->next;
+    // Later quests mustn't be appended after a damaged one
+    if (damaged || records > (int)g_hash_table_size(archived)) {
+        slog("Compacting quest archive: %d records of %d quests%s", records,
+             g_hash_table_size(archived), (damaged) ? ", damaged" : "");
+        write_quest_file(archive_path, true);
     }
-    xmlFreeDoc(doc);
+    g_hash_table_destroy(archived);
 }
 
 /**
- * save_quests:
+ * load_quests:
  *
- * Saves all quest information to the saved quest file.
+ * Loads all quest information from the saved quest files.
  **/
 void
-save_quests(void)
+load_quests(void)
 {
-    FILE *out;
+    load_quest_files(QUEST_PATH, QUEST_ARCHIVE_PATH);
+}
 
-    out = fopen(QUEST_PATH, "w");
-    if (!out) {
-        errlog("Cannot open quest file: %s", QUEST_PATH);
-        return;
+/**
+ * quest_text_being_edited:
+ * @quest the quest being queried
+ *
+ * Returns: %true if someone is editing the description or updates of
+ * the quest.  Their changes aren't made until they finish.
+ **/
+static bool
+quest_text_being_edited(struct quest *quest)
+{
+    for (struct descriptor_data *d = descriptor_list; d; d = d->next) {
+        if (!d->text_editor || !d->text_editor->is_editing)
+            continue;
+        if (d->text_editor->is_editing(d->text_editor, quest->description)
+            || d->text_editor->is_editing(d->text_editor, quest->updates))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * save_quest_files:
+ * @path the path of the active quest file
+ * @archive_path the path of the quest archive
+ *
+ * Saves the quests which have changed.  Ended quests are appended to
+ * the archive, and the active quest file is written again only when
+ * an active quest changed or a quest ended, so the cost of a save
+ * depends only on the active quests.
+ **/
+void
+save_quest_files(const char *path, const char *archive_path)
+{
+    bool rewrite = quest_file_stale, archive_ok = true;
+    FILE *archive = NULL;
+
+    for (GList * qit = quests; qit; qit = qit->next) {
+        struct quest *quest = qit->data;
+
+        if (!quest->dirty)
+            continue;
+        if (!quest->ended || !quest->archived)
+            rewrite = true;
+        // Quests being edited are archived once the editor is closed
+        if (!quest->ended || !archive_ok || quest_text_being_edited(quest))
+            continue;
+        if (!archive && !(archive = fopen(archive_path, "a"))) {
+            errlog("Cannot open quest archive %s: %s", archive_path,
+                   strerror(errno));
+            archive_ok = false;
+            continue;
+        }
+        save_quest(quest, archive);
     }
-    fputs("<Quests>", out);
+    if (archive && fclose(archive)) {
+        errlog("Cannot write quest archive %s: %s", archive_path,
+               strerror(errno));
+        archive_ok = false;
+    }
+
     for (GList * qit = quests; qit; qit = qit->next) {
         struct quest *quest = qit->data;
-        save_quest(quest, out);
+
+        if (quest->dirty && quest->ended && archive_ok
+            && !quest_text_being_edited(quest))
+            quest->archived = true;
     }
-    fputs("</Quests>", out);
-    fclose(out);
+
+    if (rewrite) {
+        quest_file_stale = !write_quest_file(path, false);
+        if (quest_file_stale)
+            return;
+    }
+
+    for (GList * qit = quests; qit; qit = qit->next) {
+        struct quest *quest = qit->data;
+
+        if (quest->dirty && (!quest->ended || (quest->archived && archive_ok))
+            && !quest_text_being_edited(quest))
+            quest->dirty = false;
+    }
+}
+
+/**
+ * save_quests:
+ *
+ * Saves all changed quest information to the saved quest files.
+ **/
+void
+save_quests(void)
+{
+    save_quest_files(QUEST_PATH, QUEST_ARCHIVE_PATH);
 }
 
 char arg1[MAX_INPUT_LENGTH], arg2[MAX_INPUT_LENGTH];
@@ -1307,6 +1544,7 @@ do_quest_ignore(struct creature *ch, char *argument)
     }
 
     TOGGLE_BIT(player->flags, QP_IGNORE);
+    quest->dirty = true;
 
     send_to_char(ch, "Ok, you are %s ignoring '%s'.\r\n",
         IS_SET(player->flags, QP_IGNORE) ? "now" : "no longer", quest->name);
@@ -1413,6 +1651,7 @@ bool
 remove_quest_ban(struct quest *quest, int id)
 {
     quest->bans = g_list_remove(quest->bans, GINT_TO_POINTER(id));
+    quest->dirty = true;
     return true;
 }
 
@@ -1420,6 +1659,7 @@ bool
 add_quest_ban(struct quest * quest, int id)
 {
     quest->bans = g_list_prepend(quest->bans, GINT_TO_POINTER(id));
+    quest->dirty = true;
     return true;
 }
 
@@ -1441,6 +1681,7 @@ tally_quest_death(struct quest *quest, int idnum)
     struct qplayer_data *player = quest_player_by_idnum(quest, idnum);
     if (player) {
         player->deaths += 1;
+        quest->dirty = true;
         save_quests();
     }
 }
@@ -1451,6 +1692,7 @@ tally_quest_mobkill(struct quest *quest, int idnum)
     struct qplayer_data *player = quest_player_by_idnum(quest, idnum);
     if (player) {
         player->mobkills += 1;
+        quest->dirty = true;
         save_quests();
     }
 }
@@ -1461,6 +1703,7 @@ tally_quest_pkill(struct quest *quest, int idnum)
     struct qplayer_data *player = quest_player_by_idnum(quest, idnum);
     if (player) {
         player->pkills += 1;
+        quest->dirty = true;
         save_quests();
     }
 }
@@ -1586,6 +1829,7 @@ do_qcontrol_loadroom(struct creature *ch, char *argument, int com)
     }
 
     quest->loadroom = number;
+    quest->dirty = true;
     send_to_char(ch, "Okay, quest loadroom is now %d\r\n", number);
 
     snprintf(buf, sizeof(buf), "%s set quest loadroom to: (%d)", GET_NAME(ch), number);
@@ -2006,6 +2250,7 @@ do_qcontrol_end(struct creature *ch, char *argument, int com)
     }
 
     quest->ended = time(NULL);
+    quest->dirty = true;
     qlog(ch, tmp_sprintf("ended quest %d '%s'", quest->vnum, quest->name),
         QLOG_BRIEF, 0, true);
     send_to_char(ch, "Quest ended.\r\n");
@@ -2235,6 +2480,7 @@ do_qcontrol_flags(struct creature *ch, char *argument, int com)
     }
 
     quest->flags = cur_flags;
+    quest->dirty = true;
 
     tmp_flags = old_flags ^ cur_flags;
     sprintbit(tmp_flags, quest_bits, buf2, sizeof(buf2));
@@ -2308,7 +2554,12 @@ do_qcontrol_desc(struct creature *ch, char *argument, int com)
         snprintf(buf, sizeof(buf), "began writing description of quest '%s'", quest->name);
     }
 
-    start_editing_text(ch->desc, &quest->description, MAX_QUEST_DESC);
+    // Quests being edited are saved until the editor is closed
+    if (!quest->description)
+        quest->description = strdup("");
+    quest->dirty = true;
+    start_editing_marked_text(ch->desc, &quest->description, MAX_QUEST_DESC,
+                              &quest->dirty);
     SET_BIT(PLR_FLAGS(ch), PLR_WRITING);
 }
 
@@ -2339,7 +2590,11 @@ do_qcontrol_update(struct creature *ch, char *argument, int com)
         snprintf(buf, sizeof(buf), "began writing the update of quest '%s'", quest->name);
     }
 
-    start_editing_text(ch->desc, &quest->updates, MAX_QUEST_UPDATE);
+    if (!quest->updates)
+        quest->updates = strdup("");
+    quest->dirty = true;
+    start_editing_marked_text(ch->desc, &quest->updates, MAX_QUEST_UPDATE,
+                              &quest->dirty);
     SET_BIT(PLR_FLAGS(ch), PLR_WRITING);
 
     act("$n begins to edit a quest update.\r\n", true, ch, NULL, NULL, TO_ROOM);
@@ -2582,6 +2837,7 @@ do_qcontrol_level(struct creature *ch, char *argument, int com)
         return;
 
     quest->owner_level = atoi(arg2);
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "set quest %d '%s' access level to %d",
         quest->vnum, quest->name, quest->owner_level);
@@ -2608,6 +2864,7 @@ do_qcontrol_minlev(struct creature *ch, char *argument, int com)
         return;
 
     quest->minlevel = MIN(LVL_GRIMP, MAX(0, atoi(arg2)));
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "set quest %d '%s' minimum level to %d",
         quest->vnum, quest->name, quest->minlevel);
@@ -2635,6 +2892,7 @@ do_qcontrol_maxlev(struct creature *ch, char *argument, int com)
         return;
 
     quest->maxlevel = MIN(LVL_GRIMP, MAX(0, atoi(arg2)));
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "set quest %d '%s' maximum level to %d",
         quest->vnum, quest->name, quest->maxlevel);
@@ -2661,6 +2919,7 @@ do_qcontrol_mingen(struct creature *ch, char *argument, int com)
         return;
 
     quest->mingen = MIN(10, MAX(0, atoi(arg2)));
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "set quest %d '%s' minimum gen to %d",
         quest->vnum, quest->name, quest->mingen);
@@ -2687,6 +2946,7 @@ do_qcontrol_maxgen(struct creature *ch, char *argument, int com)
         return;
 
     quest->maxgen = MIN(10, MAX(0, atoi(arg2)));
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "set quest %d '%s' maximum gen to %d",
         quest->vnum, quest->name, quest->maxgen);
@@ -2737,6 +2997,7 @@ do_qcontrol_mute(struct creature *ch, char *argument, int com)
     }
 
     SET_BIT(player->flags, QP_MUTE);
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "muted %s in %d quest '%s'.", arg1, quest->vnum, quest->name);
     qlog(ch, buf, QLOG_COMP, 0, true);
@@ -2788,6 +3049,7 @@ do_qcontrol_unmute(struct creature *ch, char *argument, int com)
     }
 
     REMOVE_BIT(player->flags, QP_MUTE);
+    quest->dirty = true;
 
     snprintf(buf, sizeof(buf), "unmuted %s in quest %d '%s'.", arg1, quest->vnum,
         quest->name);
@@ -2844,6 +3106,7 @@ do_qcontrol_title(struct creature *ch, char *argument)
 
     free(quest->name);
     quest->name = strdup(argument);
+    quest->dirty = true;
     send_to_char(ch, "Quest #%d's title has been changed to %s\r\n",
         quest->vnum, quest->name);
 }
@@ -2916,6 +3179,7 @@ do_qcontrol_award(struct creature *ch, char *argument, int com)
         account_set_quest_points(vict->account,
             vict->account->quest_points + award);
         quest->awarded += award;
+        quest->dirty = true;
         crashsave(ch);
         crashsave(vict);
         snprintf(buf, sizeof(buf), "awarded player %s %d qpoints.", GET_NAME(vict), award);
@@ -2995,6 +3259,7 @@ do_qcontrol_penalize(struct creature *ch, char *argument, int com)
             vict->account->quest_points - penalty);
         GET_IMMORT_QP(ch) += penalty;
         quest->penalized += penalty;
+        quest->dirty = true;
         crashsave(vict);
         crashsave(ch);
         send_to_char(vict,
@@ -36,6 +36,8 @@
 #include "search.h"
 #include "prog.h"
 #include "strutil.h"
+#include "gpqueue.h"
+#include "memstat.h"
 
 extern char locate_buf[256];
 
@@ -44,6 +46,18 @@ gint prog_tick = 0;
 GTrashStack *dead_progs = NULL;
 GList *active_progs = NULL;
 
+// Running progs, keyed by the tick on which they next wake up.  A prog
+// is only in the queue while it is waiting, not while it executes.
+static GPQueue *prog_wakeups = NULL;
+// Progs that have terminated but have not yet been freed
+static GList *terminated_progs = NULL;
+static size_t active_prog_count = 0;
+static size_t dead_prog_count = 0;
+// Mobiles and rooms which have compiled progs, so that idle and combat
+// triggers don't need to scan the whole world
+static GHashTable *prog_mobs = NULL;
+static GHashTable *prog_rooms = NULL;
+
 #define DEFPROGHANDLER(cmd, env, evt, args) \
     void prog_do_##cmd(struct prog_env *env __attribute__ ((unused)), \
                        struct prog_evt *evt __attribute__ ((unused)), \
@@ -235,7 +249,7 @@ prog_next_handler(struct prog_env * env, bool use_resume)
     while (*((short *)&prog[env->exec_pt])) {
         short cmd;
 
-        cmd = *((short *)&prog[env->exec_pt]);
+        cmd = *((short *)&prog[env->exec_pt]) & PROG_CMD_MASK;
         if (cmd == PROG_CMD_BEFORE ||
             cmd == PROG_CMD_HANDLE ||
             cmd == PROG_CMD_AFTER ||
@@ -293,33 +307,69 @@ prog_send_debug(struct prog_env *env, const char *msg)
     }
 }
 
-struct prog_var *
-prog_get_var(struct prog_env *env, const char *key, bool exact)
-{
-	struct prog_var *cur_var;
-
-    if (exact) {
-        if (env->state)
-            for (cur_var = env->state->var_list; cur_var; cur_var = cur_var->next)
-                if (!strcmp(cur_var->key, key))
-                    return cur_var;
-        if (prog_get_prog_state(env))
-            for (cur_var = prog_get_prog_state(env)->var_list; cur_var; cur_var = cur_var->next)
-                if (!strcmp(cur_var->key, key))
-                    return cur_var;
-    } else {
-        if (env->state)
-            for (cur_var = env->state->var_list; cur_var; cur_var = cur_var->next)
-                if (!strncmp(cur_var->key, key, strlen(cur_var->key)))
-                    return cur_var;
-        if (prog_get_prog_state(env))
-            for (cur_var = prog_get_prog_state(env)->var_list; cur_var; cur_var = cur_var->next)
-                if (!strncmp(cur_var->key, key, strlen(cur_var->key)))
-                    return cur_var;
+static GHashTable *prog_symbols = NULL;
+static int prog_symbol_count = 0;
+
+//
+// prog_intern_symbol
+//
+// Returns the number of the symbol with the given name, adding it to
+// the symbol table if it isn't already there.  Variables are looked
+// up by symbol number, so that a compiled prog never has to compare
+// names.
+int
+prog_intern_symbol(const char *name)
+{
+    gpointer sym;
+
+    if (!prog_symbols)
+        prog_symbols = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                             g_free, NULL);
+    sym = g_hash_table_lookup(prog_symbols, name);
+    if (!sym) {
+        sym = GINT_TO_POINTER(++prog_symbol_count);
+        g_hash_table_insert(prog_symbols, g_strdup(name), sym);
+    }
+    return GPOINTER_TO_INT(sym);
+}
+
+// Returns the number of the named symbol, or 0 if it has never been
+// interned.
+int
+prog_find_symbol(const char *name)
+{
+    if (!prog_symbols)
+        return 0;
+    return GPOINTER_TO_INT(g_hash_table_lookup(prog_symbols, name));
+}
+
+static struct prog_var *
+prog_get_var_sym(struct prog_env *env, int sym)
+{
+    struct prog_state_data *state;
+    struct prog_var *var;
+
+    if (env->state && env->state->vars) {
+        var = g_hash_table_lookup(env->state->vars, GINT_TO_POINTER(sym));
+        if (var)
+            return var;
     }
+    state = prog_get_prog_state(env);
+    if (state && state->vars)
+        return g_hash_table_lookup(state->vars, GINT_TO_POINTER(sym));
     return NULL;
 }
 
+struct prog_var *
+prog_get_var(struct prog_env *env, const char *key)
+{
+    int sym = prog_find_symbol(key);
+
+    if (!sym)
+        return NULL;
+    return prog_get_var_sym(env, sym);
+}
+
 static void
 prog_set_var(struct prog_env *env, bool local, const char *key, const char *arg)
 {
@@ -329,35 +379,28 @@ prog_set_var(struct prog_env *env, bool local, const char *key, const char *arg)
     if (local) {
         state = env->state;
         if (!state) {
-            CREATE(state, struct prog_state_data, 1);
+            CREATE_KIND(state, struct prog_state_data, 1, MEM_PROG);
             env->state = state;
         }
     } else {
         state = prog_get_prog_state(env);
         if (!state) {
-            CREATE(state, struct prog_state_data, 1);
+            CREATE_KIND(state, struct prog_state_data, 1, MEM_PROG);
             prog_set_prog_state(env, state);
         }
     }
 
-    var = prog_get_var(env, key, true);
+    var = prog_get_var(env, key);
 
 	if (!var) {
-		CREATE(var, struct prog_var, 1);
+		CREATE_KIND(var, struct prog_var, 1, MEM_PROG);
 		strcpy_s(var->key, sizeof(var->key), key);
-
-        // Sort by key length descending so inexact matches will work
-        // properly
-        if (!state->var_list || strlen(key) > strlen(state->var_list->key)) {
-            var->next = state->var_list;
-            state->var_list = var;
-        } else {
-            struct prog_var *prev_var = state->var_list;
-            while (prev_var->next && strlen(prev_var->next->key) < strlen(key))
-                prev_var = prev_var->next;
-            var->next = prev_var->next;
-            prev_var->next = var;
-        }
+        var->sym = prog_intern_symbol(key);
+        var->next = state->var_list;
+        state->var_list = var;
+        if (!state->vars)
+            state->vars = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(state->vars, GINT_TO_POINTER(var->sym), var);
 	}
 
     strcpy_s(var->value, sizeof(var->value), arg);
@@ -385,63 +428,116 @@ prog_var_equal(struct prog_env *env, char *key, char *arg)
 {
 	struct prog_var *var;
 
-    var = prog_get_var(env, key, true);
+    var = prog_get_var(env, key);
 	if (var == NULL) {
 		return !(*arg);
     }
 	return !strcasecmp(var->value, arg);
 }
 
-char *
-prog_expand_vars(struct prog_env *env, char *args)
+// Appends len characters of str to the expansion at write_pt, or
+// just counts them if nothing has been allocated yet
+static char *
+prog_template_append(char *write_pt, size_t *result_len, const char *str,
+                     size_t len)
 {
-    char *search_pt = strchr(args, '$');
-    const char *result = "";
-    struct prog_var *var;
+    if (!write_pt) {
+        *result_len += len;
+        return NULL;
+    }
+    memcpy(write_pt, str, len);
+    return write_pt + len;
+}
 
-    if (!search_pt)
-        return args;
-
-    while (search_pt) {
-        result = tmp_strcat(result, tmp_substr(args, 0, search_pt - args - 1), NULL);
-        args = search_pt + 1;
-        if (*args == '$') {
-            // Double dollar expands to simple dollar sign
-            result = tmp_strcat(result, "$", NULL);
-        } else if (*args == '{') {
-            // Variable reference
-            args++;
-            search_pt = strchr(args, '}');
-            if (!search_pt) {
-                struct room_data *room = prog_get_owner_room(env);
-                zerrlog(room->zone, "Invalid variable reference: no } found");
-                result = tmp_strcat(result, "<TYPO ME>", NULL);
+//
+// prog_expand_template
+//
+// Returns the argument described by a compiled template, with all the
+// variable references replaced by their values.
+static char *
+prog_expand_template(struct prog_env *env, const unsigned char *tmpl)
+{
+    const char *text = (const char *)tmpl, *name, *value;
+    const unsigned char *segs = tmpl + strlen(text) + 1, *read_pt;
+    struct prog_var *var;
+    char *result = NULL, *write_pt = NULL;
+    size_t result_len = 0;
+    guint16 text_offset, text_len;
+    guint8 name_len, match_len;
+    gint32 sym;
+    int pass;
+
+    // The first pass finds the length of the result, and the second
+    // pass builds it.
+    for (pass = 0; pass < 2; pass++) {
+        read_pt = segs;
+        while (*read_pt != PROG_SEG_END) {
+            switch (*read_pt++) {
+            case PROG_SEG_TEXT:
+                memcpy(&text_offset, read_pt, sizeof(text_offset));
+                memcpy(&text_len, read_pt + sizeof(text_offset),
+                       sizeof(text_len));
+                write_pt = prog_template_append(write_pt, &result_len,
+                                                text + text_offset, text_len);
+                read_pt += sizeof(text_offset) + sizeof(text_len);
                 break;
-            }
-            var = prog_get_var(env, tmp_substr(args, 0, search_pt - args - 1), true);
-            if (var) {
-                result = tmp_strcat(result, var->value, NULL);
-            } else {
-                struct room_data *room = prog_get_owner_room(env);
-                zerrlog(room->zone, "Invalid variable reference: %s not a variable",
-                        tmp_substr(args, 0, search_pt - args - 1));
-                result = tmp_strcat(result, "<TYPO ME>", NULL);
-                continue;
-            }
-            args = search_pt + 1;
-        } else {
-            // Potential variable reference
-            var = prog_get_var(env, args, false);
-            if (var) {
-                result = tmp_strcat(result, var->value, NULL);
-                args += strlen(var->key);
-            } else {
-                result = tmp_strcat(result, "$", NULL);
+            case PROG_SEG_VAR:
+                memcpy(&sym, read_pt, sizeof(sym));
+                memcpy(&text_offset, read_pt + sizeof(sym),
+                       sizeof(text_offset));
+                name_len = read_pt[sizeof(sym) + sizeof(text_offset)];
+                name = text + text_offset;
+                var = prog_get_var_sym(env, sym);
+                if (!var && pass == 0) {
+                    struct room_data *room = prog_get_owner_room(env);
+                    zerrlog(room->zone,
+                            "Invalid variable reference: %.*s not a variable",
+                            name_len, name);
+                }
+                value = (var) ? var->value:"<TYPO ME>";
+                write_pt = prog_template_append(write_pt, &result_len,
+                                                value, strlen(value));
+                read_pt += sizeof(sym) + sizeof(text_offset) + 1;
+                break;
+            case PROG_SEG_PREFIX:
+                // Substitute the longest variable name that matches.
+                // The rest of the name is just text.
+                memcpy(&text_offset, read_pt, sizeof(text_offset));
+                name_len = read_pt[sizeof(text_offset)];
+                name = text + text_offset;
+                read_pt += sizeof(text_offset) + 1;
+                var = NULL;
+                for (match_len = name_len; match_len > 0; match_len--) {
+                    memcpy(&sym, read_pt + (match_len - 1) * sizeof(sym),
+                           sizeof(sym));
+                    var = prog_get_var_sym(env, sym);
+                    if (var)
+                        break;
+                }
+                value = (var) ? var->value:"$";
+                write_pt = prog_template_append(write_pt, &result_len,
+                                                value, strlen(value));
+                write_pt = prog_template_append(write_pt, &result_len,
+                                                name + match_len,
+                                                name_len - match_len);
+                read_pt += name_len * sizeof(sym);
+                break;
+            case PROG_SEG_TYPO:
+                write_pt = prog_template_append(write_pt, &result_len,
+                                                "<TYPO ME>", 9);
+                break;
+            default:
+                errlog("Invalid prog template segment %d in %s",
+                       read_pt[-1], prog_get_desc(env));
+                return tmp_strdup("");
             }
         }
-        search_pt = strchr(args, '$');
+        if (pass == 0)
+            result = write_pt = tmp_pad(' ', result_len);
     }
-    return tmp_strcat(result, args, NULL);
+    *write_pt = '\0';
+
+    return result;
 }
 
 char *
@@ -773,7 +869,7 @@ prog_eval_condition(struct prog_env * env, struct prog_evt * evt, char *args)
         arg = tmp_gettoken(&args);
         result = prog_var_equal(env, arg, args);
         if (env->tracing) {
-            struct prog_var *var = prog_get_var(env, arg, true);
+            struct prog_var *var = prog_get_var(env, arg);
             prog_send_debug(env,
                             tmp_sprintf("('%s' %s '%s')",
                                         (var) ? var->value:"(null)",
@@ -884,7 +980,7 @@ DEFPROGHANDLER(randomly, env, evt, args)
 	exec = prog_get_obj(env->owner, env->owner_type);
 	num_paths = 0;
 	while (cur_pt < last_pt) {
-        if (*((short *)&exec[cur_pt]) == PROG_CMD_OR) {
+        if ((*((short *)&exec[cur_pt]) & PROG_CMD_MASK) == PROG_CMD_OR) {
             num_paths += 1;
             if (!number(0, num_paths))
                 env->exec_pt = cur_pt + sizeof(short) * 2;
@@ -1031,9 +1127,12 @@ DEFPROGHANDLER(driveto, env, evt, args)
 		return;
 
 	// Now find the vehicle vnum that the console points to
-	for (vehicle = object_list; vehicle; vehicle = vehicle->next)
-		if (GET_OBJ_VNUM(vehicle) == V_CAR_VNUM(console) && vehicle->in_room)
+	vehicle = NULL;
+	for (GList *it = object_instances(V_CAR_VNUM(console)); it; it = it->next)
+		if (((struct obj_data *)it->data)->in_room) {
+			vehicle = it->data;
 			break;
+		}
 	if (!vehicle)
 		return;
 
@@ -1068,7 +1167,7 @@ DEFPROGHANDLER(driveto, env, evt, args)
 
 DEFPROGHANDLER(halt, env, evt, args)
 {
-	env->exec_pt = -1;
+	prog_terminate(env);
 }
 
 DEFPROGHANDLER(mobflag, env, evt, args)
@@ -1410,7 +1509,7 @@ DEFPROGHANDLER(selfpurge, env, evt, args)
 {
 	if (env->owner_type == PROG_TYPE_MOBILE) {
 		prog_do_nuke(env, evt, args);
-		env->exec_pt = -1;
+		prog_terminate(env);
 
         if (evt->kind != PROG_EVT_DYING)
             creature_purge((struct creature *) env->owner, true);
@@ -1458,7 +1557,7 @@ DEFPROGHANDLER(nuke, env, evt, args)
 	for (GList *cur = active_progs; cur; cur = cur->next) {
         struct prog_env *cur_prog = cur->data;
 		if (cur_prog != env && cur_prog->owner == env->owner)
-			cur_prog->exec_pt = -1;
+			prog_terminate(cur_prog);
     }
 }
 
@@ -1890,12 +1989,47 @@ prog_emit_trace(struct prog_env *env, int cmd, const char *arg)
     prog_send_debug(env, tmp_sprintf("%s %s", prog_cmds[cmd].str, arg));
 }
 
+//
+// prog_schedule
+//
+// Puts a running prog in the wakeup queue, or moves it, so that it
+// is executed on its next_tick.
+static void
+prog_schedule(struct prog_env *env)
+{
+    if (env->wakeup)
+        prog_wakeups = g_pqueue_change_priority(prog_wakeups, env->wakeup,
+                                                env->next_tick);
+    else
+        prog_wakeups = g_pqueue_insert(prog_wakeups, env, env->next_tick,
+                                       &env->wakeup);
+}
+
+//
+// prog_terminate
+//
+// Stops a prog from executing any further.  The prog is freed at the
+// end of the pulse, since its caller may still be examining it.
+void
+prog_terminate(struct prog_env *env)
+{
+    if (env->exec_pt < 0)
+        return;
+    env->exec_pt = -1;
+    if (env->wakeup) {
+        prog_wakeups = g_pqueue_delete(prog_wakeups, env->wakeup);
+        env->wakeup = NULL;
+    }
+    terminated_progs = g_list_prepend(terminated_progs, env);
+}
+
 static void
 prog_execute(struct prog_env *env)
 {
 	unsigned char *exec;
     int cmd, arg_addr;
     char *arg_str;
+    struct tmp_mark mark;
 
 	// Called with NULL environment
 	if (!env)
@@ -1910,18 +2044,27 @@ prog_execute(struct prog_env *env)
     exec = prog_get_obj(env->owner, env->owner_type);
     if (!exec) {
         // Damn prog disappeared on us
-        env->exec_pt = -1;
+        prog_terminate(env);
         return;
     }
 
+    // Temporary strings are released once the prog stops running, not
+    // after each command, since a command handler may still hold one
+    mark = tmp_mark();
     while (env->exec_pt >= 0 && env->next_tick <= prog_tick) {
         // Get the command and the arg address
         cmd = *((short *)(exec + env->exec_pt));
         arg_addr = *((short *)(exec + env->exec_pt + sizeof(short)));
         // Set the execution point to the next command by default
         env->exec_pt += sizeof(short) * 2;
-        // Call the handler for the command
-        arg_str = (arg_addr) ? prog_expand_vars(env, (char *)exec + arg_addr):NULL;
+        // Substitute variables into the argument, if it has any
+        if (!arg_addr)
+            arg_str = NULL;
+        else if (cmd & PROG_CMD_TEMPLATE)
+            arg_str = prog_expand_template(env, exec + arg_addr);
+        else
+            arg_str = (char *)exec + arg_addr;
+        cmd &= PROG_CMD_MASK;
         // Emit a trace if the prog is being traced
         if (env->tracing)
             prog_emit_trace(env, cmd, arg_str);
@@ -1933,6 +2076,10 @@ prog_execute(struct prog_env *env)
         if (prog_cmds[cmd].count)
             env->executed +=1 ;
     }
+    tmp_release(mark);
+
+    if (env->exec_pt >= 0)
+        prog_schedule(env);
 }
 
 struct prog_env *
@@ -1947,9 +2094,14 @@ prog_start(enum prog_evt_type owner_type, void *owner, struct creature * target,
 
     new_prog = g_trash_stack_pop(&dead_progs);
     if (!new_prog)
-		CREATE(new_prog, struct prog_env, 1);
+		CREATE_KIND(new_prog, struct prog_env, 1, MEM_PROG);
+    else
+        dead_prog_count--;
 
     active_progs = g_list_prepend(active_progs, new_prog);
+    new_prog->link = active_progs;
+    new_prog->wakeup = NULL;
+    active_prog_count++;
 
     new_prog->owner_type = owner_type;
 	new_prog->owner = owner;
@@ -1970,6 +2122,9 @@ prog_start(enum prog_evt_type owner_type, void *owner, struct creature * target,
     if (target)
         prog_set_target(new_prog, target);
 
+    // Progs that aren't executed right away start on the next pulse
+    prog_schedule(new_prog);
+
 	return new_prog;
 }
 
@@ -1982,7 +2137,7 @@ destroy_attached_progs(void *owner)
             cur_prog->target == owner ||
             cur_prog->evt.subject == owner ||
             cur_prog->evt.object == owner)
-			cur_prog->exec_pt = -1;
+			prog_terminate(cur_prog);
     }
 }
 
@@ -2463,9 +2618,11 @@ prog_state_free(struct prog_state_data *state)
     if (state) {
         for (cur_var = state->var_list; cur_var; cur_var = next_var) {
             next_var = cur_var->next;
-            free(cur_var);
+            FREE_KIND(cur_var, MEM_PROG);
         }
-        free(state);
+        if (state->vars)
+            g_hash_table_destroy(state->vars);
+        FREE_KIND(state, MEM_PROG);
     }
 }
 
@@ -2479,47 +2636,120 @@ prog_free(struct prog_env *prog)
         else
             ((struct room_data *)prog->owner)->prog_marker -= 1;
     }
-    active_progs = g_list_remove(active_progs, prog);
+    active_progs = g_list_delete_link(active_progs, prog->link);
+    active_prog_count--;
     g_trash_stack_push(&dead_progs, prog);
+    dead_prog_count++;
 }
 
 static void
 prog_execute_and_mark(void)
 {
-	// Execute progs and mark them as non-idle
-    GList *next;
-    for (GList *cur = active_progs;cur;cur = next) {
-        struct prog_env *cur_prog = cur->data;
-        next = cur->next;
-
-        if (cur_prog->next_tick > prog_tick)
-            continue;
-        if (cur_prog->exec_pt < 0)
-            continue;
-
-        prog_execute(cur_prog);
+    struct prog_env *env;
+    gint next_tick;
+
+	// Execute only the progs that are due.  Each is taken off the
+	// queue first, and prog_execute() puts it back if it sleeps again.
+    while (g_pqueue_top_extended(prog_wakeups, (gpointer *)&env, &next_tick)
+           && next_tick <= prog_tick) {
+        prog_wakeups = g_pqueue_delete_top(prog_wakeups);
+        env->wakeup = NULL;
+        prog_execute(env);
     }
 }
 
 static void
 prog_free_terminated(void)
 {
-    GList *next;
+    GList *dead = terminated_progs;
 
-    for (GList *cur = active_progs;cur;cur = next) {
-        struct prog_env *cur_prog = cur->data;
-        next = cur->next;
+    terminated_progs = NULL;
+    for (GList *cur = dead;cur;cur = cur->next)
+        prog_free(cur->data);
+    g_list_free(dead);
+}
+
+// Adds the owner to the idle trigger registry if it has compiled
+// progs, or removes it if it doesn't.  Recompiling a mobile prototype
+// updates every loaded instance of it.
+void
+prog_register_owner(void *owner, enum prog_evt_type owner_type)
+{
+    if (!prog_mobs) {
+        prog_mobs = g_hash_table_new(g_direct_hash, g_direct_equal);
+        prog_rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+    switch (owner_type) {
+    case PROG_TYPE_MOBILE: {
+        struct creature *ch = owner;
+
+        if (!IS_NPC(ch))
+            return;
+        if (NPC_SHARED(ch)->proto == ch) {
+            for (GList *cit = creatures;cit;cit = cit->next) {
+                struct creature *tch = cit->data;
+                if (IS_NPC(tch) && tch != ch
+                    && NPC_SHARED(tch) == NPC_SHARED(ch))
+                    prog_register_owner(tch, PROG_TYPE_MOBILE);
+            }
+        } else if (GET_NPC_PROGOBJ(ch))
+            g_hash_table_add(prog_mobs, ch);
+        else
+            g_hash_table_remove(prog_mobs, ch);
+        break;
+    }
+    case PROG_TYPE_ROOM:
+        if (GET_ROOM_PROGOBJ((struct room_data *)owner))
+            g_hash_table_add(prog_rooms, owner);
+        else
+            g_hash_table_remove(prog_rooms, owner);
+        break;
+    default:
+        break;
+    }
+}
+
+void
+prog_unregister_owner(void *owner, enum prog_evt_type owner_type)
+{
+    if (!prog_mobs)
+        return;
 
-        if (cur_prog->exec_pt < 0 || !cur_prog->owner)
-            prog_free(cur_prog);
+    switch (owner_type) {
+    case PROG_TYPE_MOBILE:
+        g_hash_table_remove(prog_mobs, owner);
+        break;
+    case PROG_TYPE_ROOM:
+        g_hash_table_remove(prog_rooms, owner);
+        break;
+    default:
+        break;
     }
 }
 
+void
+prog_owner_counts(size_t *mobs, size_t *rooms)
+{
+    *mobs = (prog_mobs) ? g_hash_table_size(prog_mobs) : 0;
+    *rooms = (prog_rooms) ? g_hash_table_size(prog_rooms) : 0;
+}
+
 static void
 prog_trigger_idle_mobs(void)
 {
-	for (GList *cit = first_living(creatures);cit;cit = next_living(cit)) {
+    GList *owners;
+
+    if (!prog_mobs)
+        return;
+
+    // Progs may extract mobs, so work from a snapshot and make sure
+    // each one is still registered before triggering it.
+    owners = g_hash_table_get_keys(prog_mobs);
+    for (GList *cit = owners;cit;cit = cit->next) {
         struct creature *ch = cit->data;
+        if (!g_hash_table_contains(prog_mobs, ch) || is_dead(ch))
+            continue;
 		if (ch->prog_marker || !GET_NPC_PROGOBJ(ch))
 			continue;
 		else if (is_fighting(ch))
@@ -2527,23 +2757,29 @@ prog_trigger_idle_mobs(void)
 		else
 			trigger_prog_idle(ch, PROG_TYPE_MOBILE);
 	}
+    g_list_free(owners);
 }
 
 static void
 prog_trigger_idle_rooms(void)
 {
-	struct zone_data *zone;
-	struct room_data *room;
+    GList *owners;
 
-	for (zone = zone_table; zone; zone = zone->next)  {
-		if (ZONE_FLAGGED(zone, ZONE_FROZEN)
-				|| zone->idle_time >= ZONE_IDLE_TIME)
-			continue;
+    if (!prog_rooms)
+        return;
 
-		for (room = zone->world; room; room = room->next)
-			if (GET_ROOM_PROGOBJ(room) && !room->prog_marker)
-				trigger_prog_idle(room, PROG_TYPE_ROOM);
+    owners = g_hash_table_get_keys(prog_rooms);
+    for (GList *rit = owners;rit;rit = rit->next) {
+        struct room_data *room = rit->data;
+        if (!g_hash_table_contains(prog_rooms, room))
+            continue;
+		if (ZONE_FLAGGED(room->zone, ZONE_FROZEN)
+				|| room->zone->idle_time >= ZONE_IDLE_TIME)
+			continue;
+        if (GET_ROOM_PROGOBJ(room) && !room->prog_marker)
+            trigger_prog_idle(room, PROG_TYPE_ROOM);
 	}
+    g_list_free(owners);
 }
 
 void
@@ -2567,14 +2803,37 @@ prog_update_pending(void)
 size_t
 free_prog_count(void)
 {
-    return g_trash_stack_height(&dead_progs);
+    return dead_prog_count;
 }
 
 size_t
 prog_count(bool total)
 {
     if (total)
-        return g_list_length(active_progs) + free_prog_count();
+        return active_prog_count + dead_prog_count;
     else
-        return g_list_length(active_progs);
+        return active_prog_count;
+}
+
+//
+// prog_sched_counts
+//
+// Counts the progs that are still running, the number of those that
+// are waiting for a later tick, and the number that will run on the
+// next pulse.
+void
+prog_sched_counts(size_t *active, size_t *sleeping, size_t *due)
+{
+    *active = *sleeping = *due = 0;
+    for (GList *cur = active_progs;cur;cur = cur->next) {
+        struct prog_env *env = cur->data;
+
+        if (env->exec_pt < 0)
+            continue;
+        *active += 1;
+        if (env->next_tick <= prog_tick)
+            *due += 1;
+        else
+            *sleeping += 1;
+    }
 }
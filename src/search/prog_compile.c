@@ -4,6 +4,7 @@
 #endif
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <ctype.h>
@@ -323,18 +324,184 @@ prog_lexify(struct prog_compiler_state *compiler)
 }
 
 void
-prog_compiler_emit(struct prog_compiler_state *compiler, int instr, void *data,
-    size_t data_len)
+prog_compiler_emit(struct prog_compiler_state *compiler, int instr,
+    const void *data, size_t data_len)
 {
-    *compiler->code->code_pt++ = instr;
+    struct prog_code_block *code = compiler->code;
+    size_t code_left, data_left;
+
+    code_left = code->code_seg + G_N_ELEMENTS(code->code_seg) - code->code_pt;
+    data_left = code->data_seg + sizeof(code->data_seg) - code->data_pt;
+    if (code_left < 2 || data_len > data_left) {
+        if (!compiler->error)
+            prog_compile_error(compiler,
+                (compiler->cur_token) ? compiler->cur_token->linenum : 0,
+                "Prog is too long to compile");
+        return;
+    }
+
+    *code->code_pt++ = instr;
     if (data_len) {
-        *compiler->code->code_pt++ =
-            compiler->code->data_pt - compiler->code->data_seg;
-        memcpy(compiler->code->data_pt, data, data_len);
-        compiler->code->data_pt += data_len;
+        *code->code_pt++ = code->data_pt - code->data_seg;
+        memcpy(code->data_pt, data, data_len);
+        code->data_pt += data_len;
     } else {
-        *compiler->code->code_pt++ = 0;
+        *code->code_pt++ = 0;
+    }
+}
+
+// Interns the first len characters of name, which need not be
+// terminated
+static gint32
+prog_intern_name(const char *name, size_t len)
+{
+    char key[256];
+
+    len = MIN(len, sizeof(key) - 1);
+    memcpy(key, name, len);
+    key[len] = '\0';
+
+    return prog_intern_symbol(key);
+}
+
+static void
+prog_template_add_text(GByteArray *tmpl, size_t offset, size_t len)
+{
+    guint8 kind = PROG_SEG_TEXT;
+    guint16 seg_offset = offset;
+    guint16 seg_len = len;
+
+    g_byte_array_append(tmpl, &kind, 1);
+    g_byte_array_append(tmpl, (guint8 *)&seg_offset, sizeof(seg_offset));
+    g_byte_array_append(tmpl, (guint8 *)&seg_len, sizeof(seg_len));
+}
+
+static void
+prog_template_add_var(GByteArray *tmpl, const char *args, size_t offset,
+    size_t len)
+{
+    guint8 kind = PROG_SEG_VAR;
+    guint16 name_offset = offset;
+    guint8 name_len = len;
+    gint32 sym = prog_intern_name(args + offset, len);
+
+    g_byte_array_append(tmpl, &kind, 1);
+    g_byte_array_append(tmpl, (guint8 *)&sym, sizeof(sym));
+    g_byte_array_append(tmpl, (guint8 *)&name_offset, sizeof(name_offset));
+    g_byte_array_append(tmpl, &name_len, 1);
+}
+
+static void
+prog_template_add_prefix(GByteArray *tmpl, const char *args, size_t offset,
+    size_t len)
+{
+    guint8 kind = PROG_SEG_PREFIX;
+    guint16 name_offset = offset;
+    guint8 name_len = len;
+    gint32 sym;
+    size_t i;
+
+    g_byte_array_append(tmpl, &kind, 1);
+    g_byte_array_append(tmpl, (guint8 *)&name_offset, sizeof(name_offset));
+    g_byte_array_append(tmpl, &name_len, 1);
+    for (i = 0; i < len; i++) {
+        sym = prog_intern_name(args + offset, i + 1);
+        g_byte_array_append(tmpl, (guint8 *)&sym, sizeof(sym));
+    }
+}
+
+static void
+prog_template_add_typo(GByteArray *tmpl)
+{
+    guint8 kind = PROG_SEG_TYPO;
+
+    g_byte_array_append(tmpl, &kind, 1);
+}
+
+//
+// prog_compile_template
+//
+// Splits an argument into literal text and variable references, so
+// that the variables can be substituted at run time without searching
+// the argument.  This follows the rules used by the old run-time
+// expansion: $$ is a literal $, ${name} is a reference to the
+// variable name, and a bare $ is followed by the longest variable
+// name that matches.  The argument itself is stored at the start of
+// the template, and the segments refer to it.
+static GByteArray *
+prog_compile_template(struct prog_compiler_state *compiler, int linenum,
+    const char *args)
+{
+    GByteArray *tmpl = g_byte_array_new();
+    const char *read_pt = args, *dollar, *end;
+    guint8 kind = PROG_SEG_END;
+
+    g_byte_array_append(tmpl, (const guint8 *)args, strlen(args) + 1);
+
+    while ((dollar = strchr(read_pt, '$')) != NULL) {
+        if (dollar > read_pt)
+            prog_template_add_text(tmpl, read_pt - args, dollar - read_pt);
+        read_pt = dollar + 1;
+        if (*read_pt == '$') {
+            // Double dollar expands to simple dollar sign
+            prog_template_add_text(tmpl, read_pt - args, 1);
+            read_pt++;
+        } else if (*read_pt == '{') {
+            read_pt++;
+            end = strchr(read_pt, '}');
+            if (!end) {
+                prog_compile_warning(compiler, linenum,
+                    "Invalid variable reference: no } found");
+                prog_template_add_typo(tmpl);
+                break;
+            }
+            if (end == read_pt || end - read_pt > 254) {
+                prog_compile_warning(compiler, linenum,
+                    "Invalid variable reference: bad variable name");
+                prog_template_add_typo(tmpl);
+            } else {
+                prog_template_add_var(tmpl, args, read_pt - args,
+                    end - read_pt);
+            }
+            read_pt = end + 1;
+        } else {
+            // Potential variable reference, which may be followed
+            // directly by more text
+            end = read_pt;
+            while (*end && *end != '$' && !isspace(*end)
+                && end - read_pt < 254)
+                end++;
+            if (end == read_pt)
+                prog_template_add_text(tmpl, dollar - args, 1);
+            else
+                prog_template_add_prefix(tmpl, args, read_pt - args,
+                    end - read_pt);
+            read_pt = end;
+        }
+    }
+    if (*read_pt)
+        prog_template_add_text(tmpl, read_pt - args, strlen(read_pt));
+    g_byte_array_append(tmpl, &kind, 1);
+
+    return tmpl;
+}
+
+static void
+prog_compile_arg(struct prog_compiler_state *compiler, int cmd,
+    const char *args)
+{
+    GByteArray *tmpl;
+
+    if (!strchr(args, '$')) {
+        prog_compiler_emit(compiler, cmd, args, strlen(args) + 1);
+        return;
     }
+
+    tmpl = prog_compile_template(compiler, compiler->cur_token->linenum,
+        args);
+    prog_compiler_emit(compiler, cmd | PROG_CMD_TEMPLATE, tmpl->data,
+        tmpl->len);
+    g_byte_array_free(tmpl, true);
 }
 
 void
@@ -361,10 +528,8 @@ prog_compile_statement(struct prog_compiler_state *compiler)
         compiler->cur_token = compiler->cur_token->next;
 
         if (compiler->cur_token && compiler->cur_token->kind == PROG_TOKEN_STR) {
-            prog_compiler_emit(compiler,
-                cmd - prog_cmds,
-                compiler->cur_token->str,
-                strlen(compiler->cur_token->str) + 1);
+            prog_compile_arg(compiler, cmd - prog_cmds,
+                compiler->cur_token->str);
             compiler->cur_token = compiler->cur_token->next;
         } else {
             prog_compiler_emit(compiler, cmd - prog_cmds, NULL, 0);
@@ -377,9 +542,7 @@ prog_compile_statement(struct prog_compiler_state *compiler)
             return;
         }
         // It's an in-game command with a mob, so emit the *do command
-        prog_compiler_emit(compiler,
-            PROG_CMD_DO,
-            compiler->cur_token->str, strlen(compiler->cur_token->str) + 1);
+        prog_compile_arg(compiler, PROG_CMD_DO, compiler->cur_token->str);
         compiler->cur_token = compiler->cur_token->next;
         break;
     default:
@@ -583,6 +746,7 @@ prog_compile_handler(struct prog_compiler_state *compiler)
 void
 prog_display_obj(struct creature *ch, unsigned char *exec)
 {
+    const char *arg;
     int cmd, arg_addr, read_pt;
     int cmd_count;
     int phase_idx, event_idx;
@@ -605,19 +769,102 @@ prog_display_obj(struct creature *ch, unsigned char *exec)
                     arg_addr = *((short *)(exec + read_pt) + 1);
                     // Set the execution point to the next command by default
                     read_pt += sizeof(short) * 2;
+                    if (cmd & PROG_CMD_TEMPLATE)
+                        arg = prog_template_text(exec + arg_addr);
+                    else
+                        arg = (char *)(exec + arg_addr);
+                    cmd &= PROG_CMD_MASK;
                     if (cmd < 0 || cmd >= cmd_count)
                         send_to_char(ch, "<INVALID CMD #%d>\r\n", cmd);
                     else
                         send_to_char(ch, "%-9s %s\n",
-                            tmp_toupper(prog_cmds[cmd].str),
-                            (char *)(exec + arg_addr));
+                            tmp_toupper(prog_cmds[cmd].str), arg);
                 }
             }
         }
 }
 
+//
+// prog_template_text
+//
+// Returns the original argument text of a compiled template
+const char *
+prog_template_text(const unsigned char *tmpl)
+{
+    return (const char *)tmpl;
+}
+
+static void
+prog_link_template(unsigned char *tmpl)
+{
+    const char *text = (const char *)tmpl;
+    unsigned char *read_pt = tmpl + strlen(text) + 1;
+    guint16 name_offset;
+    guint8 name_len;
+    gint32 sym;
+    int i;
+
+    while (*read_pt != PROG_SEG_END) {
+        switch (*read_pt++) {
+        case PROG_SEG_TEXT:
+            read_pt += 2 * sizeof(guint16);
+            break;
+        case PROG_SEG_VAR:
+            memcpy(&name_offset, read_pt + sizeof(sym), sizeof(name_offset));
+            name_len = read_pt[sizeof(sym) + sizeof(name_offset)];
+            sym = prog_intern_name(text + name_offset, name_len);
+            memcpy(read_pt, &sym, sizeof(sym));
+            read_pt += sizeof(sym) + sizeof(name_offset) + 1;
+            break;
+        case PROG_SEG_PREFIX:
+            memcpy(&name_offset, read_pt, sizeof(name_offset));
+            name_len = read_pt[sizeof(name_offset)];
+            read_pt += sizeof(name_offset) + 1;
+            for (i = 0; i < name_len; i++) {
+                sym = prog_intern_name(text + name_offset, i + 1);
+                memcpy(read_pt + i * sizeof(sym), &sym, sizeof(sym));
+            }
+            read_pt += name_len * sizeof(sym);
+            break;
+        case PROG_SEG_TYPO:
+            break;
+        default:
+            errlog("Invalid prog template segment %d", read_pt[-1]);
+            return;
+        }
+    }
+}
+
+//
+// prog_link
+//
+// Symbol numbers are only valid for the running process, so prog
+// object code that was compiled in another process (such as that
+// loaded from the world image) must be linked before it is run.
+void
+prog_link(unsigned char *obj)
+{
+    int phase_idx, event_idx, read_pt, cmd, arg_addr;
+
+    if (!obj)
+        return;
+
+    for (phase_idx = 0; phase_idx < PROG_PHASE_COUNT; phase_idx++)
+        for (event_idx = 0; event_idx < PROG_EVT_COUNT; event_idx++) {
+            read_pt = *((short *)obj + phase_idx * PROG_EVT_COUNT + event_idx);
+            if (!read_pt)
+                continue;
+            while ((cmd = *((short *)&obj[read_pt])) != PROG_CMD_ENDOFPROG) {
+                arg_addr = *((short *)&obj[read_pt] + 1);
+                if ((cmd & PROG_CMD_TEMPLATE) && arg_addr)
+                    prog_link_template(obj + arg_addr);
+                read_pt += sizeof(short) * 2;
+            }
+        }
+}
+
 unsigned char *
-prog_map_to_block(struct prog_compiler_state *compiler)
+prog_map_to_block(struct prog_compiler_state *compiler, size_t *len)
 {
     struct prog_code_block *cur_code;
     unsigned char *block;
@@ -650,8 +897,16 @@ prog_map_to_block(struct prog_compiler_state *compiler)
     code_len += 2;
     block_len += code_len * sizeof(unsigned short) + data_len;
 
+    // Code and data addresses are stored as shorts
+    if (block_len > SHRT_MAX) {
+        prog_compile_error(compiler, 0, "Prog is too long to compile");
+        *len = 0;
+        return NULL;
+    }
+
     // Allocate result block and clear it
     CREATE(block, unsigned char, block_len);
+    *len = block_len;
 
     // Assign initial offsets
     code_offset = PROG_PHASE_COUNT * PROG_EVT_COUNT * sizeof(short);
@@ -702,11 +957,13 @@ prog_map_to_block(struct prog_compiler_state *compiler)
 
 unsigned char *
 prog_compile_prog(struct creature *ch,
-    char *prog_text, void *owner, enum prog_evt_type owner_type)
+    char *prog_text, void *owner, enum prog_evt_type owner_type,
+    size_t *len)
 {
     struct prog_compiler_state state;
     unsigned char *obj = NULL;
 
+    *len = 0;
     if (!prog_text || !*prog_text)
         return NULL;
 
@@ -736,7 +993,7 @@ prog_compile_prog(struct creature *ch,
     if (!state.error) {
         // No error occurred - map entry table, object code, and data to
         // a single memory block...
-        obj = prog_map_to_block(&state);
+        obj = prog_map_to_block(&state, len);
     } else {
         // An error occurred - set the result to NULL
         obj = NULL;
@@ -759,22 +1016,25 @@ prog_compile(struct creature *ch, void *owner, enum prog_evt_type owner_type)
 {
     char *prog;
     unsigned char *obj;
+    size_t len = 0;
 
     // Get the prog
     prog = prog_get_text(owner, owner_type);
 
     // Compile the prog, if one exists.
-    obj = (prog) ? prog_compile_prog(ch, prog, owner, owner_type) : NULL;
+    obj = (prog) ? prog_compile_prog(ch, prog, owner, owner_type, &len) : NULL;
 
     // Set the object code of the owner
     switch (owner_type) {
     case PROG_TYPE_MOBILE:
         free(((struct creature *)owner)->mob_specials.shared->progobj);
         ((struct creature *)owner)->mob_specials.shared->progobj = obj;
+        ((struct creature *)owner)->mob_specials.shared->progobj_len = len;
         break;
     case PROG_TYPE_ROOM:
         free(((struct room_data *)owner)->progobj);
         ((struct room_data *)owner)->progobj = obj;
+        ((struct room_data *)owner)->progobj_len = len;
         break;
     case PROG_TYPE_OBJECT:
         break;
@@ -784,4 +1044,6 @@ prog_compile(struct creature *ch, void *owner, enum prog_evt_type owner_type)
 
     // Kill all the progs the owner has to avoid invalid code
     destroy_attached_progs(owner);
+
+    prog_register_owner(owner, owner_type);
 }
@@ -1,10 +1,17 @@
 #include <time.h>
 #include <math.h>
+#include <dirent.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "obj_data.h"
 #include "room_data.h"
 #include "creature.h"
+#include "gpqueue.h"
+#include "auction.h"
 
 const char *AUC_FILE_PATH = "etc/auctions.xml";
+const char *AUC_DIR_PATH = "etc/auctions";
 
 const int TOP_MOOD = 7;
 int GOING_ONCE = 45;
@@ -17,16 +24,6 @@ int MAX_AUCTIONS = 5;
 int MAX_TOTAL_AUC = 100;
 float BID_INCREMENT = 0.05;     // percent of starting bid
 
-enum auction_state {
-    AUCTION_STARTED = 0, /* initial state: auction needs to be announced */
-    AUCTION_ANNOUNCED, /* auction has been announced and is waiting for bids */
-    AUCTION_NO_BIDS, /* it's been announced that no bids have been made */
-    AUCTION_NEW_BID,   /* a bid has just been made */
-    AUCTION_BID_ANNOUNCED,   /* the new bid has been announced */
-    AUCTION_GOING_ONCE,      /* the bid has gone once */
-    AUCTION_GOING_TWICE,     /* the bid has gone twice */
-};
-
 const char *auction_state_strs[] = {
     "started", "announced", "no bids", "new bid", "bid announced", "going once",
     "going twice"
@@ -46,49 +43,17 @@ const char *moods[] = {
 
 ACMD(do_stun);
 
-void save_auctions(void);
-
-/**
- * bid_data:
- * @bidder_id: The idnum of the bidder
- * @past_amount: The amount of gold used in the bid
- * @future_amount: The amount of cash used in the bid
- **/
-struct bid_data {
-    long bidder_id;
-    money_t past_amount;
-    money_t future_amount;
-};
-
-/**
- * auction_data:
- * @idnum: a unique id number for the auction
- * @room_id: The room of the auctioneer holding this auction
- * @owner_id: The player ID of the owner of the item
- * @item: The object being auctioned
- * @start_bid: The minimum bid of the auction
- * @start_time: The time the auction started
- * @last_bid_time: The last time the bid was made
- * @new_bid: Whether the new bid announcement has been made
- * @new_item: Whether this auction has started
- * @announce_count: The state of the auction
- * @bids: A #GList of bids, sorted from greatest to least amount
- *
- **/
-struct auction_data {
-    uint32_t idnum;
-    long room_id;
-    long owner_id;
-    struct obj_data *item;
-    money_t start_bid;
-    time_t start_time;
-    time_t last_bid_time;
-    enum auction_state state;
-    GList *bids;
-};
-
 GList *auctions;
 
+// Auctions by idnum
+static GHashTable *auction_map = NULL;
+// Queues of auctions by the time of their next deadline, by room
+static GHashTable *auction_queues = NULL;
+// No auction has a greater idnum than this
+static uint32_t top_auction_idnum = 0;
+// The settings file still holds auctions not yet saved to their own files
+static bool settings_hold_auctions = false;
+
 #define PLURAL(num) (num == 1 ? "" : "s")
 
 money_t
@@ -121,6 +86,14 @@ describe_bid_amount(struct bid_data *bid)
 
 struct auction_data *
 auction_data_from_idnum(int idnum)
+{
+    if (!auction_map)
+        return NULL;
+    return g_hash_table_lookup(auction_map, GINT_TO_POINTER(idnum));
+}
+
+struct auction_data *
+auction_data_from_idnum_scan(int idnum)
 {
     for (GList *it = auctions;it;it = it->next) {
         struct auction_data *auc = it->data;
@@ -133,18 +106,17 @@ auction_data_from_idnum(int idnum)
 uint32_t
 unused_auction_idnum(void)
 {
-    uint32_t result = 1;
-    for (GList *it = auctions;it;it = it->next) {
-        struct auction_data *auc = it->data;
-        if (auc->idnum >= result)
-            result = auc->idnum + 1;
-    }
-    return result;
+    // One more than the greatest idnum in use, so the numbers start
+    // over once the auctions with high numbers are gone
+    while (top_auction_idnum > 0
+           && !auction_data_from_idnum(top_auction_idnum))
+        top_auction_idnum--;
+    return top_auction_idnum + 1;
 }
 
 /**
  * new_auction:
- * 
+ *
  * Allocate a blank initialized auction.
  *
  * Returns: An initialized #auction_data
@@ -156,10 +128,242 @@ new_auction(void)
 
     CREATE(new_ai, struct auction_data, 1);
     new_ai->state = AUCTION_STARTED;
+    new_ai->bids = g_ptr_array_new();
+    new_ai->bidders = g_hash_table_new(g_direct_hash, g_direct_equal);
 
     return new_ai;
 }
 
+static GPQueue *
+auction_queue(long room_id)
+{
+    return g_hash_table_lookup(auction_queues, GINT_TO_POINTER(room_id));
+}
+
+static void
+set_auction_queue(long room_id, GPQueue *queue)
+{
+    if (queue)
+        g_hash_table_insert(auction_queues, GINT_TO_POINTER(room_id), queue);
+    else
+        g_hash_table_remove(auction_queues, GINT_TO_POINTER(room_id));
+}
+
+/**
+ * auction_is_due:
+ * @auc: The auction being queried
+ * @now: The current time
+ *
+ * Returns: %true if the auctioneer has something to do with @auc at
+ * @now, either announcing it or ending it.
+ **/
+bool
+auction_is_due(struct auction_data *auc, time_t now)
+{
+    if (!auc->last_bid_time && now - auc->start_time > AUCTION_THRESH)
+        return true;
+
+    switch (auc->state) {
+    case AUCTION_STARTED:
+    case AUCTION_NEW_BID:
+        return true;
+    case AUCTION_ANNOUNCED:
+        return auc->bids->len == 0 && now - auc->start_time > NO_BID_THRESH;
+    case AUCTION_BID_ANNOUNCED:
+        return auc->last_bid_time && now - auc->last_bid_time > GOING_ONCE;
+    case AUCTION_GOING_ONCE:
+        return auc->last_bid_time && now - auc->last_bid_time > GOING_TWICE;
+    case AUCTION_GOING_TWICE:
+        return auc->last_bid_time && now - auc->last_bid_time > SOLD_TIME;
+    default:
+        return false;
+    }
+}
+
+/**
+ * auction_deadline:
+ * @auc: The auction being queried
+ *
+ * Returns: the first time at which auction_is_due() is true for @auc,
+ * or -1 if nothing will happen to it until a bid is made.
+ **/
+time_t
+auction_deadline(struct auction_data *auc)
+{
+    time_t deadline = -1;
+
+    switch (auc->state) {
+    case AUCTION_STARTED:
+    case AUCTION_NEW_BID:
+        return 0;
+    case AUCTION_ANNOUNCED:
+        if (auc->bids->len == 0)
+            deadline = auc->start_time + NO_BID_THRESH + 1;
+        break;
+    case AUCTION_BID_ANNOUNCED:
+        if (auc->last_bid_time)
+            deadline = auc->last_bid_time + GOING_ONCE + 1;
+        break;
+    case AUCTION_GOING_ONCE:
+        if (auc->last_bid_time)
+            deadline = auc->last_bid_time + GOING_TWICE + 1;
+        break;
+    case AUCTION_GOING_TWICE:
+        if (auc->last_bid_time)
+            deadline = auc->last_bid_time + SOLD_TIME + 1;
+        break;
+    default:
+        break;
+    }
+
+    if (!auc->last_bid_time) {
+        time_t expiry = auc->start_time + AUCTION_THRESH + 1;
+
+        if (deadline < 0 || expiry < deadline)
+            deadline = expiry;
+    }
+
+    return deadline;
+}
+
+// Deadlines are queued as seconds since boot, since the queue's
+// priorities are ints and would overflow as times
+static gint
+auction_priority(time_t when)
+{
+    time_t since_boot = when - boot_time;
+
+    return CLAMP(since_boot, G_MININT, G_MAXINT);
+}
+
+/**
+ * schedule_auction:
+ * @auc: The auction to schedule
+ *
+ * Puts the auction in the queue of its auctioneer's room, or moves it
+ * there, so that the auctioneer looks at it again at its deadline.
+ * Must be called whenever the deadline may have changed.
+ **/
+void
+schedule_auction(struct auction_data *auc)
+{
+    time_t deadline = auction_deadline(auc);
+    GPQueue *queue = auction_queue(auc->room_id);
+
+    if (deadline < 0) {
+        if (auc->deadline)
+            queue = g_pqueue_delete(queue, auc->deadline);
+        auc->deadline = NULL;
+    } else if (auc->deadline) {
+        queue = g_pqueue_change_priority(queue, auc->deadline,
+                                         auction_priority(deadline));
+    } else {
+        queue = g_pqueue_insert(queue, auc, auction_priority(deadline),
+                                &auc->deadline);
+    }
+    set_auction_queue(auc->room_id, queue);
+}
+
+/**
+ * due_auctions:
+ * @room_id: The room of the auctioneer
+ * @now: The current time
+ *
+ * Takes the auctions which are due at @now off the queue of @room_id.
+ * They must be rescheduled with schedule_auction() if they remain.
+ *
+ * Returns: a #GList of the due auctions, which the caller must free
+ **/
+GList *
+due_auctions(long room_id, time_t now)
+{
+    GPQueue *queue;
+    struct auction_data *auc;
+    gint deadline;
+    GList *result = NULL;
+
+    if (!auction_queues)
+        return NULL;
+
+    queue = auction_queue(room_id);
+    while (g_pqueue_top_extended(queue, (gpointer *)&auc, &deadline)
+           && deadline <= auction_priority(now)) {
+        queue = g_pqueue_delete_top(queue);
+        auc->deadline = NULL;
+        result = g_list_prepend(result, auc);
+    }
+    set_auction_queue(room_id, queue);
+
+    return g_list_reverse(result);
+}
+
+/**
+ * due_auctions_scan:
+ * @room_id: The room of the auctioneer
+ * @now: The current time
+ *
+ * Finds the auctions which are due at @now by looking at every
+ * auction, as the auctioneer used to on each tick.
+ *
+ * Returns: a #GList of the due auctions, which the caller must free
+ **/
+GList *
+due_auctions_scan(long room_id, time_t now)
+{
+    GList *result = NULL;
+
+    for (GList *ai = auctions;ai;ai = ai->next) {
+        struct auction_data *auc = ai->data;
+
+        if (auc->room_id == room_id && auction_is_due(auc, now))
+            result = g_list_prepend(result, auc);
+    }
+
+    return g_list_reverse(result);
+}
+
+/**
+ * add_auction:
+ * @auc: The auction to add
+ *
+ * Adds an auction to the collection and schedules it with the
+ * auctioneer of its room.
+ **/
+void
+add_auction(struct auction_data *auc)
+{
+    if (!auction_map) {
+        auction_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+        auction_queues = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+    auctions = g_list_append(auctions, auc);
+    g_hash_table_insert(auction_map, GINT_TO_POINTER(auc->idnum), auc);
+    if (auc->idnum > top_auction_idnum)
+        top_auction_idnum = auc->idnum;
+    schedule_auction(auc);
+}
+
+/**
+ * remove_auction:
+ * @auc: The auction to remove
+ *
+ * Removes an auction from the collection, without freeing it or
+ * touching its file.
+ **/
+void
+remove_auction(struct auction_data *auc)
+{
+    auctions = g_list_remove(auctions, auc);
+    g_hash_table_remove(auction_map, GINT_TO_POINTER(auc->idnum));
+    if (auc->deadline) {
+        set_auction_queue(auc->room_id,
+                          g_pqueue_delete(auction_queue(auc->room_id),
+                                          auc->deadline));
+        auc->deadline = NULL;
+    }
+}
+
 /**
  * add_new_auction
  * @room_id: Number of the auctioneer's room
@@ -182,8 +386,9 @@ add_new_auction(long room_id, long seller_id, money_t start_bid, struct obj_data
     new_ai->item = obj;
     new_ai->start_time = time(NULL);
     new_ai->start_bid = start_bid;
+    new_ai->dirty = true;
 
-    auctions = g_list_append(auctions, new_ai);
+    add_auction(new_ai);
     save_auctions();
 
     return new_ai;
@@ -198,13 +403,76 @@ add_new_auction(long room_id, long seller_id, money_t start_bid, struct obj_data
 void
 free_auction(struct auction_data *auc)
 {
-    g_list_foreach(auc->bids, (GFunc)free, NULL);
+    g_ptr_array_foreach(auc->bids, (GFunc)free, NULL);
+    g_ptr_array_free(auc->bids, true);
+    g_hash_table_destroy(auc->bidders);
     if (auc->item) {
         extract_obj(auc->item);
     }
     free(auc);
 }
 
+static void
+swap_bids(GPtrArray *heap, guint a, guint b)
+{
+    struct bid_data *bid_a = g_ptr_array_index(heap, a);
+    struct bid_data *bid_b = g_ptr_array_index(heap, b);
+
+    g_ptr_array_index(heap, a) = bid_b;
+    bid_b->heap_index = a;
+    g_ptr_array_index(heap, b) = bid_a;
+    bid_a->heap_index = b;
+}
+
+// Bids only ever grow, so a changed bid can only move toward the top
+// of the heap.  Equal bids stay behind the one which got there first.
+static void
+raise_bid(GPtrArray *heap, struct bid_data *bid)
+{
+    while (bid->heap_index > 0) {
+        guint parent = (bid->heap_index - 1) / 2;
+
+        if (bid_total(g_ptr_array_index(heap, parent)) >= bid_total(bid))
+            break;
+        swap_bids(heap, parent, bid->heap_index);
+    }
+}
+
+/**
+ * add_auction_bid:
+ * @auc: The auction to bid on
+ * @bidder_id: The idnum of the bidder
+ * @past_amount: The gold to add to the bid
+ * @future_amount: The cash to add to the bid
+ *
+ * Adds to the bidder's bid on the auction, making the bid if they
+ * haven't bid yet.  No money is taken from the bidder.
+ *
+ * Returns: The bid
+ **/
+struct bid_data *
+add_auction_bid(struct auction_data *auc,
+                long bidder_id,
+                money_t past_amount,
+                money_t future_amount)
+{
+    struct bid_data *bid = bid_by_bidder_idnum(auc, bidder_id);
+
+    if (!bid) {
+        CREATE(bid, struct bid_data, 1);
+        bid->bidder_id = bidder_id;
+        bid->heap_index = auc->bids->len;
+        g_ptr_array_add(auc->bids, bid);
+        g_hash_table_insert(auc->bidders, GINT_TO_POINTER(bidder_id), bid);
+    }
+    bid->past_amount += past_amount;
+    bid->future_amount += future_amount;
+    raise_bid(auc->bids, bid);
+    auc->dirty = true;
+
+    return bid;
+}
+
 /**
  * load_auction_from_xml
  * @path: The path of the XML file, used for error reporting
@@ -218,7 +486,7 @@ free_auction(struct auction_data *auc)
 struct auction_data *
 load_auction_from_xml(const char *path, xmlNodePtr node)
 {
-    if (!xmlMatches(node->name, "itemdata")) {
+    if (!node || !xmlMatches(node->name, "itemdata")) {
         return NULL;
     }
     struct auction_data *new_ai = new_auction();
@@ -226,7 +494,8 @@ load_auction_from_xml(const char *path, xmlNodePtr node)
     new_ai->owner_id = xmlGetIntProp(node, "owner_id", 0);
     new_ai->start_bid = xmlGetIntProp(node, "start_bid", 0);
     new_ai->idnum = xmlGetIntProp(node, "id", 0);
-    new_ai->start_time = time(NULL);
+    new_ai->start_time = xmlGetLongProp(node, "start_time", time(NULL));
+    new_ai->last_bid_time = xmlGetLongProp(node, "last_bid_time", 0);
 
     for (xmlNodePtr cnode = node->xmlChildrenNode;
          cnode; cnode = cnode->next) {
@@ -237,21 +506,77 @@ load_auction_from_xml(const char *path, xmlNodePtr node)
                 continue;
             }
         } else if (xmlMatches(cnode->name, "bid")) {
-            struct bid_data *bid;
-            CREATE(bid, struct bid_data, 1);
-            bid->bidder_id = xmlGetIntProp(cnode, "bidder", -1);
-            bid->past_amount = xmlGetIntProp(cnode, "past_amount", 0);
-            bid->future_amount = xmlGetIntProp(cnode, "future_amount", 0);
-            new_ai->bids = g_list_prepend(new_ai->bids, bid);
+            add_auction_bid(new_ai,
+                            xmlGetIntProp(cnode, "bidder", -1),
+                            xmlGetIntProp(cnode, "past_amount", 0),
+                            xmlGetIntProp(cnode, "future_amount", 0));
         }
     }
+
+    // An auction with bids is taken up again from its last bid, so
+    // that it is sold rather than left to expire
+    if (new_ai->bids->len > 0) {
+        if (!new_ai->last_bid_time)
+            new_ai->last_bid_time = time(NULL);
+        new_ai->state = AUCTION_NEW_BID;
+    }
+    new_ai->dirty = false;
+
     return new_ai;
 }
 
+static char *
+auction_file_path(uint32_t idnum)
+{
+    return tmp_sprintf("%s/%" PRIu32 ".xml", AUC_DIR_PATH, idnum);
+}
+
+/**
+ * load_auction_files:
+ *
+ * Loads each auction from its own file in #AUC_DIR_PATH.
+ **/
+static void
+load_auction_files(void)
+{
+    DIR *dir = opendir(AUC_DIR_PATH);
+    struct dirent *file;
+
+    if (!dir) {
+        mkdir(AUC_DIR_PATH, 0755);
+        return;
+    }
+
+    while ((file = readdir(dir)) != NULL) {
+        char *ext = rindex(file->d_name, '.');
+
+        if (!ext || strcmp(ext, ".xml"))
+            continue;
+
+        char *path = tmp_sprintf("%s/%s", AUC_DIR_PATH, file->d_name);
+        xmlDocPtr doc = xmlParseFileWithLog(path);
+        if (!doc)
+            continue;
+
+        struct auction_data *auc =
+            load_auction_from_xml(path, xmlDocGetRootElement(doc));
+        xmlFreeDoc(doc);
+        if (!auc || !auc->idnum || auction_data_from_idnum(auc->idnum)) {
+            errlog("Invalid auction file %s", path);
+            if (auc)
+                free_auction(auc);
+            continue;
+        }
+        add_auction(auc);
+    }
+    closedir(dir);
+}
+
 /**
  * load_auctions_from_doc:
  *
- * Loads auctions from an XML document
+ * Loads the auctioneer settings from an XML document, along with any
+ * auctions still kept in it by older versions.
  *
  * Returns: %true if loading was successful
  **/
@@ -259,6 +584,8 @@ bool
 load_auctions_from_doc(xmlDocPtr doc)
 {
     xmlNodePtr root = xmlDocGetRootElement(doc);
+    GList *unnumbered = NULL;
+
     if (!root) {
         xmlFreeDoc(doc);
         errlog("XML file %s is empty", AUC_FILE_PATH);
@@ -273,86 +600,178 @@ load_auctions_from_doc(xmlDocPtr doc)
     MAX_AUC_VALUE = xmlGetIntProp(root, "max_auc_value", 0);
     MAX_AUCTIONS = xmlGetIntProp(root, "max_auctions", 0);
     MAX_TOTAL_AUC = xmlGetIntProp(root, "max_total_auc", 0);
-    BID_INCREMENT =
-        (float)atof((char *)xmlGetProp(root, (xmlChar *) "bid_increment"));
+    BID_INCREMENT = xmlGetFloatProp(root, "bid_increment", 0);
 
     for (xmlNodePtr node = root->xmlChildrenNode; node; node = node->next) {
         struct auction_data *new_ai = load_auction_from_xml(AUC_FILE_PATH, node);
-        if (new_ai) {
-            auctions = g_list_append(auctions, new_ai);
+        if (!new_ai) {
+            continue;
+        }
+        // Auctions that already have their own file were moved there
+        // before the settings could be rewritten
+        if (new_ai->idnum && auction_data_from_idnum(new_ai->idnum)) {
+            free_auction(new_ai);
+            continue;
         }
+        new_ai->dirty = true;
+        settings_hold_auctions = true;
+        if (new_ai->idnum)
+            add_auction(new_ai);
+        else
+            unnumbered = g_list_prepend(unnumbered, new_ai);
     }
+    xmlFreeDoc(doc);
 
-    for (GList *it = auctions;it;it = it->next) {
+    unnumbered = g_list_reverse(unnumbered);
+    for (GList *it = unnumbered;it;it = it->next) {
         struct auction_data *auc = it->data;
-        if (auc->idnum == 0) {
-            auc->idnum = unused_auction_idnum();
-        }
+        auc->idnum = unused_auction_idnum();
+        add_auction(auc);
+    }
+    g_list_free(unnumbered);
+
+    return true;
+}
+
+/**
+ * save_auction_settings
+ *
+ * Saves the auctioneer settings to an XML file at #AUC_FILE_PATH.
+ *
+ * Returns: %true if the settings were saved
+ **/
+static bool
+save_auction_settings(void)
+{
+    FILE *ouf = fopen(AUC_FILE_PATH, "w");
+
+    if (!ouf) {
+        errlog("Can't write to auction file %s: %s",
+               AUC_FILE_PATH, strerror(errno));
+        return false;
     }
 
+    fprintf(ouf, "<?xml version=\"1.0\"?>\n");
+    fprintf(ouf, "<auctioneer going_once=\"%d\" going_twice=\"%d\" "
+        "sold_time=\"%d\" nobid_thresh=\"%d\" auction_thresh=\"%d\" "
+        "max_auc_value=\"%d\" max_auctions=\"%d\" "
+        "max_total_auc=\"%d\" bid_increment=\"%f\"/>\n", GOING_ONCE,
+        GOING_TWICE, SOLD_TIME, NO_BID_THRESH, AUCTION_THRESH,
+        MAX_AUC_VALUE, MAX_AUCTIONS, MAX_TOTAL_AUC, BID_INCREMENT);
+    if (fclose(ouf)) {
+        errlog("Can't write to auction file %s: %s",
+               AUC_FILE_PATH, strerror(errno));
+        return false;
+    }
     return true;
 }
 
 /**
  * load_auctions:
  *
- * Loads auctions from the XML file at #AUC_FILE_PATH.
+ * Loads the auctions from their files in #AUC_DIR_PATH, and the
+ * settings from the XML file at #AUC_FILE_PATH.  Auctions found in the
+ * settings file are moved to their own files.
  *
  * Returns: %true if loading was successful
  **/
 bool
-load_auctions()
+load_auctions(void)
 {
+    load_auction_files();
+
     xmlDocPtr doc = xmlParseFileWithLog(AUC_FILE_PATH);
     if (!doc) {
         return false;
     }
 
-    return load_auctions_from_doc(doc);
+    if (!load_auctions_from_doc(doc)) {
+        return false;
+    }
+
+    // Only the auctions moved out of the settings file need saving
+    save_auctions();
+
+    return true;
 }
 
 /**
- * save_auctions
- * 
- * Saves all auctions to an XML file at #AUC_FILE_PATH.
+ * save_auction
+ * @auc: The auction to save
+ *
+ * Saves the auction to its own file in #AUC_DIR_PATH.  The file is
+ * replaced only once the new one is completely written.
  *
+ * Returns: %true if the auction was saved
  **/
-void
-save_auctions(void)
+static bool
+save_auction(struct auction_data *auc)
 {
-    FILE *ouf = fopen(AUC_FILE_PATH, "w");
+    char *path = auction_file_path(auc->idnum);
+    char *new_path = tmp_strcat(path, ".new", NULL);
+    FILE *ouf = fopen(new_path, "w");
 
     if (!ouf) {
         errlog("Can't write to auction file %s: %s",
-               AUC_FILE_PATH, strerror(errno));
-        return;
+               new_path, strerror(errno));
+        return false;
     }
 
     fprintf(ouf, "<?xml version=\"1.0\"?>\n");
-    fprintf(ouf, "<auctioneer going_once=\"%d\" going_twice=\"%d\" "
-        "sold_time=\"%d\" nobid_thresh=\"%d\" auction_thresh=\"%d\" "
-        "max_auc_value=\"%d\" max_auctions=\"%d\" "
-        "max_total_auc=\"%d\" bid_increment=\"%f\">\n", GOING_ONCE,
-        GOING_TWICE, SOLD_TIME, NO_BID_THRESH, AUCTION_THRESH,
-        MAX_AUC_VALUE, MAX_AUCTIONS, MAX_TOTAL_AUC, BID_INCREMENT);
+    fprintf(ouf, "<itemdata id=\"%" PRIu32 "\" room_id=\"%ld\" owner_id=\"%ld\" start_bid=\"%" PRId64 "\" start_time=\"%ld\" last_bid_time=\"%ld\">\n",
+            auc->idnum, auc->room_id, auc->owner_id, auc->start_bid,
+            (long)auc->start_time, (long)auc->last_bid_time);
+    save_object_to_xml(auc->item, ouf);
+    for (guint i = 0;i < auc->bids->len;i++) {
+        struct bid_data *bid = g_ptr_array_index(auc->bids, i);
+        fprintf(ouf, "  <bid bidder=\"%ld\"  past_amount=\"%" PRId64 "\" future_amount=\"%" PRId64 "\"/>\n",
+                bid->bidder_id,
+                bid->past_amount,
+                bid->future_amount);
+    }
+    fprintf(ouf, "</itemdata>\n");
+
+    if (fclose(ouf) || rename(new_path, path)) {
+        errlog("Can't write to auction file %s: %s",
+               path, strerror(errno));
+        unlink(new_path);
+        return false;
+    }
+
+    auc->dirty = false;
+    return true;
+}
+
+/**
+ * save_auctions
+ *
+ * Saves each auction which has changed since it was last saved.  The
+ * settings file is rewritten without the auctions it held once every
+ * one of them has been saved to its own file.
+ *
+ * Returns: the number of auctions saved
+ **/
+int
+save_auctions(void)
+{
+    bool all_saved = true;
+    int count = 0;
 
     for (GList * ai = auctions; ai; ai = ai->next) {
         struct auction_data *auc = ai->data;
 
-        fprintf(ouf, "<itemdata id=\"%" PRIu32 "\" room_id=\"%ld\" owner_id=\"%ld\" start_bid=\"%" PRId64 "\">\n",
-                auc->idnum, auc->room_id, auc->owner_id, auc->start_bid);
-        save_object_to_xml(auc->item, ouf);
-        for (GList *it = auc->bids;it;it = it->next) {
-            struct bid_data *bid = it->data;
-            fprintf(ouf, "  <bid bidder=\"%ld\"  past_amount=\"%" PRId64 "\" future_amount=\"%" PRId64 "\"/>\n",
-                    bid->bidder_id,
-                    bid->past_amount,
-                    bid->future_amount);
-        }
-        fprintf(ouf, "</itemdata>\n");
+        if (!auc->dirty)
+            continue;
+        if (save_auction(auc))
+            count++;
+        else
+            all_saved = false;
     }
-    fprintf(ouf, "</auctioneer>");
-    fclose(ouf);
+
+    if (settings_hold_auctions && all_saved)
+        settings_hold_auctions = !save_auction_settings();
+
+    return count;
 }
 
 /**
@@ -364,11 +783,11 @@ save_auctions(void)
 struct bid_data *
 auction_winning_bid(struct auction_data *auc)
 {
-    if (auc->bids == NULL) {
+    if (auc->bids->len == 0) {
         return NULL;
     }
 
-    return (struct bid_data *)auc->bids->data;
+    return g_ptr_array_index(auc->bids, 0);
 }
 
 /**
@@ -429,15 +848,7 @@ auction_minimum_bid(struct auction_data *auc)
 struct bid_data *
 bid_by_bidder_idnum(struct auction_data *auc, long idnum)
 {
-    for (GList *it = auc->bids;it;it = it->next) {
-        struct bid_data *bid = it->data;
-
-        if (bid->bidder_id == idnum) {
-            return bid;
-        }
-    }
-
-    return NULL;
+    return g_hash_table_lookup(auc->bidders, GINT_TO_POINTER(idnum));
 }
 
 /**
@@ -477,7 +888,7 @@ reversed_compare_bids(struct bid_data *a, struct bid_data *b)
 {
     money_t a_total = bid_total(a);
     money_t b_total = bid_total(b);
-    
+
     if (a_total < b_total)
         return 1;
     if (a_total > b_total)
@@ -519,7 +930,7 @@ make_bid(struct auction_data *auc, struct creature *ch, money_t amount)
         deduct_past = MIN(GET_PAST_BANK(ch), deduct_amt);
         deduct_amt -= deduct_past;
     }
-    
+
     if (deduct_amt != 0) {
         errlog("Bidder couldn't pay in make_bid()");
         return;
@@ -532,17 +943,10 @@ make_bid(struct auction_data *auc, struct creature *ch, money_t amount)
         withdraw_future_bank(ch->account, deduct_future);
     }
 
-    if (bid) {
-        bid->past_amount += deduct_past;
-        bid->future_amount += deduct_future;
-        auc->bids = g_list_sort(auc->bids, (GCompareFunc)reversed_compare_bids);
-    } else {
-        CREATE(bid, struct bid_data, 1);
-        bid->bidder_id = GET_IDNUM(ch);
-        bid->past_amount = deduct_past;
-        bid->future_amount = deduct_future;
-        auc->bids = g_list_prepend(auc->bids, bid);
-    }
+    add_auction_bid(auc, GET_IDNUM(ch), deduct_past, deduct_future);
+    auc->last_bid_time = time(NULL);
+    auc->state = AUCTION_NEW_BID;
+    schedule_auction(auc);
     save_auctions();
 }
 
@@ -599,13 +1003,20 @@ can_auction_obj(struct obj_data *obj)
             || obj->shared->vnum == -1);
 }
 
+/**
+ * end_auction:
+ * @auc: The auction to end
+ *
+ * Removes the auction from the collection and deletes its file.  The
+ * item must have been disposed of already.
+ **/
 void
 end_auction(struct auction_data *auc)
 {
-    auctions = g_list_remove(auctions, auc);
+    remove_auction(auc);
+    unlink(auction_file_path(auc->idnum));
     auc->item = NULL;
     free_auction(auc);
-    save_auctions();
 }
 
 ACMD(do_bidstat)
@@ -670,8 +1081,6 @@ ACMD(do_bid)
     }
 
     make_bid(auc, ch, amount);
-    auc->last_bid_time = time(NULL);
-    auc->state = AUCTION_NEW_BID;
 
     send_to_char(ch, "Your bid has been entered.\r\n");
 }
@@ -698,7 +1107,7 @@ ACMD(do_bidlist)
                     tmp_capitalize(obj_cond_color(auc->item, COLOR_LEV(ch))));
         acc_sprintf("%sStarting Bid:%s  %'" PRId64 " coins/cash\r\n",
             CCCYN(ch, C_NRM), CCNRM(ch, C_NRM), auc->start_bid);
-        if (auc->bids == NULL) {
+        if (auc->bids->len == 0) {
             acc_sprintf("%sCurrent Bid:%s   None\r\n",
                         CCCYN(ch, C_NRM), CCNRM(ch, C_NRM));
         } else {
@@ -709,7 +1118,7 @@ ACMD(do_bidlist)
         acc_sprintf("%sMinimum Bid:%s  %'" PRId64 " coins/cash\r\n",
                     CCCYN(ch, C_NRM), CCNRM(ch, C_NRM), auction_minimum_bid(auc));
         time_t time_left = 0;
-        if (auc->bids)
+        if (auc->bids->len > 0)
             time_left = (auc->last_bid_time + SOLD_TIME) - time(NULL);
         else
             time_left = (auc->start_time + AUCTION_THRESH) - time(NULL);
@@ -757,19 +1166,15 @@ auctioneer_tick(struct creature *self)
 {
     int mood_index;
     char *auc_str = NULL;
-    GList *next_ai;
+    time_t now = time(NULL);
+    GList *due = due_auctions(self->in_room->number, now);
 
-    for (GList * ai = auctions; ai; ai = next_ai) {
-        next_ai = ai->next;
+    for (GList * ai = due; ai; ai = ai->next) {
         struct auction_data *auc = ai->data;
         struct bid_data *winning_bid = auction_winning_bid(auc);
 
-        if (auc->room_id != self->in_room->number) {
-            continue;
-        }
-
         if ((!auc->last_bid_time) &&
-            (time(NULL) - auc->start_time) > AUCTION_THRESH) {
+            (now - auc->start_time) > AUCTION_THRESH) {
             auc_str = tmp_sprintf("Item number %d, %s is no longer "
                                   "available for bids!", auc->idnum, auc->item->name);
             auction_mail(self, auc->owner_id, auc->item,
@@ -780,7 +1185,6 @@ auctioneer_tick(struct creature *self)
                          self->in_room->name,
                          GET_NAME(self));
             end_auction(auc);
-            save_auctions();
             continue;
         }
 
@@ -794,7 +1198,7 @@ auctioneer_tick(struct creature *self)
             auc->state = AUCTION_ANNOUNCED;
             break;
         case AUCTION_ANNOUNCED:
-            if (auc->bids == NULL && (time(NULL) - auc->start_time) > NO_BID_THRESH) {
+            if (auc->bids->len == 0 && (now - auc->start_time) > NO_BID_THRESH) {
                 auc_str = tmp_sprintf("No bids yet for Item number %d, %s! "
                                       "Do I hear %'" PRId64 " coins?",
                                       auc->idnum, auc->item->name, auc->start_bid);
@@ -809,7 +1213,7 @@ auctioneer_tick(struct creature *self)
             break;
         case AUCTION_BID_ANNOUNCED:
             if (auc->last_bid_time &&
-                (time(NULL) - auc->last_bid_time) > GOING_ONCE) {
+                (now - auc->last_bid_time) > GOING_ONCE) {
                 auc_str = tmp_sprintf("Item number %d, %s, Going once!",
                                       auc->idnum, auc->item->name);
                 auc->state = AUCTION_GOING_ONCE;
@@ -817,7 +1221,7 @@ auctioneer_tick(struct creature *self)
             break;
         case AUCTION_GOING_ONCE:
             if (auc->last_bid_time &&
-                (time(NULL) - auc->last_bid_time) > GOING_TWICE) {
+                (now - auc->last_bid_time) > GOING_TWICE) {
                 auc_str = tmp_sprintf("Item number %d, %s, Going TWICE!",
                                       auc->idnum, auc->item->name);
                 auc->state = AUCTION_GOING_TWICE;
@@ -825,7 +1229,7 @@ auctioneer_tick(struct creature *self)
             break;
         case AUCTION_GOING_TWICE:
             if (auc->last_bid_time
-                && (time(NULL) - auc->last_bid_time) > SOLD_TIME) {
+                && (now - auc->last_bid_time) > SOLD_TIME) {
                 auc_str = tmp_sprintf("Item number %d, %s, SOLD!",
                                       auc->idnum, auc->item->name);
                 slog("AUCTION: %s (#%d) has been sold to %s (#%ld)",
@@ -852,8 +1256,8 @@ auctioneer_tick(struct creature *self)
                              GET_NAME(self));
 
                 // Refund losing bids
-                for (GList *it = auc->bids;it;it = it->next) {
-                    struct bid_data *bid = it->data;
+                for (guint i = 0;i < auc->bids->len;i++) {
+                    struct bid_data *bid = g_ptr_array_index(auc->bids, i);
                     if (bid != winning_bid) {
                         refund_bid(bid);
                         auction_mail(self, bid->bidder_id, NULL,
@@ -876,10 +1280,8 @@ auctioneer_tick(struct creature *self)
                              self->in_room->name,
                              GET_NAME(self));
 
-                auc->item = NULL;
-                auctions = g_list_delete_link(auctions, ai);
-                free_auction(auc);
-                save_auctions();
+                end_auction(auc);
+                auc = NULL;
             }
             break;
         default:
@@ -893,7 +1295,12 @@ auctioneer_tick(struct creature *self)
             GET_MOOD(self) = NULL;
             auc_str = NULL;
         }
+
+        if (auc) {
+            schedule_auction(auc);
+        }
     }
+    g_list_free(due);
 
     return 1;
 }
@@ -919,8 +1326,8 @@ auctioneer_stat(struct creature *self, struct creature *ch, char *argument)
                     player_name_by_idnum(auc->owner_id));
         acc_sprintf("%sHigh Bidder:%s   %s\r\n",
                     CCCYN(ch, C_NRM), CCNRM(ch, C_NRM),
-                    (auc->bids) ?
-                    player_name_by_idnum(((struct bid_data *)auc->bids->data)->bidder_id) : "NULL");
+                    (auction_winning_bid(auc)) ?
+                    player_name_by_idnum(auction_winning_bid(auc)->bidder_id) : "NULL");
         acc_sprintf("%sItem:%s          %s\r\n",
                     CCCYN(ch, C_NRM), CCNRM(ch, C_NRM), auc->item->name);
         acc_sprintf("%sStart Time:%s    %s",
@@ -935,12 +1342,18 @@ auctioneer_stat(struct creature *self, struct creature *ch, char *argument)
         acc_sprintf("%sMinimum Bid:%s  %'" PRId64 " coins/cash\r\n",
                     CCCYN(ch, C_NRM), CCNRM(ch, C_NRM), auction_minimum_bid(auc));
         acc_sprintf("Auction state:      %s\r\n", auction_state_strs[auc->state]);
-        for (GList *it = auc->bids;it != NULL;it = it->next) {
+        GList *bids = NULL;
+        for (guint i = 0;i < auc->bids->len;i++) {
+            bids = g_list_prepend(bids, g_ptr_array_index(auc->bids, i));
+        }
+        bids = g_list_sort(bids, (GCompareFunc)reversed_compare_bids);
+        for (GList *it = bids;it != NULL;it = it->next) {
             struct bid_data *bid = it->data;
             acc_sprintf("%s bid a total of %'" PRId64 "\r\n",
                         player_name_by_idnum(bid->bidder_id),
                         bid->past_amount + bid->future_amount);
         }
+        g_list_free(bids);
 
        if (ai->next) {
             acc_strcat("---------------------------------------\r\n", NULL);
@@ -1046,7 +1459,13 @@ auctioneer_aucset(struct creature *self, struct creature *ch, char *argument)
         break;
     }
 
-    save_auctions();
+    // The deadlines of the auctions depend on the times
+    g_list_foreach(auctions, (GFunc)schedule_auction, NULL);
+    // Auctions still in the settings file mustn't be written over
+    if (settings_hold_auctions)
+        save_auctions();
+    else
+        save_auction_settings();
     return 1;
 }
 
@@ -1164,15 +1583,14 @@ auctioneer_withdraw(struct creature *self, struct creature *ch, char *argument)
         return 1;
     }
 
-    if (auc->bids != NULL && !IS_IMMORT(ch)) {
+    if (auc->bids->len > 0 && !IS_IMMORT(ch)) {
         send_to_char(ch, "You cannot withdraw an item that has bids\r\n");
         return 1;
     }
 
     if (auc->item == NULL) {
         send_to_char(ch, "Something bad just happened. Please report it!");
-        auctions = g_list_remove(auctions, auc);
-        free(auc);
+        end_auction(auc);
         return 1;
     }
 
@@ -1183,9 +1601,8 @@ auctioneer_withdraw(struct creature *self, struct creature *ch, char *argument)
     GET_MOOD(self) = NULL;
 
     obj_to_char(obj, ch);
-    auctions = g_list_remove(auctions, auc);
+    end_auction(auc);
     crashsave(ch);
-    save_auctions();
 
     send_to_char(ch, "Your item has been withdrawn from auction.\r\n");
     slog("AUCTION: %s (#%ld) has withdrawn %s (#%d)",
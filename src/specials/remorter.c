@@ -85,6 +85,7 @@ do_pass_remort_test(struct creature *ch)
         PLR_OLCGOD);
 
     GET_INVIS_LVL(ch) = 0;
+    invalidate_sight();
     GET_COND(ch, DRUNK) = 0;
     GET_COND(ch, FULL) = 0;
     GET_COND(ch, THIRST) = 0;
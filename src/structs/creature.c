@@ -37,6 +37,8 @@
 #include "quest.h"
 #include "help.h"
 #include "paths.h"
+#include "memstat.h"
+#include "vendor.h"
 
 void extract_norents(struct obj_data *obj);
 void char_arrest_pardoned(struct creature *ch);
@@ -48,10 +50,11 @@ make_creature(bool pc)
 {
     struct creature *ch;
 
-    CREATE(ch, struct creature, 1);
+    CREATE_KIND(ch, struct creature, 1, MEM_CREATURE);
 
     if (pc) {
-        CREATE(ch->player_specials, struct player_special_data, 1);
+        CREATE_KIND(ch->player_specials, struct player_special_data, 1,
+                    MEM_CREATURE);
         ch->player_specials->desc_mode = CXN_UNKNOWN;
     } else {
         ch->player_specials = &dummy_mob;
@@ -128,6 +131,9 @@ reset_creature(struct creature *ch)
             free(ch->player.long_descr);
         if (ch->player.description != tmp_mob->player.description)
             free(ch->player.description);
+        // Vendors keep their stock listing in their shop data
+        if (ch->mob_specials.func_data && GET_NPC_SPEC(ch) == vendor)
+            vendor_free_stock(ch->mob_specials.func_data);
         free(ch->mob_specials.func_data);
         prog_state_free(ch->prog_state);
     } else {
@@ -160,7 +166,9 @@ reset_creature(struct creature *ch)
         g_list_foreach(GET_GRIEVANCES(ch), (GFunc)free, NULL);
         g_list_free(GET_GRIEVANCES(ch));
         GET_GRIEVANCES(ch) = NULL;
-        free(ch->player_specials);
+        free(ch->player_specials->role_bits);
+        free(ch->player_specials->cmd_bits);
+        FREE_KIND(ch->player_specials, MEM_CREATURE);
 
         if (IS_NPC(ch)) {
             errlog("Mob had player_specials allocated!");
@@ -171,6 +179,7 @@ reset_creature(struct creature *ch)
     // next remove all the combat ch creature might be involved in
     //
     remove_all_combat(ch);
+    remove_combatant(ch);
 
     memset(ch, 0, sizeof(struct creature));
 
@@ -185,7 +194,8 @@ reset_creature(struct creature *ch)
         ch->points.max_mana = 100;
 
     if (is_pc) {
-        CREATE(ch->player_specials, struct player_special_data, 1);
+        CREATE_KIND(ch->player_specials, struct player_special_data, 1,
+                    MEM_CREATURE);
         set_title(ch, "");
     } else {
         ch->player_specials = &dummy_mob;
@@ -199,7 +209,7 @@ free_creature(struct creature *ch)
 {
     reset_creature(ch);
     if (ch->player_specials != &dummy_mob) {
-        free(ch->player_specials);
+        FREE_KIND(ch->player_specials, MEM_CREATURE);
         free(ch->player.title);
     }
 }
@@ -801,6 +811,7 @@ extract_creature(struct creature *ch, enum cxn_state con_state)
     }
 
     destroy_attached_progs(ch);
+    prog_unregister_owner(ch, PROG_TYPE_MOBILE);
     char_arrest_pardoned(ch);
     remove_all_combat(ch);
 
@@ -1575,6 +1586,65 @@ ok_to_attack(struct creature *ch, struct creature *vict, bool mssg)
     return true;
 }
 
+/*
+   Every creature with a non-empty fighting list, in the order they
+   entered combat, so that a combat round doesn't have to look at
+   every creature in the world.  combatant_links maps each creature to
+   its link in the queue.
+*/
+static GQueue combatants = G_QUEUE_INIT;
+static GHashTable *combatant_links = NULL;
+
+static void
+add_combatant(struct creature *ch)
+{
+    if (!combatant_links)
+        combatant_links = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if (g_hash_table_contains(combatant_links, ch))
+        return;
+
+    g_queue_push_tail(&combatants, ch);
+    g_hash_table_insert(combatant_links, ch, combatants.tail);
+}
+
+void
+remove_combatant(struct creature *ch)
+{
+    GList *link;
+
+    if (!combatant_links)
+        return;
+    link = g_hash_table_lookup(combatant_links, ch);
+    if (!link)
+        return;
+
+    g_queue_delete_link(&combatants, link);
+    g_hash_table_remove(combatant_links, ch);
+}
+
+/*
+   Calls func on every creature in combat.  Creatures which join combat
+   during the iteration wait for the next call, and creatures which
+   leave it are skipped.
+*/
+void
+foreach_combatant(GFunc func, gpointer data)
+{
+    GList *snapshot = g_list_copy(combatants.head);
+
+    for (GList *it = snapshot;it;it = it->next) {
+        if (g_hash_table_contains(combatant_links, it->data))
+            func(it->data, data);
+    }
+    g_list_free(snapshot);
+}
+
+guint
+combatant_count(void)
+{
+    return g_queue_get_length(&combatants);
+}
+
 void
 add_combat(struct creature *attacker, struct creature *target, bool initiated __attribute__((unused)))
 {
@@ -1610,6 +1680,7 @@ add_combat(struct creature *attacker, struct creature *target, bool initiated __
 
             attacker->fighting = g_list_remove(attacker->fighting, defender);
             attacker->fighting = g_list_append(attacker->fighting, defender);
+            add_combatant(attacker);
 
             update_pos(attacker);
             trigger_prog_fight(attacker, defender);
@@ -1628,6 +1699,7 @@ add_combat(struct creature *attacker, struct creature *target, bool initiated __
 
     attacker->fighting = g_list_remove(attacker->fighting, target);
     attacker->fighting = g_list_append(attacker->fighting, target);
+    add_combatant(attacker);
     trigger_prog_fight(attacker, target);
 }
 
@@ -1666,6 +1738,8 @@ remove_combat(struct creature *ch, struct creature *target)
         return;
 
     ch->fighting = g_list_remove(ch->fighting, target);
+    if (!ch->fighting)
+        remove_combatant(ch);
     if (!is_fighting(ch))
         remove_fighting_affects(ch);
 }
@@ -1683,6 +1757,7 @@ remove_all_combat(struct creature *ch)
     if (ch->fighting) {
         g_list_free(ch->fighting);
         ch->fighting = NULL;
+        remove_combatant(ch);
         remove_fighting_affects(ch);
     }
 }
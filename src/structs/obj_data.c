@@ -29,6 +29,7 @@
 #include "spells.h"
 #include "strutil.h"
 #include "bomb.h"
+#include "memstat.h"
 
 extern int no_plrtext;
 
@@ -40,7 +41,7 @@ make_object(void)
 {
     struct obj_data *obj;
 
-    CREATE(obj, struct obj_data, 1);
+    CREATE_KIND(obj, struct obj_data, 1, MEM_OBJECT);
 
     obj->next = object_list;
     object_list = obj;
@@ -50,6 +51,154 @@ make_object(void)
     return obj;
 }
 
+// Live objects, indexed by vnum and by unique id.  Each value is a
+// GList of objects, newest first.  More than one object under the
+// same unique id means the object has been duplicated.  Each object
+// keeps its own link in each list, so that it can be removed without
+// searching.
+static GHashTable *obj_vnum_index = NULL;
+static GHashTable *obj_id_index = NULL;
+
+// The sets of objects still to be visited by each running
+// foreach_object_instance()
+static GList *obj_visits = NULL;
+
+static void
+obj_index_insert(GHashTable *index, gpointer key, struct obj_data *obj,
+                 GList **link)
+{
+    GList *instances = g_hash_table_lookup(index, key);
+
+    if (*link)
+        return;
+    instances = g_list_prepend(instances, obj);
+    *link = instances;
+    g_hash_table_insert(index, key, instances);
+}
+
+static void
+obj_index_delete(GHashTable *index, gpointer key, GList **link)
+{
+    GList *instances = g_hash_table_lookup(index, key);
+
+    if (!*link || !instances)
+        return;
+    instances = g_list_delete_link(instances, *link);
+    *link = NULL;
+    if (instances)
+        g_hash_table_insert(index, key, instances);
+    else
+        g_hash_table_remove(index, key);
+}
+
+void
+index_object(struct obj_data *obj)
+{
+    if (!obj_vnum_index) {
+        obj_vnum_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+        obj_id_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+    if (obj->shared && obj->shared->vnum >= 0)
+        obj_index_insert(obj_vnum_index,
+                         GINT_TO_POINTER(obj->shared->vnum), obj,
+                         &obj->vnum_link);
+    if (obj->unique_id)
+        obj_index_insert(obj_id_index,
+                         GSIZE_TO_POINTER(obj->unique_id), obj,
+                         &obj->id_link);
+}
+
+void
+unindex_object(struct obj_data *obj)
+{
+    if (!obj_vnum_index)
+        return;
+
+    if (obj->shared && obj->shared->vnum >= 0)
+        obj_index_delete(obj_vnum_index,
+                         GINT_TO_POINTER(obj->shared->vnum), &obj->vnum_link);
+    if (obj->unique_id)
+        obj_index_delete(obj_id_index,
+                         GSIZE_TO_POINTER(obj->unique_id), &obj->id_link);
+    for (GList *it = obj_visits; it; it = it->next)
+        g_hash_table_remove(it->data, obj);
+}
+
+void
+set_object_unique_id(struct obj_data *obj, long unique_id)
+{
+    unindex_object(obj);
+    obj->unique_id = unique_id;
+    index_object(obj);
+}
+
+// Returns the live instances of the object with the given vnum.  The
+// list belongs to the index and must not be modified or kept past
+// the extraction of any object.
+GList *
+object_instances(int vnum)
+{
+    if (!obj_vnum_index)
+        return NULL;
+    return g_hash_table_lookup(obj_vnum_index, GINT_TO_POINTER(vnum));
+}
+
+struct obj_data *
+object_by_unique_id(long unique_id)
+{
+    GList *instances;
+
+    if (!obj_id_index)
+        return NULL;
+    instances = g_hash_table_lookup(obj_id_index, GSIZE_TO_POINTER(unique_id));
+    return (instances) ? instances->data : NULL;
+}
+
+// Calls func on each instance of vnum.  func may extract any object,
+// including the one it was passed.
+void
+foreach_object_instance(int vnum, GFunc func, gpointer data)
+{
+    GList *snapshot = g_list_copy(object_instances(vnum));
+    GHashTable *unvisited = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    // Extracted objects are removed from the set by unindex_object()
+    for (GList *it = snapshot; it; it = it->next)
+        g_hash_table_insert(unvisited, it->data, it->data);
+    obj_visits = g_list_prepend(obj_visits, unvisited);
+
+    for (GList *it = snapshot; it; it = it->next)
+        if (g_hash_table_remove(unvisited, it->data))
+            func(it->data, data);
+
+    obj_visits = g_list_remove(obj_visits, unvisited);
+    g_hash_table_destroy(unvisited);
+    g_list_free(snapshot);
+}
+
+// Returns a list of the instance lists of every unique id shared by
+// more than one live object.  The caller frees the outer list.
+GList *
+duplicate_objects(void)
+{
+    GHashTableIter iter;
+    gpointer key, val;
+    GList *result = NULL;
+
+    if (!obj_id_index)
+        return NULL;
+
+    g_hash_table_iter_init(&iter, obj_id_index);
+    while (g_hash_table_iter_next(&iter, &key, &val)) {
+        GList *instances = val;
+
+        if (instances->next)
+            result = g_list_prepend(result, instances);
+    }
+    return result;
+}
+
 /* release memory allocated for an obj struct */
 void
 free_object(struct obj_data *obj)
@@ -127,7 +276,7 @@ free_object(struct obj_data *obj)
             remove_object_affect(obj, aff);
         }
     }
-    free(obj);
+    FREE_KIND(obj, MEM_OBJECT);
 }
 
 const char *
@@ -599,6 +748,7 @@ load_object_from_xml(struct obj_data *container,
 
         obj->shared = prototype->shared;
         obj->shared->number++;
+        index_object(obj);
 
         obj->name = obj->shared->proto->name;
         obj->aliases = obj->shared->proto->aliases;
@@ -661,7 +811,7 @@ load_object_from_xml(struct obj_data *container,
             obj->obj_flags.timer = xmlGetIntProp(cur, "timer", 0);
             fix_object_weight(obj);
         } else if (xmlMatches(cur->name, "tracking")) {
-            obj->unique_id = xmlGetIntProp(cur, "id", 0);
+            set_object_unique_id(obj, xmlGetIntProp(cur, "id", 0));
             obj->creation_method = xmlGetIntProp(cur, "method", 0);
             obj->creator = xmlGetIntProp(cur, "creator", 0);
             obj->creation_time = xmlGetIntProp(cur, "time", 0);
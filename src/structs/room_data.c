@@ -97,6 +97,7 @@ free_room(struct room_data *room)
     free(room->prog);
     free(room->progobj);
     prog_state_free(room->prog_state);
+    prog_unregister_owner(room, PROG_TYPE_ROOM);
 
     free(room);
 }
@@ -1,10 +1,13 @@
 #ifdef HAS_CONFIG_H
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <libxml/parser.h>
 
+#include "memstat.h"
+
 const size_t DEFAULT_ACCUM_SIZE = 65536;    // 64k to start with
 const size_t MAX_STR_ALLOC = 20 * 1024 * 1024;  // 20MB hard maximum
 
@@ -18,6 +21,7 @@ acc_string_init(void)
 {
     acc_str_space = DEFAULT_ACCUM_SIZE;
     acc_str_data = (char *)malloc(acc_str_space);
+    memstat_alloc(MEM_ACCSTR, acc_str_data, acc_str_space);
 }
 
 // Clears the accumulator for use.
@@ -38,12 +42,15 @@ acc_string_adjust(size_t wanted)
     if (acc_str_space > MAX_STR_ALLOC)
         raise(SIGSEGV);
 
+    memstat_free(MEM_ACCSTR, acc_str_data, acc_str_space);
+
     // if they want more than we've got, chances are they'll want
     // even more, so we increase it in chunks
     while (acc_str_space < wanted)
         acc_str_space += DEFAULT_ACCUM_SIZE;
 
     acc_str_data = (char *)realloc(acc_str_data, acc_str_space);
+    memstat_alloc(MEM_ACCSTR, acc_str_data, acc_str_space);
 }
 
 // vsprintf into a accum str
@@ -56,6 +56,7 @@
 #include "smokes.h"
 #include "strutil.h"
 #include "paths.h"
+#include "house.h"
 
 /* external vars */
 extern struct descriptor_data *descriptor_list;
@@ -66,6 +67,10 @@ long special(struct creature *ch, int cmd, int subcmd, char *arg,
 void free_socials();
 extern struct clan_data *clan_list;
 
+// Given to a room's contents or a creature's inventory whenever an
+// object enters or leaves it, so lists can be seen to have changed.
+static unsigned long obj_list_serial = 0;
+
 void
 init_affect(struct affected_type *af)
 {
@@ -145,6 +150,7 @@ void
 affect_modify(struct creature *ch, int16_t loc, int16_t mod, long bitv,
     int index, bool add)
 {
+    invalidate_sight();
     if (bitv) {
         if (add) {
             if (index == 2) {
@@ -806,6 +812,7 @@ char_from_room(struct creature *ch, bool check_specials)
     }
 
     remove_all_combat(ch);
+    invalidate_sight();
 
     if (GET_RACE(ch) == RACE_ELEMENTAL && IS_CLASS(ch, CLASS_FIRE))
         ch->in_room->light--;
@@ -891,6 +898,7 @@ char_to_room(struct creature * ch, struct room_data * room,
 
     room->people = g_list_prepend(room->people, ch);
     ch->in_room = room;
+    invalidate_sight();
 
     if (GET_RACE(ch) == RACE_ELEMENTAL && IS_CLASS(ch, CLASS_FIRE))
         room->light++;
@@ -1029,6 +1037,7 @@ general_obj_to_char(struct obj_data *object,
     }
 
     ch->carrying = insert_func(ch->carrying, object);
+    ch->carrying_serial = ++obj_list_serial;
     object->carried_by = ch;
     object->in_room = NULL;
 
@@ -1083,6 +1092,7 @@ obj_from_char(struct obj_data *object)
 #endif
 
     REMOVE_FROM_LIST(object, object->carried_by->carrying, next_content);
+    object->carried_by->carrying_serial = ++obj_list_serial;
 
     /* set flag for crash-save system */
     if (!IS_NPC(object->carried_by))
@@ -1428,13 +1438,9 @@ get_obj_in_list_num(int num, struct obj_data *list)
 struct obj_data *
 get_obj_num(int nr)
 {
-    struct obj_data *i;
+    GList *instances = object_instances(nr);
 
-    for (i = object_list; i; i = i->next)
-        if (GET_OBJ_VNUM(i) == nr)
-            return i;
-
-    return NULL;
+    return (instances) ? instances->data : NULL;
 }
 
 /* search a room for a char, and return a pointer if found..  */
@@ -1545,7 +1551,9 @@ general_obj_to_room(struct obj_data *object,
     }
 
     room->contents = insert_func(room->contents, object);
+    room->contents_serial = ++obj_list_serial;
     object->in_room = room;
+    house_object_moved(object, room, 1);
 
     if (ROOM_FLAGGED(room, ROOM_HOUSE))
         SET_BIT(ROOM_FLAGS(room), ROOM_HOUSE_CRASH);
@@ -1600,6 +1608,8 @@ obj_from_room(struct obj_data *object)
         object->in_room->light--;
 
     REMOVE_FROM_LIST(object, object->in_room->contents, next_content);
+    object->in_room->contents_serial = ++obj_list_serial;
+    house_object_moved(object, object->in_room, -1);
 
     if (ROOM_FLAGGED(object->in_room, ROOM_HOUSE))
         SET_BIT(ROOM_FLAGS(object->in_room), ROOM_HOUSE_CRASH);
@@ -1608,11 +1618,21 @@ obj_from_room(struct obj_data *object)
     REMOVE_BIT(GET_OBJ_EXTRA2(object), ITEM2_HIDDEN);
 }
 
+// Returns the room holding the outermost container of obj, if any
+static struct room_data *
+obj_top_room(struct obj_data *obj)
+{
+    while (obj->in_obj)
+        obj = obj->in_obj;
+    return obj->in_room;
+}
+
 /* put an object in an object (quaint)  */
 static void
 general_obj_to_obj(struct obj_data *obj, struct obj_data *obj_to, insert_func_t insert_func)
 {
     struct creature *vict = NULL;
+    struct room_data *top_room;
 
     if (!obj || !obj_to || obj == obj_to) {
         errlog("NULL object or same src and targ obj passed to obj_to_obj");
@@ -1621,6 +1641,8 @@ general_obj_to_obj(struct obj_data *obj, struct obj_data *obj_to, insert_func_t
 
     obj_to->contains = insert_func(obj_to->contains, obj);
     obj->in_obj = obj_to;
+    if ((top_room = obj_top_room(obj_to)))
+        house_object_moved(obj, top_room, 1);
 
     /* top level object.  Subtract weight from inventory if necessary. */
     modify_object_weight(obj_to, GET_OBJ_WEIGHT(obj));
@@ -1654,6 +1676,7 @@ obj_from_obj(struct obj_data *obj)
 {
     struct obj_data *obj_from = NULL, *temp = NULL;
     struct creature *vict = NULL;
+    struct room_data *top_room;
 
     if (obj->in_obj == NULL) {
         errlog("(handler.c): trying to illegally extract obj from obj");
@@ -1670,6 +1693,8 @@ obj_from_obj(struct obj_data *obj)
     modify_object_weight(obj_from, -GET_OBJ_WEIGHT(obj));
 
     REMOVE_FROM_LIST(obj, obj_from->contains, next_content);
+    if ((top_room = obj_top_room(obj_from)))
+        house_object_moved(obj, top_room, -1);
 
     if (IS_INTERFACE(obj_from)
         && (vict = obj_from->worn_by)
@@ -1721,6 +1746,7 @@ extract_obj(struct obj_data *obj)
     if (obj->func_data)
         free(obj->func_data);
 
+    unindex_object(obj);
     if (obj->shared && obj->shared->vnum >= 0)
         obj->shared->number--;
 
@@ -2081,11 +2107,8 @@ get_obj_vis(struct creature *ch, const char *name)
     char *tmp = tmpname;
 
     if (is_number(name) && is_authorized(ch, DEBUGGING, NULL)) {
-        // Scan the object list for the unique ID given by the number
-        number = atoi(name);
-        for (i = object_list; i; i = i->next)
-            if (i->unique_id == number)
-                return i;
+        // Look up the object by the unique ID given by the number
+        return object_by_unique_id(atol(name));
     } else {
         /* scan items carried */
         if ((i = get_obj_in_list_vis(ch, name, ch->carrying)))
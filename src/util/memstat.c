@@ -0,0 +1,229 @@
+//
+// File: memstat.c                      -- Part of TempusMUD
+//
+// Counts the memory held by each subsystem.  While block tracking is
+// on, allocations made through CREATE_KIND() are also recorded by
+// address, along with the code address that made them, so the live
+// blocks can be dumped in the format read by tools/analyze_memusage.rb.
+//
+
+#ifdef HAS_CONFIG_H
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <link.h>
+#include <libxml/parser.h>
+#include <glib.h>
+
+#include "utils.h"
+#include "constants.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "memstat.h"
+
+const char *mem_kind_names[] = {
+    "creatures",
+    "objects",
+    "progs",
+    "tmpstr",
+    "accstr",
+    "glist",
+    "sql",
+    "\n"
+};
+
+struct mem_block {
+    size_t size;
+    enum mem_kind kind;
+    void *caller;               // Code address which made the allocation
+};
+
+static bool mem_tracking = false;
+static GHashTable *mem_blocks = NULL;  // Block address -> struct mem_block
+static struct mem_counts mem_totals[NUM_MEM_KINDS];
+static struct mem_counts mem_pulse_start[NUM_MEM_KINDS];
+static struct mem_pulse mem_last_pulse[NUM_MEM_KINDS];
+
+static void
+memstat_track(enum mem_kind kind, void *ptr, size_t size, void *caller)
+{
+    struct mem_block *blk;
+
+    // An address can only be handed out again once it has been freed,
+    // so a block still recorded here was freed without being counted.
+    blk = g_hash_table_lookup(mem_blocks, ptr);
+    if (blk)
+        errlog("memstat: %s block %p (%zu bytes, from %p) was never freed",
+               mem_kind_names[blk->kind], ptr, blk->size, blk->caller);
+
+    CREATE(blk, struct mem_block, 1);
+    blk->size = size;
+    blk->kind = kind;
+    blk->caller = caller;
+    g_hash_table_replace(mem_blocks, ptr, blk);
+}
+
+void
+memstat_alloc(enum mem_kind kind, void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    mem_totals[kind].allocs++;
+    mem_totals[kind].blocks++;
+    mem_totals[kind].bytes += size;
+
+    if (mem_tracking)
+        memstat_track(kind, ptr, size, __builtin_return_address(0));
+}
+
+void
+memstat_free(enum mem_kind kind, void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    mem_totals[kind].frees++;
+    mem_totals[kind].blocks--;
+    mem_totals[kind].bytes -= size;
+
+    // Blocks made before tracking was turned on were never recorded
+    if (mem_tracking)
+        g_hash_table_remove(mem_blocks, ptr);
+}
+
+void
+memstat_set_tracking(bool on)
+{
+    if (on && !mem_blocks)
+        mem_blocks = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                           NULL, free);
+    else if (!on && mem_blocks) {
+        g_hash_table_destroy(mem_blocks);
+        mem_blocks = NULL;
+    }
+    mem_tracking = on;
+}
+
+bool
+memstat_tracking(void)
+{
+    return mem_tracking;
+}
+
+void
+memstat_sample(enum mem_kind kind, size_t blocks, size_t bytes)
+{
+    mem_totals[kind].blocks = blocks;
+    mem_totals[kind].bytes = bytes;
+}
+
+void
+memstat_pulse(void)
+{
+    for (int kind = 0; kind < NUM_MEM_KINDS; kind++) {
+        struct mem_counts *now = &mem_totals[kind];
+        struct mem_counts *then = &mem_pulse_start[kind];
+        struct mem_pulse *pulse = &mem_last_pulse[kind];
+
+        pulse->allocs = now->allocs - then->allocs;
+        pulse->frees = now->frees - then->frees;
+        pulse->bytes = (long)now->bytes - (long)then->bytes;
+        if (pulse->bytes > pulse->most_growth)
+            pulse->most_growth = pulse->bytes;
+        *then = *now;
+    }
+}
+
+void
+memstat_counts(enum mem_kind kind, struct mem_counts *counts,
+               struct mem_pulse *pulse)
+{
+    if (counts)
+        *counts = mem_totals[kind];
+    if (pulse)
+        *pulse = mem_last_pulse[kind];
+}
+
+// GList nodes come from glib's slice allocator, so they are counted by
+// walking the largest lists instead.
+void
+memstat_sample_glists(void)
+{
+    size_t nodes = g_list_length(creatures);
+
+    for (GList *it = creatures; it; it = it->next) {
+        struct creature *tch = it->data;
+
+        nodes += g_list_length(tch->fighting);
+    }
+    for (struct zone_data *zone = zone_table; zone; zone = zone->next)
+        for (struct room_data *room = zone->world; room; room = room->next)
+            nodes += g_list_length(room->people);
+
+    memstat_sample(MEM_GLIST, nodes, nodes * sizeof(GList));
+}
+
+static int
+find_load_bias(struct dl_phdr_info *info,
+               size_t size __attribute__ ((unused)), void *data)
+{
+    // The first object is always the executable itself
+    *(uintptr_t *)data = info->dlpi_addr;
+    return 1;
+}
+
+int
+memstat_dump(const char *path)
+{
+    GHashTableIter iter;
+    gpointer key, val;
+    uintptr_t bias = 0;
+    FILE *ouf;
+    int count = 0;
+
+    ouf = fopen(path, "w");
+    if (!ouf)
+        return -1;
+
+    // Code addresses are written relative to where the executable was
+    // loaded, so addr2line can resolve them.
+    dl_iterate_phdr(find_load_bias, &bias);
+
+    if (mem_blocks) {
+        g_hash_table_iter_init(&iter, mem_blocks);
+        while (g_hash_table_iter_next(&iter, &key, &val)) {
+            struct mem_block *blk = val;
+
+            fprintf(ouf, "%d %zu %p 0x%lx\n", ++count, blk->size, key,
+                    (unsigned long)((uintptr_t)blk->caller - bias));
+        }
+    }
+    fclose(ouf);
+
+    return count;
+}
+
+void
+memstat_log(void)
+{
+    memstat_sample_glists();
+    for (int kind = 0; kind < NUM_MEM_KINDS; kind++)
+        slog("memstat: %-9s %8zu blocks %10zu bytes (%+ld last pulse, %+ld most)",
+             mem_kind_names[kind], mem_totals[kind].blocks,
+             mem_totals[kind].bytes, mem_last_pulse[kind].bytes,
+             mem_last_pulse[kind].most_growth);
+    if (mem_tracking && memstat_dump(MEMSTAT_FILE) < 0)
+        errlog("Couldn't write %s", MEMSTAT_FILE);
+}
@@ -147,46 +147,53 @@ show_file(struct creature *ch, const char *fname, int lines)
 }
 
 void
-page_string(struct descriptor_data *d, const char *str)
+pager_stop(struct descriptor_data *d)
 {
-    if (!d || !str || suppress_output)
-        return;
-
-    // Free any previous paged string
     if (d->showstr_head)
         free(d->showstr_head);
+    d->showstr_head = d->showstr_point = NULL;
 
-    // If term height is zero, just send the string
-    if (!d->account->term_height) {
-        d_send(d, str);
-        d->showstr_point = d->showstr_head = NULL;
-        return;
-    }
-    // Create a new paged string
-    CREATE(d->showstr_head, char, strlen(str) + 1);
-    strcpy_s(d->showstr_head, strlen(str) + 1, str);
-    d->showstr_point = d->showstr_head;
+    if (d->pager_free)
+        d->pager_free(d->pager_data);
+    d->pager_gen = NULL;
+    d->pager_data = NULL;
+    d->pager_free = NULL;
+}
 
-    // Show the first page
-    show_string(d);
+// Pages a string already built in full, as a generator that gives it
+// all at once
+static bool
+page_string_gen(struct descriptor_data *d __attribute__ ((unused)),
+                void *data)
+{
+    acc_strcat(data, NULL);
+    return false;
 }
 
 void
-show_string(struct descriptor_data *d)
+page_string(struct descriptor_data *d, const char *str)
 {
-    register char *line_pt, *read_pt;
-    int page_length, cols, undisplayed;
-    int pt_save;
+    if (!d || !str || suppress_output)
+        return;
+
+    // The string is copied, as it is usually the accumulator, which
+    // the pager reuses
+    page_generator(d, page_string_gen, strdup(str), free);
+}
 
-    page_length = d->account->term_height;
-    cols = d->account->term_width;
+// Returns the end of the page of text starting at str
+static char *
+find_page_end(char *str, int page_length, int cols)
+{
+    register char *line_pt, *read_pt;
+    int undisplayed;
 
     // No division by zero errors!
     if (cols == 0)
         cols = -1;
 
     undisplayed = 0;
-    line_pt = read_pt = d->showstr_point;
+    line_pt = read_pt = str;
     while (*read_pt && page_length > 0) {
         while (*read_pt && *read_pt != '\r' && *read_pt != '\n') {
             // nearly all ANSI codes end with the first alphabetical character
@@ -214,6 +221,102 @@ show_string(struct descriptor_data *d)
         }
     }
 
+    return read_pt;
+}
+
+// Returns true if there is anything but newlines left in str
+static bool
+pager_text_left(const char *str)
+{
+    return str[strspn(str, "\r\n")] != '\0';
+}
+
+// Calls the generator until there is more than a page of unread text,
+// or it has nothing left to give.
+static void
+pager_fill(struct descriptor_data *d, int page_length, int cols)
+{
+    if (!d->pager_gen)
+        return;
+    if (d->showstr_point
+        && pager_text_left(find_page_end(d->showstr_point, page_length, cols)))
+        return;
+
+    acc_string_clear();
+    if (d->showstr_point)
+        acc_strcat(d->showstr_point, NULL);
+    while (d->pager_gen
+           && !pager_text_left(find_page_end(acc_get_string(), page_length,
+                                             cols))) {
+        if (!d->pager_gen(d, d->pager_data)) {
+            if (d->pager_free)
+                d->pager_free(d->pager_data);
+            d->pager_gen = NULL;
+            d->pager_data = NULL;
+            d->pager_free = NULL;
+        }
+    }
+
+    if (d->showstr_head)
+        free(d->showstr_head);
+    d->showstr_head = strdup(acc_get_string());
+    d->showstr_point = d->showstr_head;
+}
+
+bool
+page_generator(struct descriptor_data *d, pager_func gen, void *data,
+               void (*free_data)(void *data))
+{
+    if (!d || suppress_output) {
+        if (free_data)
+            free_data(data);
+        return false;
+    }
+
+    pager_stop(d);
+    d->pager_gen = gen;
+    d->pager_data = data;
+    d->pager_free = free_data;
+
+    // Without paging, the whole listing is sent a part at a time
+    if (!d->account->term_height) {
+        bool produced = false;
+
+        while (d->pager_gen) {
+            acc_string_clear();
+            if (!d->pager_gen(d, d->pager_data))
+                pager_stop(d);
+            if (acc_get_length()) {
+                d_send(d, acc_get_string());
+                produced = true;
+            }
+        }
+        return produced;
+    }
+
+    pager_fill(d, d->account->term_height, d->account->term_width);
+    if (!*d->showstr_head) {
+        pager_stop(d);
+        return false;
+    }
+    show_string(d);
+
+    return true;
+}
+
+void
+show_string(struct descriptor_data *d)
+{
+    char *read_pt;
+    int pt_save;
+
+    pager_fill(d, d->account->term_height, d->account->term_width);
+    if (!d->showstr_point)
+        return;
+
+    read_pt = find_page_end(d->showstr_point, d->account->term_height,
+                            d->account->term_width);
+
     pt_save = *read_pt;
     *read_pt = '\0';
 
@@ -222,13 +325,14 @@ show_string(struct descriptor_data *d)
     *read_pt = pt_save;
 
     // Advance past newlines to next bit of text
-    while (*read_pt && *read_pt == '\n' && *read_pt == '\r')
+    while (*read_pt == '\n' || *read_pt == '\r')
         read_pt++;
 
     d->showstr_point = read_pt;
 
     // If all we have left are newlines (or nothing), free the string,
-    // otherwise we tell em to use the 'more' command
+    // otherwise we tell em to use the 'more' command.  The pager was
+    // filled past this page if the generator had any more to give.
     if (*read_pt) {
         if (d->creature)
             d_printf(d, "&r**** &nUse the 'more' command to continue. &r****&n\r\n");
@@ -0,0 +1,278 @@
+//
+// File: profiler.c                      -- Part of TempusMUD
+//
+// Times the repeating callbacks of the main loop.  Each callback
+// registered with pulse_timeout_add() is run through pulse_dispatch(),
+// which records how long it ran, how much CPU it used, and how late it
+// was called, and logs any run which takes longer than its budget.
+//
+
+#ifdef HAS_CONFIG_H
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+#include <libxml/parser.h>
+#include <glib.h>
+
+#include "utils.h"
+#include "constants.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "account.h"
+#include "comm.h"
+#include "screen.h"
+#include "tmpstr.h"
+#include "accstr.h"
+#include "profiler.h"
+
+struct pulse_callback {
+    const char *name;
+    guint interval;             // Milliseconds between calls
+    GSourceFunc func;
+    gpointer data;
+    gint64 due;                 // Monotonic time the next call is due
+    unsigned long budget;       // Microseconds a run may take
+    unsigned long slow;         // Runs which exceeded the budget
+    struct prof_hist wall;      // Microseconds of wall time per run
+    struct prof_hist cpu;       // Microseconds of CPU time per run
+    struct prof_hist lag;       // Microseconds late each run started
+};
+
+static GList *pulse_callbacks = NULL;
+
+static unsigned int
+prof_hist_index(unsigned long value)
+{
+    int msb, shift;
+
+    if (value < PROF_HIST_SUB_COUNT)
+        return value;
+
+    msb = 63 - __builtin_clzll(value);
+    if (msb >= PROF_HIST_MAX_BITS)
+        return PROF_HIST_BUCKETS - 1;
+    shift = msb - PROF_HIST_SUB_BITS + 1;
+
+    return PROF_HIST_SUB_COUNT + (shift - 1) * PROF_HIST_HALF_COUNT
+        + (value >> shift) - PROF_HIST_HALF_COUNT;
+}
+
+// Returns the highest value which is counted in the bucket
+static unsigned long
+prof_hist_bucket_value(unsigned int idx)
+{
+    unsigned int shift, sub;
+
+    if (idx < PROF_HIST_SUB_COUNT)
+        return idx;
+
+    shift = (idx - PROF_HIST_SUB_COUNT) / PROF_HIST_HALF_COUNT + 1;
+    sub = (idx - PROF_HIST_SUB_COUNT) % PROF_HIST_HALF_COUNT
+        + PROF_HIST_HALF_COUNT;
+
+    return (((unsigned long)sub + 1) << shift) - 1;
+}
+
+void
+prof_hist_record(struct prof_hist *hist, unsigned long value)
+{
+    hist->buckets[prof_hist_index(value)]++;
+    hist->count++;
+    hist->total += value;
+    if (value > hist->max)
+        hist->max = value;
+}
+
+unsigned long
+prof_hist_percentile(struct prof_hist *hist, double pct)
+{
+    unsigned long wanted, seen = 0;
+
+    if (!hist->count)
+        return 0;
+
+    wanted = (unsigned long)(pct / 100.0 * hist->count + 0.5);
+    if (wanted < 1)
+        wanted = 1;
+    for (unsigned int idx = 0; idx < PROF_HIST_BUCKETS; idx++) {
+        seen += hist->buckets[idx];
+        if (seen < wanted)
+            continue;
+        // The last bucket holds everything too large to bucket
+        if (idx == PROF_HIST_BUCKETS - 1)
+            return hist->max;
+        return MIN(prof_hist_bucket_value(idx), hist->max);
+    }
+
+    return hist->max;
+}
+
+void
+prof_hist_clear(struct prof_hist *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+static long
+cpu_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static gboolean
+pulse_dispatch(gpointer data)
+{
+    struct pulse_callback *cb = data;
+    gint64 start = g_get_monotonic_time();
+    long cpu_start = cpu_usec();
+    unsigned long wall, cpu, lag;
+    gboolean result;
+
+    lag = (start > cb->due) ? start - cb->due : 0;
+
+    result = cb->func(cb->data);
+
+    wall = g_get_monotonic_time() - start;
+    cpu = cpu_usec() - cpu_start;
+    prof_hist_record(&cb->wall, wall);
+    prof_hist_record(&cb->cpu, cpu);
+    prof_hist_record(&cb->lag, lag);
+
+    if (wall > cb->budget) {
+        cb->slow++;
+        slog("SLOW PULSE: %s took %lu.%03lums (%lu.%03lums cpu, %lu.%03lums late)",
+             cb->name, wall / 1000, wall % 1000, cpu / 1000, cpu % 1000,
+             lag / 1000, lag % 1000);
+    }
+
+    // glib schedules the next call from when this one was dispatched
+    cb->due = start + cb->interval * 1000L;
+
+    return result;
+}
+
+guint
+pulse_timeout_add(const char *name, guint interval, GSourceFunc func,
+                  gpointer data)
+{
+    return pulse_timeout_add_budget(name, interval, PULSE_BUDGET_USEC,
+                                    func, data);
+}
+
+guint
+pulse_timeout_add_budget(const char *name, guint interval,
+                         unsigned long budget_usec, GSourceFunc func,
+                         gpointer data)
+{
+    struct pulse_callback *cb;
+
+    CREATE(cb, struct pulse_callback, 1);
+    cb->name = name;
+    cb->interval = interval;
+    cb->budget = budget_usec;
+    cb->func = func;
+    cb->data = data;
+    cb->due = g_get_monotonic_time() + interval * 1000L;
+    pulse_callbacks = g_list_append(pulse_callbacks, cb);
+
+    return g_timeout_add(interval, pulse_dispatch, cb);
+}
+
+static const char *
+usec_str(unsigned long usec)
+{
+    if (usec >= 10000000)
+        return tmp_sprintf("%lus", usec / 1000000);
+    return tmp_sprintf("%lu.%lu", usec / 1000, (usec % 1000) / 100);
+}
+
+static void
+show_pulse_hist(const char *label, struct prof_hist *hist)
+{
+    acc_sprintf("  %-5s p50 %8s  p90 %8s  p99 %8s  p99.9 %8s  max %8s  avg %8s\r\n",
+                label,
+                usec_str(prof_hist_percentile(hist, 50)),
+                usec_str(prof_hist_percentile(hist, 90)),
+                usec_str(prof_hist_percentile(hist, 99)),
+                usec_str(prof_hist_percentile(hist, 99.9)),
+                usec_str(hist->max),
+                usec_str((hist->count) ? hist->total / hist->count : 0));
+}
+
+void
+show_pulse_stats(struct creature *ch, char *arg)
+{
+    char *name = tmp_getword(&arg);
+    bool found = false;
+
+    if (!strcmp(name, "reset")) {
+        for (GList *it = pulse_callbacks; it; it = it->next) {
+            struct pulse_callback *cb = it->data;
+
+            cb->slow = 0;
+            prof_hist_clear(&cb->wall);
+            prof_hist_clear(&cb->cpu);
+            prof_hist_clear(&cb->lag);
+        }
+        send_to_char(ch, "Pulse timings cleared.\r\n");
+        return;
+    }
+
+    acc_string_clear();
+    if (*name) {
+        for (GList *it = pulse_callbacks; it; it = it->next) {
+            struct pulse_callback *cb = it->data;
+
+            if (strncasecmp(cb->name, name, strlen(name)))
+                continue;
+            acc_sprintf("%s%s%s every %ums, %lu runs, %lu over %sms (times in ms):\r\n",
+                        CCCYN(ch, C_NRM), cb->name, CCNRM(ch, C_NRM),
+                        cb->interval, cb->wall.count, cb->slow,
+                        usec_str(cb->budget));
+            show_pulse_hist("wall", &cb->wall);
+            show_pulse_hist("cpu", &cb->cpu);
+            show_pulse_hist("lag", &cb->lag);
+            found = true;
+        }
+        if (!found) {
+            send_to_char(ch, "No pulse callback matches '%s'.\r\n", name);
+            return;
+        }
+        page_string(ch->desc, acc_get_string());
+        return;
+    }
+
+    acc_strcat("Pulse callbacks (times in ms):\r\n"
+               "Callback                Every    Runs  Wall p50     p99     max"
+               "  CPU p99  Lag p99     max  Slow\r\n"
+               "----------------------- ----- ------- -------- ------- -------"
+               " -------- -------- ------- -----\r\n", NULL);
+    for (GList *it = pulse_callbacks; it; it = it->next) {
+        struct pulse_callback *cb = it->data;
+
+        acc_sprintf("%-23s %5u %7lu %8s %7s %7s %8s %8s %7s %5lu\r\n",
+                    cb->name, cb->interval, cb->wall.count,
+                    usec_str(prof_hist_percentile(&cb->wall, 50)),
+                    usec_str(prof_hist_percentile(&cb->wall, 99)),
+                    usec_str(cb->wall.max),
+                    usec_str(prof_hist_percentile(&cb->cpu, 99)),
+                    usec_str(prof_hist_percentile(&cb->lag, 99)),
+                    usec_str(cb->lag.max),
+                    cb->slow);
+    }
+    page_string(ch->desc, acc_get_string());
+}
@@ -216,8 +216,34 @@ check_sight_vict(struct creature * self, struct creature * vict)
     return true;
 }
 
+// The results of can_see_creature(), remembered until anything they
+// depend upon may have changed.  Every change to affects, movement and
+// invisibility level starts a new epoch, as does every pulse, to catch
+// the rarer changes.  Changes in the light of the victim's room are
+// noticed by remembering the light.
+#define SIGHT_CACHE_SIZE 8192
+
+struct sight_cache_entry {
+    struct creature *self;
+    struct creature *vict;
+    struct room_data *room;
+    int light;
+    unsigned long epoch;
+    bool result;
+};
+
+static struct sight_cache_entry sight_cache[SIGHT_CACHE_SIZE];
+static unsigned long sight_epoch = 1;
+
+// Forgets every remembered result of can_see_creature()
+void
+invalidate_sight(void)
+{
+    sight_epoch++;
+}
+
 bool
-can_see_creature(struct creature * self, struct creature * vict)
+can_see_creature_uncached(struct creature * self, struct creature * vict)
 {
     // Can always see self
     if (self == vict)
@@ -250,6 +276,35 @@ can_see_creature(struct creature * self, struct creature * vict)
     return true;
 }
 
+bool
+can_see_creature(struct creature * self, struct creature * vict)
+{
+    struct sight_cache_entry *entry;
+    struct room_data *room = vict->in_room;
+    int light = (room) ? room->light : 0;
+
+    if (self == vict)
+        return true;
+
+    entry = &sight_cache[((uintptr_t)self / sizeof(*self) * 31
+            + (uintptr_t)vict / sizeof(*vict)) % SIGHT_CACHE_SIZE];
+    if (entry->epoch == sight_epoch
+        && entry->self == self
+        && entry->vict == vict
+        && entry->room == room
+        && entry->light == light)
+        return entry->result;
+
+    entry->self = self;
+    entry->vict = vict;
+    entry->room = room;
+    entry->light = light;
+    entry->epoch = sight_epoch;
+    entry->result = can_see_creature_uncached(self, vict);
+
+    return entry->result;
+}
+
 bool
 can_see_object(struct creature * self, struct obj_data * obj)
 {
@@ -12,6 +12,7 @@
 #include "tmpstr.h"
 #include "utils.h"
 #include "strutil.h"
+#include "memstat.h"
 
 struct tmp_str_pool {
     struct tmp_str_pool *next;  // Ptr to next in linked list
@@ -26,8 +27,17 @@ size_t tmp_max_used = 0;        // Tracks maximum tmp str space used
 static struct tmp_str_pool *tmp_list_head;  // Always points to the initial pool
 static struct tmp_str_pool *tmp_list_tail;  // Points to the end of the linked
                                     // list of pools
+static unsigned int tmp_gc_count = 0;   // Number of times strings were gc'd
+static size_t tmp_released = 0;         // Most space used before a release
+                                        // since the last gc
+
+#ifdef DEBUG_TMPSTR
+static GHashTable *tmp_mark_sites = NULL;   // Site -> most space released
+#endif
 
 struct tmp_str_pool *tmp_alloc_pool(size_t size_req);
+static void tmp_free_pool(struct tmp_str_pool *pool);
+
 // Initializes the structures used for the temporary string mechanism
 void
 tmp_string_init(void)
@@ -48,15 +58,20 @@ tmp_gc_strings(void)
     for (cur_buf = tmp_list_head->next; cur_buf; cur_buf = next_buf) {
         next_buf = cur_buf->next;
         wanted += cur_buf->used;
-        free(cur_buf);
+        tmp_free_pool(cur_buf);
     }
 
+    // Space reclaimed by tmp_release() was still needed at one point
+    wanted = MAX(wanted, tmp_released);
+    tmp_released = 0;
+    tmp_gc_count++;
+
     // Track the max used and resize the pool if necessary
     if (wanted > tmp_max_used) {
         tmp_max_used = wanted;
 
         if (tmp_max_used > tmp_list_head->space) {
-            free(tmp_list_head);
+            tmp_free_pool(tmp_list_head);
             tmp_list_tail = NULL;
             tmp_list_head = tmp_alloc_pool(tmp_max_used);
         }
@@ -77,6 +92,7 @@ tmp_alloc_pool(size_t size_req)
 
     new_buf =
         (struct tmp_str_pool *)malloc(sizeof(struct tmp_str_pool) + size);
+    memstat_alloc(MEM_TMPSTR, new_buf, sizeof(struct tmp_str_pool) + size);
     new_buf->next = NULL;
     if (tmp_list_tail)
         tmp_list_tail->next = new_buf;
@@ -84,11 +100,104 @@ tmp_alloc_pool(size_t size_req)
     new_buf->space = size;
     new_buf->used = 0;
 
-    memset(new_buf->data, 0, size);
-
     return new_buf;
 }
 
+static void
+tmp_free_pool(struct tmp_str_pool *pool)
+{
+    memstat_free(MEM_TMPSTR, pool, sizeof(struct tmp_str_pool) + pool->space);
+    free(pool);
+}
+
+// Returns the amount of space used by every pool from the given one
+// onward.
+static size_t
+tmp_space_used(struct tmp_str_pool *from)
+{
+    size_t used = 0;
+
+    for (struct tmp_str_pool *cur_buf = from; cur_buf; cur_buf = cur_buf->next)
+        used += cur_buf->used;
+
+    return used;
+}
+
+struct tmp_mark
+tmp_mark_site(const char *site)
+{
+    struct tmp_mark mark;
+
+    mark.pool = tmp_list_tail;
+    mark.used = tmp_list_tail->used;
+    mark.gc_count = tmp_gc_count;
+    mark.site = site;
+
+    return mark;
+}
+
+void
+tmp_release(struct tmp_mark mark)
+{
+    struct tmp_str_pool *cur_buf, *next_buf;
+
+    // Strings were already freed by a gc after the mark was made
+    if (mark.gc_count != tmp_gc_count)
+        return;
+
+    // The pool must still be in the list and must not have shrunk
+    // past the mark; otherwise, an enclosing mark was already released.
+    for (cur_buf = tmp_list_head; cur_buf && cur_buf != mark.pool;
+         cur_buf = cur_buf->next)
+        ;
+    if (!cur_buf || cur_buf->used < mark.used)
+        return;
+
+    tmp_released = MAX(tmp_released, tmp_space_used(tmp_list_head));
+
+#ifdef DEBUG_TMPSTR
+    if (mark.site) {
+        size_t released = tmp_space_used(mark.pool) - mark.used;
+        gpointer site, most;
+
+        if (!tmp_mark_sites)
+            tmp_mark_sites = g_hash_table_new(g_str_hash, g_str_equal);
+        if (!g_hash_table_lookup_extended(tmp_mark_sites, mark.site,
+                                          &site, &most))
+            g_hash_table_insert(tmp_mark_sites, g_strdup(mark.site),
+                                GSIZE_TO_POINTER(released));
+        else if (released > GPOINTER_TO_SIZE(most))
+            g_hash_table_insert(tmp_mark_sites, site,
+                                GSIZE_TO_POINTER(released));
+    }
+#endif
+
+    for (cur_buf = mark.pool->next; cur_buf; cur_buf = next_buf) {
+        next_buf = cur_buf->next;
+        tmp_free_pool(cur_buf);
+    }
+    mark.pool->next = NULL;
+    mark.pool->used = mark.used;
+    tmp_list_tail = mark.pool;
+}
+
+void
+tmp_foreach_mark_site(void (*func)(const char *site, size_t released,
+                                   void *data),
+                      void *data)
+{
+#ifdef DEBUG_TMPSTR
+    GHashTableIter iter;
+    gpointer key, val;
+
+    if (!tmp_mark_sites)
+        return;
+    g_hash_table_iter_init(&iter, tmp_mark_sites);
+    while (g_hash_table_iter_next(&iter, &key, &val))
+        func(key, GPOINTER_TO_SIZE(val), data);
+#endif
+}
+
 // Allocate space for a string, creating a new pool if necessary
 static char *
 tmp_alloc(size_t size_req)
@@ -0,0 +1,555 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "auction.h"
+#include "testing.h"
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+bool is_open_auction(struct auction_data *auc);
+
+#define ITEM_VNUM 100
+#define SIM_AUCTIONS 5000
+#define SIM_ROOMS 10
+#define SIM_BIDDERS 200
+#define SIM_BIDS_PER_SECOND 20
+#define SIM_BIDDING_TIME 1500
+
+static char *auction_dir = NULL;
+static char *auction_file = NULL;
+
+static void
+clear_auction_files(void)
+{
+    DIR *dir = opendir(auction_dir);
+    struct dirent *file;
+
+    if (dir) {
+        while ((file = readdir(dir)) != NULL)
+            if (file->d_name[0] != '.')
+                unlink(tmp_sprintf("%s/%s", auction_dir, file->d_name));
+        closedir(dir);
+    }
+    unlink(auction_file);
+}
+
+// Forgets the auctions without ending them
+static void
+forget_auctions(void)
+{
+    while (auctions) {
+        struct auction_data *auc = auctions->data;
+
+        remove_auction(auc);
+        free_auction(auc);
+    }
+}
+
+void
+fixture_auction_setup(void)
+{
+    test_world_init();
+    make_test_proto(ITEM_VNUM, "a test object", "test object");
+
+    auction_dir = g_strdup(test_path("auctions"));
+    auction_file = g_strdup(test_path("auctions.xml"));
+    AUC_DIR_PATH = auction_dir;
+    AUC_FILE_PATH = auction_file;
+    mkdir(auction_dir, 0755);
+    clear_auction_files();
+}
+
+void
+fixture_auction_teardown(void)
+{
+    forget_auctions();
+    clear_auction_files();
+    g_free(auction_dir);
+    g_free(auction_file);
+}
+
+static struct auction_data *
+make_test_auction(long room_id, money_t start_bid, time_t start_time)
+{
+    struct auction_data *auc = new_auction();
+
+    auc->idnum = unused_auction_idnum();
+    auc->room_id = room_id;
+    auc->owner_id = 1;
+    auc->start_bid = start_bid;
+    auc->start_time = start_time;
+    add_auction(auc);
+
+    return auc;
+}
+
+// The greatest bid, found by looking at them all
+static struct bid_data *
+greatest_bid(struct auction_data *auc)
+{
+    struct bid_data *result = NULL;
+
+    for (guint i = 0; i < auc->bids->len; i++) {
+        struct bid_data *bid = g_ptr_array_index(auc->bids, i);
+
+        if (!result || bid_total(bid) > bid_total(result))
+            result = bid;
+    }
+    return result;
+}
+
+static void
+check_bid_heap(struct auction_data *auc)
+{
+    for (guint i = 0; i < auc->bids->len; i++) {
+        struct bid_data *bid = g_ptr_array_index(auc->bids, i);
+
+        fail_unless(bid->heap_index == i);
+        fail_unless(bid_by_bidder_idnum(auc, bid->bidder_id) == bid);
+        if (i > 0)
+            fail_unless(bid_total(g_ptr_array_index(auc->bids, (i - 1) / 2))
+                        >= bid_total(bid), "bid %u is above its parent", i);
+    }
+    fail_unless(g_hash_table_size(auc->bidders) == auc->bids->len);
+    if (auc->bids->len)
+        fail_unless(bid_total(auction_winning_bid(auc))
+                    == bid_total(greatest_bid(auc)));
+    else
+        fail_unless(auction_winning_bid(auc) == NULL);
+}
+
+static gint
+compare_auction_idnums(struct auction_data *a, struct auction_data *b)
+{
+    return (a->idnum > b->idnum) - (a->idnum < b->idnum);
+}
+
+START_TEST(test_auction_bid_heap)
+{
+    struct auction_data *auc = make_test_auction(1, 100, time(NULL));
+
+    check_bid_heap(auc);
+    for (int i = 0; i < 2000; i++) {
+        add_auction_bid(auc, number(1, 50), number(0, 1000), number(0, 1000));
+        check_bid_heap(auc);
+    }
+    fail_unless(auc->bids->len <= 50);
+
+    // Equal bids leave the first bidder winning
+    auc = make_test_auction(1, 100, time(NULL));
+    add_auction_bid(auc, 10, 500, 0);
+    add_auction_bid(auc, 11, 0, 500);
+    fail_unless(auction_winning_bid(auc)->bidder_id == 10);
+    add_auction_bid(auc, 11, 1, 0);
+    fail_unless(auction_winning_bid(auc)->bidder_id == 11);
+    fail_unless(auction_minimum_bid(auc) == 501 + 5);
+}
+END_TEST
+
+START_TEST(test_auction_index)
+{
+    time_t now = time(NULL);
+    struct auction_data *aucs[10];
+
+    for (int i = 0; i < 10; i++) {
+        aucs[i] = make_test_auction(1, 100, now);
+        fail_unless(aucs[i]->idnum == (uint32_t)i + 1);
+    }
+    for (int i = 0; i <= 11; i++)
+        fail_unless(auction_data_from_idnum(i)
+                    == auction_data_from_idnum_scan(i));
+
+    // Numbers are reused only from the top
+    remove_auction(aucs[4]);
+    free_auction(aucs[4]);
+    fail_unless(auction_data_from_idnum(5) == NULL);
+    fail_unless(unused_auction_idnum() == 11);
+    for (int i = 9; i >= 5; i--) {
+        remove_auction(aucs[i]);
+        free_auction(aucs[i]);
+    }
+    fail_unless(unused_auction_idnum() == 5);
+}
+END_TEST
+
+START_TEST(test_auction_deadlines)
+{
+    time_t start = time(NULL);
+    enum auction_state states[] = {
+        AUCTION_STARTED, AUCTION_ANNOUNCED, AUCTION_NO_BIDS,
+        AUCTION_NEW_BID, AUCTION_BID_ANNOUNCED, AUCTION_GOING_ONCE,
+        AUCTION_GOING_TWICE
+    };
+
+    // The deadline is the first time the auction is due
+    for (size_t s = 0; s < G_N_ELEMENTS(states); s++) {
+        for (int with_bid = 0; with_bid < 2; with_bid++) {
+            struct auction_data *auc = new_auction();
+            time_t deadline;
+
+            auc->state = states[s];
+            auc->start_time = start;
+            if (with_bid) {
+                add_auction_bid(auc, 10, 200, 0);
+                auc->last_bid_time = start + 30;
+            }
+            deadline = auction_deadline(auc);
+            for (time_t now = start; now < start + AUCTION_THRESH + 10; now++)
+                fail_unless(auction_is_due(auc, now)
+                            == (deadline >= 0 && now >= deadline),
+                            "state %d, bid %d is wrong at %ld", states[s],
+                            with_bid, (long)(now - start));
+            free_auction(auc);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_auction_queue_late_times)
+{
+    time_t start = boot_time = ((time_t)1 << 32) + 100;
+    struct auction_data *early, *late;
+    GList *due;
+
+    // Deadlines past the range of an int are still queued in order
+    late = make_test_auction(1, 100, start + 20);
+    early = make_test_auction(1, 100, start);
+    late->state = early->state = AUCTION_ANNOUNCED;
+    schedule_auction(late);
+    schedule_auction(early);
+    fail_unless(due_auctions(1, auction_deadline(early) - 1) == NULL);
+    due = due_auctions(1, auction_deadline(late));
+    fail_unless(g_list_length(due) == 2);
+    fail_unless(due->data == early && due->next->data == late);
+    g_list_free(due);
+    boot_time = 0;
+}
+END_TEST
+
+START_TEST(test_auction_save_load)
+{
+    time_t now = time(NULL);
+    struct auction_data *auc;
+
+    // New auctions are saved at once
+    for (int i = 0; i < 5; i++)
+        add_new_auction(1 + i % 2, 2, 100 * (i + 1), read_object(ITEM_VNUM));
+    fail_unless(save_auctions() == 0);
+
+    for (int i = 1; i < 5; i++) {
+        auc = auction_data_from_idnum(i + 1);
+        for (int b = 0; b < i; b++)
+            add_auction_bid(auc, 10 + b, 100 * (i + 1) + 10 * b, 5);
+        auc->last_bid_time = now - i;
+    }
+    fail_unless(save_auctions() == 4);
+    fail_unless(save_auctions() == 0);
+
+    // Only the auction bid upon is written again
+    add_auction_bid(auction_data_from_idnum(3), 10, 1000, 0);
+    fail_unless(save_auctions() == 1);
+
+    // The auctions are read back, though there are no settings to load
+    forget_auctions();
+    fail_if(load_auctions());
+    fail_unless(g_list_length(auctions) == 5);
+    for (int i = 0; i < 5; i++) {
+        auc = auction_data_from_idnum(i + 1);
+        fail_unless(auc != NULL);
+        fail_unless(auc->room_id == 1 + i % 2);
+        fail_unless(auc->start_bid == 100 * (i + 1));
+        fail_unless(auc->item != NULL);
+        fail_unless(auc->bids->len == (guint)i);
+        fail_if(auc->dirty);
+        check_bid_heap(auc);
+        if (i > 0) {
+            fail_unless(auc->last_bid_time == now - i);
+            fail_unless(auc->state == AUCTION_NEW_BID);
+        } else {
+            fail_unless(auc->state == AUCTION_STARTED);
+        }
+    }
+    fail_unless(auction_winning_bid(auction_data_from_idnum(3))->bidder_id == 10);
+    fail_unless(bid_total(auction_winning_bid(auction_data_from_idnum(5)))
+                == 500 + 30 + 5);
+}
+END_TEST
+
+START_TEST(test_auction_migration)
+{
+    struct auction_data *auc;
+    FILE *ouf;
+
+    // Auctions used to be kept in the settings file, with their bids
+    // from the greatest to the least
+    ouf = fopen(auction_file, "w");
+    fail_unless(ouf != NULL);
+    fprintf(ouf, "<?xml version=\"1.0\"?>\n"
+            "<auctioneer going_once=\"40\" going_twice=\"80\" "
+            "sold_time=\"120\" nobid_thresh=\"400\" auction_thresh=\"800\" "
+            "max_auc_value=\"1000000\" max_auctions=\"5\" "
+            "max_total_auc=\"100\" bid_increment=\"0.100000\">\n"
+            "<itemdata id=\"2\" room_id=\"1\" owner_id=\"3\" start_bid=\"100\">\n"
+            "<object vnum=\"%d\"/>\n"
+            "  <bid bidder=\"12\"  past_amount=\"300\" future_amount=\"0\"/>\n"
+            "  <bid bidder=\"11\"  past_amount=\"200\" future_amount=\"0\"/>\n"
+            "  <bid bidder=\"10\"  past_amount=\"100\" future_amount=\"0\"/>\n"
+            "</itemdata>\n"
+            "<itemdata id=\"0\" room_id=\"1\" owner_id=\"3\" start_bid=\"50\">\n"
+            "<object vnum=\"%d\"/>\n"
+            "</itemdata>\n"
+            "</auctioneer>", ITEM_VNUM, ITEM_VNUM);
+    fclose(ouf);
+
+    fail_unless(load_auctions());
+    fail_unless(GOING_ONCE == 40);
+    fail_unless(AUCTION_THRESH == 800);
+    fail_unless(g_list_length(auctions) == 2);
+    auc = auction_data_from_idnum(2);
+    fail_unless(auc != NULL);
+    fail_unless(auction_winning_bid(auc)->bidder_id == 12);
+    fail_unless(auc->state == AUCTION_NEW_BID);
+    fail_unless(auc->last_bid_time != 0);
+    fail_unless(auction_data_from_idnum(3) != NULL);
+
+    // The auctions are moved to their own files, and read from there
+    forget_auctions();
+    fail_unless(load_auctions());
+    fail_unless(g_list_length(auctions) == 2);
+    fail_unless(auction_winning_bid(auction_data_from_idnum(2))->bidder_id
+                == 12);
+    fail_unless(save_auctions() == 0);
+}
+END_TEST
+
+START_TEST(test_auction_migration_unsaved)
+{
+    char *settings;
+    FILE *ouf;
+
+    ouf = fopen(auction_file, "w");
+    fail_unless(ouf != NULL);
+    fprintf(ouf, "<?xml version=\"1.0\"?>\n"
+            "<auctioneer going_once=\"40\" going_twice=\"80\" "
+            "sold_time=\"120\" nobid_thresh=\"400\" auction_thresh=\"800\" "
+            "max_auc_value=\"1000000\" max_auctions=\"5\" "
+            "max_total_auc=\"100\" bid_increment=\"0.100000\">\n"
+            "<itemdata id=\"2\" room_id=\"1\" owner_id=\"3\" start_bid=\"100\">\n"
+            "<object vnum=\"%d\"/>\n"
+            "</itemdata>\n"
+            "</auctioneer>", ITEM_VNUM);
+    fclose(ouf);
+
+    // The settings file keeps the auctions until they can be saved
+    AUC_DIR_PATH = test_path("auctions.xml/auctions");
+    fail_unless(load_auctions());
+    fail_unless(g_file_get_contents(auction_file, &settings, NULL, NULL));
+    fail_unless(strstr(settings, "<itemdata") != NULL);
+    g_free(settings);
+
+    AUC_DIR_PATH = auction_dir;
+    fail_unless(save_auctions() == 1);
+    fail_unless(g_file_get_contents(auction_file, &settings, NULL, NULL));
+    fail_unless(strstr(settings, "<itemdata") == NULL);
+    fail_unless(strstr(settings, "going_once=\"40\"") != NULL);
+    g_free(settings);
+}
+END_TEST
+
+// Does what the auctioneer does with a due auction, apart from the
+// announcements.  Returns true if the auction is over.
+static bool
+advance_test_auction(struct auction_data *auc, time_t now, int *sold)
+{
+    if (!auc->last_bid_time && now - auc->start_time > AUCTION_THRESH)
+        return true;
+
+    switch (auc->state) {
+    case AUCTION_STARTED:
+        auc->state = AUCTION_ANNOUNCED;
+        break;
+    case AUCTION_ANNOUNCED:
+        if (auc->bids->len == 0 && now - auc->start_time > NO_BID_THRESH)
+            auc->state = AUCTION_NO_BIDS;
+        break;
+    case AUCTION_NEW_BID:
+        auc->state = AUCTION_BID_ANNOUNCED;
+        break;
+    case AUCTION_BID_ANNOUNCED:
+        if (now - auc->last_bid_time > GOING_ONCE)
+            auc->state = AUCTION_GOING_ONCE;
+        break;
+    case AUCTION_GOING_ONCE:
+        if (now - auc->last_bid_time > GOING_TWICE)
+            auc->state = AUCTION_GOING_TWICE;
+        break;
+    case AUCTION_GOING_TWICE:
+        if (now - auc->last_bid_time > SOLD_TIME) {
+            check_bid_heap(auc);
+            (*sold)++;
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+    return false;
+}
+
+START_TEST(test_auction_simulation)
+{
+    struct timespec start, end, len, scan_total = { 0, 0 }, queue_total = { 0, 0 };
+    time_t begin = time(NULL), now;
+    int sold = 0, expired = 0, bids = 0, due_count = 0;
+
+    GOING_ONCE = 45;
+    GOING_TWICE = 90;
+    SOLD_TIME = 135;
+    NO_BID_THRESH = 450;
+    AUCTION_THRESH = 900;
+    BID_INCREMENT = 0.05;
+
+    for (int i = 0; i < SIM_AUCTIONS; i++)
+        make_test_auction(i % SIM_ROOMS + 1, number(1, 1000) * 100,
+                          begin - number(0, 300));
+    fail_unless(g_list_length(auctions) == SIM_AUCTIONS);
+
+    for (now = begin; auctions && now < begin + 3 * AUCTION_THRESH; now++) {
+        if (now < begin + SIM_BIDDING_TIME) {
+            for (int b = 0; b < SIM_BIDS_PER_SECOND; b++) {
+                struct auction_data *auc =
+                    auction_data_from_idnum(number(1, SIM_AUCTIONS));
+                long bidder = number(1, SIM_BIDDERS);
+                struct bid_data *bid;
+                money_t amount;
+
+                if (!auc || !is_open_auction(auc))
+                    continue;
+                amount = auction_minimum_bid(auc) + number(0, auc->start_bid);
+                bid = bid_by_bidder_idnum(auc, bidder);
+                if (bid)
+                    amount -= bid_total(bid);
+                add_auction_bid(auc, bidder, amount / 2, amount - amount / 2);
+                fail_unless(auction_winning_bid(auc)->bidder_id == bidder);
+                auc->last_bid_time = now;
+                auc->state = AUCTION_NEW_BID;
+                schedule_auction(auc);
+                bids++;
+            }
+        }
+
+        for (long room_id = 1; room_id <= SIM_ROOMS; room_id++) {
+            GList *scan, *due;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            scan = due_auctions_scan(room_id, now);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            len = timediff(&end, &start);
+            scan_total.tv_sec += len.tv_sec;
+            scan_total.tv_nsec += len.tv_nsec;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            due = due_auctions(room_id, now);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            len = timediff(&end, &start);
+            queue_total.tv_sec += len.tv_sec;
+            queue_total.tv_nsec += len.tv_nsec;
+
+            scan = g_list_sort(scan, (GCompareFunc)compare_auction_idnums);
+            due = g_list_sort(due, (GCompareFunc)compare_auction_idnums);
+            fail_unless(g_list_length(scan) == g_list_length(due),
+                        "room %ld at %ld: %d due, %d in the queue", room_id,
+                        (long)(now - begin), g_list_length(scan),
+                        g_list_length(due));
+            for (GList *s = scan, *d = due; s; s = s->next, d = d->next)
+                fail_unless(s->data == d->data);
+
+            for (GList *it = due; it; it = it->next) {
+                struct auction_data *auc = it->data;
+
+                due_count++;
+                if (advance_test_auction(auc, now, &sold)) {
+                    if (auc->bids->len == 0)
+                        expired++;
+                    remove_auction(auc);
+                    free_auction(auc);
+                } else {
+                    schedule_auction(auc);
+                }
+            }
+            g_list_free(scan);
+            g_list_free(due);
+        }
+    }
+    fail_unless(auctions == NULL, "%d auctions never ended",
+                g_list_length(auctions));
+    fail_unless(sold + expired == SIM_AUCTIONS);
+    fail_unless(sold > 0);
+
+    scan_total.tv_sec += scan_total.tv_nsec / 1000000000;
+    scan_total.tv_nsec %= 1000000000;
+    queue_total.tv_sec += queue_total.tv_nsec / 1000000000;
+    queue_total.tv_nsec %= 1000000000;
+    printf("auction simulation: %d auctions in %d rooms, %d bids over "
+           "%ld seconds, %d sold, %d expired, %d due: "
+           "scan %ld.%03lds, queued %ld.%03lds\n",
+           SIM_AUCTIONS, SIM_ROOMS, bids, (long)(now - begin), sold, expired,
+           due_count,
+           (long)scan_total.tv_sec, scan_total.tv_nsec / 1000000,
+           (long)queue_total.tv_sec, queue_total.tv_nsec / 1000000);
+}
+END_TEST
+
+Suite *
+auction_suite(void)
+{
+    Suite *s = suite_create("auction");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_auction_setup,
+                              fixture_auction_teardown);
+    tcase_add_test(tc_core, test_auction_bid_heap);
+    tcase_add_test(tc_core, test_auction_index);
+    tcase_add_test(tc_core, test_auction_deadlines);
+    tcase_add_test(tc_core, test_auction_queue_late_times);
+    tcase_add_test(tc_core, test_auction_save_load);
+    tcase_add_test(tc_core, test_auction_migration);
+    tcase_add_test(tc_core, test_auction_migration_unsaved);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_auction_setup,
+                                  fixture_auction_teardown);
+        tcase_add_test(tc_bench, test_auction_simulation);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
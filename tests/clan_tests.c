@@ -0,0 +1,321 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "accstr.h"
+#include "clan.h"
+#include "testing.h"
+
+extern struct clan_data *clan_list;
+extern struct descriptor_data *descriptor_list;
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+#define BENCH_CLANS 500
+#define BENCH_MEMBERS 20000
+#define BENCH_ONLINE 1000
+
+static const char *clan_tables[] = {
+    "clans", "clan_ranks", "clan_members", "clan_rooms"
+};
+
+// The clan tables are shadowed by empty temporary tables, so the
+// tests don't touch the clans in the database
+void
+fixture_clan_setup(void)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(clan_tables); i++)
+        sql_exec("create temporary table %s (like %s)", clan_tables[i],
+                 clan_tables[i]);
+}
+
+void
+fixture_clan_teardown(void)
+{
+    while (descriptor_list) {
+        struct descriptor_data *d = descriptor_list;
+
+        descriptor_list = d->next;
+        char_from_room(d->creature, false);
+        free_creature(d->creature);
+        free(d);
+    }
+    while (clan_list)
+        delete_clan(clan_list);
+    flush_clan_sql();
+
+    for (size_t i = 0; i < G_N_ELEMENTS(clan_tables); i++)
+        sql_exec("drop table pg_temp.%s", clan_tables[i]);
+}
+
+static int
+count_rows(const char *query)
+{
+    return atoi(PQgetvalue(sql_query("%s", query), 0, 0));
+}
+
+// Checks that the member list is in rank order and agrees with the
+// index of members
+static void
+check_clan_roster(struct clan_data *clan)
+{
+    int count = 0;
+
+    for (struct clanmember_data *member = clan->member_list; member;
+         member = member->next) {
+        fail_unless(real_clanmember(member->idnum, clan) == member);
+        if (member->next)
+            fail_unless(member->rank >= member->next->rank,
+                        "rank %d listed before rank %d", member->rank,
+                        member->next->rank);
+        count++;
+    }
+    fail_unless(count == clan->member_count);
+    fail_unless(count == (int)g_hash_table_size(clan->members));
+}
+
+static struct descriptor_data *
+make_test_descriptor(long idnum, int clan, int level)
+{
+    struct descriptor_data *d;
+    struct creature *ch = make_creature(true);
+
+    CREATE(d, struct descriptor_data, 1);
+    GET_IDNUM(ch) = idnum;
+    GET_CLAN(ch) = clan;
+    GET_LEVEL(ch) = level;
+    ch->player.name = strdup(tmp_sprintf("Player%ld", idnum));
+    char_to_room(ch, real_room(1), false);
+    ch->desc = d;
+    d->creature = ch;
+    d->input_mode = CXN_PLAYING;
+    d->next = descriptor_list;
+    descriptor_list = d;
+
+    return d;
+}
+
+START_TEST(test_clan_roster)
+{
+    struct clan_data *clan = create_clan(1);
+    int ranks[] = { 0, 3, 1, 3, 0, 2 };
+
+    for (size_t i = 0; i < G_N_ELEMENTS(ranks); i++)
+        add_clan_member(clan, 100 + i, ranks[i], false);
+    check_clan_roster(clan);
+    fail_unless(clan->member_count == 6);
+    fail_unless(clan->member_list->rank == 3);
+    fail_unless(real_clanmember(99, clan) == NULL);
+
+    set_clanmember_rank(clan, real_clanmember(100, clan), 4);
+    check_clan_roster(clan);
+    fail_unless(clan->member_list->idnum == 100);
+
+    set_clanmember_rank(clan, real_clanmember(101, clan), 0);
+    check_clan_roster(clan);
+
+    remove_member_from_clan(real_clanmember(102, clan), clan);
+    check_clan_roster(clan);
+    fail_unless(real_clanmember(102, clan) == NULL);
+
+    dismiss_clan_member(clan, 103);
+    check_clan_roster(clan);
+    fail_unless(clan->member_count == 4);
+    fail_unless(real_clan(1) == clan);
+}
+END_TEST
+
+START_TEST(test_clan_batched_sql)
+{
+    struct clan_data *clan = create_clan(1);
+    struct clanmember_data *member;
+
+    flush_clan_sql();
+    enroll_clan_member(clan, 100);
+    enroll_clan_member(clan, 101);
+    member = enroll_clan_member(clan, 102);
+    set_clanmember_rank(clan, member, 5);
+    dismiss_clan_member(clan, 101);
+
+    // Nothing is written until the queue is flushed
+    fail_unless(count_rows("select count(*) from clan_members") == 0);
+    flush_clan_sql();
+    fail_unless(count_rows("select count(*) from clan_members") == 2);
+    fail_unless(count_rows("select rank from clan_members where player=102")
+                == 5);
+
+    // Forget the clan without the deletion reaching the database, and
+    // read it back
+    delete_clan(clan);
+    fail_unless(real_clan(1) == NULL);
+    fail_unless(boot_clans());
+    flush_clan_sql();
+
+    clan = real_clan(1);
+    fail_unless(clan != NULL);
+    check_clan_roster(clan);
+    fail_unless(clan->member_count == 2);
+    fail_unless(clan->member_list->idnum == 102);
+    fail_unless(clan->member_list->rank == 5);
+    fail_unless(real_clanmember(101, clan) == NULL);
+}
+END_TEST
+
+START_TEST(test_clan_sql_order)
+{
+    // A clan deleted and made again must reach the database in the
+    // same order, or the queued deletion removes the new clan
+    delete_clan(create_clan(1));
+    create_clan(1);
+    fail_unless(count_rows("select count(*) from clans") == 0);
+    flush_clan_sql();
+    fail_unless(count_rows("select count(*) from clans where idnum=1") == 1);
+}
+END_TEST
+
+START_TEST(test_clan_member_listing)
+{
+    struct clan_data *clan = create_clan(1);
+    struct descriptor_data *viewer;
+    char *scan;
+
+    create_clan(2);
+    for (int i = 0; i < 10; i++)
+        add_clan_member(clan, 100 + i, i % 4, false);
+
+    viewer = make_test_descriptor(100, 1, 20);
+    for (int i = 1; i < 8; i++)
+        make_test_descriptor(100 + i, 1, 5 * i);
+    // In another clan, not yet playing, and logged in twice
+    make_test_descriptor(108, 2, 20);
+    make_test_descriptor(109, 1, 20)->input_mode = CXN_MENU;
+    make_test_descriptor(103, 1, 15);
+
+    for (int min_lev = 0; min_lev <= 40; min_lev += 10) {
+        acc_string_clear();
+        acc_print_clan_members_scan(viewer->creature, clan, false, min_lev);
+        scan = tmp_strdup(acc_get_string());
+        acc_string_clear();
+        acc_print_clan_members(viewer->creature, clan, false, min_lev);
+        fail_unless(!strcmp(scan, acc_get_string()),
+                    "listing above level %d changed:\n%s\nbecame\n%s",
+                    min_lev, scan, acc_get_string());
+    }
+}
+END_TEST
+
+START_TEST(test_clan_benchmark)
+{
+    struct timespec start, end, boot_len, scan_len, index_len;
+    struct clan_data *viewers[BENCH_CLANS + 1] = { NULL };
+    struct creature *viewer_chars[BENCH_CLANS + 1] = { NULL };
+    GPtrArray *listings = g_ptr_array_new_with_free_func(g_free);
+    int clans = 0, members = 0;
+
+    sql_exec("insert into clans (idnum, name, badge, password, bank) "
+             "select g, 'Clan ' || g, '(Clan ' || g || ')', '', 0 "
+             "from generate_series(1, %d) g", BENCH_CLANS);
+    sql_exec("insert into clan_members (clan, player, rank, no_mail) "
+             "select g %% %d + 1, g, g %% %d, 'f' "
+             "from generate_series(1, %d) g",
+             BENCH_CLANS, NUM_CLAN_RANKS, BENCH_MEMBERS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fail_unless(boot_clans());
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    boot_len = timediff(&end, &start);
+
+    for (struct clan_data *clan = clan_list; clan; clan = clan->next) {
+        check_clan_roster(clan);
+        clans++;
+        members += clan->member_count;
+    }
+    fail_unless(clans == BENCH_CLANS);
+    fail_unless(members == BENCH_MEMBERS);
+
+    for (int idnum = 1; idnum <= BENCH_ONLINE; idnum++) {
+        int clan_num = idnum % BENCH_CLANS + 1;
+        struct descriptor_data *d =
+            make_test_descriptor(idnum, clan_num, idnum % 40 + 1);
+
+        viewers[clan_num] = real_clan(clan_num);
+        viewer_chars[clan_num] = d->creature;
+    }
+
+    // The old way: look through the descriptors for each member
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int c = 1; c <= BENCH_CLANS; c++) {
+        acc_string_clear();
+        acc_print_clan_members_scan(viewer_chars[c], viewers[c], false, 0);
+        g_ptr_array_add(listings, g_strdup(acc_get_string()));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    scan_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int c = 1; c <= BENCH_CLANS; c++) {
+        acc_string_clear();
+        acc_print_clan_members(viewer_chars[c], viewers[c], false, 0);
+        fail_unless(!strcmp(g_ptr_array_index(listings, c - 1),
+                            acc_get_string()));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    index_len = timediff(&end, &start);
+
+    printf("clan benchmark: %d clans, %d members, %d online: "
+           "boot %ld.%03lds, %d listings scan %ld.%03lds, indexed %ld.%03lds\n",
+           BENCH_CLANS, BENCH_MEMBERS, BENCH_ONLINE,
+           (long)boot_len.tv_sec, boot_len.tv_nsec / 1000000,
+           BENCH_CLANS,
+           (long)scan_len.tv_sec, scan_len.tv_nsec / 1000000,
+           (long)index_len.tv_sec, index_len.tv_nsec / 1000000);
+    g_ptr_array_free(listings, true);
+}
+END_TEST
+
+Suite *
+clan_suite(void)
+{
+    Suite *s = suite_create("clan");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, test_tempus_boot, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_clan_setup,
+                              fixture_clan_teardown);
+    tcase_add_test(tc_core, test_clan_roster);
+    tcase_add_test(tc_core, test_clan_batched_sql);
+    tcase_add_test(tc_core, test_clan_sql_order);
+    tcase_add_test(tc_core, test_clan_member_listing);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, test_tempus_boot, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_clan_setup,
+                                  fixture_clan_teardown);
+        tcase_add_test(tc_bench, test_clan_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
@@ -0,0 +1,144 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "strutil.h"
+#include "testing.h"
+
+extern GList *creatures;
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+void perform_violence(void);
+void perform_violence1(struct creature *ch, gpointer ignore);
+
+#define IDLE_MOBS 50000
+#define FIGHTS 200
+
+static struct zone_data *zone = NULL;
+
+void
+fixture_combat_setup(void)
+{
+    test_world_init();
+
+    zone = make_zone(1);
+}
+
+// Keeps a fighter from swinging, so the rounds only measure how long
+// it takes to find the combatants.
+static void
+hold_fighter(struct creature *mob)
+{
+    GET_POSITION(mob) = POS_SITTING;
+    GET_NPC_WAIT(mob) = 1000000;
+}
+
+START_TEST(test_combatant_set)
+{
+    struct room_data *room = make_room(zone, 1);
+    struct creature *a = make_test_mob("combatmob", room);
+    struct creature *b = make_test_mob("combatmob", room);
+    struct creature *c = make_test_mob("combatmob", room);
+
+    fail_unless(combatant_count() == 0);
+    add_combat(a, b, true);
+    add_combat(b, a, false);
+    fail_unless(combatant_count() == 2);
+    add_combat(a, c, true);
+    fail_unless(combatant_count() == 2);
+
+    remove_combat(a, b);
+    fail_unless(combatant_count() == 2);
+    remove_combat(a, c);
+    fail_unless(combatant_count() == 1);
+    remove_all_combat(b);
+    fail_unless(combatant_count() == 0);
+}
+END_TEST
+
+START_TEST(test_combat_benchmark)
+{
+    struct room_data *idle_room = make_room(zone, 1);
+    struct timespec start, end, sweep_len, set_len;
+    int i;
+
+    for (i = 0; i < IDLE_MOBS; i++)
+        make_test_mob("combatmob", idle_room);
+
+    for (i = 0; i < FIGHTS; i++) {
+        struct room_data *room = make_room(zone, i + 2);
+        struct creature *a = make_test_mob("combatmob", room);
+        struct creature *b = make_test_mob("combatmob", room);
+
+        hold_fighter(a);
+        hold_fighter(b);
+        add_combat(a, b, true);
+        add_combat(b, a, false);
+    }
+    fail_unless(combatant_count() == FIGHTS * 2);
+
+    // The old way: visit every creature in the world
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < 100; i++)
+        g_list_foreach(creatures, (GFunc) perform_violence1, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sweep_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < 100; i++)
+        perform_violence();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    set_len = timediff(&end, &start);
+
+    fail_unless(combatant_count() == FIGHTS * 2);
+    printf("combat benchmark: 100 rounds, %d mobs, %d fights: "
+           "sweep %ld.%03lds, combatant set %ld.%03lds\n",
+           IDLE_MOBS + FIGHTS * 2, FIGHTS,
+           (long)sweep_len.tv_sec, sweep_len.tv_nsec / 1000000,
+           (long)set_len.tv_sec, set_len.tv_nsec / 1000000);
+}
+END_TEST
+
+Suite *
+combat_suite(void)
+{
+    Suite *s = suite_create("combat");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_combat_setup, NULL);
+    tcase_add_test(tc_core, test_combatant_set);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_combat_setup, NULL);
+        tcase_add_test(tc_bench, test_combat_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
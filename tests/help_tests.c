@@ -0,0 +1,387 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "strutil.h"
+#include "help.h"
+#include "testing.h"
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+#define BENCH_TOPICS 3000
+#define BENCH_VOCABULARY 4000
+#define BENCH_TEXT_WORDS 200
+#define BENCH_LOOKUPS 2000
+#define BENCH_SEARCHES 100
+
+static struct help_collection *col = NULL;
+static char *store_path = NULL;
+
+void
+fixture_help_setup(void)
+{
+    col = make_help_collection();
+    store_path = tmp_strdup(test_path("help.store"));
+    unlink(store_path);
+}
+
+void
+fixture_help_teardown(void)
+{
+    free_help_collection(col);
+    col = NULL;
+    unlink(store_path);
+}
+
+static struct help_item *
+add_test_topic(const char *name, const char *keys, int groups,
+               const char *text)
+{
+    struct help_item *item = make_help_item();
+
+    item->idnum = ++col->top_id;
+    free(item->name);
+    item->name = strdup(name);
+    free(item->keys);
+    item->keys = strdup(keys);
+    item->groups = groups;
+    item->flags = 0;
+    item->text = strdup(text);
+    help_collection_push(col, item);
+
+    return item;
+}
+
+static void
+add_test_topics(void)
+{
+    add_test_topic("Search", "search", HGROUP_PLAYER | HGROUP_SKILL,
+                   "Lets you &cfind&n hidden doors and traps.");
+    add_test_topic("Magic Missile", "\"magic missile\" missile mm",
+                   HGROUP_PLAYER | HGROUP_SPELL,
+                   "Hurls a bolt of magic at a single target.");
+    add_test_topic("Magic Items", "magic items", HGROUP_PLAYER,
+                   "Wands, staves and scrolls hold magic.");
+    add_test_topic("Medit", "medit mobile", HGROUP_OLC,
+                   "Edits a mobile prototype.  Find it with mlist.");
+    add_test_topic("Secret", "secret search", HGROUP_PLAYER,
+                   "Hidden things.")->flags = HFLAG_UNAPPROVED;
+    add_test_topic("Mobiles", "mobile mobiles", HGROUP_PLAYER | HGROUP_OLC,
+                   "Every monster is a mobile.");
+}
+
+// Checks that the index finds the same topics as the old scan
+static void
+check_find_items(const char *args, bool find_no_approve, int thegroup)
+{
+    struct help_item *scan, *indexed;
+
+    scan = help_collection_find_items_scan(col, tmp_strdup(args),
+                                           find_no_approve, thegroup, false);
+    indexed = help_collection_find_items(col, tmp_strdup(args),
+                                         find_no_approve, thegroup, false);
+    fail_unless(scan == indexed, "'%s' in group %d found #%d, not #%d", args,
+                thegroup, indexed ? indexed->idnum : 0,
+                scan ? scan->idnum : 0);
+
+    scan = help_collection_find_items_scan(col, tmp_strdup(args),
+                                           find_no_approve, thegroup, true);
+    indexed = help_collection_find_items(col, tmp_strdup(args),
+                                         find_no_approve, thegroup, true);
+    while (scan && indexed && scan == indexed) {
+        scan = scan->next_show;
+        indexed = indexed->next_show;
+    }
+    fail_unless(!scan && !indexed,
+                "searching '%s' in group %d found different topics", args,
+                thegroup);
+}
+
+START_TEST(test_help_find_items)
+{
+    const char *args[] = { "search", "SEA", "magic", "magic missile", "mi",
+                           "mob", "mobiles", "m", "s", "xyzzy" };
+    const int groups[] = { 0, -1, HGROUP_PLAYER, HGROUP_OLC, HGROUP_SPELL,
+                           HGROUP_PLAYER | HGROUP_OLC };
+
+    add_test_topics();
+    for (size_t i = 0; i < G_N_ELEMENTS(args); i++) {
+        for (size_t g = 0; g < G_N_ELEMENTS(groups); g++) {
+            check_find_items(args[i], false, groups[g]);
+            check_find_items(args[i], true, groups[g]);
+        }
+    }
+
+    fail_unless(help_collection_find_items(col, tmp_strdup("mag"), false,
+                                           HGROUP_PLAYER, false)->idnum == 2);
+    fail_unless(help_collection_find_items(col, tmp_strdup("mob"), false,
+                                           HGROUP_PLAYER, false)->idnum == 6);
+    fail_unless(help_collection_find_items(col, tmp_strdup("mob"), false,
+                                           HGROUP_OLC, false)->idnum == 4);
+    fail_unless(help_collection_find_items(col, tmp_strdup("secret"), false,
+                                           0, false) == NULL);
+}
+END_TEST
+
+START_TEST(test_help_keys_changed)
+{
+    struct help_item *item;
+
+    add_test_topics();
+    fail_unless(help_collection_find_items(col, tmp_strdup("mm"), false,
+                                           0, false)->idnum == 2);
+
+    // New keywords and groups are indexed before the next lookup
+    add_test_topic("Mana", "mana mm", HGROUP_PLAYER, "Magic power.");
+    item = help_collection_find_item_by_id(col, 2);
+    free(item->keys);
+    item->keys = strdup("\"magic missile\" missile");
+    col->keys_stale = true;
+    fail_unless(help_collection_find_items(col, tmp_strdup("mm"), false,
+                                           0, false)->idnum == 7);
+    check_find_items("mm", false, HGROUP_PLAYER);
+    check_find_items("magic", false, HGROUP_SPELL);
+}
+END_TEST
+
+START_TEST(test_help_store)
+{
+    struct help_item *item;
+
+    add_test_topics();
+    fail_unless(help_collection_build_store(col, store_path));
+    fail_unless(col->store_size > 0);
+    fail_unless(access(tmp_strcat(store_path, ".new", NULL), F_OK) < 0);
+
+    // Topics are served from the store once their text is let go
+    help_collection_sync(col);
+    for (GList *it = col->items; it; it = it->next) {
+        item = it->data;
+        fail_unless(item->text == NULL);
+        fail_unless(item->stored_text != NULL);
+    }
+    item = help_collection_find_item_by_id(col, 4);
+    fail_unless(!strcmp(help_item_text(item),
+                        "Edits a mobile prototype.  Find it with mlist."));
+
+    // Editors get a copy to change
+    fail_unless(help_item_load_text(item));
+    fail_unless(item->text != item->stored_text);
+    fail_unless(!strcmp(item->text, item->stored_text));
+
+    // A store missing topics is built again
+    item = add_test_topic("Mana", "mana", HGROUP_PLAYER, "Magic power.");
+    fail_unless(help_collection_open_store(col, store_path));
+    help_collection_sync(col);
+    fail_unless(item->stored_text && !strcmp(item->stored_text, "Magic power."));
+    fail_unless(help_collection_search_text(col, "power", false, 0) == item);
+}
+END_TEST
+
+// Checks that the word index finds the same topics as reading every one
+static void
+check_search_text(const char *args, bool find_no_approve, int thegroup)
+{
+    struct help_item *scan, *indexed;
+
+    scan = help_collection_search_text_scan(col, args, find_no_approve,
+                                            thegroup);
+    indexed = help_collection_search_text(col, args, find_no_approve,
+                                          thegroup);
+    while (scan && indexed && scan == indexed) {
+        scan = scan->next_show;
+        indexed = indexed->next_show;
+    }
+    fail_unless(!scan && !indexed,
+                "searching text for '%s' in group %d found different topics",
+                args, thegroup);
+}
+
+START_TEST(test_help_search_text)
+{
+    const char *args[] = { "magic", "MAGIC bolt", "hidden", "find",
+                           "mobile prototype", "magic xyzzy", "", "!!" };
+    struct help_item *item, *found;
+
+    add_test_topics();
+    fail_unless(help_collection_build_store(col, store_path));
+    for (size_t i = 0; i < G_N_ELEMENTS(args); i++) {
+        check_search_text(args[i], false, 0);
+        check_search_text(args[i], true, 0);
+        check_search_text(args[i], false, HGROUP_PLAYER);
+    }
+
+    found = help_collection_search_text(col, "magic", false, 0);
+    fail_unless(found && found->idnum == 2);
+    fail_unless(found->next_show && found->next_show->idnum == 3);
+    fail_unless(!found->next_show->next_show);
+    // Color codes aren't part of words
+    fail_unless(help_collection_search_text(col, "find", false, 0)->idnum == 1);
+    fail_unless(help_collection_search_text(col, "cfind", false, 0) == NULL);
+    fail_unless(help_collection_search_text(col, "scrolls", false, 0)->idnum
+                == 3);
+
+    // Changed topics are searched without the index
+    item = help_collection_find_item_by_id(col, 3);
+    free(item->text);
+    item->text = strdup("Wands and staves are charged items.");
+    item->stored_text = NULL;
+    help_collection_text_changed(col, item);
+    fail_unless(help_collection_search_text(col, "scrolls", false, 0) == NULL);
+    fail_unless(help_collection_search_text(col, "charged", false, 0) == item);
+    item = add_test_topic("Charge", "charge", HGROUP_PLAYER,
+                          "Charged at the enemy.");
+    fail_unless(help_collection_search_text(col, "charged", false, 0)->next_show
+                == item);
+    check_search_text("charged", false, 0);
+    check_search_text("magic", false, 0);
+}
+END_TEST
+
+static const char *
+bench_word(int num)
+{
+    const char *syllables[] = { "ka", "lo", "mir", "tha", "zen", "qu", "dor",
+                                "ae", "vis", "rul", "ne", "bo", "sti", "gar",
+                                "fe", "wy" };
+
+    return tmp_sprintf("%s%s%s", syllables[num % 16],
+                       syllables[(num / 16) % 16], syllables[(num / 256) % 16]);
+}
+
+START_TEST(test_help_benchmark)
+{
+    struct timespec start, end, scan_len, find_len, scan_search_len,
+        search_len;
+    char **queries;
+    int found = 0;
+
+    srandom(1);
+    for (int i = 0; i < BENCH_TOPICS; i++) {
+        char keys[64] = "", text[BENCH_TEXT_WORDS * 16] = "";
+        int groups = HGROUP_PLAYER | (1 << (random() % HGROUP_MAX));
+        size_t len = 0;
+
+        for (int k = 0; k < 3; k++)
+            snprintf_cat(keys, sizeof(keys), " %s",
+                         bench_word(random() % BENCH_VOCABULARY));
+        for (int w = 0; w < BENCH_TEXT_WORDS; w++)
+            len += snprintf(text + len, sizeof(text) - len, " %s%s",
+                            bench_word(random() % BENCH_VOCABULARY),
+                            (w % 12 == 11) ? ".\r\n" : "");
+        add_test_topic(tmp_sprintf("Topic %d", i), keys, groups, text);
+    }
+    fail_unless(help_collection_build_store(col, store_path));
+    help_collection_sync(col);
+    help_collection_index_keys(col);
+
+    CREATE(queries, char *, BENCH_LOOKUPS);
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+        const char *word = bench_word(random() % BENCH_VOCABULARY);
+
+        queries[i] = strndup(word, 2 + random() % (strlen(word) - 1));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_LOOKUPS; i++)
+        if (help_collection_find_items_scan(col, queries[i], false,
+                                            HGROUP_PLAYER, false))
+            found++;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    scan_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_LOOKUPS; i++)
+        if (help_collection_find_items(col, queries[i], false,
+                                       HGROUP_PLAYER, false))
+            found--;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    find_len = timediff(&end, &start);
+    fail_unless(found == 0);
+
+    for (int i = 0; i < BENCH_SEARCHES; i++) {
+        free(queries[i]);
+        queries[i] = strdup(tmp_sprintf("%s %s",
+                                        bench_word(random() % BENCH_VOCABULARY),
+                                        bench_word(random() % BENCH_VOCABULARY)));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_SEARCHES; i++)
+        for (struct help_item *cur = help_collection_search_text_scan(col,
+                 queries[i], false, HGROUP_PLAYER); cur; cur = cur->next_show)
+            found++;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    scan_search_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_SEARCHES; i++)
+        for (struct help_item *cur = help_collection_search_text(col,
+                 queries[i], false, HGROUP_PLAYER); cur; cur = cur->next_show)
+            found--;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    search_len = timediff(&end, &start);
+    fail_unless(found == 0);
+
+    for (int i = 0; i < BENCH_LOOKUPS; i++)
+        free(queries[i]);
+    free(queries);
+
+    printf("help benchmark: %d topics, %zu bytes of text: "
+           "%d lookups scan %ld.%03lds, indexed %ld.%03lds; "
+           "%d searches scan %ld.%03lds, indexed %ld.%03lds\n",
+           BENCH_TOPICS, col->store_size, BENCH_LOOKUPS,
+           (long)scan_len.tv_sec, scan_len.tv_nsec / 1000000,
+           (long)find_len.tv_sec, find_len.tv_nsec / 1000000,
+           BENCH_SEARCHES,
+           (long)scan_search_len.tv_sec, scan_search_len.tv_nsec / 1000000,
+           (long)search_len.tv_sec, search_len.tv_nsec / 1000000);
+}
+END_TEST
+
+Suite *
+help_suite(void)
+{
+    Suite *s = suite_create("help");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_help_setup,
+                              fixture_help_teardown);
+    tcase_add_test(tc_core, test_help_find_items);
+    tcase_add_test(tc_core, test_help_keys_changed);
+    tcase_add_test(tc_core, test_help_store);
+    tcase_add_test(tc_core, test_help_search_text);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_help_setup,
+                                  fixture_help_teardown);
+        tcase_add_test(tc_bench, test_help_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
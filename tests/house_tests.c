@@ -0,0 +1,249 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "house.h"
+#include "testing.h"
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+#define BENCH_HOUSES 2000
+#define BENCH_ROOMS 2
+#define BENCH_BAGS 10
+#define BENCH_GEMS 5
+
+static struct zone_data *zone = NULL;
+
+void
+fixture_house_setup(void)
+{
+    test_world_init();
+
+    zone = make_zone(1);
+    make_test_proto(100, "a bag", "bag")->shared->cost_per_day = 10;
+    make_test_proto(101, "a gem", "gem")->shared->cost_per_day = 3;
+}
+
+// Puts a bag holding gem_count gems into the room
+static struct obj_data *
+add_test_bag(struct room_data *room, int gem_count)
+{
+    struct obj_data *bag = read_object(100);
+
+    for (int i = 0; i < gem_count; i++)
+        obj_to_obj(read_object(101), bag);
+    obj_to_room(bag, room);
+
+    return bag;
+}
+
+START_TEST(test_house_rent_cache)
+{
+    struct room_data *room_a = make_room(zone, 1);
+    struct room_data *room_b = make_room(zone, 2);
+    struct house *house = make_house(1, 1);
+    struct obj_data *bag, *gem, *junk;
+
+    houses = g_list_prepend(houses, house);
+
+    // Objects already in a room are totalled when it joins a house
+    bag = add_test_bag(room_a, 2);
+    add_house_room(house, room_a->number);
+    add_house_room(house, room_b->number);
+    fail_unless(room_a->house_rent == 16);
+    fail_unless(room_a->house_objects == 3);
+    fail_unless(house_rent_cost(house) == house_rent_cost_scan(house));
+
+    // Contents of a NORENT container are still charged
+    junk = read_object(100);
+    SET_BIT(GET_OBJ_EXTRA(junk), ITEM_NORENT);
+    obj_to_obj(read_object(101), junk);
+    obj_to_room(junk, room_b);
+    fail_unless(room_b->house_rent == 3);
+    fail_unless(room_b->house_objects == 2);
+    fail_unless(house_rent_cost(house) == house_rent_cost_scan(house));
+
+    gem = bag->contains;
+    obj_from_obj(gem);
+    fail_unless(room_a->house_rent == 13);
+    obj_to_obj(gem, junk);
+    fail_unless(room_b->house_rent == 6);
+    fail_unless(room_b->house_objects == 3);
+
+    // Too many objects multiply the rent
+    for (int i = 0; i < MAX_HOUSE_ITEMS; i++)
+        obj_to_room(read_object(101), room_a);
+    fail_unless(room_rent_cost(house, room_a) ==
+                (13 + 3 * MAX_HOUSE_ITEMS) * 2);
+    fail_unless(house_rent_cost(house) == house_rent_cost_scan(house));
+    fail_unless(audit_house_rent(NULL) == 0);
+
+    // The audit fixes a wrong total
+    room_b->house_rent = 100;
+    fail_unless(audit_house_rent(NULL) == 1);
+    fail_unless(room_b->house_rent == 6);
+
+    // Changing the rent of a prototype recounts the totals
+    real_object_proto(101)->shared->cost_per_day = 4;
+    house_rent_changed();
+    fail_unless(room_b->house_rent == 8);
+    fail_unless(audit_house_rent(NULL) == 0);
+    real_object_proto(101)->shared->cost_per_day = 3;
+    house_rent_changed();
+
+    extract_obj(junk);
+    fail_unless(room_b->house_rent == 0);
+    fail_unless(room_b->house_objects == 0);
+
+    remove_house_room(house, room_a->number);
+    fail_unless(room_a->house_rent == 0);
+    fail_unless(room_a->house_objects == 0);
+    // Rooms outside of houses are still costed
+    fail_unless(room_rent_cost(house, room_a) ==
+                (13 + 3 * MAX_HOUSE_ITEMS) * 2);
+
+    houses = g_list_remove(houses, house);
+    free_house(house);
+}
+END_TEST
+
+START_TEST(test_house_needs_save)
+{
+    struct room_data *room = make_room(zone, 1);
+    struct house *house = make_house(1, 1);
+    struct obj_data *bag;
+
+    add_house_room(house, room->number);
+    house->dirty = false;
+    fail_if(house_needs_save(house));
+
+    bag = add_test_bag(room, 1);
+    fail_unless(house_needs_save(house));
+    house->dirty = false;
+
+    obj_from_obj(bag->contains);
+    fail_unless(house_needs_save(house));
+    house->dirty = false;
+
+    // Rent covered by repossessions changes the house
+    house->type = PUBLIC;
+    house->rent_overflow = 10;
+    collect_house_rent(house, 0);
+    fail_if(house_needs_save(house));
+    collect_house_rent(house, 4);
+    fail_unless(house->rent_overflow == 6);
+    fail_unless(house_needs_save(house));
+    house->dirty = false;
+
+    SET_BIT(ROOM_FLAGS(room), ROOM_HOUSE_CRASH);
+    fail_unless(house_needs_save(house));
+
+    free_house(house);
+}
+END_TEST
+
+START_TEST(test_house_rent_benchmark)
+{
+    struct timespec start, end, scan_len, cache_len;
+    long scan_total = 0, cache_total = 0;
+    int changed = 0;
+
+    for (int h = 0; h < BENCH_HOUSES; h++) {
+        struct house *house = make_house(h + 1, h + 1);
+
+        house->type = PRIVATE;
+        for (int r = 0; r < BENCH_ROOMS; r++) {
+            struct room_data *room = make_room(zone, h * BENCH_ROOMS + r + 1);
+
+            for (int b = 0; b < BENCH_BAGS; b++)
+                add_test_bag(room, BENCH_GEMS);
+            add_house_room(house, room->number);
+        }
+        house->dirty = false;
+        houses = g_list_prepend(houses, house);
+    }
+
+    // One house in fifty sees something change between collections
+    for (GList *it = houses; it; it = it->next) {
+        struct house *house = it->data;
+        int id = house->id;
+
+        if (id % 50)
+            continue;
+        add_test_bag(real_room(GPOINTER_TO_INT(house->rooms->data)), 1);
+    }
+
+    // The old way: walk every object in every house
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (GList *it = houses; it; it = it->next)
+        scan_total += house_rent_cost_scan(it->data);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    scan_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (GList *it = houses; it; it = it->next)
+        cache_total += house_rent_cost(it->data);
+    for (GList *it = houses; it; it = it->next)
+        if (house_needs_save(it->data))
+            changed++;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cache_len = timediff(&end, &start);
+
+    fail_unless(scan_total == cache_total,
+                "scan charged %ld, cache charged %ld", scan_total, cache_total);
+    fail_unless(changed == BENCH_HOUSES / 50);
+    printf("house rent benchmark: 1 collection, %d houses, %d objects: "
+           "scan %ld.%03lds, cached %ld.%03lds, %d of %d house files written\n",
+           BENCH_HOUSES,
+           BENCH_HOUSES * BENCH_ROOMS * BENCH_BAGS * (BENCH_GEMS + 1)
+           + BENCH_HOUSES / 50 * 2,
+           (long)scan_len.tv_sec, scan_len.tv_nsec / 1000000,
+           (long)cache_len.tv_sec, cache_len.tv_nsec / 1000000,
+           changed, BENCH_HOUSES);
+}
+END_TEST
+
+Suite *
+house_suite(void)
+{
+    Suite *s = suite_create("house");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_house_setup, NULL);
+    tcase_add_test(tc_core, test_house_rent_cache);
+    tcase_add_test(tc_core, test_house_needs_save);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_house_setup, NULL);
+        tcase_add_test(tc_bench, test_house_rent_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
@@ -0,0 +1,267 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "mail.h"
+#include "testing.h"
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+#define PACKAGE_VNUM 3000
+#define BENCH_LETTERS 10000
+
+static char *mail_path = NULL;
+
+void
+fixture_mail_setup(void)
+{
+    test_world_init();
+
+    make_test_proto(MAIL_OBJ_VNUM, "a letter", "letter");
+    make_test_proto(PACKAGE_VNUM, "a package", "package");
+
+    mail_path = tmp_strdup(test_path("test_mail.dat"));
+    unlink(mail_path);
+}
+
+static struct obj_data *
+make_test_letter(const char *text)
+{
+    struct obj_data *letter = read_object(MAIL_OBJ_VNUM);
+
+    letter->action_desc = strdup(text);
+    letter->plrtext_len = strlen(text) + 1;
+
+    return letter;
+}
+
+static void
+collect_mail(struct obj_data *obj, void *data)
+{
+    GList **objs = data;
+
+    *objs = g_list_append(*objs, obj);
+}
+
+static void
+discard_mail(struct obj_data *obj, void *data)
+{
+    int *count = data;
+
+    (*count)++;
+    extract_obj(obj);
+}
+
+static long
+file_size(const char *path)
+{
+    struct stat stat_buf;
+
+    if (stat(path, &stat_buf) < 0)
+        return -1;
+    return stat_buf.st_size;
+}
+
+START_TEST(test_mail_append_read)
+{
+    struct obj_data *letter = make_test_letter("Hello there");
+    struct obj_data *package = read_object(PACKAGE_VNUM);
+    struct mailbox box;
+    GList *objs = NULL;
+    long written;
+
+    written = mail_file_append(mail_path, letter, package);
+    fail_unless(written > 0);
+    fail_unless(written == file_size(mail_path));
+    extract_obj(letter);
+    extract_obj(package);
+
+    written = mail_file_append(mail_path, make_test_letter("Again"), NULL);
+    fail_unless(written > 0);
+
+    fail_unless(mail_file_scan(mail_path, &box));
+    fail_unless(box.letters == 2);
+    fail_unless(box.packages == 1);
+    fail_unless(box.size == file_size(mail_path));
+
+    fail_unless(mail_file_read(mail_path, collect_mail, &objs) == 3);
+    fail_unless(g_list_length(objs) == 3);
+    letter = g_list_nth_data(objs, 0);
+    fail_unless(GET_OBJ_VNUM(letter) == MAIL_OBJ_VNUM);
+    fail_unless(!strcmp(letter->action_desc, "Hello there"));
+    package = g_list_nth_data(objs, 1);
+    fail_unless(GET_OBJ_VNUM(package) == PACKAGE_VNUM);
+    letter = g_list_nth_data(objs, 2);
+    fail_unless(!strcmp(letter->action_desc, "Again"));
+    g_list_foreach(objs, (GFunc) extract_obj, NULL);
+    g_list_free(objs);
+}
+END_TEST
+
+START_TEST(test_mail_migration)
+{
+    struct obj_data *letter = make_test_letter("Old letter");
+    struct obj_data *package = read_object(PACKAGE_VNUM);
+    struct mailbox box;
+    GList *objs = NULL;
+    FILE *ouf;
+
+    // Mail files used to be a single XML document
+    ouf = fopen(mail_path, "w");
+    fail_unless(ouf != NULL);
+    fprintf(ouf, "<objects>");
+    save_object_to_xml(letter, ouf);
+    save_object_to_xml(package, ouf);
+    save_object_to_xml(letter, ouf);
+    fprintf(ouf, "</objects>");
+    fclose(ouf);
+    extract_obj(letter);
+    extract_obj(package);
+
+    fail_unless(mail_file_scan(mail_path, &box));
+    fail_unless(box.letters == 2);
+    fail_unless(box.packages == 1);
+    fail_unless(box.size == file_size(mail_path));
+
+    // New letters are appended to the converted file
+    fail_unless(mail_file_append(mail_path, make_test_letter("New letter"),
+                                 NULL) > 0);
+    fail_unless(mail_file_read(mail_path, collect_mail, &objs) == 4);
+    letter = g_list_nth_data(objs, 0);
+    fail_unless(!strcmp(letter->action_desc, "Old letter"));
+    letter = g_list_nth_data(objs, 3);
+    fail_unless(!strcmp(letter->action_desc, "New letter"));
+    g_list_foreach(objs, (GFunc) extract_obj, NULL);
+    g_list_free(objs);
+}
+END_TEST
+
+START_TEST(test_mail_bad_migration)
+{
+    struct mailbox box;
+    long size;
+    FILE *ouf;
+
+    // An old mail file that doesn't parse is left for repair
+    ouf = fopen(mail_path, "w");
+    fail_unless(ouf != NULL);
+    fprintf(ouf, "<objects><object vnum=");
+    fclose(ouf);
+    size = file_size(mail_path);
+
+    fail_if(mail_file_scan(mail_path, &box));
+    fail_unless(file_size(mail_path) == size);
+    fail_unless(access(tmp_strcat(mail_path, ".new", NULL), F_OK) < 0);
+}
+END_TEST
+
+START_TEST(test_mail_damaged)
+{
+    struct mailbox box;
+    int count = 0;
+    long good;
+    FILE *ouf;
+
+    mail_file_append(mail_path, make_test_letter("One"), NULL);
+    mail_file_append(mail_path, make_test_letter("Two"), NULL);
+    good = file_size(mail_path);
+
+    // A letter cut short by a crash
+    ouf = fopen(mail_path, "a");
+    fprintf(ouf, "L 500\n  <object vnum=");
+    fclose(ouf);
+
+    fail_unless(mail_file_scan(mail_path, &box));
+    fail_unless(box.letters == 2);
+    fail_unless(box.size == good);
+    fail_unless(file_size(mail_path) == good);
+
+    mail_file_append(mail_path, make_test_letter("Three"), NULL);
+    fail_unless(mail_file_read(mail_path, discard_mail, &count) == 3);
+}
+END_TEST
+
+START_TEST(test_mail_benchmark)
+{
+    struct timespec start, end, append_len, scan_len, read_len;
+    struct obj_data *letter = make_test_letter("A letter for the benchmark, "
+                                               "long enough to be typical of "
+                                               "the mail players send.");
+    struct mailbox box;
+    int count = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCH_LETTERS; i++)
+        fail_unless(mail_file_append(mail_path, letter, NULL) > 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    append_len = timediff(&end, &start);
+    extract_obj(letter);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fail_unless(mail_file_scan(mail_path, &box));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    scan_len = timediff(&end, &start);
+    fail_unless(box.letters == BENCH_LETTERS);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fail_unless(mail_file_read(mail_path, discard_mail, &count) == BENCH_LETTERS);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    read_len = timediff(&end, &start);
+
+    printf("mail benchmark: %d letters to one mailbox (%ld bytes): "
+           "deliver %ld.%03lds, count %ld.%03lds, receive %ld.%03lds\n",
+           BENCH_LETTERS, box.size,
+           (long)append_len.tv_sec, append_len.tv_nsec / 1000000,
+           (long)scan_len.tv_sec, scan_len.tv_nsec / 1000000,
+           (long)read_len.tv_sec, read_len.tv_nsec / 1000000);
+    unlink(mail_path);
+}
+END_TEST
+
+Suite *
+mail_suite(void)
+{
+    Suite *s = suite_create("mail");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_mail_setup, NULL);
+    tcase_add_test(tc_core, test_mail_append_read);
+    tcase_add_test(tc_core, test_mail_migration);
+    tcase_add_test(tc_core, test_mail_bad_migration);
+    tcase_add_test(tc_core, test_mail_damaged);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_mail_setup, NULL);
+        tcase_add_test(tc_bench, test_mail_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
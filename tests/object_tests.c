@@ -17,6 +17,7 @@
 #include "desc_data.h"
 #include "macros.h"
 #include "room_data.h"
+#include "zone_data.h"
 #include "race.h"
 #include "creature.h"
 #include "db.h"
@@ -32,11 +33,11 @@
 #include "quest.h"
 #include "help.h"
 #include "editor.h"
+#include "memstat.h"
+#include "house.h"
+#include "testing.h"
 
 extern int current_mob_idnum;
-extern GHashTable *rooms;
-extern GHashTable *mob_prototypes;
-extern GHashTable *obj_prototypes;
 
 extern GList *creatures;
 extern GHashTable *creature_map;
@@ -48,10 +49,7 @@ static struct room_data *room_a = NULL, *room_b = NULL;
 void
 fixture_object_setup(void)
 {
-    rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
-    mob_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
-    obj_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
-    creature_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+    test_world_init();
 
     ch = make_creature(false);
 
@@ -139,6 +137,176 @@ START_TEST(test_obj_to_from_carried)
 }
 END_TEST
 
+static void
+count_instance(struct obj_data *obj, gpointer data)
+{
+    int *count = data;
+
+    (*count)++;
+    extract_obj(obj);
+}
+
+// Extracts every instance of the object's vnum, not just the object
+static void
+extract_all_instances(struct obj_data *obj, gpointer data)
+{
+    int *count = data;
+    int vnum = GET_OBJ_VNUM(obj);
+
+    (*count)++;
+    while (object_instances(vnum))
+        extract_obj(object_instances(vnum)->data);
+}
+
+START_TEST(test_object_index)
+{
+    struct obj_data *obj_a, *obj_b, *obj_c;
+    GList *dupes;
+    long id_b;
+    int count = 0;
+
+    make_test_proto(100, "a test object", "test object");
+    make_test_proto(101, "a test object", "test object");
+
+    obj_a = read_object(100);
+    obj_b = read_object(100);
+    obj_c = read_object(101);
+    fail_unless(g_list_length(object_instances(100)) == 2);
+    fail_unless(g_list_length(object_instances(101)) == 1);
+    fail_unless(object_instances(102) == NULL);
+    fail_unless(get_obj_num(100) == obj_b);
+    fail_unless(object_by_unique_id(obj_a->unique_id) == obj_a);
+    fail_unless(object_by_unique_id(obj_c->unique_id) == obj_c);
+    fail_unless(duplicate_objects() == NULL);
+
+    // Duplicated objects share a unique id
+    set_object_unique_id(obj_c, obj_a->unique_id);
+    dupes = duplicate_objects();
+    fail_unless(g_list_length(dupes) == 1);
+    fail_unless(g_list_length(dupes->data) == 2);
+    g_list_free(dupes);
+
+    extract_obj(obj_c);
+    fail_unless(object_instances(101) == NULL);
+    fail_unless(object_by_unique_id(obj_a->unique_id) == obj_a);
+    fail_unless(duplicate_objects() == NULL);
+
+    id_b = obj_b->unique_id;
+    foreach_object_instance(100, (GFunc) count_instance, &count);
+    fail_unless(count == 2);
+    fail_unless(object_instances(100) == NULL);
+    fail_unless(object_by_unique_id(id_b) == NULL);
+
+    // Objects extracted by the callback aren't visited
+    count = 0;
+    read_object(101);
+    read_object(101);
+    foreach_object_instance(101, (GFunc) extract_all_instances, &count);
+    fail_unless(count == 1);
+    fail_unless(object_instances(101) == NULL);
+}
+END_TEST
+
+START_TEST(test_object_memstat)
+{
+    struct mem_counts before, after;
+    struct mem_pulse pulse;
+    struct obj_data *obj;
+
+    make_test_proto(100, "a test object", "test object");
+    memstat_pulse();
+    memstat_counts(MEM_OBJECT, &before, NULL);
+
+    obj = read_object(100);
+    memstat_counts(MEM_OBJECT, &after, NULL);
+    fail_unless(after.blocks == before.blocks + 1);
+    fail_unless(after.bytes == before.bytes + sizeof(struct obj_data));
+
+    memstat_pulse();
+    memstat_counts(MEM_OBJECT, NULL, &pulse);
+    fail_unless(pulse.allocs == 1 && pulse.frees == 0);
+    fail_unless(pulse.bytes == (long)sizeof(struct obj_data));
+
+    extract_obj(obj);
+    memstat_counts(MEM_OBJECT, &after, NULL);
+    fail_unless(after.blocks == before.blocks);
+    fail_unless(after.bytes == before.bytes);
+}
+END_TEST
+
+START_TEST(test_object_memstat_tracking)
+{
+    const char *path = test_path("memusage");
+    struct obj_data *obj;
+    int held;
+
+    make_test_proto(100, "a test object", "test object");
+    fail_unless(memstat_dump(path) == 0);
+
+    memstat_set_tracking(true);
+    obj = read_object(100);
+    held = memstat_dump(path);
+    fail_unless(held >= 1);
+
+    extract_obj(obj);
+    fail_unless(memstat_dump(path) == held - 1);
+
+    memstat_set_tracking(false);
+    fail_unless(memstat_dump(path) == 0);
+}
+END_TEST
+
+START_TEST(test_housed_count)
+{
+    struct house *house = make_house(1, 1);
+    struct obj_data *proto;
+    struct obj_data *bag, *gem, *junk;
+
+    proto = make_test_proto(100, "a test object", "test object");
+
+    bag = read_object(100);
+    gem = read_object(100);
+    junk = read_object(100);
+    SET_BIT(GET_OBJ_EXTRA(junk), ITEM_NORENT);
+
+    // Objects already in a room are counted when it joins a house
+    obj_to_obj(gem, bag);
+    obj_to_room(bag, room_a);
+    fail_unless(proto->shared->house_count == 0);
+    add_house_room(house, room_a->number);
+    fail_unless(find_house_by_room(room_a->number) == house);
+    fail_unless(find_house_by_room(room_b->number) == NULL);
+    fail_unless(proto->shared->house_count == 2);
+
+    obj_to_room(junk, room_a);
+    fail_unless(proto->shared->house_count == 2);
+
+    obj_from_obj(gem);
+    fail_unless(proto->shared->house_count == 1);
+    obj_to_room(gem, room_b);
+    fail_unless(proto->shared->house_count == 1);
+    obj_from_room(gem);
+    obj_to_obj(gem, bag);
+    fail_unless(proto->shared->house_count == 2);
+
+    houses = g_list_prepend(houses, house);
+    fail_unless(audit_objects_housed_count(NULL) == 0);
+
+    // The recount fixes a wrong count
+    proto->shared->house_count = 5;
+    fail_unless(audit_objects_housed_count(NULL) == 1);
+    fail_unless(proto->shared->house_count == 2);
+
+    extract_obj(bag);
+    fail_unless(proto->shared->house_count == 0);
+
+    remove_house_room(house, room_a->number);
+    fail_unless(find_house_by_room(room_a->number) == NULL);
+    houses = g_list_remove(houses, house);
+    free_house(house);
+}
+END_TEST
+
 Suite *
 object_suite(void)
 {
@@ -150,6 +318,10 @@ object_suite(void)
     tcase_add_test(tc_core, test_obj_to_from_obj);
     tcase_add_test(tc_core, test_obj_to_from_char);
     tcase_add_test(tc_core, test_obj_to_from_carried);
+    tcase_add_test(tc_core, test_object_index);
+    tcase_add_test(tc_core, test_object_memstat);
+    tcase_add_test(tc_core, test_object_memstat_tracking);
+    tcase_add_test(tc_core, test_housed_count);
     suite_add_tcase(s, tc_core);
 
     return s;
@@ -0,0 +1,106 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "profiler.h"
+
+static struct prof_hist hist;
+
+void
+fixture_profiler_setup(void)
+{
+    prof_hist_clear(&hist);
+}
+
+static void
+check_close(unsigned long result, unsigned long expected)
+{
+    // Values are kept to within one part in PROF_HIST_HALF_COUNT
+    fail_unless(result >= expected
+                && result <= expected + expected / PROF_HIST_HALF_COUNT,
+                "got %lu, expected about %lu", result, expected);
+}
+
+START_TEST(test_hist_empty)
+{
+    fail_unless(prof_hist_percentile(&hist, 50) == 0);
+    fail_unless(prof_hist_percentile(&hist, 100) == 0);
+}
+END_TEST
+
+START_TEST(test_hist_small_values)
+{
+    for (unsigned long i = 1; i <= 10; i++)
+        prof_hist_record(&hist, i);
+
+    fail_unless(hist.count == 10);
+    fail_unless(hist.max == 10);
+    fail_unless(hist.total == 55);
+    fail_unless(prof_hist_percentile(&hist, 50) == 5);
+    fail_unless(prof_hist_percentile(&hist, 90) == 9);
+    fail_unless(prof_hist_percentile(&hist, 100) == 10);
+    fail_unless(prof_hist_percentile(&hist, 0) == 1);
+}
+END_TEST
+
+START_TEST(test_hist_percentiles)
+{
+    for (unsigned long i = 1; i <= 100000; i++)
+        prof_hist_record(&hist, i);
+
+    check_close(prof_hist_percentile(&hist, 50), 50000);
+    check_close(prof_hist_percentile(&hist, 90), 90000);
+    check_close(prof_hist_percentile(&hist, 99), 99000);
+    fail_unless(prof_hist_percentile(&hist, 100) == 100000);
+}
+END_TEST
+
+START_TEST(test_hist_large_values)
+{
+    prof_hist_record(&hist, 3);
+    prof_hist_record(&hist, 1UL << 40);
+
+    fail_unless(prof_hist_percentile(&hist, 50) == 3);
+    fail_unless(prof_hist_percentile(&hist, 100) == 1UL << 40);
+    fail_unless(hist.buckets[PROF_HIST_BUCKETS - 1] == 1);
+
+    prof_hist_clear(&hist);
+    fail_unless(hist.count == 0 && hist.max == 0);
+}
+END_TEST
+
+Suite *
+profiler_suite(void)
+{
+    Suite *s = suite_create("profiler");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_profiler_setup, NULL);
+    tcase_add_test(tc_core, test_hist_empty);
+    tcase_add_test(tc_core, test_hist_small_values);
+    tcase_add_test(tc_core, test_hist_percentiles);
+    tcase_add_test(tc_core, test_hist_large_values);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,260 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "strutil.h"
+#include "prog.h"
+#include "testing.h"
+
+extern int current_mob_idnum;
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+static struct creature *mob = NULL;
+static struct zone_data *zone = NULL;
+static struct room_data *room = NULL;
+
+void
+fixture_prog_setup(void)
+{
+    test_world_init();
+
+    mob = make_creature(false);
+    mob->player.name = strdup("progmob");
+    mob->player.short_descr = strdup("the prog mob");
+
+    CREATE(mob->mob_specials.shared, struct mob_shared_data, 1);
+    mob->mob_specials.shared->vnum = 1;
+    mob->mob_specials.shared->proto = mob;
+    NPC_IDNUM(mob) = (++current_mob_idnum);
+
+    zone = make_zone(1);
+    room = make_room(zone, 1);
+    char_to_room(mob, room, false);
+}
+
+static void
+set_mob_prog(const char *prog)
+{
+    free(mob->mob_specials.shared->prog);
+    mob->mob_specials.shared->prog = strdup(prog);
+    prog_compile(NULL, mob, PROG_TYPE_MOBILE);
+    fail_unless(GET_NPC_PROGOBJ(mob) != NULL);
+}
+
+static const char *
+mob_var(const char *key)
+{
+    struct prog_var *var;
+
+    if (!mob->prog_state)
+        return NULL;
+    for (var = mob->prog_state->var_list; var; var = var->next)
+        if (!strcmp(var->key, key))
+            return var->value;
+    return NULL;
+}
+
+START_TEST(test_prog_symbols)
+{
+    int sym = prog_intern_symbol("testsym");
+
+    fail_unless(sym > 0);
+    fail_unless(prog_intern_symbol("testsym") == sym);
+    fail_unless(prog_find_symbol("testsym") == sym);
+    fail_unless(prog_intern_symbol("testsym2") != sym);
+    fail_unless(prog_find_symbol("never interned") == 0);
+}
+END_TEST
+
+START_TEST(test_prog_expand_vars)
+{
+    set_mob_prog("*handle idle\n"
+                 "*let x foo\n"
+                 "*set plain no variables here\n"
+                 "*set braced <${x}>\n"
+                 "*set bare $x-bar\n"
+                 "*set dollar $$x\n"
+                 "*set longest $xy\n"
+                 "*set missing $nothere\n"
+                 "*set typo a${x b\n"
+                 "*let xy bar\n"
+                 "*set longer $xy\n");
+    trigger_prog_idle(mob, PROG_TYPE_MOBILE);
+
+    fail_unless(!strcmp(mob_var("plain"), "no variables here"));
+    fail_unless(!strcmp(mob_var("braced"), "<foo>"));
+    fail_unless(!strcmp(mob_var("bare"), "foo-bar"));
+    fail_unless(!strcmp(mob_var("dollar"), "$x"));
+    fail_unless(!strcmp(mob_var("longest"), "fooy"));
+    fail_unless(!strcmp(mob_var("missing"), "$nothere"));
+    fail_unless(!strcmp(mob_var("typo"), "a<TYPO ME>x b"));
+    fail_unless(!strcmp(mob_var("longer"), "bar"));
+}
+END_TEST
+
+START_TEST(test_prog_owner_vars)
+{
+    set_mob_prog("*handle idle\n"
+                 "*set count one\n"
+                 "*set copy ${count} ${count}\n");
+    trigger_prog_idle(mob, PROG_TYPE_MOBILE);
+    fail_unless(!strcmp(mob_var("copy"), "one one"));
+
+    // Owner variables persist between runs
+    set_mob_prog("*handle idle\n"
+                 "*set copy $count again\n");
+    trigger_prog_idle(mob, PROG_TYPE_MOBILE);
+    fail_unless(!strcmp(mob_var("copy"), "one again"));
+}
+END_TEST
+
+START_TEST(test_prog_too_long)
+{
+    GString *prog = g_string_new("*handle idle\n");
+    int i;
+
+    // Each line compiles to more than its own length of data
+    for (i = 0; i < 2000; i++)
+        g_string_append_printf(prog, "*set var%d $x and ${y} line %d\n", i, i);
+    free(mob->mob_specials.shared->prog);
+    mob->mob_specials.shared->prog = strdup(prog->str);
+    g_string_free(prog, true);
+    prog_compile(NULL, mob, PROG_TYPE_MOBILE);
+    fail_unless(GET_NPC_PROGOBJ(mob) == NULL);
+
+    set_mob_prog("*handle idle\n*set short $x\n");
+}
+END_TEST
+
+START_TEST(test_prog_wakeup)
+{
+    size_t active, sleeping, due;
+
+    set_mob_prog("*handle idle\n"
+                 "*set woke no\n"
+                 "*pause 2\n"
+                 "*set woke yes\n");
+    trigger_prog_idle(mob, PROG_TYPE_MOBILE);
+    fail_unless(!strcmp(mob_var("woke"), "no"));
+    prog_sched_counts(&active, &sleeping, &due);
+    fail_unless(active == 1 && sleeping == 1 && due == 0);
+
+    prog_update();
+    fail_unless(!strcmp(mob_var("woke"), "no"));
+    prog_sched_counts(&active, &sleeping, &due);
+    fail_unless(active == 1 && sleeping == 0 && due == 1);
+
+    prog_update();
+    fail_unless(!strcmp(mob_var("woke"), "yes"));
+    prog_sched_counts(&active, &sleeping, &due);
+    fail_unless(active == 0);
+    fail_unless(prog_count(false) == 0);
+}
+END_TEST
+
+START_TEST(test_prog_owner_registry)
+{
+    size_t mobs, rooms_with_progs;
+
+    room->prog = strdup("*handle idle\n*set ran yes\n");
+    prog_compile(NULL, room, PROG_TYPE_ROOM);
+    prog_owner_counts(&mobs, &rooms_with_progs);
+    fail_unless(rooms_with_progs == 1);
+
+    prog_update();
+    fail_unless(room->prog_state != NULL);
+
+    free(room->prog);
+    room->prog = NULL;
+    prog_compile(NULL, room, PROG_TYPE_ROOM);
+    prog_owner_counts(&mobs, &rooms_with_progs);
+    fail_unless(rooms_with_progs == 0);
+}
+END_TEST
+
+START_TEST(test_prog_benchmark)
+{
+    struct timespec start, end, len;
+    int i;
+
+    set_mob_prog("*handle idle\n"
+                 "*let a alpha\n"
+                 "*let b beta\n"
+                 "*let c gamma\n"
+                 "*let ab ${a}${b}\n"
+                 "*let abc ${ab}${c}\n"
+                 "*set out1 $a $b $c $ab $abc\n"
+                 "*set out2 ${abc}-${ab}-${a}-$b's $c.\n"
+                 "*set out3 $abc$abc$abc$abc\n"
+                 "*set out4 plain text without any variables at all\n"
+                 "*set n $out1 / $out2\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < 10000; i++) {
+        trigger_prog_idle(mob, PROG_TYPE_MOBILE);
+        if (i % 100 == 99) {
+            prog_update();
+            tmp_gc_strings();
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    len = timediff(&end, &start);
+
+    fail_unless(!strcmp(mob_var("out2"),
+                        "alphabetagamma-alphabeta-alpha-beta's gamma."));
+    fail_unless(!strcmp(mob_var("out3"),
+                        "alphabetagammaalphabetagammaalphabetagammaalphabetagamma"));
+    printf("prog benchmark: 10000 progs in %ld.%03lds\n",
+           (long)len.tv_sec, len.tv_nsec / 1000000);
+}
+END_TEST
+
+Suite *
+prog_suite(void)
+{
+    Suite *s = suite_create("prog");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_prog_setup, NULL);
+    tcase_add_test(tc_core, test_prog_symbols);
+    tcase_add_test(tc_core, test_prog_expand_vars);
+    tcase_add_test(tc_core, test_prog_owner_vars);
+    tcase_add_test(tc_core, test_prog_too_long);
+    tcase_add_test(tc_core, test_prog_wakeup);
+    tcase_add_test(tc_core, test_prog_owner_registry);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_prog_setup, NULL);
+        tcase_add_test(tc_bench, test_prog_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <unistd.h>
 #include <libpq-fe.h>
 #include <libxml/parser.h>
 #include <glib.h>
@@ -217,6 +218,253 @@ START_TEST(test_save_load_quest)
 }
 END_TEST
 
+// Counts the quests saved in a quest file
+static int
+count_saved_quests(const char *path)
+{
+    gchar *text = NULL;
+    int count = 0;
+
+    if (!g_file_get_contents(path, &text, NULL, NULL))
+        return -1;
+    for (char *s = strstr(text, "<Quest "); s; s = strstr(s + 1, "<Quest "))
+        count++;
+    g_free(text);
+
+    return count;
+}
+
+// Makes a quest as if created by qcontrol, ended if ended is true
+static struct quest *
+add_test_quest(int vnum, bool ended)
+{
+    struct quest *q = random_quest();
+
+    q->vnum = vnum;
+    if (!ended)
+        q->ended = 0;
+    add_test_questor(q, vnum + 100, 0, 1, 2, 3);
+    quests = g_list_append(quests, q);
+
+    return q;
+}
+
+static struct quest *
+quest_with_vnum(int vnum)
+{
+    for (GList *it = quests; it; it = it->next) {
+        struct quest *q = it->data;
+
+        if (q->vnum == vnum)
+            return q;
+    }
+    return NULL;
+}
+
+// Reloads the quests and checks them against the ones saved
+static void
+reload_and_compare_quests(const char *path, const char *archive_path)
+{
+    GList *saved = quests;
+
+    quests = NULL;
+    load_quest_files(path, archive_path);
+    fail_unless(g_list_length(quests) == g_list_length(saved));
+    for (GList *it = saved; it; it = it->next) {
+        struct quest *q = it->data;
+        struct quest *lq = quest_with_vnum(q->vnum);
+
+        fail_unless(lq != NULL, "quest %d wasn't loaded", q->vnum);
+        compare_quests(q, lq);
+        fail_unless(lq->archived == (q->ended != 0));
+    }
+    g_list_foreach(saved, (GFunc) free_quest, NULL);
+    g_list_free(saved);
+}
+
+static void
+free_test_quests(void)
+{
+    g_list_foreach(quests, (GFunc) free_quest, NULL);
+    g_list_free(quests);
+    quests = NULL;
+}
+
+START_TEST(test_save_load_quest_files)
+{
+    char *path = tmp_strdup(test_path("quest.xml"));
+    char *archive_path = tmp_strdup(test_path("quest_archive.xml"));
+    struct quest *q;
+
+    unlink(path);
+    unlink(archive_path);
+    add_test_quest(1, true);
+    add_test_quest(2, false);
+    add_test_quest(3, true);
+    add_test_quest(4, false);
+
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 2);
+    fail_unless(count_saved_quests(archive_path) == 2);
+    for (GList *it = quests; it; it = it->next)
+        fail_if(((struct quest *)it->data)->dirty);
+
+    // Nothing is written when nothing changed
+    unlink(path);
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == -1);
+    fail_unless(count_saved_quests(archive_path) == 2);
+
+    // A change to an active quest only rewrites the active quests
+    q = quest_with_vnum(2);
+    add_quest_player(q, 50);
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 2);
+    fail_unless(count_saved_quests(archive_path) == 2);
+
+    // An ending quest moves to the archive
+    q = quest_with_vnum(4);
+    q->ended = q->started + 20;
+    q->dirty = true;
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 1);
+    fail_unless(count_saved_quests(archive_path) == 3);
+
+    reload_and_compare_quests(path, archive_path);
+    fail_unless(count_saved_quests(archive_path) == 3);
+    free_test_quests();
+}
+END_TEST
+
+START_TEST(test_quest_archive_unwritable)
+{
+    char *path = tmp_strdup(test_path("quest.xml"));
+    char *archive_path = tmp_strdup(test_path("missing/quest_archive.xml"));
+    struct quest *q;
+
+    unlink(path);
+    add_test_quest(1, true);
+    add_test_quest(2, false);
+
+    // Active quests are saved even if the archive can't be opened
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 2);
+    q = quest_with_vnum(1);
+    fail_if(q->archived);
+    fail_unless(q->dirty);
+    fail_if(quest_with_vnum(2)->dirty);
+    free_test_quests();
+}
+END_TEST
+
+START_TEST(test_quest_archive_compaction)
+{
+    char *path = tmp_strdup(test_path("quest.xml"));
+    char *archive_path = tmp_strdup(test_path("quest_archive.xml"));
+    struct quest *q;
+    int awarded;
+
+    unlink(path);
+    unlink(archive_path);
+    add_test_quest(1, true);
+    add_test_quest(2, true);
+    add_test_quest(3, false);
+    save_quest_files(path, archive_path);
+
+    // Awarding points after the quest ended archives it again
+    q = quest_with_vnum(1);
+    awarded = (q->awarded += 5);
+    q->dirty = true;
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(archive_path) == 3);
+    fail_unless(count_saved_quests(path) == 1);
+
+    // The last copy is loaded, and the older one dropped
+    reload_and_compare_quests(path, archive_path);
+    fail_unless(quest_with_vnum(1)->awarded == awarded);
+    fail_unless(count_saved_quests(archive_path) == 2);
+    free_test_quests();
+}
+END_TEST
+
+START_TEST(test_quest_archive_damaged)
+{
+    char *path = tmp_strdup(test_path("quest.xml"));
+    char *archive_path = tmp_strdup(test_path("quest_archive.xml"));
+    FILE *out;
+
+    unlink(path);
+    unlink(archive_path);
+    add_test_quest(1, true);
+    add_test_quest(2, false);
+    save_quest_files(path, archive_path);
+
+    // A quest cut short by a crash
+    out = fopen(archive_path, "a");
+    fputs("    <Quest VNUM=\"7\" NAME=\"Cut", out);
+    fclose(out);
+
+    reload_and_compare_quests(path, archive_path);
+    fail_unless(count_saved_quests(archive_path) == 1);
+
+    // Quests archived afterward can be read
+    add_test_quest(3, true);
+    save_quest_files(path, archive_path);
+    reload_and_compare_quests(path, archive_path);
+    free_test_quests();
+}
+END_TEST
+
+START_TEST(test_quest_file_migration)
+{
+    char *path = tmp_strdup(test_path("quest.xml"));
+    char *archive_path = tmp_strdup(test_path("quest_archive.xml"));
+    GList *saved;
+    FILE *out;
+
+    unlink(path);
+    unlink(archive_path);
+    add_test_quest(1, true);
+    add_test_quest(2, false);
+    add_test_quest(3, true);
+
+    // All quests used to be saved in the one file
+    out = fopen(path, "w");
+    fputs("<Quests>", out);
+    for (GList *it = quests; it; it = it->next)
+        save_quest(it->data, out);
+    fputs("</Quests>", out);
+    fclose(out);
+
+    saved = quests;
+    quests = NULL;
+    load_quest_files(path, archive_path);
+    fail_unless(g_list_length(quests) == 3);
+    fail_unless(quest_with_vnum(1)->dirty);
+    fail_if(quest_with_vnum(2)->dirty);
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 1);
+    fail_unless(count_saved_quests(archive_path) == 2);
+    free_test_quests();
+
+    quests = saved;
+    reload_and_compare_quests(path, archive_path);
+
+    // A crash after archiving leaves ended quests in the quest file
+    out = fopen(path, "w");
+    fputs("<Quests>", out);
+    for (GList *it = quests; it; it = it->next)
+        save_quest(it->data, out);
+    fputs("</Quests>", out);
+    fclose(out);
+    reload_and_compare_quests(path, archive_path);
+    save_quest_files(path, archive_path);
+    fail_unless(count_saved_quests(path) == 1);
+    fail_unless(count_saved_quests(archive_path) == 2);
+    free_test_quests();
+}
+END_TEST
+
 START_TEST(test_quest_player_by_idnum)
 {
     struct quest *q = random_quest();
@@ -640,6 +888,11 @@ quest_suite(void)
     tcase_add_test(tc_core, test_next_quest_vnum);
     tcase_add_test(tc_core, test_make_destroy_quest);
     tcase_add_test(tc_core, test_save_load_quest);
+    tcase_add_test(tc_core, test_save_load_quest_files);
+    tcase_add_test(tc_core, test_quest_archive_unwritable);
+    tcase_add_test(tc_core, test_quest_archive_compaction);
+    tcase_add_test(tc_core, test_quest_archive_damaged);
+    tcase_add_test(tc_core, test_quest_file_migration);
     tcase_add_test(tc_core, test_quest_player_by_idnum);
     tcase_add_test(tc_core, test_banned_from_quest);
     tcase_add_test(tc_core, test_add_remove_quest_player);
@@ -0,0 +1,189 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+
+// More than a word of roles, so the bitmaps span several words
+#define TEST_ROLES 40
+#define TEST_PLAYERS 5
+#define TEST_IDNUM 1001
+
+static struct creature *players[TEST_PLAYERS];
+static int command_count = 0;
+
+void
+fixture_security_setup(void)
+{
+    command_count = 0;
+    while (*cmd_info[command_count].command != '\n')
+        command_count++;
+
+    roles = NULL;
+    for (int i = 0; i < TEST_ROLES; i++) {
+        struct role *role = make_role(tmp_sprintf("TestRole%d", i),
+                                      "A test role", NULL);
+
+        for (int cmd = i; cmd < command_count; cmd += i + 3)
+            add_role_command(role, &cmd_info[cmd]);
+        for (int p = 0; p < TEST_PLAYERS; p++)
+            if ((i + p) % 3 == 0)
+                add_role_member(role, TEST_IDNUM + p);
+        roles = g_list_append(roles, role);
+    }
+    roles_changed();
+
+    for (int p = 0; p < TEST_PLAYERS; p++) {
+        players[p] = make_creature(true);
+        GET_IDNUM(players[p]) = TEST_IDNUM + p;
+        GET_LEVEL(players[p]) = LVL_AMBASSADOR;
+    }
+}
+
+void
+fixture_security_teardown(void)
+{
+    for (GList *it = roles; it; it = it->next) {
+        struct role *role = it->data;
+
+        while (role->commands)
+            remove_role_command(role, role->commands->data);
+        free_role(role);
+    }
+    g_list_free(roles);
+    roles = NULL;
+
+    for (int p = 0; p < TEST_PLAYERS; p++)
+        free_creature(players[p]);
+}
+
+static void
+check_privileges(struct creature *ch)
+{
+    for (GList *it = roles; it; it = it->next) {
+        struct role *role = it->data;
+
+        fail_unless(is_named_role_member(ch, role->name)
+                    == is_named_role_member_scan(ch, role->name),
+                    "player %ld membership of %s differs", GET_IDNUM(ch),
+                    role->name);
+        fail_unless(is_named_role_member(ch, tmp_toupper(role->name))
+                    == is_named_role_member_scan(ch, tmp_toupper(role->name)));
+    }
+    fail_if(is_named_role_member(ch, "NoSuchRole"));
+
+    for (int cmd = 0; cmd < command_count; cmd++) {
+        bool allowed = role_command_allowed(ch, &cmd_info[cmd]);
+
+        fail_unless(allowed == role_command_allowed_scan(ch, &cmd_info[cmd]),
+                    "player %ld access to %s differs", GET_IDNUM(ch),
+                    cmd_info[cmd].command);
+        fail_unless(is_authorized(ch, COMMAND, &cmd_info[cmd])
+                    == (GET_LEVEL(ch) >= cmd_info[cmd].minimum_level
+                        && (!cmd_info[cmd].role_count || allowed)),
+                    "player %ld authorization for %s differs",
+                    GET_IDNUM(ch), cmd_info[cmd].command);
+    }
+}
+
+static void
+check_all_privileges(void)
+{
+    for (int p = 0; p < TEST_PLAYERS; p++)
+        check_privileges(players[p]);
+}
+
+START_TEST(test_role_privileges_match)
+{
+    for (int p = 0; p < TEST_PLAYERS; p++)
+        compile_role_privileges(players[p]);
+    check_all_privileges();
+}
+END_TEST
+
+START_TEST(test_role_privileges_follow_changes)
+{
+    struct role *role = role_by_name("TestRole7");
+    struct command_info *command = &cmd_info[command_count - 1];
+
+    fail_unless(role != NULL);
+    check_all_privileges();
+
+    add_role_member(role, TEST_IDNUM);
+    add_role_member(role, TEST_IDNUM + 1);
+    check_all_privileges();
+
+    remove_role_member(role, TEST_IDNUM + 1);
+    check_all_privileges();
+
+    add_role_command(role, command);
+    check_all_privileges();
+    fail_unless(role_command_allowed(players[0], command));
+
+    remove_role_command(role, command);
+    check_all_privileges();
+
+    // Destroying a role renumbers the ones after it
+    roles = g_list_remove(roles, role);
+    while (role->commands)
+        remove_role_command(role, role->commands->data);
+    free_role(role);
+    check_all_privileges();
+    fail_unless(role_by_name("TestRole7") == NULL);
+
+    role = make_role("NewRole", "A new role", NULL);
+    add_role_command(role, &cmd_info[1]);
+    add_role_member(role, TEST_IDNUM + 2);
+    roles = g_list_prepend(roles, role);
+    roles_changed();
+    check_all_privileges();
+    fail_unless(is_named_role_member(players[2], "newrole"));
+}
+END_TEST
+
+START_TEST(test_role_privileges_charmed_npc)
+{
+    struct creature *mob = make_creature(false);
+
+    SET_BIT(AFF_FLAGS(players[0]), AFF_CHARM);
+    fail_if(is_named_role_member(players[0], "TestRole0"));
+    fail_if(is_named_role_member(mob, "TestRole0"));
+    fail_if(role_command_allowed(mob, &cmd_info[0]));
+    free_creature(mob);
+}
+END_TEST
+
+Suite *
+security_suite(void)
+{
+    Suite *s = suite_create("security");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_security_setup,
+                              fixture_security_teardown);
+    tcase_add_test(tc_core, test_role_privileges_match);
+    tcase_add_test(tc_core, test_role_privileges_follow_changes);
+    tcase_add_test(tc_core, test_role_privileges_charmed_npc);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
@@ -0,0 +1,202 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <time.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "testing.h"
+
+struct timespec timediff(struct timespec *a, struct timespec *b);
+
+#define BENCH_FIGHTERS 60
+#define BENCH_ROUNDS 200
+
+static struct zone_data *zone = NULL;
+static struct room_data *lit_room = NULL, *dark_room = NULL;
+
+void
+fixture_sight_setup(void)
+{
+    test_world_init();
+
+    zone = make_zone(1);
+    lit_room = make_room(zone, 1);
+    dark_room = make_room(zone, 2);
+    SET_BIT(ROOM_FLAGS(dark_room), ROOM_DARK);
+}
+
+// Checks that every creature in the room sees every other one as it
+// would without the cache
+static void
+check_room_sight(struct room_data *room)
+{
+    for (GList *it = room->people; it; it = it->next)
+        for (GList *vit = room->people; vit; vit = vit->next)
+            fail_unless(can_see_creature(it->data, vit->data)
+                        == can_see_creature_uncached(it->data, vit->data),
+                        "%s seeing %s is wrong",
+                        GET_NAME((struct creature *)it->data),
+                        GET_NAME((struct creature *)vit->data));
+}
+
+START_TEST(test_sight_cache)
+{
+    struct creature *viewer = make_test_mob("viewer", lit_room);
+    struct creature *target = make_test_mob("target", lit_room);
+
+    GET_LEVEL(viewer) = GET_LEVEL(target) = 30;
+
+    fail_unless(can_see_creature(viewer, target));
+    check_room_sight(lit_room);
+
+    // Affects are changed through affect_modify()
+    affect_modify(target, 0, 0, AFF_INVISIBLE, 1, true);
+    fail_if(can_see_creature(viewer, target));
+    affect_modify(viewer, 0, 0, AFF_DETECT_INVIS, 1, true);
+    fail_unless(can_see_creature(viewer, target));
+    affect_modify(viewer, 0, 0, AFF_DETECT_INVIS, 1, false);
+    fail_if(can_see_creature(viewer, target));
+    affect_modify(target, 0, 0, AFF_INVISIBLE, 1, false);
+    fail_unless(can_see_creature(viewer, target));
+
+    // Moving into the dark
+    char_from_room(target, false);
+    char_to_room(target, dark_room, false);
+    fail_if(can_see_creature(viewer, target));
+
+    // Light in the room, however it got there
+    dark_room->light++;
+    fail_unless(can_see_creature(viewer, target));
+    dark_room->light--;
+    fail_if(can_see_creature(viewer, target));
+
+    // Anything else needs the cache to be invalidated
+    SET_BIT(AFF_FLAGS(viewer), AFF_INFRAVISION);
+    invalidate_sight();
+    fail_unless(can_see_creature(viewer, target));
+
+    char_from_room(viewer, false);
+    char_to_room(viewer, dark_room, false);
+    check_room_sight(dark_room);
+}
+END_TEST
+
+START_TEST(test_sight_benchmark)
+{
+    struct timespec start, end, uncached_len, cached_len;
+    struct creature *fighters[BENCH_FIGHTERS];
+    long uncached_seen = 0, cached_seen = 0, checks = 0;
+
+    for (int i = 0; i < BENCH_FIGHTERS; i++) {
+        struct creature *ch =
+            make_test_mob(tmp_sprintf("fighter%d", i), lit_room);
+
+        GET_LEVEL(ch) = 30;
+        if (i % 4 == 0)
+            SET_BIT(AFF_FLAGS(ch), AFF_INVISIBLE);
+        if (i % 3 == 0)
+            SET_BIT(AFF_FLAGS(ch), AFF_SANCTUARY);
+        if (i % 5 == 0)
+            SET_BIT(AFF_FLAGS(ch), AFF_DETECT_INVIS);
+        if (i % 7 == 0)
+            SET_BIT(AFF2_FLAGS(ch), AFF2_TRUE_SEEING);
+        if (i % 11 == 0)
+            SET_BIT(AFF_FLAGS(ch), AFF_BLIND);
+        fighters[i] = ch;
+    }
+    invalidate_sight();
+    check_room_sight(lit_room);
+
+    // Each round, everyone hits the fighter beside them, and everyone
+    // in the room is shown the hit if they can see the attacker and
+    // victim.  One fighter's sanctuary wears off or is renewed.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_FIGHTERS; i++) {
+            struct creature *ch = fighters[i];
+            struct creature *vict = fighters[(i + 1) % BENCH_FIGHTERS];
+
+            for (GList *it = lit_room->people; it; it = it->next) {
+                if (can_see_creature_uncached(it->data, ch))
+                    uncached_seen++;
+                if (can_see_creature_uncached(it->data, vict))
+                    uncached_seen++;
+                checks += 2;
+            }
+        }
+        affect_modify(fighters[round % BENCH_FIGHTERS], 0, 0, AFF_SANCTUARY,
+                      1, round % 2);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    uncached_len = timediff(&end, &start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = 0; i < BENCH_FIGHTERS; i++) {
+            struct creature *ch = fighters[i];
+            struct creature *vict = fighters[(i + 1) % BENCH_FIGHTERS];
+
+            for (GList *it = lit_room->people; it; it = it->next) {
+                if (can_see_creature(it->data, ch))
+                    cached_seen++;
+                if (can_see_creature(it->data, vict))
+                    cached_seen++;
+            }
+        }
+        affect_modify(fighters[round % BENCH_FIGHTERS], 0, 0, AFF_SANCTUARY,
+                      1, round % 2);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cached_len = timediff(&end, &start);
+
+    fail_unless(uncached_seen == cached_seen,
+                "%ld seen uncached, %ld cached", uncached_seen, cached_seen);
+    check_room_sight(lit_room);
+    printf("sight benchmark: %d fighters, %d rounds, %ld checks: "
+           "uncached %ld.%03lds, cached %ld.%03lds\n",
+           BENCH_FIGHTERS, BENCH_ROUNDS, checks,
+           (long)uncached_len.tv_sec, uncached_len.tv_nsec / 1000000,
+           (long)cached_len.tv_sec, cached_len.tv_nsec / 1000000);
+}
+END_TEST
+
+Suite *
+sight_suite(void)
+{
+    Suite *s = suite_create("sight");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_sight_setup, NULL);
+    tcase_add_test(tc_core, test_sight_cache);
+    suite_add_tcase(s, tc_core);
+
+    if (test_benchmarks_wanted()) {
+        TCase *tc_bench = tcase_create("Benchmark");
+        tcase_add_checked_fixture(tc_bench, tmp_string_init, NULL);
+        tcase_add_checked_fixture(tc_bench, fixture_sight_setup, NULL);
+        tcase_add_test(tc_bench, test_sight_benchmark);
+        suite_add_tcase(s, tc_bench);
+    }
+
+    return s;
+}
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "spells.h"
+#include "strutil.h"
+
+static const char *test_spell_names[] = {
+    "!RESERVED!",
+    "armor",
+    "teleport",
+    "bless",
+    "blindness",
+    "!UNUSED!",
+    "burning hands",
+    "call lightning",
+    "charm person",
+    "chill touch",
+    "clone",
+    "cure critic",
+    "cure light",
+    "curse",
+    "detect alignment",
+    "detect invisibility",
+    "detect magic",
+    "detect poison",
+    "magic missile",
+    "improved invisibility",
+    "invisibility",
+    "word of recall",
+    "recall",
+    "cure light wounds",
+    "second weapon",
+    "!UNUSED!",
+    "armor of gods",
+    "b",
+    "Mixed Case Name",
+    "spaced  out   name",
+    "\n"
+};
+
+void
+fixture_spell_setup(void)
+{
+    int count = G_N_ELEMENTS(test_spell_names);
+
+    spells = calloc(count, sizeof(char *));
+    for (int i = 0; i < count; i++)
+        spells[i] = strdup(test_spell_names[i]);
+    max_spell_num = count - 1;
+}
+
+static void
+check_skill_lookup(const char *str)
+{
+    char *name = tmp_strdup(str);
+    int expected = find_skill_num_scan(name);
+    int result = find_skill_num(name);
+
+    fail_unless(result == expected,
+                "find_skill_num(\"%s\") returned %d, scan returned %d",
+                str, result, expected);
+}
+
+START_TEST(test_find_skill_num_index)
+{
+    index_skill_names();
+
+    for (int i = 1; *spells[i] != '\n'; i++) {
+        size_t len = strlen(spells[i]);
+
+        // Every prefix of the whole name
+        for (size_t j = 1; j <= len; j++) {
+            check_skill_lookup(tmp_substr(spells[i], 0, j - 1));
+            check_skill_lookup(tmp_toupper(tmp_substr(spells[i], 0, j - 1)));
+        }
+
+        // Abbreviations of each word, such as "c l w"
+        for (size_t abbrev = 1; abbrev <= 3; abbrev++) {
+            char *words = tmp_strdup(spells[i]);
+            char *word;
+            char *str = "";
+
+            while (*(word = tmp_getword(&words))) {
+                str = tmp_sprintf("%s%s%s", str, (*str) ? " " : "",
+                                  tmp_substr(word, 0, MIN(strlen(word), abbrev) - 1));
+                check_skill_lookup(str);
+                check_skill_lookup(tmp_strcat(str, " ", NULL));
+                check_skill_lookup(tmp_strcat(str, " x", NULL));
+            }
+        }
+    }
+
+    check_skill_lookup("");
+    check_skill_lookup("   ");
+    check_skill_lookup("nonexistent");
+    check_skill_lookup("cure light wounds extra");
+    check_skill_lookup("!un");
+}
+END_TEST
+
+START_TEST(test_find_skill_num_precedence)
+{
+    index_skill_names();
+
+    fail_unless(find_skill_num("cure light") == 12);
+    fail_unless(find_skill_num("cure light w") == 23);
+    fail_unless(find_skill_num("c l w") == 23);
+    fail_unless(find_skill_num("invis") == 20);
+    fail_unless(find_skill_num("recall") == 22);
+    fail_unless(find_skill_num("w o r") == 21);
+    fail_unless(find_skill_num("b") == 3);
+    fail_unless(find_skill_num("mixed case") == 28);
+    fail_unless(find_skill_num("spaced out") == 29);
+    fail_unless(find_skill_num("xyzzy") == -1);
+}
+END_TEST
+
+Suite *
+spell_suite(void)
+{
+    Suite *s = suite_create("spells");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_spell_setup, NULL);
+    tcase_add_test(tc_core, test_find_skill_num_index);
+    tcase_add_test(tc_core, test_find_skill_num_precedence);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
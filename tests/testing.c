@@ -44,6 +44,7 @@ extern PGconn *sql_cxn;
 extern GList *creatures;
 extern GHashTable *creature_map;
 extern GHashTable *rooms;
+extern int current_mob_idnum;
 extern GMainLoop *main_loop;
 extern FILE *qlogfile;
 
@@ -64,6 +65,65 @@ test_path(char *relpath)
     return buf;
 }
 
+// Benchmarks are slow and only print their timings, so they are only
+// run when TEMPUS_BENCHMARK is set.  They may need CK_TIMEOUT_MULTIPLIER
+// set as well.
+bool
+test_benchmarks_wanted(void)
+{
+    return getenv("TEMPUS_BENCHMARK") != NULL;
+}
+
+// Makes the empty tables of a world for a test to build in
+void
+test_world_init(void)
+{
+    rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
+    mob_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
+    obj_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
+    creature_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+// Makes an object prototype which read_object() can load
+struct obj_data *
+make_test_proto(int vnum, const char *name, const char *aliases)
+{
+    struct obj_data *proto;
+
+    CREATE(proto, struct obj_data, 1);
+    CREATE(proto->shared, struct obj_shared_data, 1);
+    proto->shared->vnum = vnum;
+    proto->shared->proto = proto;
+    proto->name = strdup(name);
+    proto->aliases = strdup(aliases);
+    proto->worn_on = -1;
+    g_hash_table_insert(obj_prototypes, GINT_TO_POINTER(vnum), proto);
+
+    return proto;
+}
+
+// Makes a mobile with its own prototype data, placing it in the room
+// if one is given
+struct creature *
+make_test_mob(const char *name, struct room_data *room)
+{
+    struct creature *mob = make_creature(false);
+
+    mob->player.name = strdup(name);
+    mob->player.short_descr = strdup(name);
+    mob->points.hit = mob->points.max_hit = 100;
+    CREATE(mob->mob_specials.shared, struct mob_shared_data, 1);
+    mob->mob_specials.shared->vnum = 1;
+    mob->mob_specials.shared->proto = mob;
+    NPC_IDNUM(mob) = (++current_mob_idnum);
+    creatures = g_list_prepend(creatures, mob);
+    g_hash_table_insert(creature_map, GINT_TO_POINTER(-NPC_IDNUM(mob)), mob);
+    if (room)
+        char_to_room(mob, room, false);
+
+    return mob;
+}
+
 void
 test_tempus_boot(void)
 {
@@ -80,10 +140,7 @@ test_tempus_boot(void)
     }
 
     creatures = NULL;
-    rooms = g_hash_table_new(g_direct_hash, g_direct_equal);
-    mob_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
-    obj_prototypes = g_hash_table_new(g_direct_hash, g_direct_equal);
-    creature_map = g_hash_table_new(g_direct_hash, g_direct_equal);
+    test_world_init();
 
     if (chdir("../../lib") < 0) {
         // fail("Couldn't change directory to lib");
@@ -2,6 +2,11 @@
 #define __TESTING__
 
 const char *test_path(char *relpath);
+bool test_benchmarks_wanted(void);
+void test_world_init(void);
+struct obj_data *make_test_proto(int vnum, const char *name,
+                                 const char *aliases);
+struct creature *make_test_mob(const char *name, struct room_data *room);
 void test_tempus_boot(void);
 
 struct creature *make_test_player(const char *acct_name, const char *char_name);
@@ -489,6 +489,88 @@ START_TEST(tmp_wrap_7)
 }
 END_TEST
 
+// Testing tmp_mark and tmp_release
+START_TEST(tmp_mark_1)
+{
+    char *keep = tmp_strdup("keep");
+    struct tmp_mark mark = tmp_mark();
+    char *str = tmp_strdup("released");
+
+    tmp_release(mark);
+    ck_assert_str_eq(keep, "keep");
+    fail_unless(tmp_strdup("reused") == str);
+}
+END_TEST
+START_TEST(tmp_mark_2)
+{
+    struct tmp_mark outer = tmp_mark();
+    char *a = tmp_strdup("outer");
+    struct tmp_mark inner = tmp_mark();
+    char *b = tmp_strdup("inner");
+
+    tmp_release(inner);
+    ck_assert_str_eq(a, "outer");
+    fail_unless(tmp_strdup("again") == b);
+
+    inner = tmp_mark();
+    tmp_strdup("inner again");
+    tmp_release(inner);
+    ck_assert_str_eq(b, "again");
+
+    tmp_release(outer);
+    fail_unless(tmp_strdup("reused") == a);
+}
+END_TEST
+START_TEST(tmp_mark_3)
+{
+    char *keep = tmp_strdup("keep");
+    struct tmp_mark outer = tmp_mark();
+    char *a = tmp_strdup("outer");
+    struct tmp_mark inner;
+
+    // Force allocation of new pools
+    tmp_pad('x', 100000);
+    inner = tmp_mark();
+    tmp_pad('y', 200000);
+    tmp_release(inner);
+    tmp_strdup("in the last pool");
+
+    tmp_release(outer);
+    ck_assert_str_eq(keep, "keep");
+    fail_unless(tmp_strdup("reused") == a);
+
+    // Releasing the inner mark again must not touch the original pool
+    tmp_release(inner);
+    ck_assert_str_eq(a, "reused");
+}
+END_TEST
+START_TEST(tmp_mark_4)
+{
+    struct tmp_mark mark;
+    char *str;
+
+    tmp_strdup("before");
+    mark = tmp_mark();
+    tmp_gc_strings();
+    str = tmp_strdup("after gc");
+    tmp_release(mark);
+    ck_assert_str_eq(str, "after gc");
+    fail_unless(tmp_strdup("next") != str);
+}
+END_TEST
+START_TEST(tmp_mark_5)
+{
+    struct tmp_mark mark = tmp_mark();
+
+    tmp_pad('x', 300000);
+    tmp_release(mark);
+    tmp_gc_strings();
+
+    // The released space still counts toward the pool size
+    fail_unless(tmp_max_used >= 300000);
+}
+END_TEST
+
 Suite *
 tmpstr_suite(void)
 {
@@ -566,6 +648,11 @@ tmpstr_suite(void)
     tcase_add_test(tc_core, tmp_wrap_5);
     tcase_add_test(tc_core, tmp_wrap_6);
     tcase_add_test(tc_core, tmp_wrap_7);
+    tcase_add_test(tc_core, tmp_mark_1);
+    tcase_add_test(tc_core, tmp_mark_2);
+    tcase_add_test(tc_core, tmp_mark_3);
+    tcase_add_test(tc_core, tmp_mark_4);
+    tcase_add_test(tc_core, tmp_mark_5);
     suite_add_tcase(s, tc_core);
 
     return s;
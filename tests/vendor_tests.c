@@ -0,0 +1,286 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <libpq-fe.h>
+#include <libxml/parser.h>
+#include <glib.h>
+#include <check.h>
+
+#include "interpreter.h"
+#include "utils.h"
+#include "constants.h"
+#include "comm.h"
+#include "security.h"
+#include "handler.h"
+#include "defs.h"
+#include "desc_data.h"
+#include "macros.h"
+#include "room_data.h"
+#include "zone_data.h"
+#include "race.h"
+#include "creature.h"
+#include "db.h"
+#include "tmpstr.h"
+#include "obj_data.h"
+#include "vendor.h"
+#include "testing.h"
+
+int vendor_inventory(struct obj_data *obj, struct obj_data *obj_list);
+
+static struct creature *self = NULL, *ch = NULL;
+static struct room_data *storeroom = NULL;
+static struct shop_data *shop = NULL;
+
+void
+fixture_vendor_setup(void)
+{
+    struct zone_data *zone;
+
+    test_world_init();
+
+    zone = make_zone(1);
+    storeroom = make_room(zone, 2);
+    self = make_test_mob("shopkeeper", make_room(zone, 1));
+    ch = make_test_mob("customer", self->in_room);
+
+    make_test_proto(100, "a long sword", "long sword")->shared->cost = 1000;
+    make_test_proto(101, "a small shield", "small shield")->shared->cost = 500;
+    make_test_proto(102, "a loaf of bread", "loaf bread")->shared->cost = 15;
+    make_test_proto(103, "a lantern", "lantern")->shared->cost = 80;
+
+    CREATE(shop, struct shop_data, 1);
+    shop->room = -1;
+    shop->markup = 120;
+    shop->markdown = 70;
+    shop->item_list = g_list_prepend(NULL, GINT_TO_POINTER(102));
+}
+
+// Gives the shopkeeper a stock with several runs of identical objects,
+// variants which don't group with them, and a repeated run
+static void
+stock_test_shop(void (*put)(struct obj_data *obj))
+{
+    struct obj_data *obj;
+
+    for (int i = 0; i < 3; i++)
+        put(read_object(100));
+    for (int i = 0; i < 2; i++)
+        put(read_object(101));
+    put(read_object(102));
+
+    obj = read_object(100);
+    SET_BIT(GET_OBJ_EXTRA(obj), ITEM_GLOW);
+    put(obj);
+
+    obj = read_object(101);
+    obj->name = strdup("a dented small shield");
+    put(obj);
+
+    // Identical, but answering to another name
+    obj = read_object(103);
+    obj->aliases = strdup("lantern brass");
+    put(obj);
+    put(read_object(103));
+}
+
+static void
+put_carried(struct obj_data *obj)
+{
+    obj_to_char(obj, self);
+}
+
+static void
+put_carried_unsorted(struct obj_data *obj)
+{
+    unsorted_obj_to_char(obj, self);
+}
+
+static void
+put_stored(struct obj_data *obj)
+{
+    obj_to_room(obj, storeroom);
+}
+
+static struct obj_data *
+stock_list(void)
+{
+    return (shop->storeroom > 0) ? storeroom->contents : self->carrying;
+}
+
+// Finds the nth run of identical objects the way listings number them
+static struct obj_data *
+nth_stock_run(int num)
+{
+    struct obj_data *last_obj = NULL;
+
+    for (struct obj_data *obj = stock_list(); obj; obj = obj->next_content) {
+        if (!last_obj || !same_obj(last_obj, obj))
+            if (--num == 0)
+                return obj;
+        last_obj = obj;
+    }
+    return NULL;
+}
+
+static void
+check_stock_index(void)
+{
+    const char *args[] = { "", "sword", "shield", "lantern", "brass", "xyzzy" };
+    int runs = 0;
+
+    for (size_t i = 0; i < G_N_ELEMENTS(args); i++) {
+        char *scan = vendor_list_str_scan(ch, tmp_strdup(args[i]), self, shop);
+        char *indexed = vendor_list_str(ch, tmp_strdup(args[i]), self, shop);
+
+        fail_unless(!strcmp(scan, indexed),
+                    "listing '%s' changed:\n%s\nbecame\n%s", args[i], scan,
+                    indexed);
+    }
+
+    while (nth_stock_run(runs + 1))
+        runs++;
+    for (int num = 0; num <= runs + 1; num++)
+        fail_unless(vendor_resolve_hash(shop, self, tmp_sprintf("#%d", num))
+                    == ((num > 0) ? nth_stock_run(num) : NULL),
+                    "#%d resolved to the wrong object", num);
+
+    for (size_t i = 0; i < G_N_ELEMENTS(args); i++) {
+        struct obj_data *expected = NULL;
+
+        for (struct obj_data *obj = stock_list(); obj && !expected;
+             obj = obj->next_content)
+            if (namelist_match(args[i], obj->aliases))
+                expected = obj;
+        fail_unless(vendor_resolve_name(shop, self, tmp_strdup(args[i]))
+                    == expected, "'%s' resolved to the wrong object", args[i]);
+    }
+
+    for (struct obj_data *obj = stock_list(); obj; obj = obj->next_content)
+        fail_unless(vendor_stock_count(shop, self, obj)
+                    == vendor_inventory(obj, stock_list()),
+                    "stock count of %s is %d, not %d", obj->name,
+                    vendor_stock_count(shop, self, obj),
+                    vendor_inventory(obj, stock_list()));
+}
+
+START_TEST(test_vendor_stock_carried)
+{
+    stock_test_shop(put_carried);
+    check_stock_index();
+    fail_unless(vendor_stock(shop, self)->groups->len == 6);
+
+    // Buying and selling regroup the stock
+    obj_from_char(self->carrying->next_content);
+    check_stock_index();
+    obj_to_char(read_object(101), self);
+    obj_to_char(read_object(100), self);
+    check_stock_index();
+    while (self->carrying) {
+        struct obj_data *obj = self->carrying;
+
+        obj_from_char(obj);
+        extract_obj(obj);
+        check_stock_index();
+    }
+    fail_unless(vendor_stock(shop, self)->groups->len == 0);
+}
+END_TEST
+
+START_TEST(test_vendor_stock_unsorted)
+{
+    // Identical objects apart from each other are listed separately
+    stock_test_shop(put_carried_unsorted);
+    stock_test_shop(put_carried_unsorted);
+    check_stock_index();
+    fail_unless(vendor_stock_count(shop, self, self->carrying)
+                == vendor_inventory(self->carrying, self->carrying));
+}
+END_TEST
+
+START_TEST(test_vendor_stock_storeroom)
+{
+    shop->storeroom = storeroom->number;
+    stock_test_shop(put_stored);
+    check_stock_index();
+
+    obj_from_room(storeroom->contents);
+    check_stock_index();
+    obj_to_room(read_object(103), storeroom);
+    check_stock_index();
+
+    // The shopkeeper's own inventory isn't for sale
+    obj_to_char(read_object(100), self);
+    check_stock_index();
+}
+END_TEST
+
+// Checks that the vendor's own trades kept the stock current
+static void
+check_stock_in_place(void)
+{
+    unsigned long serial = (shop->storeroom > 0)
+        ? storeroom->contents_serial : self->carrying_serial;
+
+    fail_unless(shop->stock.serial == serial, "stock was left to regroup");
+    fail_unless(shop->stock.contents == stock_list());
+    check_stock_index();
+}
+
+// Trades with the vendor, buying new stock and then selling it off
+static void
+trade_test_stock(struct room_data *room)
+{
+    struct obj_data *obj;
+
+    vendor_stock_add(shop, self, room, read_object(101));
+    check_stock_in_place();
+    vendor_stock_add(shop, self, room, read_object(100));
+    check_stock_in_place();
+
+    // Something unlike the rest starts a new group
+    obj = read_object(102);
+    SET_BIT(GET_OBJ_EXTRA(obj), ITEM_GLOW);
+    vendor_stock_add(shop, self, room, obj);
+    check_stock_in_place();
+
+    while (stock_list()) {
+        obj = stock_list();
+        vendor_stock_remove(shop, self, room, obj);
+        extract_obj(obj);
+        check_stock_in_place();
+    }
+    fail_unless(vendor_stock(shop, self)->groups->len == 0);
+}
+
+START_TEST(test_vendor_stock_trades)
+{
+    stock_test_shop(put_carried);
+    check_stock_index();
+    trade_test_stock(NULL);
+    vendor_free_stock(shop);
+    fail_unless(shop->stock.groups == NULL);
+
+    shop->storeroom = storeroom->number;
+    stock_test_shop(put_stored);
+    check_stock_index();
+    trade_test_stock(storeroom);
+}
+END_TEST
+
+Suite *
+vendor_suite(void)
+{
+    Suite *s = suite_create("vendor");
+
+    TCase *tc_core = tcase_create("Core");
+    tcase_add_checked_fixture(tc_core, tmp_string_init, NULL);
+    tcase_add_checked_fixture(tc_core, fixture_vendor_setup, NULL);
+    tcase_add_test(tc_core, test_vendor_stock_carried);
+    tcase_add_test(tc_core, test_vendor_stock_unsorted);
+    tcase_add_test(tc_core, test_vendor_stock_storeroom);
+    tcase_add_test(tc_core, test_vendor_stock_trades);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}